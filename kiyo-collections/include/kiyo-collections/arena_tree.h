@@ -0,0 +1,173 @@
+#ifndef ARENA_TREE_H
+#define ARENA_TREE_H
+
+#include "functions.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Node of an arena tree. Nodes link by their index inside the arena instead of
+ * a pointer, index 0 is never used and stands for no node. The key and the
+ * value follow the header inside the same slot of the arena.
+ */
+typedef struct {
+  uint32_t left;
+  uint32_t right;
+  uint8_t height;
+} ArenaNode;
+
+/**
+ * AVL tree with fixed size keys and values whose nodes live in a single
+ * growable array. Because the nodes only refer to each other by index, the
+ * array can be moved by realloc or written out as a whole. Removed nodes go on
+ * a free list and are reused first. Sets use a value size of 0.
+ */
+typedef struct {
+  char *nodes;
+  /* Number of slots the array has room for, including slot 0. */
+  size_t capacity;
+  /* Number of slots that were ever handed out, including slot 0. */
+  size_t used;
+  /* First slot of the free list, linked through left. */
+  uint32_t free_list;
+  uint32_t root;
+  size_t len;
+  size_t key_size;
+  size_t value_size;
+  size_t key_offset;
+  size_t value_offset;
+  size_t node_size;
+  Comperator comperator;
+} ArenaTree;
+
+/* Upper bound for the height of an AVL tree with up to UINT32_MAX nodes. */
+#define ARENA_TREE_MAX_HEIGHT 48
+
+/**
+ * Position of an entry inside an arena tree. The cursor keeps the entries that
+ * follow the current one on the path from the root, the current entry is on
+ * top of the stack.
+ */
+typedef struct {
+  ArenaTree *tree;
+  uint32_t stack[ARENA_TREE_MAX_HEIGHT];
+  size_t depth;
+} ArenaCursor;
+
+/* Creates and returns a new empty arena tree. */
+ArenaTree *arena_tree_new(size_t key_size, size_t value_size,
+                          Comperator comperator);
+
+/**
+ * Frees the arena and then the tree itself.
+ *
+ * Time complexity: O(1)
+ */
+void arena_tree_free(ArenaTree *tree);
+
+/**
+ * Inserts the key with the given value or overwrites the value if the key is
+ * already present. The value is ignored if the value size is 0. Returns EXIT
+ * FAILURE if the arena could not grow, EXIT SUCCESS otherwise.
+ *
+ * Time complexity: O(log n) amortized
+ */
+int arena_tree_put(ArenaTree *tree, void *k, void *v);
+
+/**
+ * Returns a pointer to the value of the key, after inserting the key with the
+ * value v if it is missing. A NULL v inserts a value of zero bytes. Sets
+ * inserted to whether the key was missing. Returns NULL if the arena could not
+ * grow. The pointer stays valid until the tree is modified.
+ *
+ * Time complexity: O(log n) amortized
+ */
+void *arena_tree_emplace(ArenaTree *tree, void *k, void *v, bool *inserted);
+
+/**
+ * If the key is present, writes its value to the buffer and returns EXIT
+ * SUCCESS. Otherwise returns EXIT FAILURE.
+ *
+ * Time complexity: O(log n)
+ */
+int arena_tree_get(ArenaTree *tree, void *k, void *v);
+
+/**
+ * Returns a pointer to the value of the key or NULL if the key is not present.
+ * The pointer stays valid until the tree is modified.
+ *
+ * Time complexity: O(log n)
+ */
+void *arena_tree_get_ptr(ArenaTree *tree, void *k);
+
+/**
+ * Returns if the key is present in the tree.
+ *
+ * Time complexity: O(log n)
+ */
+bool arena_tree_contains(ArenaTree *tree, void *k);
+
+/**
+ * Removes the key and its value and puts the node on the free list. Returns
+ * EXIT FAILURE if the key was not present, EXIT SUCCESS otherwise.
+ *
+ * Time complexity: O(log n)
+ */
+int arena_tree_remove(ArenaTree *tree, void *k);
+
+/**
+ * Removes all entries. The arena keeps its capacity for new entries.
+ *
+ * Time complexity: O(1)
+ */
+void arena_tree_clear(ArenaTree *tree);
+
+/* Returns the height of the tree, 0 if the tree is empty. */
+size_t arena_tree_height(ArenaTree *tree);
+
+/**
+ * Moves the cursor to the smallest entry. Returns false if the tree is empty.
+ *
+ * Time complexity: O(log n)
+ */
+bool arena_tree_first(ArenaTree *tree, ArenaCursor *cursor);
+
+/**
+ * Moves the cursor to the largest entry. Returns false if the tree is empty.
+ *
+ * Time complexity: O(log n)
+ */
+bool arena_tree_last(ArenaTree *tree, ArenaCursor *cursor);
+
+/**
+ * Moves the cursor to the smallest entry that is not less than the key.
+ * Returns false if there is no such entry.
+ *
+ * Time complexity: O(log n)
+ */
+bool arena_tree_lower_bound(ArenaTree *tree, void *k, ArenaCursor *cursor);
+
+/**
+ * Moves the cursor to the largest entry that is not greater than the key.
+ * Returns false if there is no such entry.
+ *
+ * Time complexity: O(log n)
+ */
+bool arena_tree_floor(ArenaTree *tree, void *k, ArenaCursor *cursor);
+
+/**
+ * Moves the cursor to the next entry in ascending order. Returns false if the
+ * cursor was at the largest entry.
+ *
+ * Time complexity: O(1) amortized
+ */
+bool arena_cursor_next(ArenaCursor *cursor);
+
+/* Returns a pointer to the key the cursor points to. */
+void *arena_cursor_key(ArenaCursor *cursor);
+
+/* Returns a pointer to the value the cursor points to. */
+void *arena_cursor_value(ArenaCursor *cursor);
+
+#endif
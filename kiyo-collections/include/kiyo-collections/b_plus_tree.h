@@ -0,0 +1,162 @@
+#ifndef B_PLUS_TREE_H
+#define B_PLUS_TREE_H
+
+#include "functions.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Every inner node has at least two children, so no B+ tree that fits into
+ * memory is higher than this.
+ */
+#define B_PLUS_TREE_MAX_HEIGHT 64
+
+/**
+ * Node of a B+ tree. The header is followed by the packed keys of the node.
+ * Leaves then store their values, inner nodes the pointers to their children.
+ * Leaves are linked with their neighbours, inner nodes have prev and next set
+ * to NULL.
+ */
+typedef struct BPlusNode {
+  size_t len;
+  bool leaf;
+  struct BPlusNode *prev;
+  struct BPlusNode *next;
+} BPlusNode;
+
+/**
+ * B+ tree with fixed size keys and values. All entries are stored inside the
+ * leaves, inner nodes only hold separator keys. The number of keys per node is
+ * chosen so that the keys of a node fill a few cache lines. Sets use a
+ * value size of 0.
+ */
+typedef struct {
+  BPlusNode *root;
+  size_t len;
+  size_t height;
+  size_t key_size;
+  size_t value_size;
+  /* Maximum number of keys inside a single node. */
+  size_t capacity;
+  /* Offset of the values or children behind the start of a node. */
+  size_t payload_offset;
+  /* Buffer for separator keys that move between nodes while splitting. */
+  void *scratch;
+  Comperator comperator;
+} BPlusTree;
+
+/**
+ * Position of an entry inside a leaf of a B+ tree.
+ */
+typedef struct {
+  BPlusNode *leaf;
+  size_t index;
+} BPlusCursor;
+
+/* Creates and returns a new empty B+ tree. */
+BPlusTree *b_plus_tree_new(size_t key_size, size_t value_size,
+                           Comperator comperator);
+
+/* Frees all nodes and then the tree itself. */
+void b_plus_tree_free(BPlusTree *tree);
+
+/**
+ * Inserts the key with the given value or overwrites the value if the key is
+ * already present. The value is ignored if the value size is 0. Returns EXIT
+ * FAILURE if a node could not be allocated, EXIT SUCCESS otherwise.
+ *
+ * Time complexity: O(log n)
+ */
+int b_plus_tree_put(BPlusTree *tree, void *k, void *v);
+
+/**
+ * If the key is present, writes its value to the buffer and returns EXIT
+ * SUCCESS. Otherwise returns EXIT FAILURE.
+ *
+ * Time complexity: O(log n)
+ */
+int b_plus_tree_get(BPlusTree *tree, void *k, void *v);
+
+/**
+ * Returns if the key is present in the tree.
+ *
+ * Time complexity: O(log n)
+ */
+bool b_plus_tree_contains(BPlusTree *tree, void *k);
+
+/**
+ * Removes the key and its value. Underfull nodes borrow from or are merged
+ * with their siblings. Returns EXIT FAILURE if the key was not present, EXIT
+ * SUCCESS otherwise.
+ *
+ * Time complexity: O(log n)
+ */
+int b_plus_tree_remove(BPlusTree *tree, void *k);
+
+/* Removes all entries and frees all nodes. */
+void b_plus_tree_clear(BPlusTree *tree);
+
+/* Returns the number of levels of the tree, 0 if the tree is empty. */
+size_t b_plus_tree_height(BPlusTree *tree);
+
+/**
+ * Moves the cursor to the smallest entry. Returns false if the tree is empty.
+ *
+ * Time complexity: O(log n)
+ */
+bool b_plus_tree_first(BPlusTree *tree, BPlusCursor *cursor);
+
+/**
+ * Moves the cursor to the largest entry. Returns false if the tree is empty.
+ *
+ * Time complexity: O(log n)
+ */
+bool b_plus_tree_last(BPlusTree *tree, BPlusCursor *cursor);
+
+/**
+ * Moves the cursor to the smallest entry that is not less than the key.
+ * Returns false if there is no such entry.
+ *
+ * Time complexity: O(log n)
+ */
+bool b_plus_tree_lower_bound(BPlusTree *tree, void *k, BPlusCursor *cursor);
+
+/**
+ * Moves the cursor to the smallest entry that is greater than the key. Returns
+ * false if there is no such entry.
+ *
+ * Time complexity: O(log n)
+ */
+bool b_plus_tree_upper_bound(BPlusTree *tree, void *k, BPlusCursor *cursor);
+
+/**
+ * Moves the cursor to the largest entry that is not greater than the key.
+ * Returns false if there is no such entry.
+ *
+ * Time complexity: O(log n)
+ */
+bool b_plus_tree_floor(BPlusTree *tree, void *k, BPlusCursor *cursor);
+
+/**
+ * Moves the cursor to the next entry by following the leaf links. Returns
+ * false if the cursor was at the largest entry.
+ *
+ * Time complexity: O(1)
+ */
+bool b_plus_cursor_next(BPlusCursor *cursor);
+
+/**
+ * Moves the cursor to the previous entry by following the leaf links. Returns
+ * false if the cursor was at the smallest entry.
+ *
+ * Time complexity: O(1)
+ */
+bool b_plus_cursor_prev(BPlusCursor *cursor);
+
+/* Returns a pointer to the key the cursor points to. */
+void *b_plus_cursor_key(BPlusTree *tree, BPlusCursor *cursor);
+
+/* Returns a pointer to the value the cursor points to. */
+void *b_plus_cursor_value(BPlusTree *tree, BPlusCursor *cursor);
+
+#endif
@@ -1,41 +1,565 @@
 #ifndef B_TREE_MAP_H
 #define B_TREE_MAP_H
 
+#include "arena_tree.h"
+#include "b_plus_tree.h"
+#include "bloom_filter.h"
 #include "functions.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
 
+/**
+ * Node of the AVL tree. The key and the value are stored inline behind the
+ * node inside the same allocation, key and value point to them.
+ */
 typedef struct BinaryEntry {
   void *key;
   void *value;
   struct BinaryEntry *left;
   struct BinaryEntry *right;
   size_t height;
+  /* Number of entries in the subtree of this entry. */
+  size_t size;
 } BinaryEntry;
 
+/**
+ * Key types that a map compares itself instead of calling its comperator.
+ */
+typedef enum {
+  /* Keys of any type, compared by the comperator. */
+  B_TREE_KEY_GENERIC,
+  /* Unsigned 64 bit integers. */
+  B_TREE_KEY_U64,
+  /* Signed 64 bit integers. */
+  B_TREE_KEY_I64,
+  /* Doubles, NaN is not a valid key. */
+  B_TREE_KEY_F64,
+  /* Byte strings of key size bytes, ordered like memcmp. */
+  B_TREE_KEY_BYTES,
+  /* Pointers to NUL terminated strings, ordered like strcmp. */
+  B_TREE_KEY_CSTR,
+} BTreeKeyType;
+
 typedef struct {
   BinaryEntry *root;
   size_t len;
   size_t key_size;
   size_t value_size;
   Comperator comperator;
+  /* B+ tree that stores the entries instead of root, NULL for AVL trees. */
+  BPlusTree *paged;
+  /* Arena tree that stores the entries instead of root, NULL otherwise. */
+  ArenaTree *arena;
+  /* Lets AVL maps compare built-in key types without the comperator. */
+  BTreeKeyType key_type;
+  /**
+   * Sorted keys, followed by their values, of an AVL map with few entries.
+   * The entries live here instead of in a tree as long as root is NULL.
+   */
+  char *small;
+  /* Number of entries the small array has room for. */
+  size_t small_capacity;
+  /* Most entries the map keeps in the small array before it builds a tree. */
+  size_t small_limit;
+  /* Rules out missing keys before a lookup, NULL if none is attached. */
+  BloomFilter *filter;
 } BTreeMap;
 
+/**
+ * Default number of entries up to which an AVL map keeps a sorted array
+ * instead of a tree. A map with more entries builds a tree, a tree that
+ * shrinks to half the limit turns back into an array.
+ */
+#define B_TREE_MAP_SMALL_LIMIT 16
+
+/* Upper bound for the height of an AVL tree with up to SIZE_MAX entries. */
+#define B_TREE_MAP_MAX_HEIGHT 96
+
+/**
+ * In-order iterator over the entries of a map. The iterator keeps the path of
+ * pending AVL entries on an explicit stack, a cursor into the leaves of a
+ * paged map or a cursor into the arena of an arena map. It is invalidated by
+ * any modification of the map.
+ */
+typedef struct {
+  BTreeMap *tree;
+  BinaryEntry *stack[B_TREE_MAP_MAX_HEIGHT];
+  size_t depth;
+  BPlusCursor cursor;
+  ArenaCursor arena_cursor;
+  bool has_cursor;
+  /* Position of the next entry inside the small array. */
+  size_t index;
+} BTreeMapIter;
+
 BTreeMap *b_tree_map_new(size_t key_size, size_t value_size,
                          Comperator comperator);
 
+/**
+ * Creates a map that stores its entries in a B+ tree with many packed keys per
+ * node instead of an AVL tree. Lookups touch far fewer cache lines on large
+ * maps. All b_tree_map functions work on both kinds of maps.
+ */
+BTreeMap *b_tree_map_new_paged(size_t key_size, size_t value_size,
+                               Comperator comperator);
+
+/**
+ * Creates a map whose AVL nodes live in a single growable arena and link by
+ * 32 bit indices, which needs about half the memory per entry of a regular
+ * map. Clearing and freeing the map take constant time, no matter how many
+ * entries it holds. All b_tree_map functions work on arena maps, order
+ * statistics walk the entries and take O(n) like on paged maps.
+ */
+BTreeMap *b_tree_map_new_arena(size_t key_size, size_t value_size,
+                               Comperator comperator);
+
+/**
+ * Sets the number of entries up to which an AVL map keeps its entries in a
+ * sorted array, searched by binary search, instead of allocating a tree entry
+ * for each of them. A limit of 0 always uses a tree. Converts the entries
+ * right away if they no longer fit the limit. Has no effect on paged and arena
+ * maps. Returns EXIT FAILURE if the conversion could not allocate, EXIT
+ * SUCCESS otherwise.
+ *
+ * Time complexity: O(n)
+ */
+int b_tree_map_set_small_limit(BTreeMap *tree, size_t limit);
+
+/**
+ * Attaches a Bloom filter over the keys, sized for capacity keys or the
+ * current number of entries if that is larger. Afterwards get, get_ptr,
+ * contains_key and get_many answer most misses from the filter without
+ * searching the tree. Removed keys stay in the filter until the map is
+ * cleared or the filter is attached again. A NULL hasher hashes the bytes of
+ * a key, or the string of a cstr key. Replaces a filter that was attached
+ * before. Returns EXIT FAILURE if the filter could not be allocated, EXIT
+ * SUCCESS otherwise.
+ *
+ * Time complexity: O(n)
+ */
+int b_tree_map_attach_filter(BTreeMap *tree, Hasher hasher, size_t capacity);
+
+/* Frees the attached Bloom filter, lookups search the tree again. */
+void b_tree_map_detach_filter(BTreeMap *tree);
+
+/**
+ * Creates a map with uint64_t keys. Searches compare the keys inline instead
+ * of calling a comperator for every entry on the path. The comperator of the
+ * map still orders the keys for functions that take no key type into account.
+ */
+BTreeMap *b_tree_map_new_u64(size_t value_size);
+
+/* Creates a map with int64_t keys, see b_tree_map_new_u64. */
+BTreeMap *b_tree_map_new_i64(size_t value_size);
+
+/* Creates a map with double keys, see b_tree_map_new_u64. NaN is no key. */
+BTreeMap *b_tree_map_new_f64(size_t value_size);
+
+/**
+ * Creates a map whose keys are key_size raw bytes, ordered like memcmp, see
+ * b_tree_map_new_u64. A comperator cannot know the key size, so the map has
+ * none and cannot be frozen.
+ */
+BTreeMap *b_tree_map_new_bytes(size_t key_size, size_t value_size);
+
+/**
+ * Creates a map whose keys are char pointers to NUL terminated strings,
+ * ordered like strcmp, see b_tree_map_new_u64. The map stores the pointers
+ * only, the strings must outlive their entries and must not change.
+ */
+BTreeMap *b_tree_map_new_cstr(size_t value_size);
+
+/**
+ * Creates a map from n keys and their values, stored contiguously in keys and
+ * values. The keys must be strictly ascending, otherwise NULL is returned. The
+ * tree is built perfectly balanced without any comparisons or rotations.
+ *
+ * Time complexity: O(n)
+ */
+BTreeMap *b_tree_map_from_sorted(size_t key_size, size_t value_size,
+                                 Comperator comperator, void *keys,
+                                 void *values, size_t n);
+
+/**
+ * Creates a map from n keys and their values in any order. The entries are
+ * sorted first, if a key occurs more than once the last value wins like with
+ * repeated puts.
+ *
+ * Time complexity: O(n log n)
+ */
+BTreeMap *b_tree_map_from_unsorted(size_t key_size, size_t value_size,
+                                   Comperator comperator, void *keys,
+                                   void *values, size_t n);
+
 void b_tree_map_free(BTreeMap *tree);
 
+/**
+ * Inserts the key with the value v or overwrites the value of the key. Returns
+ * EXIT FAILURE if k is NaN on a map with double keys or the entry could not be
+ * allocated, EXIT SUCCESS otherwise.
+ *
+ * Time complexity: O(log n)
+ */
 int b_tree_map_put(BTreeMap *tree, void *k, void *v);
 
 int b_tree_map_get(BTreeMap *tree, void *k, void *v);
 
+/**
+ * Returns a pointer to the stored value of the key, or NULL if the key is not
+ * present. The value can be changed in place through the pointer, which stays
+ * valid until the map is modified.
+ *
+ * Time complexity: O(log n)
+ */
+void *b_tree_map_get_ptr(BTreeMap *tree, void *k);
+
+/**
+ * Returns a pointer to the stored value of the key, after inserting the key
+ * with a copy of the default value v if it is missing. Returns NULL if k is
+ * NaN on a map with double keys or the entry could not be allocated. The
+ * pointer stays valid until the map is modified. AVL and arena maps find or
+ * insert the key with a single descent, paged maps look the key up again after
+ * inserting it.
+ *
+ * Time complexity: O(log n)
+ */
+void *b_tree_map_get_or_insert(BTreeMap *tree, void *k, void *v);
+
+/**
+ * Calls fn with a pointer to the stored value of the key and ctx, so that fn
+ * can update the value in place. A missing key is inserted with a value of
+ * zero bytes first. Returns EXIT FAILURE if k is NaN on a map with double keys
+ * or the entry could not be allocated, EXIT SUCCESS otherwise.
+ *
+ * Time complexity: O(log n)
+ */
+int b_tree_map_upsert(BTreeMap *tree, void *k, BiConsumer fn, void *ctx);
+
 int b_tree_map_remove(BTreeMap *tree, void *k);
 
 bool b_tree_map_contains_key(BTreeMap *tree, void *k);
 
+/**
+ * Looks up n keys, stored contiguously in keys, at once. The value of key i is
+ * written to values at index i and found[i] tells if the key is present,
+ * values of missing keys are left untouched. found may be NULL. Several
+ * lookups descend the tree in lockstep and prefetch their next entry, so the
+ * cache misses of different lookups overlap instead of adding up. Returns the
+ * number of keys that were found.
+ *
+ * Time complexity: O(n log m)
+ */
+size_t b_tree_map_get_many(BTreeMap *tree, void *keys, size_t n, void *values,
+                           bool *found);
+
 void b_tree_map_clear(BTreeMap *tree);
 
 size_t b_tree_map_height(BTreeMap *tree);
 
+/**
+ * Positions the iterator before the smallest entry of the map.
+ *
+ * Time complexity: O(log n)
+ */
+void b_tree_map_iter(BTreeMap *tree, BTreeMapIter *iter);
+
+/**
+ * Positions the iterator before the smallest entry whose key is not less than
+ * k.
+ *
+ * Time complexity: O(log n)
+ */
+void b_tree_map_iter_from(BTreeMap *tree, BTreeMapIter *iter, void *k);
+
+/**
+ * If there is no entry left, returns false. Otherwise writes pointers to the
+ * key and the value of the next entry in ascending order to k and v and
+ * returns true. The pointers stay valid until the map is modified.
+ *
+ * Time complexity: O(1) amortized
+ */
+bool b_tree_map_iter_next(BTreeMapIter *iter, void **k, void **v);
+
+/**
+ * If the map is empty, returns EXIT FAILURE. Otherwise writes the smallest
+ * key and its value to the buffers and returns EXIT SUCCESS. Either buffer may
+ * be NULL.
+ *
+ * Time complexity: O(log n)
+ */
+int b_tree_map_first(BTreeMap *tree, void *buffer_k, void *buffer_v);
+
+/**
+ * If the map is empty, returns EXIT FAILURE. Otherwise writes the largest key
+ * and its value to the buffers and returns EXIT SUCCESS. Either buffer may be
+ * NULL.
+ *
+ * Time complexity: O(log n)
+ */
+int b_tree_map_last(BTreeMap *tree, void *buffer_k, void *buffer_v);
+
+/**
+ * Writes the largest key that is not greater than k and its value to the
+ * buffers. Returns EXIT FAILURE if there is no such key.
+ *
+ * Time complexity: O(log n)
+ */
+int b_tree_map_floor(BTreeMap *tree, void *k, void *buffer_k, void *buffer_v);
+
+/**
+ * Writes the smallest key that is not less than k and its value to the
+ * buffers. Returns EXIT FAILURE if there is no such key.
+ *
+ * Time complexity: O(log n)
+ */
+int b_tree_map_ceiling(BTreeMap *tree, void *k, void *buffer_k,
+                       void *buffer_v);
+
+/**
+ * Calls the consumer with the key and the value of every entry whose key lies
+ * inside [lo, hi), in ascending order. Only the entries inside the range are
+ * visited.
+ *
+ * Time complexity: O(log n + m)
+ */
+void b_tree_map_range(BTreeMap *tree, void *lo, void *hi, BiConsumer consumer);
+
+/**
+ * Returns the number of keys that are less than k. Every AVL entry knows the
+ * size of its subtree, paged and arena maps count their entries instead.
+ *
+ * Time complexity: O(log n) for AVL and small maps, O(n) for paged and arena
+ * maps
+ */
+size_t b_tree_map_rank(BTreeMap *tree, void *k);
+
+/**
+ * Writes the entry with the i-th smallest key to the buffers, starting at 0.
+ * Returns EXIT FAILURE if i is not less than the number of entries.
+ *
+ * Time complexity: O(log n) for AVL and small maps, O(n) for paged and arena
+ * maps
+ */
+int b_tree_map_select(BTreeMap *tree, size_t i, void *buffer_k,
+                      void *buffer_v);
+
+/**
+ * Returns the number of keys inside [lo, hi).
+ *
+ * Time complexity: O(log n) for AVL and small maps, O(n) for paged and arena
+ * maps
+ */
+size_t b_tree_map_count_range(BTreeMap *tree, void *lo, void *hi);
+
+/**
+ * Writes the entry at the p-th percentile of the keys to the buffers, with p
+ * between 0 and 100 and the nearest-rank method: the smallest key that is not
+ * less than p percent of all keys. Percentile 50 is the median. Returns EXIT
+ * FAILURE if the map is empty or p is out of range.
+ *
+ * Time complexity: O(log n) for AVL and small maps, O(n) for paged and arena
+ * maps
+ */
+int b_tree_map_percentile(BTreeMap *tree, double p, void *buffer_k,
+                          void *buffer_v);
+
+/**
+ * Generates a map BTreeMapN from keys of type K to values of type V. Keys and
+ * values are stored inline in the nodes, so put and get copy them by
+ * assignment instead of memcpy. CMP is a function-like macro or a static
+ * inline function that takes two keys and follows the sign convention of a
+ * Comperator, for example COMPARE_ASCENDING. Because CMP is known at
+ * instantiation time, it is inlined into every level of the search.
+ */
+#define GENERATE_B_TREE_MAP_H(N, K, V)                                         \
+  typedef struct BinaryEntry##N {                                              \
+    K key;                                                                     \
+    V value;                                                                   \
+    struct BinaryEntry##N *left;                                               \
+    struct BinaryEntry##N *right;                                              \
+    size_t height;                                                             \
+  } BinaryEntry##N;                                                            \
+  typedef struct {                                                             \
+    BinaryEntry##N *root;                                                      \
+    size_t len;                                                                \
+  } BTreeMap##N;                                                               \
+  BTreeMap##N *b_tree_map_##N##_new();                                         \
+  void b_tree_map_##N##_free(BTreeMap##N *tree);                               \
+  int b_tree_map_##N##_put(BTreeMap##N *tree, K k, V v);                       \
+  int b_tree_map_##N##_get(BTreeMap##N *tree, K k, V *buffer);                 \
+  int b_tree_map_##N##_remove(BTreeMap##N *tree, K k);                         \
+  bool b_tree_map_##N##_contains_key(BTreeMap##N *tree, K k);                  \
+  size_t b_tree_map_##N##_len(BTreeMap##N *tree);                              \
+  void b_tree_map_##N##_clear(BTreeMap##N *tree);
+
+#define GENERATE_B_TREE_MAP_C(N, K, V, CMP)                                    \
+  BinaryEntry##N *binary_entry##N##_new(K k, V v) {                            \
+    BinaryEntry##N *created = malloc(sizeof(BinaryEntry##N));                  \
+    if (!created)                                                              \
+      return NULL;                                                             \
+    created->key = k;                                                          \
+    created->value = v;                                                        \
+    created->left = NULL;                                                      \
+    created->right = NULL;                                                     \
+    created->height = 1;                                                       \
+    return created;                                                            \
+  }                                                                            \
+  void binary_entry##N##_free(BinaryEntry##N *node) {                          \
+    while (node) {                                                             \
+      if (node->left) {                                                        \
+        BinaryEntry##N *left = node->left;                                     \
+        node->left = left->right;                                              \
+        left->right = node;                                                    \
+        node = left;                                                           \
+      } else {                                                                 \
+        BinaryEntry##N *right = node->right;                                   \
+        free(node);                                                            \
+        node = right;                                                          \
+      }                                                                        \
+    }                                                                          \
+  }                                                                            \
+  size_t binary_entry##N##_height(BinaryEntry##N *node) {                      \
+    return node ? node->height : 0;                                            \
+  }                                                                            \
+  void binary_entry##N##_update_height(BinaryEntry##N *node) {                 \
+    size_t left = binary_entry##N##_height(node->left);                        \
+    size_t right = binary_entry##N##_height(node->right);                      \
+    node->height = (left > right ? left : right) + 1;                          \
+  }                                                                            \
+  int binary_entry##N##_get_balance_factor(BinaryEntry##N *node) {             \
+    return (int)binary_entry##N##_height(node->left) -                         \
+           (int)binary_entry##N##_height(node->right);                         \
+  }                                                                            \
+  BinaryEntry##N *binary_entry##N##_rotate_right(BinaryEntry##N *node) {       \
+    BinaryEntry##N *left = node->left;                                         \
+    node->left = left->right;                                                  \
+    left->right = node;                                                        \
+    binary_entry##N##_update_height(node);                                     \
+    binary_entry##N##_update_height(left);                                     \
+    return left;                                                               \
+  }                                                                            \
+  BinaryEntry##N *binary_entry##N##_rotate_left(BinaryEntry##N *node) {        \
+    BinaryEntry##N *right = node->right;                                       \
+    node->right = right->left;                                                 \
+    right->left = node;                                                        \
+    binary_entry##N##_update_height(node);                                     \
+    binary_entry##N##_update_height(right);                                    \
+    return right;                                                              \
+  }                                                                            \
+  BinaryEntry##N *binary_entry##N##_rebalance(BinaryEntry##N *node) {          \
+    binary_entry##N##_update_height(node);                                     \
+    int balance_factor = binary_entry##N##_get_balance_factor(node);           \
+    if (balance_factor > 1) {                                                  \
+      if (binary_entry##N##_get_balance_factor(node->left) < 0)                \
+        node->left = binary_entry##N##_rotate_left(node->left);                \
+      return binary_entry##N##_rotate_right(node);                             \
+    } else if (balance_factor < -1) {                                          \
+      if (binary_entry##N##_get_balance_factor(node->right) > 0)               \
+        node->right = binary_entry##N##_rotate_right(node->right);             \
+      return binary_entry##N##_rotate_left(node);                              \
+    }                                                                          \
+    return node;                                                               \
+  }                                                                            \
+  void binary_entry##N##_rebalance_path(BinaryEntry##N ***path,                \
+                                        size_t depth) {                        \
+    while (depth > 0) {                                                        \
+      BinaryEntry##N **link = path[--depth];                                   \
+      size_t height = (*link)->height;                                         \
+      *link = binary_entry##N##_rebalance(*link);                              \
+      if ((*link)->height == height)                                           \
+        break;                                                                 \
+    }                                                                          \
+  }                                                                            \
+  BinaryEntry##N *binary_entry##N##_find(BTreeMap##N *tree, K k) {             \
+    BinaryEntry##N *node = tree->root;                                         \
+    while (node) {                                                             \
+      int c = CMP(node->key, k);                                               \
+      if (c == 0)                                                              \
+        return node;                                                           \
+      node = (c > 0) ? node->right : node->left;                               \
+    }                                                                          \
+    return NULL;                                                               \
+  }                                                                            \
+  BTreeMap##N *b_tree_map_##N##_new() {                                        \
+    BTreeMap##N *created = malloc(sizeof(BTreeMap##N));                        \
+    if (!created)                                                              \
+      return NULL;                                                             \
+    created->root = NULL;                                                      \
+    created->len = 0;                                                          \
+    return created;                                                            \
+  }                                                                            \
+  void b_tree_map_##N##_free(BTreeMap##N *tree) {                              \
+    binary_entry##N##_free(tree->root);                                        \
+    free(tree);                                                                \
+  }                                                                            \
+  int b_tree_map_##N##_put(BTreeMap##N *tree, K k, V v) {                      \
+    BinaryEntry##N **path[B_TREE_MAP_MAX_HEIGHT];                              \
+    size_t depth = 0;                                                          \
+    BinaryEntry##N **link = &(tree->root);                                     \
+    while (*link) {                                                            \
+      int c = CMP((*link)->key, k);                                            \
+      if (c == 0) {                                                            \
+        (*link)->value = v;                                                    \
+        return EXIT_SUCCESS;                                                   \
+      }                                                                        \
+      path[depth++] = link;                                                    \
+      link = (c > 0) ? &((*link)->right) : &((*link)->left);                   \
+    }                                                                          \
+    *link = binary_entry##N##_new(k, v);                                       \
+    if (*link == NULL)                                                         \
+      return EXIT_FAILURE;                                                     \
+    tree->len++;                                                               \
+    binary_entry##N##_rebalance_path(path, depth);                             \
+    return EXIT_SUCCESS;                                                       \
+  }                                                                            \
+  int b_tree_map_##N##_get(BTreeMap##N *tree, K k, V *buffer) {                \
+    BinaryEntry##N *node = binary_entry##N##_find(tree, k);                    \
+    if (node == NULL)                                                          \
+      return EXIT_FAILURE;                                                     \
+    *buffer = node->value;                                                     \
+    return EXIT_SUCCESS;                                                       \
+  }                                                                            \
+  int b_tree_map_##N##_remove(BTreeMap##N *tree, K k) {                        \
+    BinaryEntry##N **path[B_TREE_MAP_MAX_HEIGHT];                              \
+    size_t depth = 0;                                                          \
+    BinaryEntry##N **link = &(tree->root);                                     \
+    while (*link) {                                                            \
+      int c = CMP((*link)->key, k);                                            \
+      if (c == 0)                                                              \
+        break;                                                                 \
+      path[depth++] = link;                                                    \
+      link = (c > 0) ? &((*link)->right) : &((*link)->left);                   \
+    }                                                                          \
+    BinaryEntry##N *node = *link;                                              \
+    if (node == NULL)                                                          \
+      return EXIT_FAILURE;                                                     \
+    if (node->left && node->right) {                                           \
+      path[depth++] = link;                                                    \
+      link = &(node->right);                                                   \
+      while ((*link)->left) {                                                  \
+        path[depth++] = link;                                                  \
+        link = &((*link)->left);                                               \
+      }                                                                        \
+      node->key = (*link)->key;                                                \
+      node->value = (*link)->value;                                            \
+      node = *link;                                                            \
+    }                                                                          \
+    *link = node->left ? node->left : node->right;                             \
+    free(node);                                                                \
+    tree->len--;                                                               \
+    binary_entry##N##_rebalance_path(path, depth);                             \
+    return EXIT_SUCCESS;                                                       \
+  }                                                                            \
+  bool b_tree_map_##N##_contains_key(BTreeMap##N *tree, K k) {                 \
+    return binary_entry##N##_find(tree, k) != NULL;                            \
+  }                                                                            \
+  size_t b_tree_map_##N##_len(BTreeMap##N *tree) { return tree->len; }         \
+  void b_tree_map_##N##_clear(BTreeMap##N *tree) {                             \
+    binary_entry##N##_free(tree->root);                                        \
+    tree->root = NULL;                                                         \
+    tree->len = 0;                                                             \
+  }
+
 #endif
@@ -0,0 +1,138 @@
+#ifndef B_TREE_MULTI_MAP_H
+#define B_TREE_MULTI_MAP_H
+
+#include "functions.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+/**
+ * Node of the AVL tree of a multimap. The key is stored inline behind the
+ * entry, all values of the key follow each other in a separate array.
+ */
+typedef struct MultiEntry {
+  void *key;
+  /* Values of the key in the order they were put, room for capacity. */
+  char *values;
+  size_t count;
+  size_t capacity;
+  struct MultiEntry *left;
+  struct MultiEntry *right;
+  size_t height;
+  /* Number of values of all keys in the subtree of this entry. */
+  size_t total;
+} MultiEntry;
+
+/**
+ * Sorted map from keys to any number of values, both of a fixed size. All
+ * values of a key live in one contiguous run behind a single tree entry, so
+ * duplicate keys neither grow the tree nor add comparisons, and the values of
+ * a key are read as a plain array.
+ */
+typedef struct {
+  MultiEntry *root;
+  /* Number of values of all keys. */
+  size_t len;
+  /* Number of distinct keys, the number of entries. */
+  size_t distinct_len;
+  size_t key_size;
+  size_t value_size;
+  Comperator comperator;
+} BTreeMultiMap;
+
+/* Upper bound for the height of an AVL tree with up to SIZE_MAX entries. */
+#define B_TREE_MULTI_MAP_MAX_HEIGHT 96
+
+/**
+ * In-order iterator over the keys of a multimap. It is invalidated by any
+ * modification of the multimap.
+ */
+typedef struct {
+  MultiEntry *stack[B_TREE_MULTI_MAP_MAX_HEIGHT];
+  size_t depth;
+} BTreeMultiMapIter;
+
+/* Creates and returns a new empty multimap. */
+BTreeMultiMap *b_tree_multi_map_new(size_t key_size, size_t value_size,
+                                    Comperator comperator);
+
+void b_tree_multi_map_free(BTreeMultiMap *tree);
+
+/**
+ * Appends the value to the values of the key, adding the key if it is not
+ * present. The run of values doubles its capacity when it is full. Returns
+ * EXIT FAILURE if memory could not be allocated, EXIT SUCCESS otherwise.
+ *
+ * Time complexity: O(log n) amortized
+ */
+int b_tree_multi_map_put(BTreeMultiMap *tree, void *k, void *v);
+
+/**
+ * Returns a pointer to the first of the values of the key and writes their
+ * number to count, or returns NULL and writes 0 if the key is not present.
+ * The values stay valid until the multimap is modified.
+ *
+ * Time complexity: O(log n)
+ */
+void *b_tree_multi_map_get(BTreeMultiMap *tree, void *k, size_t *count);
+
+/**
+ * Returns the number of values of the key, 0 if it is not present.
+ *
+ * Time complexity: O(log n)
+ */
+size_t b_tree_multi_map_count(BTreeMultiMap *tree, void *k);
+
+bool b_tree_multi_map_contains_key(BTreeMultiMap *tree, void *k);
+
+/**
+ * Removes the key with all of its values. Returns EXIT FAILURE if the key was
+ * not present, EXIT SUCCESS otherwise.
+ *
+ * Time complexity: O(log n)
+ */
+int b_tree_multi_map_remove(BTreeMultiMap *tree, void *k);
+
+/**
+ * Removes the i-th value of the key, the values behind it move up. The key
+ * goes away with its last value. Returns EXIT FAILURE if the key is not
+ * present or has no i-th value, EXIT SUCCESS otherwise.
+ *
+ * Time complexity: O(log n + m)
+ */
+int b_tree_multi_map_remove_at(BTreeMultiMap *tree, void *k, size_t i);
+
+/* Returns the number of values of all keys. */
+size_t b_tree_multi_map_len(BTreeMultiMap *tree);
+
+/* Returns the number of distinct keys. */
+size_t b_tree_multi_map_distinct_len(BTreeMultiMap *tree);
+
+void b_tree_multi_map_clear(BTreeMultiMap *tree);
+
+/**
+ * Positions the iterator before the smallest key of the multimap.
+ *
+ * Time complexity: O(log n)
+ */
+void b_tree_multi_map_iter(BTreeMultiMap *tree, BTreeMultiMapIter *iter);
+
+/**
+ * If there is no key left, returns false. Otherwise writes a pointer to the
+ * next key in ascending order to k, a pointer to its first value to values,
+ * their number to count and returns true.
+ *
+ * Time complexity: O(1) amortized
+ */
+bool b_tree_multi_map_iter_next(BTreeMultiMapIter *iter, void **k,
+                                void **values, size_t *count);
+
+/**
+ * Returns the number of values of all keys inside [lo, hi) without visiting
+ * them.
+ *
+ * Time complexity: O(log n)
+ */
+size_t b_tree_multi_map_count_range(BTreeMultiMap *tree, void *lo, void *hi);
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef B_TREE_MULTI_SET_H
+#define B_TREE_MULTI_SET_H
+
+#include "functions.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+/**
+ * Node of the AVL tree of a multiset. Equal elements share a single node that
+ * counts them. The element is stored inline behind the node inside the same
+ * allocation, value points to it.
+ */
+typedef struct MultiNode {
+  void *value;
+  struct MultiNode *left;
+  struct MultiNode *right;
+  size_t height;
+  /* Number of copies of this element. */
+  size_t count;
+  /* Number of copies of all elements in the subtree of this node. */
+  size_t total;
+} MultiNode;
+
+/**
+ * Sorted multiset of elements of a fixed size. Adding an element that is
+ * already present only increments its count, so duplicates cost neither
+ * memory nor comparisons. Every node knows the copies inside its subtree, so
+ * rank, select and range counts take the duplicates into account.
+ */
+typedef struct {
+  MultiNode *root;
+  /* Number of copies of all elements. */
+  size_t len;
+  /* Number of distinct elements, the number of nodes. */
+  size_t distinct_len;
+  size_t element_size;
+  Comperator comperator;
+} BTreeMultiSet;
+
+/* Upper bound for the height of an AVL tree with up to SIZE_MAX nodes. */
+#define B_TREE_MULTI_SET_MAX_HEIGHT 96
+
+/**
+ * In-order iterator over the distinct elements of a multiset. It is
+ * invalidated by any modification of the multiset.
+ */
+typedef struct {
+  MultiNode *stack[B_TREE_MULTI_SET_MAX_HEIGHT];
+  size_t depth;
+} BTreeMultiSetIter;
+
+/* Creates and returns a new empty multiset. */
+BTreeMultiSet *b_tree_multi_set_new(size_t element_size,
+                                    Comperator comperator);
+
+void b_tree_multi_set_free(BTreeMultiSet *tree);
+
+/**
+ * Adds a copy of the element. Returns EXIT FAILURE if a new node could not be
+ * allocated, EXIT SUCCESS otherwise.
+ *
+ * Time complexity: O(log n)
+ */
+int b_tree_multi_set_add(BTreeMultiSet *tree, void *e);
+
+/**
+ * Adds n copies of the element at once. Adding 0 copies does nothing.
+ *
+ * Time complexity: O(log n)
+ */
+int b_tree_multi_set_add_count(BTreeMultiSet *tree, void *e, size_t n);
+
+/**
+ * Removes a single copy of the element, the node goes away with the last one.
+ * Returns EXIT FAILURE if the element was not present, EXIT SUCCESS otherwise.
+ *
+ * Time complexity: O(log n)
+ */
+int b_tree_multi_set_remove(BTreeMultiSet *tree, void *e);
+
+/**
+ * Removes all copies of the element and returns how many there were.
+ *
+ * Time complexity: O(log n)
+ */
+size_t b_tree_multi_set_remove_all(BTreeMultiSet *tree, void *e);
+
+/**
+ * Returns the number of copies of the element, 0 if it is not present.
+ *
+ * Time complexity: O(log n)
+ */
+size_t b_tree_multi_set_count(BTreeMultiSet *tree, void *e);
+
+bool b_tree_multi_set_contains(BTreeMultiSet *tree, void *e);
+
+/* Returns the number of copies of all elements. */
+size_t b_tree_multi_set_len(BTreeMultiSet *tree);
+
+/* Returns the number of distinct elements. */
+size_t b_tree_multi_set_distinct_len(BTreeMultiSet *tree);
+
+void b_tree_multi_set_clear(BTreeMultiSet *tree);
+
+/**
+ * Positions the iterator before the smallest element of the multiset.
+ *
+ * Time complexity: O(log n)
+ */
+void b_tree_multi_set_iter(BTreeMultiSet *tree, BTreeMultiSetIter *iter);
+
+/**
+ * If there is no element left, returns false. Otherwise writes a pointer to
+ * the next distinct element in ascending order to e, its number of copies to
+ * count and returns true.
+ *
+ * Time complexity: O(1) amortized
+ */
+bool b_tree_multi_set_iter_next(BTreeMultiSetIter *iter, void **e,
+                                size_t *count);
+
+/**
+ * Returns the number of copies of elements that are less than e.
+ *
+ * Time complexity: O(log n)
+ */
+size_t b_tree_multi_set_rank(BTreeMultiSet *tree, void *e);
+
+/**
+ * Writes the i-th smallest copy to the buffer, starting at 0, so an element
+ * with k copies fills k consecutive positions. Returns EXIT FAILURE if i is
+ * not less than the number of copies.
+ *
+ * Time complexity: O(log n)
+ */
+int b_tree_multi_set_select(BTreeMultiSet *tree, size_t i, void *buffer);
+
+/**
+ * Returns the number of copies of elements inside [lo, hi) without visiting
+ * them.
+ *
+ * Time complexity: O(log n)
+ */
+size_t b_tree_multi_set_count_range(BTreeMultiSet *tree, void *lo, void *hi);
+
+#endif
@@ -1,15 +1,26 @@
 #ifndef B_TREE_SET_H
 #define B_TREE_SET_H
 
+#include "arena_tree.h"
+#include "b_plus_tree.h"
+#include "bloom_filter.h"
 #include "functions.h"
+#include "vec.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdlib.h>
 
+/**
+ * Node of the AVL tree. The element is stored inline behind the node inside
+ * the same allocation, value points to it.
+ */
 typedef struct BinaryNode {
   void *value;
   struct BinaryNode *left;
   struct BinaryNode *right;
   size_t height;
+  /* Number of elements in the subtree of this node. */
+  size_t size;
 } BinaryNode;
 
 typedef struct {
@@ -17,10 +28,126 @@ typedef struct {
   size_t len;
   size_t element_size;
   Comperator comperator;
+  /* B+ tree that stores the elements instead of root, NULL for AVL trees. */
+  BPlusTree *paged;
+  /* Arena tree that stores the elements instead of root, NULL otherwise. */
+  ArenaTree *arena;
+  /**
+   * Sorted elements of an AVL set with few elements. The elements live here
+   * instead of in a tree as long as root is NULL.
+   */
+  char *small;
+  /* Number of elements the small array has room for. */
+  size_t small_capacity;
+  /* Most elements the set keeps in the small array before it builds a tree. */
+  size_t small_limit;
+  /* Rules out missing elements before a lookup, NULL if none is attached. */
+  BloomFilter *filter;
 } BTreeSet;
 
+/**
+ * Default number of elements up to which an AVL set keeps a sorted array
+ * instead of a tree. A set with more elements builds a tree, a tree that
+ * shrinks to half the limit turns back into an array.
+ */
+#define B_TREE_SET_SMALL_LIMIT 16
+
+/**
+ * Selects which elements a merge of two sets keeps.
+ */
+typedef enum {
+  /* Elements that are in either set. */
+  B_TREE_SET_UNION,
+  /* Elements that are in both sets. */
+  B_TREE_SET_INTERSECTION,
+  /* Elements that are in the left but not in the right set. */
+  B_TREE_SET_DIFFERENCE,
+  /* Elements that are in exactly one of the sets. */
+  B_TREE_SET_SYMMETRIC_DIFFERENCE,
+} BTreeSetOperation;
+
+/* Upper bound for the height of an AVL tree with up to SIZE_MAX elements. */
+#define B_TREE_SET_MAX_HEIGHT 96
+
+/**
+ * In-order iterator over the elements of a set. The iterator keeps the path of
+ * pending AVL nodes on an explicit stack, a cursor into the leaves of a paged
+ * set or a cursor into the arena of an arena set. It is invalidated by any
+ * modification of the set.
+ */
+typedef struct {
+  BTreeSet *tree;
+  BinaryNode *stack[B_TREE_SET_MAX_HEIGHT];
+  size_t depth;
+  BPlusCursor cursor;
+  ArenaCursor arena_cursor;
+  bool has_cursor;
+  /* Position of the next element inside the small array. */
+  size_t index;
+} BTreeSetIter;
+
 BTreeSet *b_tree_set_new(size_t element_size, Comperator comperator);
 
+/**
+ * Creates a set that stores its elements in a B+ tree with many packed
+ * elements per node instead of an AVL tree. All b_tree_set functions work on
+ * both kinds of sets.
+ */
+BTreeSet *b_tree_set_new_paged(size_t element_size, Comperator comperator);
+
+/**
+ * Creates a set whose AVL nodes live in a single growable arena and link by
+ * 32 bit indices instead of pointers. Freeing the set takes constant time. All
+ * b_tree_set functions work on arena sets, order statistics walk the elements
+ * and take O(n) like on paged sets.
+ */
+BTreeSet *b_tree_set_new_arena(size_t element_size, Comperator comperator);
+
+/**
+ * Sets the number of elements up to which an AVL set keeps them in a sorted
+ * array, searched by binary search, instead of allocating a tree node for each
+ * of them. A limit of 0 always uses a tree. Converts the elements right away if
+ * they no longer fit the limit. Has no effect on paged and arena sets. Returns
+ * EXIT FAILURE if the conversion could not allocate, EXIT SUCCESS otherwise.
+ *
+ * Time complexity: O(n)
+ */
+int b_tree_set_set_small_limit(BTreeSet *tree, size_t limit);
+
+/**
+ * Attaches a Bloom filter sized for capacity elements, or the current number
+ * of elements if that is larger, and adds all elements to it. Afterwards
+ * contains and contains_many answer most misses from the filter without
+ * searching the tree. Removed elements stay in the filter and only make it
+ * less selective, attaching again rebuilds it. A NULL hasher hashes the bytes
+ * of an element. Replaces a filter that was attached before. Returns EXIT
+ * FAILURE if the filter could not be allocated, EXIT SUCCESS otherwise.
+ *
+ * Time complexity: O(n)
+ */
+int b_tree_set_attach_filter(BTreeSet *tree, Hasher hasher, size_t capacity);
+
+/* Frees the attached Bloom filter, lookups search the tree again. */
+void b_tree_set_detach_filter(BTreeSet *tree);
+
+/**
+ * Creates a set from the elements of the vec. The elements must be strictly
+ * ascending, otherwise NULL is returned. The tree is built perfectly balanced
+ * without any comparisons or rotations. The vec is not changed.
+ *
+ * Time complexity: O(n)
+ */
+BTreeSet *b_tree_set_from_sorted(Vec *vec, Comperator comperator);
+
+/**
+ * Creates a set from the elements of the vec in any order. A sorted copy of
+ * the elements is made first and duplicates are dropped. The vec is not
+ * changed.
+ *
+ * Time complexity: O(n log n)
+ */
+BTreeSet *b_tree_set_from_unsorted(Vec *vec, Comperator comperator);
+
 void b_tree_set_free(BTreeSet *tree);
 
 int b_tree_set_add(BTreeSet *tree, void *e);
@@ -29,6 +156,355 @@ int b_tree_set_remove(BTreeSet *tree, void *e);
 
 bool b_tree_set_contains(BTreeSet *tree, void *e);
 
+/**
+ * Looks up n elements, stored contiguously in elements, at once and writes to
+ * found[i] if element i is present. found may be NULL. Several lookups
+ * descend the tree in lockstep and prefetch their next node, so the cache
+ * misses of different lookups overlap instead of adding up. Returns the number
+ * of elements that were found.
+ *
+ * Time complexity: O(n log m)
+ */
+size_t b_tree_set_contains_many(BTreeSet *tree, void *elements, size_t n,
+                                bool *found);
+
 size_t b_tree_set_len(BTreeSet *tree);
 
+/**
+ * Positions the iterator before the smallest element of the set.
+ *
+ * Time complexity: O(log n)
+ */
+void b_tree_set_iter(BTreeSet *tree, BTreeSetIter *iter);
+
+/**
+ * Positions the iterator before the smallest element that is not less than e.
+ *
+ * Time complexity: O(log n)
+ */
+void b_tree_set_iter_from(BTreeSet *tree, BTreeSetIter *iter, void *e);
+
+/**
+ * If there is no element left, returns false. Otherwise writes a pointer to
+ * the next element in ascending order to e and returns true. The pointer stays
+ * valid until the set is modified.
+ *
+ * Time complexity: O(1) amortized
+ */
+bool b_tree_set_iter_next(BTreeSetIter *iter, void **e);
+
+/**
+ * If the set is empty, returns EXIT FAILURE. Otherwise writes the smallest
+ * element to the buffer and returns EXIT SUCCESS.
+ *
+ * Time complexity: O(log n)
+ */
+int b_tree_set_first(BTreeSet *tree, void *buffer);
+
+/**
+ * If the set is empty, returns EXIT FAILURE. Otherwise writes the largest
+ * element to the buffer and returns EXIT SUCCESS.
+ *
+ * Time complexity: O(log n)
+ */
+int b_tree_set_last(BTreeSet *tree, void *buffer);
+
+/**
+ * Writes the largest element that is not greater than e to the buffer. Returns
+ * EXIT FAILURE if there is no such element.
+ *
+ * Time complexity: O(log n)
+ */
+int b_tree_set_floor(BTreeSet *tree, void *e, void *buffer);
+
+/**
+ * Writes the smallest element that is not less than e to the buffer. Returns
+ * EXIT FAILURE if there is no such element.
+ *
+ * Time complexity: O(log n)
+ */
+int b_tree_set_ceiling(BTreeSet *tree, void *e, void *buffer);
+
+/**
+ * Calls the consumer with every element inside [lo, hi), in ascending order.
+ * Only the elements inside the range are visited.
+ *
+ * Time complexity: O(log n + m)
+ */
+void b_tree_set_range(BTreeSet *tree, void *lo, void *hi, Consumer consumer);
+
+/**
+ * Returns the number of elements that are less than e. Every AVL node knows
+ * the size of its subtree, paged and arena sets count their elements instead.
+ *
+ * Time complexity: O(log n) for AVL and small sets, O(n) for paged and arena
+ * sets
+ */
+size_t b_tree_set_rank(BTreeSet *tree, void *e);
+
+/**
+ * Writes the i-th smallest element to the buffer, starting at 0. Returns EXIT
+ * FAILURE if i is not less than the number of elements.
+ *
+ * Time complexity: O(log n) for AVL and small sets, O(n) for paged and arena
+ * sets
+ */
+int b_tree_set_select(BTreeSet *tree, size_t i, void *buffer);
+
+/**
+ * Returns the number of elements inside [lo, hi).
+ *
+ * Time complexity: O(log n) for AVL and small sets, O(n) for paged and arena
+ * sets
+ */
+size_t b_tree_set_count_range(BTreeSet *tree, void *lo, void *hi);
+
+/**
+ * Writes the element at the p-th percentile to the buffer, with p between 0
+ * and 100 and the nearest-rank method: the smallest element that is not less
+ * than p percent of all elements. Percentile 50 is the median. Returns EXIT
+ * FAILURE if the set is empty or p is out of range.
+ *
+ * Time complexity: O(log n) for AVL and small sets, O(n) for paged and arena
+ * sets
+ */
+int b_tree_set_percentile(BTreeSet *tree, double p, void *buffer);
+
+/**
+ * Walks both sets side by side in ascending order and pushes the elements
+ * selected by the operation to the vec, which stay in ascending order. Both
+ * sets must use the same element size and comperator as the vec.
+ *
+ * Time complexity: O(n + m)
+ */
+void b_tree_set_merge(BTreeSet *left, BTreeSet *right,
+                      BTreeSetOperation operation, Vec *out);
+
+/**
+ * Returns a new set with the elements that are in either set, or NULL if the
+ * set could not be allocated.
+ *
+ * Time complexity: O(n + m)
+ */
+BTreeSet *b_tree_set_union(BTreeSet *left, BTreeSet *right);
+
+/**
+ * Returns a new set with the elements that are in both sets, or NULL if the
+ * set could not be allocated.
+ *
+ * Time complexity: O(n + m)
+ */
+BTreeSet *b_tree_set_intersection(BTreeSet *left, BTreeSet *right);
+
+/**
+ * Returns a new set with the elements of the left set that are not in the
+ * right set, or NULL if the set could not be allocated.
+ *
+ * Time complexity: O(n + m)
+ */
+BTreeSet *b_tree_set_difference(BTreeSet *left, BTreeSet *right);
+
+/**
+ * Returns a new set with the elements that are in exactly one of the sets, or
+ * NULL if the set could not be allocated.
+ *
+ * Time complexity: O(n + m)
+ */
+BTreeSet *b_tree_set_symmetric_difference(BTreeSet *left, BTreeSet *right);
+
+/**
+ * Returns if every element of the left set is also in the right set. Stops at
+ * the first element that is missing.
+ *
+ * Time complexity: O(n + m)
+ */
+bool b_tree_set_is_subset(BTreeSet *left, BTreeSet *right);
+
+/**
+ * Returns if the sets have no element in common. Stops at the first element
+ * they share.
+ *
+ * Time complexity: O(n + m)
+ */
+bool b_tree_set_is_disjoint(BTreeSet *left, BTreeSet *right);
+
+/**
+ * Generates a set BTreeSetN of elements of type T, stored inline in the nodes.
+ * CMP is a function-like macro or a static inline function that takes two
+ * elements and follows the sign convention of a Comperator, for example
+ * COMPARE_ASCENDING. It is inlined into every level of the search instead of
+ * being called through a pointer.
+ */
+#define GENERATE_B_TREE_SET_H(N, T)                                            \
+  typedef struct BinaryNode##N {                                               \
+    T value;                                                                   \
+    struct BinaryNode##N *left;                                                \
+    struct BinaryNode##N *right;                                               \
+    size_t height;                                                             \
+  } BinaryNode##N;                                                             \
+  typedef struct {                                                             \
+    BinaryNode##N *root;                                                       \
+    size_t len;                                                                \
+  } BTreeSet##N;                                                               \
+  BTreeSet##N *b_tree_set_##N##_new();                                         \
+  void b_tree_set_##N##_free(BTreeSet##N *tree);                               \
+  int b_tree_set_##N##_add(BTreeSet##N *tree, T e);                            \
+  int b_tree_set_##N##_remove(BTreeSet##N *tree, T e);                         \
+  bool b_tree_set_##N##_contains(BTreeSet##N *tree, T e);                      \
+  size_t b_tree_set_##N##_len(BTreeSet##N *tree);                              \
+  void b_tree_set_##N##_clear(BTreeSet##N *tree);
+
+#define GENERATE_B_TREE_SET_C(N, T, CMP)                                       \
+  BinaryNode##N *binary_node##N##_new(T e) {                                   \
+    BinaryNode##N *created = malloc(sizeof(BinaryNode##N));                    \
+    if (!created)                                                              \
+      return NULL;                                                             \
+    created->value = e;                                                        \
+    created->left = NULL;                                                      \
+    created->right = NULL;                                                     \
+    created->height = 1;                                                       \
+    return created;                                                            \
+  }                                                                            \
+  void binary_node##N##_free(BinaryNode##N *node) {                            \
+    while (node) {                                                             \
+      if (node->left) {                                                        \
+        BinaryNode##N *left = node->left;                                      \
+        node->left = left->right;                                              \
+        left->right = node;                                                    \
+        node = left;                                                           \
+      } else {                                                                 \
+        BinaryNode##N *right = node->right;                                    \
+        free(node);                                                            \
+        node = right;                                                          \
+      }                                                                        \
+    }                                                                          \
+  }                                                                            \
+  size_t binary_node##N##_height(BinaryNode##N *node) {                        \
+    return node ? node->height : 0;                                            \
+  }                                                                            \
+  void binary_node##N##_update_height(BinaryNode##N *node) {                   \
+    size_t left = binary_node##N##_height(node->left);                         \
+    size_t right = binary_node##N##_height(node->right);                       \
+    node->height = (left > right ? left : right) + 1;                          \
+  }                                                                            \
+  int binary_node##N##_get_balance_factor(BinaryNode##N *node) {               \
+    return (int)binary_node##N##_height(node->left) -                          \
+           (int)binary_node##N##_height(node->right);                          \
+  }                                                                            \
+  BinaryNode##N *binary_node##N##_rotate_right(BinaryNode##N *node) {          \
+    BinaryNode##N *left = node->left;                                          \
+    node->left = left->right;                                                  \
+    left->right = node;                                                        \
+    binary_node##N##_update_height(node);                                      \
+    binary_node##N##_update_height(left);                                      \
+    return left;                                                               \
+  }                                                                            \
+  BinaryNode##N *binary_node##N##_rotate_left(BinaryNode##N *node) {           \
+    BinaryNode##N *right = node->right;                                        \
+    node->right = right->left;                                                 \
+    right->left = node;                                                        \
+    binary_node##N##_update_height(node);                                      \
+    binary_node##N##_update_height(right);                                     \
+    return right;                                                              \
+  }                                                                            \
+  BinaryNode##N *binary_node##N##_rebalance(BinaryNode##N *node) {             \
+    binary_node##N##_update_height(node);                                      \
+    int balance_factor = binary_node##N##_get_balance_factor(node);            \
+    if (balance_factor > 1) {                                                  \
+      if (binary_node##N##_get_balance_factor(node->left) < 0)                 \
+        node->left = binary_node##N##_rotate_left(node->left);                 \
+      return binary_node##N##_rotate_right(node);                              \
+    } else if (balance_factor < -1) {                                          \
+      if (binary_node##N##_get_balance_factor(node->right) > 0)                \
+        node->right = binary_node##N##_rotate_right(node->right);              \
+      return binary_node##N##_rotate_left(node);                               \
+    }                                                                          \
+    return node;                                                               \
+  }                                                                            \
+  void binary_node##N##_rebalance_path(BinaryNode##N ***path, size_t depth) {  \
+    while (depth > 0) {                                                        \
+      BinaryNode##N **link = path[--depth];                                    \
+      size_t height = (*link)->height;                                         \
+      *link = binary_node##N##_rebalance(*link);                               \
+      if ((*link)->height == height)                                           \
+        break;                                                                 \
+    }                                                                          \
+  }                                                                            \
+  BTreeSet##N *b_tree_set_##N##_new() {                                        \
+    BTreeSet##N *created = malloc(sizeof(BTreeSet##N));                        \
+    if (!created)                                                              \
+      return NULL;                                                             \
+    created->root = NULL;                                                      \
+    created->len = 0;                                                          \
+    return created;                                                            \
+  }                                                                            \
+  void b_tree_set_##N##_free(BTreeSet##N *tree) {                              \
+    binary_node##N##_free(tree->root);                                         \
+    free(tree);                                                                \
+  }                                                                            \
+  int b_tree_set_##N##_add(BTreeSet##N *tree, T e) {                           \
+    BinaryNode##N **path[B_TREE_SET_MAX_HEIGHT];                               \
+    size_t depth = 0;                                                          \
+    BinaryNode##N **link = &(tree->root);                                      \
+    while (*link) {                                                            \
+      int c = CMP((*link)->value, e);                                          \
+      if (c == 0)                                                              \
+        return EXIT_SUCCESS;                                                   \
+      path[depth++] = link;                                                    \
+      link = (c > 0) ? &((*link)->right) : &((*link)->left);                   \
+    }                                                                          \
+    *link = binary_node##N##_new(e);                                           \
+    if (*link == NULL)                                                         \
+      return EXIT_FAILURE;                                                     \
+    tree->len++;                                                               \
+    binary_node##N##_rebalance_path(path, depth);                              \
+    return EXIT_SUCCESS;                                                       \
+  }                                                                            \
+  int b_tree_set_##N##_remove(BTreeSet##N *tree, T e) {                        \
+    BinaryNode##N **path[B_TREE_SET_MAX_HEIGHT];                               \
+    size_t depth = 0;                                                          \
+    BinaryNode##N **link = &(tree->root);                                      \
+    while (*link) {                                                            \
+      int c = CMP((*link)->value, e);                                          \
+      if (c == 0)                                                              \
+        break;                                                                 \
+      path[depth++] = link;                                                    \
+      link = (c > 0) ? &((*link)->right) : &((*link)->left);                   \
+    }                                                                          \
+    BinaryNode##N *node = *link;                                               \
+    if (node == NULL)                                                          \
+      return EXIT_FAILURE;                                                     \
+    if (node->left && node->right) {                                           \
+      path[depth++] = link;                                                    \
+      link = &(node->right);                                                   \
+      while ((*link)->left) {                                                  \
+        path[depth++] = link;                                                  \
+        link = &((*link)->left);                                               \
+      }                                                                        \
+      node->value = (*link)->value;                                            \
+      node = *link;                                                            \
+    }                                                                          \
+    *link = node->left ? node->left : node->right;                             \
+    free(node);                                                                \
+    tree->len--;                                                               \
+    binary_node##N##_rebalance_path(path, depth);                              \
+    return EXIT_SUCCESS;                                                       \
+  }                                                                            \
+  bool b_tree_set_##N##_contains(BTreeSet##N *tree, T e) {                     \
+    BinaryNode##N *node = tree->root;                                          \
+    while (node) {                                                             \
+      int c = CMP(node->value, e);                                             \
+      if (c == 0)                                                              \
+        return true;                                                           \
+      node = (c > 0) ? node->right : node->left;                               \
+    }                                                                          \
+    return false;                                                              \
+  }                                                                            \
+  size_t b_tree_set_##N##_len(BTreeSet##N *tree) { return tree->len; }         \
+  void b_tree_set_##N##_clear(BTreeSet##N *tree) {                             \
+    binary_node##N##_free(tree->root);                                         \
+    tree->root = NULL;                                                         \
+    tree->len = 0;                                                             \
+  }
+
 #endif
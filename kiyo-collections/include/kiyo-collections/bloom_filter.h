@@ -0,0 +1,73 @@
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+
+#include "functions.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/* Number of 64 bit words in a block, a block fills one cache line. */
+#define BLOOM_FILTER_BLOCK_WORDS 8
+
+/* Bits reserved per expected element, at most about 0.1% false positives. */
+#define BLOOM_FILTER_BITS_PER_ELEMENT 16
+
+/**
+ * Blocked Bloom filter over elements of a fixed size. Every element sets one
+ * bit in each word of a single block, so a lookup touches exactly one cache
+ * line and the eight word probes are independent of each other. The filter
+ * answers if an element may have been added: there are no false negatives,
+ * but an element that was never added is reported with a small probability.
+ * Elements cannot be removed.
+ */
+typedef struct {
+  /* Blocks of BLOOM_FILTER_BLOCK_WORDS words, aligned to a cache line. */
+  uint64_t *blocks;
+  /* Number of blocks, always a power of two. */
+  size_t block_count;
+  /* Number of adds since the last clear, duplicates included. */
+  size_t len;
+  size_t element_size;
+  /* Hashes an element, NULL hashes its element size bytes. */
+  Hasher hasher;
+} BloomFilter;
+
+/**
+ * Creates and returns a new empty filter sized for the expected number of
+ * elements. More elements can be added at the cost of more false positives.
+ * Equal elements must have equal hashes. Without a hasher, elements are
+ * hashed by their bytes, which only works if equal elements have equal bytes.
+ */
+BloomFilter *bloom_filter_new(size_t element_size, Hasher hasher,
+                              size_t capacity);
+
+void bloom_filter_free(BloomFilter *filter);
+
+/**
+ * Adds the element to the filter.
+ *
+ * Time complexity: O(1)
+ */
+void bloom_filter_add(BloomFilter *filter, void *e);
+
+/**
+ * Returns false if the element was certainly never added, true if it may have
+ * been added.
+ *
+ * Time complexity: O(1)
+ */
+bool bloom_filter_contains(BloomFilter *filter, void *e);
+
+/* Adds an element by its precomputed hash. */
+void bloom_filter_add_hash(BloomFilter *filter, uint64_t hash);
+
+/* Checks an element by its precomputed hash, like bloom_filter_contains. */
+bool bloom_filter_contains_hash(BloomFilter *filter, uint64_t hash);
+
+size_t bloom_filter_len(BloomFilter *filter);
+
+/* Removes all elements but keeps the size of the filter. */
+void bloom_filter_clear(BloomFilter *filter);
+
+#endif
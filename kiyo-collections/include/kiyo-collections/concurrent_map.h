@@ -0,0 +1,92 @@
+#ifndef CONCURRENT_MAP_H
+#define CONCURRENT_MAP_H
+
+#include "functions.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Shard of a concurrent map, a hash map guarded by a reader-writer lock. */
+typedef struct ConcurrentShard ConcurrentShard;
+
+/**
+ * Hash map that can be used from many threads at once. The keys are
+ * partitioned across independently locked shards by their hash. Lookups only
+ * take the read lock of their shard, so they never block each other, and
+ * writes only block the lookups of the same shard.
+ */
+typedef struct {
+  ConcurrentShard *shards;
+  /* Number of shards, a power of two. */
+  size_t shard_count;
+  Hasher hasher;
+} ConcurrentMap;
+
+/* Number of shards used if 0 is passed to concurrent_map_new. */
+#define CONCURRENT_MAP_DEFAULT_SHARDS 16
+
+/**
+ * Creates and returns a new empty map with at least the given number of
+ * shards, rounded up to a power of two. More shards than threads keep
+ * writers from contending on the same lock.
+ */
+ConcurrentMap *concurrent_map_new(size_t key_size, size_t value_size,
+                                  Hasher hasher, Comperator comperator,
+                                  size_t shards);
+
+/* Frees all shards and then the map itself. No thread may use the map. */
+void concurrent_map_free(ConcurrentMap *map);
+
+/**
+ * Inserts the key with the given value or overwrites the value if the key is
+ * already present. Returns EXIT FAILURE if the shard could not be grown, EXIT
+ * SUCCESS otherwise.
+ *
+ * Time complexity: O(1) amortized
+ */
+int concurrent_map_put(ConcurrentMap *map, void *k, void *v);
+
+/**
+ * If the key is present, writes its value to the buffer and returns EXIT
+ * SUCCESS. Otherwise returns EXIT FAILURE.
+ *
+ * Time complexity: O(1)
+ */
+int concurrent_map_get(ConcurrentMap *map, void *k, void *v);
+
+/**
+ * Removes the key and its value. Returns EXIT FAILURE if the key was not
+ * present, EXIT SUCCESS otherwise.
+ *
+ * Time complexity: O(1)
+ */
+int concurrent_map_remove(ConcurrentMap *map, void *k);
+
+/**
+ * Returns if the key is present in the map.
+ *
+ * Time complexity: O(1)
+ */
+bool concurrent_map_contains_key(ConcurrentMap *map, void *k);
+
+/**
+ * If the key is absent, calls the factory with the key and a buffer for the
+ * value and inserts the value the factory wrote to it. Then writes the value of
+ * the key to v. The lookup and the insert happen atomically, so the factory is
+ * called at most once per key even if many threads race for it. The factory
+ * runs while the shard is locked and must not use the map. Returns EXIT
+ * FAILURE if the value could not be inserted.
+ *
+ * Time complexity: O(1) amortized
+ */
+int concurrent_map_compute_if_absent(ConcurrentMap *map, void *k,
+                                     BiConsumer factory, void *v);
+
+/**
+ * Returns the number of entries. Other threads may change it while the shards
+ * are counted one after another.
+ *
+ * Time complexity: O(s)
+ */
+size_t concurrent_map_len(ConcurrentMap *map);
+
+#endif
@@ -0,0 +1,203 @@
+#ifndef FLAT_MAP_H
+#define FLAT_MAP_H
+
+#include "functions.h"
+#include "vec.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Ordered map that keeps its keys sorted in one vec and the values in a second
+ * vec in the same order, without any per entry allocation. Lookups are binary
+ * searches over the contiguous keys and a range of entries is a slice of both
+ * vecs. Single inserts and removals shift the entries behind them, so the map
+ * suits tables that are read often and updated in batches: flat_map_buffer
+ * collects new entries and flat_map_flush sorts and merges them in at once.
+ */
+typedef struct {
+  /* Keys in ascending order. */
+  Vec keys;
+  /* Values in the order of their keys. */
+  Vec values;
+  /**
+   * Buffered entries that are not merged in yet, in the order they were added.
+   * Every record holds a key followed by its value at value_offset.
+   */
+  Vec pending;
+  size_t value_offset;
+  Comperator comperator;
+} FlatMap;
+
+/**
+ * Iterator over the entries of a flat map in ascending order. It is
+ * invalidated by any modification of the map.
+ */
+typedef struct {
+  FlatMap *map;
+  size_t index;
+} FlatMapIter;
+
+/* Creates and returns a new empty flat map, or NULL if allocation failed. */
+FlatMap *flat_map_new(size_t key_size, size_t value_size,
+                      Comperator comperator);
+
+void flat_map_free(FlatMap *map);
+
+/**
+ * Makes room for n entries, so that inserts up to that size do not allocate.
+ * Returns EXIT FAILURE if the vecs could not grow, EXIT SUCCESS otherwise.
+ *
+ * Time complexity: O(n)
+ */
+int flat_map_reserve(FlatMap *map, size_t n);
+
+/**
+ * Inserts the key with the given value or overwrites the value if the key is
+ * already present. The value is ignored if the value size is 0. Buffered
+ * entries are flushed first. Returns EXIT FAILURE if an allocation failed,
+ * EXIT SUCCESS otherwise.
+ *
+ * Time complexity: O(n)
+ */
+int flat_map_put(FlatMap *map, void *k, void *v);
+
+/**
+ * Adds the entry to the buffer without touching the sorted entries. Buffered
+ * entries are not visible to lookups until they are merged in by
+ * flat_map_flush, which put and remove do first as well. If a key is buffered
+ * more than once, the last value wins. Returns EXIT FAILURE if the buffer
+ * could not grow, EXIT SUCCESS otherwise.
+ *
+ * Time complexity: O(1) amortized
+ */
+int flat_map_buffer(FlatMap *map, void *k, void *v);
+
+/**
+ * Sorts the buffered entries and merges them into the sorted entries in place,
+ * from the back, in a single pass. Buffered values replace the values of keys
+ * that are already present. Returns EXIT FAILURE if an allocation failed, in
+ * which case the map and the buffer are unchanged.
+ *
+ * Time complexity: O(m log m + n)
+ */
+int flat_map_flush(FlatMap *map);
+
+/**
+ * If the key is present, writes its value to the buffer and returns EXIT
+ * SUCCESS. Otherwise returns EXIT FAILURE.
+ *
+ * Time complexity: O(log n)
+ */
+int flat_map_get(FlatMap *map, void *k, void *v);
+
+/**
+ * Returns a pointer to the stored value of the key, or NULL if the key is not
+ * present. The pointer stays valid until the map is modified.
+ *
+ * Time complexity: O(log n)
+ */
+void *flat_map_get_ptr(FlatMap *map, void *k);
+
+/**
+ * Removes the key and its value. Buffered entries are flushed first. Returns
+ * EXIT FAILURE if the key was not present or the flush failed, EXIT SUCCESS
+ * otherwise.
+ *
+ * Time complexity: O(n)
+ */
+int flat_map_remove(FlatMap *map, void *k);
+
+/**
+ * Returns if the key is present in the map.
+ *
+ * Time complexity: O(log n)
+ */
+bool flat_map_contains_key(FlatMap *map, void *k);
+
+/* Returns the number of sorted entries, buffered entries are not counted. */
+size_t flat_map_len(FlatMap *map);
+
+/* Removes all entries, including the buffered ones. */
+void flat_map_clear(FlatMap *map);
+
+/* Positions the iterator before the smallest entry of the map. */
+void flat_map_iter(FlatMap *map, FlatMapIter *iter);
+
+/**
+ * Positions the iterator before the smallest entry whose key is not less than
+ * k.
+ *
+ * Time complexity: O(log n)
+ */
+void flat_map_iter_from(FlatMap *map, FlatMapIter *iter, void *k);
+
+/**
+ * If there is no entry left, returns false. Otherwise writes pointers to the
+ * key and the value of the next entry in ascending order to k and v and
+ * returns true.
+ *
+ * Time complexity: O(1)
+ */
+bool flat_map_iter_next(FlatMapIter *iter, void **k, void **v);
+
+/**
+ * If the map is empty, returns EXIT FAILURE. Otherwise writes the smallest
+ * key and its value to the buffers and returns EXIT SUCCESS. Either buffer may
+ * be NULL.
+ *
+ * Time complexity: O(1)
+ */
+int flat_map_first(FlatMap *map, void *buffer_k, void *buffer_v);
+
+/**
+ * If the map is empty, returns EXIT FAILURE. Otherwise writes the largest key
+ * and its value to the buffers and returns EXIT SUCCESS. Either buffer may be
+ * NULL.
+ *
+ * Time complexity: O(1)
+ */
+int flat_map_last(FlatMap *map, void *buffer_k, void *buffer_v);
+
+/**
+ * Writes the largest key that is not greater than k and its value to the
+ * buffers. Returns EXIT FAILURE if there is no such key.
+ *
+ * Time complexity: O(log n)
+ */
+int flat_map_floor(FlatMap *map, void *k, void *buffer_k, void *buffer_v);
+
+/**
+ * Writes the smallest key that is not less than k and its value to the
+ * buffers. Returns EXIT FAILURE if there is no such key.
+ *
+ * Time complexity: O(log n)
+ */
+int flat_map_ceiling(FlatMap *map, void *k, void *buffer_k, void *buffer_v);
+
+/**
+ * Writes pointers to the first key and the first value of the entries whose
+ * keys lie inside [lo, hi) to keys and values and returns their number. The
+ * entries are contiguous, so they can be read as two arrays without copying.
+ * Either pointer may be NULL. The slices stay valid until the map is modified.
+ *
+ * Time complexity: O(log n)
+ */
+size_t flat_map_range(FlatMap *map, void *lo, void *hi, void **keys,
+                      void **values);
+
+/**
+ * Returns the number of keys that are less than k.
+ *
+ * Time complexity: O(log n)
+ */
+size_t flat_map_rank(FlatMap *map, void *k);
+
+/**
+ * Writes the entry with the i-th smallest key to the buffers, starting at 0.
+ * Returns EXIT FAILURE if i is not less than the number of entries.
+ *
+ * Time complexity: O(1)
+ */
+int flat_map_select(FlatMap *map, size_t i, void *buffer_k, void *buffer_v);
+
+#endif
@@ -0,0 +1,158 @@
+#ifndef FLAT_SET_H
+#define FLAT_SET_H
+
+#include "flat_map.h"
+#include "functions.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Ordered set stored as a flat map whose values have a size of 0. The elements
+ * are kept sorted in a single vec, new elements can be buffered and merged in
+ * at once with flat_set_flush.
+ */
+typedef struct {
+  FlatMap *table;
+} FlatSet;
+
+/* Iterator over the elements of a flat set in ascending order. */
+typedef struct {
+  FlatMapIter inner;
+} FlatSetIter;
+
+/* Creates and returns a new empty flat set, or NULL if allocation failed. */
+FlatSet *flat_set_new(size_t element_size, Comperator comperator);
+
+void flat_set_free(FlatSet *set);
+
+/**
+ * Makes room for n elements. Returns EXIT FAILURE if the vec could not grow,
+ * EXIT SUCCESS otherwise.
+ *
+ * Time complexity: O(n)
+ */
+int flat_set_reserve(FlatSet *set, size_t n);
+
+/**
+ * Inserts the element if it is not present yet. Buffered elements are flushed
+ * first. Returns EXIT FAILURE if an allocation failed, EXIT SUCCESS otherwise.
+ *
+ * Time complexity: O(n)
+ */
+int flat_set_add(FlatSet *set, void *e);
+
+/**
+ * Adds the element to the buffer. Buffered elements are not visible to
+ * lookups until flat_set_flush merges them in. Returns EXIT FAILURE if the
+ * buffer could not grow, EXIT SUCCESS otherwise.
+ *
+ * Time complexity: O(1) amortized
+ */
+int flat_set_buffer(FlatSet *set, void *e);
+
+/**
+ * Sorts the buffered elements and merges them into the set in a single pass.
+ * Returns EXIT FAILURE if an allocation failed, in which case the set and the
+ * buffer are unchanged.
+ *
+ * Time complexity: O(m log m + n)
+ */
+int flat_set_flush(FlatSet *set);
+
+/**
+ * Removes the element. Buffered elements are flushed first. Returns EXIT
+ * FAILURE if the element was not present or the flush failed, EXIT SUCCESS
+ * otherwise.
+ *
+ * Time complexity: O(n)
+ */
+int flat_set_remove(FlatSet *set, void *e);
+
+/**
+ * Returns if the element is present in the set.
+ *
+ * Time complexity: O(log n)
+ */
+bool flat_set_contains(FlatSet *set, void *e);
+
+/* Returns the number of sorted elements, buffered ones are not counted. */
+size_t flat_set_len(FlatSet *set);
+
+/* Removes all elements, including the buffered ones. */
+void flat_set_clear(FlatSet *set);
+
+/* Positions the iterator before the smallest element of the set. */
+void flat_set_iter(FlatSet *set, FlatSetIter *iter);
+
+/**
+ * Positions the iterator before the smallest element that is not less than e.
+ *
+ * Time complexity: O(log n)
+ */
+void flat_set_iter_from(FlatSet *set, FlatSetIter *iter, void *e);
+
+/**
+ * If there is no element left, returns false. Otherwise writes a pointer to
+ * the next element in ascending order to e and returns true.
+ *
+ * Time complexity: O(1)
+ */
+bool flat_set_iter_next(FlatSetIter *iter, void **e);
+
+/**
+ * Writes the smallest element to the buffer. Returns EXIT FAILURE if the set
+ * is empty.
+ *
+ * Time complexity: O(1)
+ */
+int flat_set_first(FlatSet *set, void *buffer);
+
+/**
+ * Writes the largest element to the buffer. Returns EXIT FAILURE if the set is
+ * empty.
+ *
+ * Time complexity: O(1)
+ */
+int flat_set_last(FlatSet *set, void *buffer);
+
+/**
+ * Writes the largest element that is not greater than e to the buffer.
+ * Returns EXIT FAILURE if there is no such element.
+ *
+ * Time complexity: O(log n)
+ */
+int flat_set_floor(FlatSet *set, void *e, void *buffer);
+
+/**
+ * Writes the smallest element that is not less than e to the buffer. Returns
+ * EXIT FAILURE if there is no such element.
+ *
+ * Time complexity: O(log n)
+ */
+int flat_set_ceiling(FlatSet *set, void *e, void *buffer);
+
+/**
+ * Writes a pointer to the first element inside [lo, hi) to elements and
+ * returns the number of elements in the range, which follow each other
+ * contiguously. The slice stays valid until the set is modified.
+ *
+ * Time complexity: O(log n)
+ */
+size_t flat_set_range(FlatSet *set, void *lo, void *hi, void **elements);
+
+/**
+ * Returns the number of elements that are less than e.
+ *
+ * Time complexity: O(log n)
+ */
+size_t flat_set_rank(FlatSet *set, void *e);
+
+/**
+ * Writes the i-th smallest element to the buffer, starting at 0. Returns EXIT
+ * FAILURE if i is not less than the number of elements.
+ *
+ * Time complexity: O(1)
+ */
+int flat_set_select(FlatSet *set, size_t i, void *buffer);
+
+#endif
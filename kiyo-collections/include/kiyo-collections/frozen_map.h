@@ -0,0 +1,125 @@
+#ifndef FROZEN_MAP_H
+#define FROZEN_MAP_H
+
+#include "b_tree_map.h"
+#include "functions.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Header at the start of the data of a frozen map. Keys follow the header,
+ * values follow the keys, both aligned to the maximum alignment.
+ */
+typedef struct {
+  char magic[8];
+  uint64_t len;
+  uint64_t key_size;
+  uint64_t value_size;
+} FrozenHeader;
+
+/**
+ * Immutable ordered map stored in a single contiguous block. The keys are laid
+ * out in Eytzinger order, the breadth first order of a complete binary search
+ * tree, so the first levels of every search share a few cache lines and the
+ * next levels can be prefetched. Slot 0 is unused, the children of slot i are
+ * 2i and 2i + 1. The block contains no pointers and can be written to a file
+ * and mapped back in on the same architecture.
+ */
+typedef struct {
+  /* Header followed by the keys and values. */
+  void *data;
+  /* Size of data in bytes. */
+  size_t size;
+  size_t len;
+  size_t key_size;
+  size_t value_size;
+  char *keys;
+  char *values;
+  Comperator comperator;
+  /* If data was allocated by the map and is freed with it. */
+  bool owned;
+} FrozenMap;
+
+/**
+ * Creates a frozen copy of the map. The entries are written in one in-order
+ * walk. Works for AVL, paged and arena maps. Returns NULL if an allocation
+ * failed or the map has no comperator, like maps with byte string keys.
+ *
+ * Time complexity: O(n)
+ */
+FrozenMap *b_tree_map_freeze(BTreeMap *tree);
+
+/**
+ * Creates a frozen map with room for len entries, whose slots still have to
+ * be filled in order with frozen_map_first_slot and frozen_map_next_slot.
+ * Returns NULL if an allocation failed.
+ */
+FrozenMap *frozen_map_alloc(size_t len, size_t key_size, size_t value_size,
+                            Comperator comperator);
+
+/* Returns the slot of the smallest key of a frozen map with len entries. */
+size_t frozen_map_first_slot(size_t len);
+
+/**
+ * Returns the slot that follows slot i in key order, 0 after the largest key.
+ *
+ * Time complexity: O(1) amortized
+ */
+size_t frozen_map_next_slot(size_t i, size_t len);
+
+/**
+ * Creates a frozen map that reads from data, which must have been produced by
+ * frozen_map_data of a map with the same key and value types and stay valid
+ * while the frozen map is used, for example a mapped file. Nothing is copied.
+ * Returns NULL if the data is not a frozen map.
+ *
+ * Time complexity: O(1)
+ */
+FrozenMap *frozen_map_view(void *data, size_t size, Comperator comperator);
+
+/* Frees the map, and its data if the map allocated it. */
+void frozen_map_free(FrozenMap *map);
+
+/* Returns the contiguous data of the map, frozen_map_size bytes long. */
+void *frozen_map_data(FrozenMap *map);
+
+/* Returns the number of bytes of the data of the map. */
+size_t frozen_map_size(FrozenMap *map);
+
+size_t frozen_map_len(FrozenMap *map);
+
+/**
+ * Returns the slot of the smallest key that is not less than k, 0 if there is
+ * no such key. The search descends without branching on the comparison and
+ * prefetches the slots four levels below.
+ *
+ * Time complexity: O(log n)
+ */
+size_t frozen_map_search(FrozenMap *map, void *k);
+
+/**
+ * If the key is present, writes its value to the buffer and returns EXIT
+ * SUCCESS. Otherwise returns EXIT FAILURE.
+ *
+ * Time complexity: O(log n)
+ */
+int frozen_map_get(FrozenMap *map, void *k, void *v);
+
+/**
+ * Returns if the key is present in the map.
+ *
+ * Time complexity: O(log n)
+ */
+bool frozen_map_contains_key(FrozenMap *map, void *k);
+
+/**
+ * Writes the entry with the smallest key that is not less than k to the
+ * buffers. Returns EXIT FAILURE if there is no such key.
+ *
+ * Time complexity: O(log n)
+ */
+int frozen_map_lower_bound(FrozenMap *map, void *k, void *buffer_k,
+                           void *buffer_v);
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef FROZEN_SET_H
+#define FROZEN_SET_H
+
+#include "b_tree_set.h"
+#include "frozen_map.h"
+#include "functions.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Immutable ordered set stored as a frozen map whose values have a size of 0.
+ * The elements are laid out in Eytzinger order in a single contiguous block,
+ * which can be written to a file and mapped back in.
+ */
+typedef struct {
+  FrozenMap *table;
+} FrozenSet;
+
+/**
+ * Creates a frozen copy of the set. The elements are written in one in-order
+ * walk. Works for AVL and paged sets. Returns NULL if an allocation failed.
+ *
+ * Time complexity: O(n)
+ */
+FrozenSet *b_tree_set_freeze(BTreeSet *tree);
+
+/**
+ * Creates a frozen set that reads from data produced by frozen_set_data,
+ * without copying it. Returns NULL if the data is not a frozen set.
+ *
+ * Time complexity: O(1)
+ */
+FrozenSet *frozen_set_view(void *data, size_t size, Comperator comperator);
+
+/* Frees the set, and its data if the set allocated it. */
+void frozen_set_free(FrozenSet *set);
+
+/* Returns the contiguous data of the set, frozen_set_size bytes long. */
+void *frozen_set_data(FrozenSet *set);
+
+/* Returns the number of bytes of the data of the set. */
+size_t frozen_set_size(FrozenSet *set);
+
+size_t frozen_set_len(FrozenSet *set);
+
+/**
+ * Returns if the element is present in the set.
+ *
+ * Time complexity: O(log n)
+ */
+bool frozen_set_contains(FrozenSet *set, void *e);
+
+/**
+ * Writes the smallest element that is not less than e to the buffer. Returns
+ * EXIT FAILURE if there is no such element.
+ *
+ * Time complexity: O(log n)
+ */
+int frozen_set_lower_bound(FrozenSet *set, void *e, void *buffer);
+
+#endif
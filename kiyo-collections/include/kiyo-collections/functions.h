@@ -2,11 +2,25 @@
 #define FUNCTIONS_H
 
 #include <stdbool.h>
+#include <stddef.h>
 
 typedef int (*Comperator)(void *, void *);
 
+/* Returns the hash of the key, equal keys must have equal hashes. */
+typedef size_t (*Hasher)(void *);
+
 typedef void (*Consumer)(void *);
 
+typedef void (*BiConsumer)(void *, void *);
+
 typedef bool (*Test)(void *);
 
+/**
+ * Three-way comparison of two scalar values with the sign convention of a
+ * Comperator: positive if a is less than b, negative if a is greater than b
+ * and 0 if they are equal. Meant as the CMP argument of the typed collection
+ * generators, it never overflows like a subtraction would.
+ */
+#define COMPARE_ASCENDING(a, b) (((a) < (b)) - ((a) > (b)))
+
 #endif
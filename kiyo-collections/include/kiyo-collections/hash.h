@@ -0,0 +1,34 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Mixes all bits of x into every bit of the result. Small and sequential
+ * integers become well distributed hashes.
+ *
+ * Time complexity: O(1)
+ */
+uint64_t hash_mix64(uint64_t x);
+
+/**
+ * Hashes len bytes, reading eight bytes at a time.
+ *
+ * Time complexity: O(n)
+ */
+uint64_t hash_bytes(const void *data, size_t len);
+
+/* Hasher for keys of type int. */
+size_t hash_int(void *k);
+
+/* Hasher for keys of type uint32_t. */
+size_t hash_u32(void *k);
+
+/* Hasher for keys of type uint64_t. */
+size_t hash_u64(void *k);
+
+/* Hasher for keys of type char *, hashes the string the key points to. */
+size_t hash_cstr(void *k);
+
+#endif
@@ -0,0 +1,348 @@
+#ifndef HASH_MAP_H
+#define HASH_MAP_H
+
+#include "functions.h"
+#include "hash.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Number of control bytes that are matched at once. */
+#define HASH_GROUP_WIDTH 16
+
+/* Control byte of a slot that was never used. */
+#define HASH_CTRL_EMPTY ((int8_t)-128)
+
+/* Control byte of a slot whose entry was removed. */
+#define HASH_CTRL_DELETED ((int8_t)-2)
+
+/**
+ * Hash map with open addressing. Every slot has a control byte that is either
+ * empty, deleted or holds the low 7 bits of the hash of its key. A lookup
+ * compares the control bytes of a whole group of slots at once, with SSE2 if
+ * available, and only compares the keys of the slots whose bits match.
+ * Keys and values are stored inline in the slots.
+ */
+typedef struct {
+  /* Control bytes, one per slot. Stored behind the slots, NULL if empty. */
+  int8_t *ctrl;
+  /* Array of slots, each holds a key followed by its value. */
+  void *slots;
+  /* Number of stored entries. */
+  size_t len;
+  /* Number of slots, 0 or a power of two of at least one group. */
+  size_t capacity;
+  /* Number of empty slots that may still be filled before growing. */
+  size_t growth_left;
+  size_t key_size;
+  size_t value_size;
+  /* Offset of the value inside a slot. */
+  size_t value_offset;
+  /* Size of a slot including padding. */
+  size_t slot_size;
+  Hasher hasher;
+  /* Only used to test keys for equality, which is a result of 0. */
+  Comperator comperator;
+} HashMap;
+
+/**
+ * Iterator over the entries of a hash map in slot order. It is invalidated by
+ * any modification of the map.
+ */
+typedef struct {
+  HashMap *map;
+  size_t index;
+} HashMapIter;
+
+/**
+ * Returns a bit for every control byte in the group that equals h2.
+ *
+ * Time complexity: O(1)
+ */
+uint32_t hash_group_match(int8_t *group, int8_t h2);
+
+/**
+ * Returns a bit for every empty control byte in the group.
+ *
+ * Time complexity: O(1)
+ */
+uint32_t hash_group_match_empty(int8_t *group);
+
+/**
+ * Returns a bit for every empty or deleted control byte in the group.
+ *
+ * Time complexity: O(1)
+ */
+uint32_t hash_group_match_free(int8_t *group);
+
+/* Returns the index of the lowest set bit of a non-zero mask. */
+unsigned hash_group_lowest(uint32_t mask);
+
+/**
+ * Returns the number of slots needed to store n entries without exceeding the
+ * maximum load factor of 7/8.
+ */
+size_t hash_capacity_for(size_t n);
+
+/**
+ * Returns the number of slots to resize to once a table with the given
+ * capacity and len entries runs out of empty slots. A table that is at most
+ * 25/32 full only drops its deleted slots and keeps its capacity, a fuller one
+ * doubles. Either way the next resize is at least capacity * 3/32 inserts away,
+ * so deleted slots cannot force a rehash on every insert.
+ *
+ * Time complexity: O(1)
+ */
+size_t hash_capacity_grow(size_t capacity, size_t len);
+
+/**
+ * Creates and returns a new empty hash map. No slots are allocated until the
+ * first entry is inserted.
+ */
+HashMap *hash_map_new(size_t key_size, size_t value_size, Hasher hasher,
+                      Comperator comperator);
+
+/* Frees all slots and then the map itself. */
+void hash_map_free(HashMap *map);
+
+/**
+ * Inserts the key with the given value or overwrites the value if the key is
+ * already present. Returns EXIT FAILURE if the slots could not be grown, EXIT
+ * SUCCESS otherwise.
+ *
+ * Time complexity: O(1) amortized
+ */
+int hash_map_put(HashMap *map, void *k, void *v);
+
+/**
+ * If the key is present, writes its value to the buffer and returns EXIT
+ * SUCCESS. Otherwise returns EXIT FAILURE.
+ *
+ * Time complexity: O(1)
+ */
+int hash_map_get(HashMap *map, void *k, void *v);
+
+/**
+ * Removes the key and its value. Returns EXIT FAILURE if the key was not
+ * present, EXIT SUCCESS otherwise.
+ *
+ * Time complexity: O(1)
+ */
+int hash_map_remove(HashMap *map, void *k);
+
+/**
+ * Returns if the key is present in the map.
+ *
+ * Time complexity: O(1)
+ */
+bool hash_map_contains_key(HashMap *map, void *k);
+
+size_t hash_map_len(HashMap *map);
+
+/**
+ * Removes all entries but keeps the slots for reuse.
+ *
+ * Time complexity: O(n)
+ */
+void hash_map_clear(HashMap *map);
+
+/**
+ * Grows the slots so that at least n entries fit without another resize.
+ * Returns EXIT FAILURE if the slots could not be allocated.
+ *
+ * Time complexity: O(n)
+ */
+int hash_map_reserve(HashMap *map, size_t n);
+
+/**
+ * Shrinks the slots to the smallest capacity that holds all entries, an empty
+ * map frees its slots. Returns EXIT FAILURE if the slots could not be
+ * allocated, the map is unchanged in that case.
+ *
+ * Time complexity: O(n)
+ */
+int hash_map_shrink_to_fit(HashMap *map);
+
+/* Positions the iterator before the first entry of the map. */
+void hash_map_iter(HashMap *map, HashMapIter *iter);
+
+/**
+ * If there is no entry left, returns false. Otherwise writes pointers to the
+ * key and the value of the next entry to k and v and returns true.
+ *
+ * Time complexity: O(1) amortized
+ */
+bool hash_map_iter_next(HashMapIter *iter, void **k, void **v);
+
+/**
+ * Generates a hash map HashMapN from keys of type K to values of type V. Slots
+ * are structs of K and V and are copied by assignment. HASH is a function-like
+ * macro or a static inline function that takes a key and returns its hash,
+ * for example hash_mix64. EQ takes two keys and returns if they are equal.
+ * Both are inlined into the probe loop.
+ */
+#define GENERATE_HASH_MAP_H(N, K, V)                                           \
+  typedef struct {                                                             \
+    K key;                                                                     \
+    V value;                                                                   \
+  } HashSlot##N;                                                               \
+  typedef struct {                                                             \
+    int8_t *ctrl;                                                              \
+    HashSlot##N *slots;                                                        \
+    size_t len;                                                                \
+    size_t capacity;                                                           \
+    size_t growth_left;                                                        \
+  } HashMap##N;                                                                \
+  HashMap##N *hash_map_##N##_new();                                            \
+  void hash_map_##N##_free(HashMap##N *map);                                   \
+  int hash_map_##N##_put(HashMap##N *map, K k, V v);                           \
+  int hash_map_##N##_get(HashMap##N *map, K k, V *buffer);                     \
+  int hash_map_##N##_remove(HashMap##N *map, K k);                             \
+  bool hash_map_##N##_contains_key(HashMap##N *map, K k);                      \
+  size_t hash_map_##N##_len(HashMap##N *map);                                  \
+  void hash_map_##N##_clear(HashMap##N *map);                                  \
+  int hash_map_##N##_reserve(HashMap##N *map, size_t n);                       \
+  int hash_map_##N##_shrink_to_fit(HashMap##N *map);
+
+#define GENERATE_HASH_MAP_C(N, K, V, HASH, EQ)                                 \
+  HashMap##N *hash_map_##N##_new() {                                           \
+    HashMap##N *created = malloc(sizeof(HashMap##N));                          \
+    if (!created)                                                              \
+      return NULL;                                                             \
+    created->ctrl = NULL;                                                      \
+    created->slots = NULL;                                                     \
+    created->len = 0;                                                          \
+    created->capacity = 0;                                                     \
+    created->growth_left = 0;                                                  \
+    return created;                                                            \
+  }                                                                            \
+  void hash_map_##N##_free(HashMap##N *map) {                                  \
+    free(map->slots);                                                          \
+    free(map);                                                                 \
+  }                                                                            \
+  HashSlot##N *hash_map_##N##_find(HashMap##N *map, K k) {                     \
+    if (map->capacity == 0)                                                    \
+      return NULL;                                                             \
+    size_t hash = HASH(k);                                                     \
+    int8_t h2 = (int8_t)(hash & 0x7F);                                         \
+    size_t groups = map->capacity / HASH_GROUP_WIDTH;                          \
+    size_t group = (hash >> 7) & (groups - 1);                                 \
+    for (size_t step = 1;; step++) {                                           \
+      int8_t *ctrl = map->ctrl + group * HASH_GROUP_WIDTH;                     \
+      uint32_t match = hash_group_match(ctrl, h2);                             \
+      while (match) {                                                          \
+        size_t i = group * HASH_GROUP_WIDTH + hash_group_lowest(match);        \
+        if (EQ(map->slots[i].key, k))                                          \
+          return &map->slots[i];                                               \
+        match &= match - 1;                                                    \
+      }                                                                        \
+      if (hash_group_match_empty(ctrl) || step >= groups)                      \
+        return NULL;                                                           \
+      group = (group + step) & (groups - 1);                                   \
+    }                                                                          \
+  }                                                                            \
+  size_t hash_map_##N##_find_free(int8_t *ctrl, size_t capacity,               \
+                                  size_t hash) {                               \
+    size_t groups = capacity / HASH_GROUP_WIDTH;                               \
+    size_t group = (hash >> 7) & (groups - 1);                                 \
+    for (size_t step = 1;; step++) {                                           \
+      uint32_t free_slots =                                                    \
+          hash_group_match_free(ctrl + group * HASH_GROUP_WIDTH);              \
+      if (free_slots)                                                          \
+        return group * HASH_GROUP_WIDTH + hash_group_lowest(free_slots);       \
+      group = (group + step) & (groups - 1);                                   \
+    }                                                                          \
+  }                                                                            \
+  int hash_map_##N##_resize(HashMap##N *map, size_t capacity) {                \
+    HashSlot##N *slots = NULL;                                                 \
+    int8_t *ctrl = NULL;                                                       \
+    if (capacity > 0) {                                                        \
+      slots = malloc(capacity * (sizeof(HashSlot##N) + 1));                    \
+      if (!slots)                                                              \
+        return EXIT_FAILURE;                                                   \
+      ctrl = (int8_t *)(slots + capacity);                                     \
+      memset(ctrl, HASH_CTRL_EMPTY, capacity);                                 \
+    }                                                                          \
+    for (size_t i = 0; i < map->capacity; i++) {                               \
+      if (map->ctrl[i] < 0)                                                    \
+        continue;                                                              \
+      size_t hash = HASH(map->slots[i].key);                                   \
+      size_t j = hash_map_##N##_find_free(ctrl, capacity, hash);               \
+      ctrl[j] = (int8_t)(hash & 0x7F);                                         \
+      slots[j] = map->slots[i];                                                \
+    }                                                                          \
+    free(map->slots);                                                          \
+    map->slots = slots;                                                        \
+    map->ctrl = ctrl;                                                          \
+    map->capacity = capacity;                                                  \
+    map->growth_left = capacity - capacity / 8 - map->len;                     \
+    return EXIT_SUCCESS;                                                       \
+  }                                                                            \
+  int hash_map_##N##_put(HashMap##N *map, K k, V v) {                          \
+    HashSlot##N *slot = hash_map_##N##_find(map, k);                           \
+    if (slot) {                                                                \
+      slot->value = v;                                                         \
+      return EXIT_SUCCESS;                                                     \
+    }                                                                          \
+    if (map->growth_left == 0 &&                                               \
+        hash_map_##N##_resize(                                                 \
+            map, hash_capacity_grow(map->capacity, map->len)) != EXIT_SUCCESS) \
+      return EXIT_FAILURE;                                                     \
+    size_t hash = HASH(k);                                                     \
+    size_t i = hash_map_##N##_find_free(map->ctrl, map->capacity, hash);       \
+    if (map->ctrl[i] == HASH_CTRL_EMPTY)                                       \
+      map->growth_left--;                                                      \
+    map->ctrl[i] = (int8_t)(hash & 0x7F);                                      \
+    map->slots[i].key = k;                                                     \
+    map->slots[i].value = v;                                                   \
+    map->len++;                                                                \
+    return EXIT_SUCCESS;                                                       \
+  }                                                                            \
+  int hash_map_##N##_get(HashMap##N *map, K k, V *buffer) {                    \
+    HashSlot##N *slot = hash_map_##N##_find(map, k);                           \
+    if (slot == NULL)                                                          \
+      return EXIT_FAILURE;                                                     \
+    *buffer = slot->value;                                                     \
+    return EXIT_SUCCESS;                                                       \
+  }                                                                            \
+  int hash_map_##N##_remove(HashMap##N *map, K k) {                            \
+    HashSlot##N *slot = hash_map_##N##_find(map, k);                           \
+    if (slot == NULL)                                                          \
+      return EXIT_FAILURE;                                                     \
+    size_t i = slot - map->slots;                                              \
+    int8_t *group = map->ctrl + i / HASH_GROUP_WIDTH * HASH_GROUP_WIDTH;       \
+    if (hash_group_match_empty(group)) {                                       \
+      map->ctrl[i] = HASH_CTRL_EMPTY;                                          \
+      map->growth_left++;                                                      \
+    } else {                                                                   \
+      map->ctrl[i] = HASH_CTRL_DELETED;                                        \
+    }                                                                          \
+    map->len--;                                                                \
+    return EXIT_SUCCESS;                                                       \
+  }                                                                            \
+  bool hash_map_##N##_contains_key(HashMap##N *map, K k) {                     \
+    return hash_map_##N##_find(map, k) != NULL;                                \
+  }                                                                            \
+  size_t hash_map_##N##_len(HashMap##N *map) { return map->len; }              \
+  void hash_map_##N##_clear(HashMap##N *map) {                                 \
+    if (map->capacity > 0)                                                     \
+      memset(map->ctrl, HASH_CTRL_EMPTY, map->capacity);                       \
+    map->len = 0;                                                              \
+    map->growth_left = map->capacity - map->capacity / 8;                      \
+  }                                                                            \
+  int hash_map_##N##_reserve(HashMap##N *map, size_t n) {                      \
+    size_t capacity = hash_capacity_for(n);                                    \
+    if (capacity <= map->capacity)                                             \
+      return EXIT_SUCCESS;                                                     \
+    return hash_map_##N##_resize(map, capacity);                               \
+  }                                                                            \
+  int hash_map_##N##_shrink_to_fit(HashMap##N *map) {                          \
+    size_t capacity = hash_capacity_for(map->len);                             \
+    if (capacity >= map->capacity)                                             \
+      return EXIT_SUCCESS;                                                     \
+    return hash_map_##N##_resize(map, capacity);                               \
+  }
+
+#endif
@@ -0,0 +1,232 @@
+#ifndef HASH_SET_H
+#define HASH_SET_H
+
+#include "functions.h"
+#include "hash_map.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Set without duplicates implemented as a hash map whose values have a size of
+ * 0, so the slots hold nothing but the elements.
+ */
+typedef struct {
+  HashMap *table;
+} HashSet;
+
+/**
+ * Iterator over the elements of a hash set in slot order. It is invalidated by
+ * any modification of the set.
+ */
+typedef struct {
+  HashMapIter inner;
+} HashSetIter;
+
+HashSet *hash_set_new(size_t element_size, Hasher hasher,
+                      Comperator comperator);
+
+void hash_set_free(HashSet *set);
+
+/**
+ * Adds the element if it is not already present. Returns EXIT FAILURE if the
+ * slots could not be grown, EXIT SUCCESS otherwise.
+ *
+ * Time complexity: O(1) amortized
+ */
+int hash_set_add(HashSet *set, void *e);
+
+/**
+ * Removes the element. Returns EXIT FAILURE if it was not present, EXIT
+ * SUCCESS otherwise.
+ *
+ * Time complexity: O(1)
+ */
+int hash_set_remove(HashSet *set, void *e);
+
+/**
+ * Returns if the element is present in the set.
+ *
+ * Time complexity: O(1)
+ */
+bool hash_set_contains(HashSet *set, void *e);
+
+size_t hash_set_len(HashSet *set);
+
+/* Removes all elements but keeps the slots for reuse. */
+void hash_set_clear(HashSet *set);
+
+/**
+ * Grows the slots so that at least n elements fit without another resize.
+ * Returns EXIT FAILURE if the slots could not be allocated.
+ */
+int hash_set_reserve(HashSet *set, size_t n);
+
+/**
+ * Shrinks the slots to the smallest capacity that holds all elements. Returns
+ * EXIT FAILURE if the slots could not be allocated.
+ */
+int hash_set_shrink_to_fit(HashSet *set);
+
+/* Positions the iterator before the first element of the set. */
+void hash_set_iter(HashSet *set, HashSetIter *iter);
+
+/**
+ * If there is no element left, returns false. Otherwise writes a pointer to
+ * the next element to e and returns true.
+ */
+bool hash_set_iter_next(HashSetIter *iter, void **e);
+
+/**
+ * Generates a hash set HashSetN of elements of type T, stored inline in the
+ * slots. HASH takes an element and returns its hash, EQ takes two elements and
+ * returns if they are equal. Both are inlined into the probe loop.
+ */
+#define GENERATE_HASH_SET_H(N, T)                                              \
+  typedef struct {                                                             \
+    int8_t *ctrl;                                                              \
+    T *slots;                                                                  \
+    size_t len;                                                                \
+    size_t capacity;                                                           \
+    size_t growth_left;                                                        \
+  } HashSet##N;                                                                \
+  HashSet##N *hash_set_##N##_new();                                            \
+  void hash_set_##N##_free(HashSet##N *set);                                   \
+  int hash_set_##N##_add(HashSet##N *set, T e);                                \
+  int hash_set_##N##_remove(HashSet##N *set, T e);                             \
+  bool hash_set_##N##_contains(HashSet##N *set, T e);                          \
+  size_t hash_set_##N##_len(HashSet##N *set);                                  \
+  void hash_set_##N##_clear(HashSet##N *set);                                  \
+  int hash_set_##N##_reserve(HashSet##N *set, size_t n);                       \
+  int hash_set_##N##_shrink_to_fit(HashSet##N *set);
+
+#define GENERATE_HASH_SET_C(N, T, HASH, EQ)                                    \
+  HashSet##N *hash_set_##N##_new() {                                           \
+    HashSet##N *created = malloc(sizeof(HashSet##N));                          \
+    if (!created)                                                              \
+      return NULL;                                                             \
+    created->ctrl = NULL;                                                      \
+    created->slots = NULL;                                                     \
+    created->len = 0;                                                          \
+    created->capacity = 0;                                                     \
+    created->growth_left = 0;                                                  \
+    return created;                                                            \
+  }                                                                            \
+  void hash_set_##N##_free(HashSet##N *set) {                                  \
+    free(set->slots);                                                          \
+    free(set);                                                                 \
+  }                                                                            \
+  size_t hash_set_##N##_find(HashSet##N *set, T e) {                           \
+    if (set->capacity == 0)                                                    \
+      return 0;                                                                \
+    size_t hash = HASH(e);                                                     \
+    int8_t h2 = (int8_t)(hash & 0x7F);                                         \
+    size_t groups = set->capacity / HASH_GROUP_WIDTH;                          \
+    size_t group = (hash >> 7) & (groups - 1);                                 \
+    for (size_t step = 1;; step++) {                                           \
+      int8_t *ctrl = set->ctrl + group * HASH_GROUP_WIDTH;                     \
+      uint32_t match = hash_group_match(ctrl, h2);                             \
+      while (match) {                                                          \
+        size_t i = group * HASH_GROUP_WIDTH + hash_group_lowest(match);        \
+        if (EQ(set->slots[i], e))                                              \
+          return i;                                                            \
+        match &= match - 1;                                                    \
+      }                                                                        \
+      if (hash_group_match_empty(ctrl) || step >= groups)                      \
+        return set->capacity;                                                  \
+      group = (group + step) & (groups - 1);                                   \
+    }                                                                          \
+  }                                                                            \
+  size_t hash_set_##N##_find_free(int8_t *ctrl, size_t capacity,               \
+                                  size_t hash) {                               \
+    size_t groups = capacity / HASH_GROUP_WIDTH;                               \
+    size_t group = (hash >> 7) & (groups - 1);                                 \
+    for (size_t step = 1;; step++) {                                           \
+      uint32_t free_slots =                                                    \
+          hash_group_match_free(ctrl + group * HASH_GROUP_WIDTH);              \
+      if (free_slots)                                                          \
+        return group * HASH_GROUP_WIDTH + hash_group_lowest(free_slots);       \
+      group = (group + step) & (groups - 1);                                   \
+    }                                                                          \
+  }                                                                            \
+  int hash_set_##N##_resize(HashSet##N *set, size_t capacity) {                \
+    T *slots = NULL;                                                           \
+    int8_t *ctrl = NULL;                                                       \
+    if (capacity > 0) {                                                        \
+      slots = malloc(capacity * (sizeof(T) + 1));                              \
+      if (!slots)                                                              \
+        return EXIT_FAILURE;                                                   \
+      ctrl = (int8_t *)(slots + capacity);                                     \
+      memset(ctrl, HASH_CTRL_EMPTY, capacity);                                 \
+    }                                                                          \
+    for (size_t i = 0; i < set->capacity; i++) {                               \
+      if (set->ctrl[i] < 0)                                                    \
+        continue;                                                              \
+      size_t hash = HASH(set->slots[i]);                                       \
+      size_t j = hash_set_##N##_find_free(ctrl, capacity, hash);               \
+      ctrl[j] = (int8_t)(hash & 0x7F);                                         \
+      slots[j] = set->slots[i];                                                \
+    }                                                                          \
+    free(set->slots);                                                          \
+    set->slots = slots;                                                        \
+    set->ctrl = ctrl;                                                          \
+    set->capacity = capacity;                                                  \
+    set->growth_left = capacity - capacity / 8 - set->len;                     \
+    return EXIT_SUCCESS;                                                       \
+  }                                                                            \
+  int hash_set_##N##_add(HashSet##N *set, T e) {                               \
+    if (hash_set_##N##_find(set, e) < set->capacity)                           \
+      return EXIT_SUCCESS;                                                     \
+    if (set->growth_left == 0 &&                                               \
+        hash_set_##N##_resize(                                                 \
+            set, hash_capacity_grow(set->capacity, set->len)) != EXIT_SUCCESS) \
+      return EXIT_FAILURE;                                                     \
+    size_t hash = HASH(e);                                                     \
+    size_t i = hash_set_##N##_find_free(set->ctrl, set->capacity, hash);       \
+    if (set->ctrl[i] == HASH_CTRL_EMPTY)                                       \
+      set->growth_left--;                                                      \
+    set->ctrl[i] = (int8_t)(hash & 0x7F);                                      \
+    set->slots[i] = e;                                                         \
+    set->len++;                                                                \
+    return EXIT_SUCCESS;                                                       \
+  }                                                                            \
+  int hash_set_##N##_remove(HashSet##N *set, T e) {                            \
+    size_t i = hash_set_##N##_find(set, e);                                    \
+    if (i >= set->capacity)                                                    \
+      return EXIT_FAILURE;                                                     \
+    int8_t *group = set->ctrl + i / HASH_GROUP_WIDTH * HASH_GROUP_WIDTH;       \
+    if (hash_group_match_empty(group)) {                                       \
+      set->ctrl[i] = HASH_CTRL_EMPTY;                                          \
+      set->growth_left++;                                                      \
+    } else {                                                                   \
+      set->ctrl[i] = HASH_CTRL_DELETED;                                        \
+    }                                                                          \
+    set->len--;                                                                \
+    return EXIT_SUCCESS;                                                       \
+  }                                                                            \
+  bool hash_set_##N##_contains(HashSet##N *set, T e) {                         \
+    return hash_set_##N##_find(set, e) < set->capacity;                        \
+  }                                                                            \
+  size_t hash_set_##N##_len(HashSet##N *set) { return set->len; }              \
+  void hash_set_##N##_clear(HashSet##N *set) {                                 \
+    if (set->capacity > 0)                                                     \
+      memset(set->ctrl, HASH_CTRL_EMPTY, set->capacity);                       \
+    set->len = 0;                                                              \
+    set->growth_left = set->capacity - set->capacity / 8;                      \
+  }                                                                            \
+  int hash_set_##N##_reserve(HashSet##N *set, size_t n) {                      \
+    size_t capacity = hash_capacity_for(n);                                    \
+    if (capacity <= set->capacity)                                             \
+      return EXIT_SUCCESS;                                                     \
+    return hash_set_##N##_resize(set, capacity);                               \
+  }                                                                            \
+  int hash_set_##N##_shrink_to_fit(HashSet##N *set) {                          \
+    size_t capacity = hash_capacity_for(set->len);                             \
+    if (capacity >= set->capacity)                                             \
+      return EXIT_SUCCESS;                                                     \
+    return hash_set_##N##_resize(set, capacity);                               \
+  }
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef INTERVAL_MAP_H
+#define INTERVAL_MAP_H
+
+#include "functions.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+/**
+ * Node of the AVL tree of an interval map. The start and the end of the
+ * interval are stored next to each other behind the node, followed by the
+ * value, all inside the same allocation.
+ */
+typedef struct IntervalEntry {
+  /* Start of the interval, the end follows directly at hi. */
+  void *lo;
+  void *hi;
+  void *value;
+  /* Entry with the largest end of all intervals in the subtree. */
+  struct IntervalEntry *max;
+  struct IntervalEntry *left;
+  struct IntervalEntry *right;
+  size_t height;
+} IntervalEntry;
+
+/**
+ * Map from half-open intervals [lo, hi) to values, ordered by their start and
+ * then by their end. Every entry also knows the largest end inside its
+ * subtree, so queries skip every subtree that ends before the query starts.
+ * The endpoints have a fixed size and are ordered by the comperator.
+ */
+typedef struct {
+  IntervalEntry *root;
+  size_t len;
+  /* Size of a single endpoint, an interval takes twice as much. */
+  size_t key_size;
+  size_t value_size;
+  Comperator comperator;
+} IntervalMap;
+
+/* Upper bound for the height of an AVL tree with up to SIZE_MAX entries. */
+#define INTERVAL_MAP_MAX_HEIGHT 96
+
+/* Creates and returns a new empty interval map. */
+IntervalMap *interval_map_new(size_t key_size, size_t value_size,
+                              Comperator comperator);
+
+void interval_map_free(IntervalMap *map);
+
+/**
+ * Inserts the interval [lo, hi) with the given value or overwrites the value
+ * if the same interval is already present. Returns EXIT FAILURE if hi is not
+ * greater than lo or the entry could not be allocated, EXIT SUCCESS otherwise.
+ *
+ * Time complexity: O(log n)
+ */
+int interval_map_put(IntervalMap *map, void *lo, void *hi, void *v);
+
+/**
+ * If the interval [lo, hi) is present, writes its value to the buffer and
+ * returns EXIT SUCCESS. Otherwise returns EXIT FAILURE.
+ *
+ * Time complexity: O(log n)
+ */
+int interval_map_get(IntervalMap *map, void *lo, void *hi, void *v);
+
+/**
+ * Removes the interval [lo, hi) and its value. Returns EXIT FAILURE if the
+ * interval was not present, EXIT SUCCESS otherwise.
+ *
+ * Time complexity: O(log n)
+ */
+int interval_map_remove(IntervalMap *map, void *lo, void *hi);
+
+/**
+ * Returns if the interval [lo, hi) itself is present in the map.
+ *
+ * Time complexity: O(log n)
+ */
+bool interval_map_contains(IntervalMap *map, void *lo, void *hi);
+
+size_t interval_map_len(IntervalMap *map);
+
+void interval_map_clear(IntervalMap *map);
+
+/**
+ * Calls the consumer for every interval that contains the point, in ascending
+ * order. The consumer receives a pointer to the start of the interval, with
+ * the end key size bytes behind it, and a pointer to the value. k is the
+ * number of reported intervals, each of which may cost a descent of its own.
+ *
+ * Time complexity: O(min(n, k log n))
+ */
+void interval_map_stab(IntervalMap *map, void *point, BiConsumer consumer);
+
+/**
+ * Calls the consumer for every interval that overlaps [lo, hi), in ascending
+ * order, with the same arguments as interval_map_stab.
+ *
+ * Time complexity: O(min(n, k log n))
+ */
+void interval_map_overlap(IntervalMap *map, void *lo, void *hi,
+                          BiConsumer consumer);
+
+/**
+ * Returns if any interval overlaps [lo, hi). Follows a single path from the
+ * root instead of visiting all overlapping intervals.
+ *
+ * Time complexity: O(log n)
+ */
+bool interval_map_overlaps(IntervalMap *map, void *lo, void *hi);
+
+#endif
@@ -3,15 +3,27 @@
 
 #include "functions.h"
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 /**
- * Two sided directional linked node.
+ * Header of a memory block that holds several nodes and their values. The
+ * block is freed once the last node inside of it was freed.
+ */
+typedef struct LinkedBlock {
+  /* Number of nodes inside this block that were not freed yet. */
+  size_t live;
+} LinkedBlock;
+
+/**
+ * Two sided directional linked node. If the node was allocated as part of a
+ * block, block points to its header, otherwise block is NULL.
  */
 typedef struct LinkedNode {
   void *value;
   struct LinkedNode *prev;
   struct LinkedNode *next;
+  LinkedBlock *block;
 } LinkedNode;
 
 /**
@@ -33,6 +45,16 @@ typedef struct {
  */
 LinkedList *linked_list_new(size_t element_size);
 
+/**
+ * Creates and returns a new linked list that contains copies of the n elements
+ * of data in the same order. All nodes and their values are allocated in a
+ * single block and linked in address order. Returns NULL if the allocation
+ * failed.
+ *
+ * Time complexity: O(n)
+ */
+LinkedList *linked_list_from_array(size_t element_size, void *data, size_t n);
+
 /**
  * Destroys the linked list by freeing the memory of
  * the head if present and then itself.
@@ -66,6 +88,16 @@ void linked_list_push_front(LinkedList *linked_list, void *value);
  */
 void linked_list_push_back(LinkedList *linked_list, void *value);
 
+/**
+ * Adds the n elements of data to the end of the linked list, keeping their
+ * order. All new nodes and their values are allocated in a single block and
+ * linked in address order. Returns EXIT FAILURE if the allocation failed,
+ * EXIT SUCCESS otherwise.
+ *
+ * Time complexity: O(n)
+ */
+int linked_list_push_back_n(LinkedList *linked_list, void *data, size_t n);
+
 /**
  * If the linked list is empty, returns EXIT FAILURE. Otherwise writes the
  * content of the first element to the buffer and returns EXIT SUCCESS.
@@ -123,6 +155,26 @@ int linked_list_remove(LinkedList *linked_list, size_t index, void *buffer);
  */
 void linked_list_remove_if(LinkedList *linked_list, Test test);
 
+/**
+ * Moves all nodes and their values into a single block, in list order, and
+ * rewires the links accordingly. Afterwards traversing the list walks memory
+ * sequentially. Returns EXIT FAILURE if the allocation failed, in which case
+ * the linked list is unchanged, EXIT SUCCESS otherwise.
+ *
+ * Time complexity: O(n)
+ */
+int linked_list_compact(LinkedList *linked_list);
+
+/**
+ * Returns the average distance in bytes between the addresses of neighbouring
+ * nodes. A compacted linked list reports about the size of a node plus its
+ * value, larger values mean the nodes are scattered across the heap. Returns 0
+ * if the linked list has less than two elements.
+ *
+ * Time complexity: O(n)
+ */
+double linked_list_fragmentation(LinkedList *linked_list);
+
 /**
  * Returns the number of the elements that are inside the linked list.
  *
@@ -152,18 +204,26 @@ void linked_list_clear(LinkedList *linked_list);
     T value;                                                                   \
     struct LinkedNode##N *prev;                                                \
     struct LinkedNode##N *next;                                                \
+    LinkedBlock *block;                                                        \
   } LinkedNode##N;                                                             \
+  typedef struct {                                                             \
+    LinkedBlock header;                                                        \
+    LinkedNode##N nodes[];                                                     \
+  } LinkedNodeBlock##N;                                                        \
   typedef struct {                                                             \
     LinkedNode##N *head;                                                       \
     LinkedNode##N *tail;                                                       \
     size_t len;                                                                \
   } LinkedList##N;                                                             \
   LinkedList##N *linked_list_##N##_new();                                      \
+  LinkedList##N *linked_list_##N##_from_array(T *data, size_t n);              \
   void linked_list_##N##_free(LinkedList##N *linked_list);                     \
   bool linked_list_##N##_contains(LinkedList##N *linked_list,                  \
                                   Comperator comperator, T *value);            \
   void linked_list_##N##_push_front(LinkedList##N *linked_list, T value);      \
   void linked_list_##N##_push_back(LinkedList##N *linked_list, T value);       \
+  int linked_list_##N##_push_back_n(LinkedList##N *linked_list, T *data,       \
+                                    size_t n);                                 \
   int linked_list_##N##_front(LinkedList##N *linked_list, T *buffer);          \
   int linked_list_##N##_back(LinkedList##N *linked_list, T *buffer);           \
   int linked_list_##N##_get(LinkedList##N *linked_list, size_t index,          \
@@ -173,6 +233,8 @@ void linked_list_clear(LinkedList *linked_list);
   int linked_list_##N##_remove(LinkedList##N *linked_list, size_t index,       \
                                T *buffer);                                     \
   void linked_list_##N##_remove_if(LinkedList##N *linked_list, Test test);     \
+  int linked_list_##N##_compact(LinkedList##N *linked_list);                   \
+  double linked_list_##N##_fragmentation(LinkedList##N *linked_list);          \
   size_t linked_list_##N##_len(LinkedList##N *linked_list);                    \
   bool linked_list_##N##_is_empty(LinkedList##N *linked_list);                 \
   void linked_list_##N##_clear(LinkedList##N *linked_list);
@@ -187,9 +249,34 @@ void linked_list_clear(LinkedList *linked_list);
     created->value = value;                                                    \
     created->next = NULL;                                                      \
     created->prev = NULL;                                                      \
+    created->block = NULL;                                                     \
     return created;                                                            \
   }                                                                            \
-  void linked_node##N##_free(LinkedNode##N *node) { free(node); }              \
+  LinkedNode##N *linked_block##N##_new(size_t n, LinkedNode##N **last) {       \
+    if (n == 0 || n > (SIZE_MAX - sizeof(LinkedNodeBlock##N)) /                \
+                          sizeof(LinkedNode##N))                               \
+      return NULL;                                                             \
+    LinkedNodeBlock##N *block =                                                \
+        malloc(sizeof(LinkedNodeBlock##N) + n * sizeof(LinkedNode##N));        \
+    if (!block)                                                                \
+      return NULL;                                                             \
+    block->header.live = n;                                                    \
+    for (size_t i = 0; i < n; i++) {                                           \
+      block->nodes[i].block = &block->header;                                  \
+      block->nodes[i].prev = i > 0 ? &block->nodes[i - 1] : NULL;              \
+      block->nodes[i].next = i + 1 < n ? &block->nodes[i + 1] : NULL;          \
+    }                                                                          \
+    *last = &block->nodes[n - 1];                                              \
+    return block->nodes;                                                       \
+  }                                                                            \
+  void linked_node##N##_free(LinkedNode##N *node) {                            \
+    if (node->block) {                                                         \
+      if (--node->block->live == 0)                                            \
+        free(node->block);                                                     \
+      return;                                                                  \
+    }                                                                          \
+    free(node);                                                                \
+  }                                                                            \
   LinkedList##N *linked_list_##N##_new() {                                     \
     LinkedList##N *created = (LinkedList##N *)malloc(sizeof(LinkedList##N));   \
     if (!created)                                                              \
@@ -199,6 +286,36 @@ void linked_list_clear(LinkedList *linked_list);
     created->len = 0;                                                          \
     return created;                                                            \
   }                                                                            \
+  int linked_list_##N##_push_back_n(LinkedList##N *linked_list, T *data,       \
+                                    size_t n) {                                \
+    if (n == 0)                                                                \
+      return EXIT_SUCCESS;                                                     \
+    LinkedNode##N *last;                                                       \
+    LinkedNode##N *first = linked_block##N##_new(n, &last);                    \
+    if (!first)                                                                \
+      return EXIT_FAILURE;                                                     \
+    for (size_t i = 0; i < n; i++)                                             \
+      first[i].value = data[i];                                                \
+    if (linked_list->head) {                                                   \
+      linked_list->tail->next = first;                                         \
+      first->prev = linked_list->tail;                                         \
+    } else {                                                                   \
+      linked_list->head = first;                                               \
+    }                                                                          \
+    linked_list->tail = last;                                                  \
+    linked_list->len += n;                                                     \
+    return EXIT_SUCCESS;                                                       \
+  }                                                                            \
+  LinkedList##N *linked_list_##N##_from_array(T *data, size_t n) {             \
+    LinkedList##N *created = linked_list_##N##_new();                          \
+    if (!created)                                                              \
+      return NULL;                                                             \
+    if (linked_list_##N##_push_back_n(created, data, n) != EXIT_SUCCESS) {     \
+      free(created);                                                           \
+      return NULL;                                                             \
+    }                                                                          \
+    return created;                                                            \
+  }                                                                            \
   void linked_list_##N##_free_data(LinkedList##N *linked_list) {               \
     LinkedNode##N *back = linked_list->tail;                                   \
     while (back) {                                                             \
@@ -353,6 +470,33 @@ void linked_list_clear(LinkedList *linked_list);
       node = next;                                                             \
     }                                                                          \
   }                                                                            \
+  int linked_list_##N##_compact(LinkedList##N *linked_list) {                  \
+    if (linked_list->len == 0)                                                 \
+      return EXIT_SUCCESS;                                                     \
+    LinkedNode##N *last;                                                       \
+    LinkedNode##N *first = linked_block##N##_new(linked_list->len, &last);     \
+    if (!first)                                                                \
+      return EXIT_FAILURE;                                                     \
+    LinkedNode##N *from = linked_list->head;                                   \
+    for (LinkedNode##N *to = first; to; to = to->next, from = from->next)      \
+      to->value = from->value;                                                 \
+    linked_list_##N##_free_data(linked_list);                                  \
+    linked_list->head = first;                                                 \
+    linked_list->tail = last;                                                  \
+    return EXIT_SUCCESS;                                                       \
+  }                                                                            \
+  double linked_list_##N##_fragmentation(LinkedList##N *linked_list) {         \
+    if (linked_list->len < 2)                                                  \
+      return 0.0;                                                              \
+    double total = 0.0;                                                        \
+    for (LinkedNode##N *node = linked_list->head; node->next;                  \
+         node = node->next) {                                                  \
+      uintptr_t a = (uintptr_t)node;                                           \
+      uintptr_t b = (uintptr_t)node->next;                                     \
+      total += (double)(a < b ? b - a : a - b);                                \
+    }                                                                          \
+    return total / (double)(linked_list->len - 1);                             \
+  }                                                                            \
   size_t linked_list_##N##_len(LinkedList##N *linked_list) {                   \
     return linked_list->len;                                                   \
   }                                                                            \
@@ -366,4 +510,48 @@ void linked_list_clear(LinkedList *linked_list);
     linked_list->len = 0;                                                      \
   }
 
+/**
+ * Generates linked_list_N_contains_NAME, a variant of contains for the typed
+ * linked list N that compares with EQ instead of a Comperator. EQ is a
+ * function-like macro or a static inline function that takes two values of
+ * type T and returns true if they are equal. Because EQ is known at
+ * instantiation time, the comparison is inlined into the loop.
+ */
+#define GENERATE_LINKED_LIST_CONTAINS_H(N, T, NAME)                            \
+  bool linked_list_##N##_contains_##NAME(LinkedList##N *linked_list, T value);
+
+#define GENERATE_LINKED_LIST_CONTAINS_C(N, T, NAME, EQ)                        \
+  bool linked_list_##N##_contains_##NAME(LinkedList##N *linked_list,           \
+                                         T value) {                            \
+    for (LinkedNode##N *node = linked_list->head; node; node = node->next) {   \
+      if (EQ(node->value, value))                                              \
+        return true;                                                           \
+    }                                                                          \
+    return false;                                                              \
+  }
+
+/**
+ * Generates linked_list_N_remove_if_NAME, a variant of remove_if for the typed
+ * linked list N that removes every element for which TEST returns true. TEST
+ * is a function-like macro or a static inline function that takes a value of
+ * the element type and is inlined into the loop instead of being called
+ * through a Test pointer.
+ */
+#define GENERATE_LINKED_LIST_REMOVE_IF_H(N, NAME)                              \
+  void linked_list_##N##_remove_if_##NAME(LinkedList##N *linked_list);
+
+#define GENERATE_LINKED_LIST_REMOVE_IF_C(N, NAME, TEST)                        \
+  void linked_list_##N##_remove_if_##NAME(LinkedList##N *linked_list) {        \
+    LinkedNode##N *node = linked_list->head;                                   \
+    while (node) {                                                             \
+      LinkedNode##N *next = node->next;                                        \
+      if (TEST(node->value)) {                                                 \
+        linked_list_##N##_relink(linked_list, node);                           \
+        linked_list->len--;                                                    \
+        linked_node##N##_free(node);                                           \
+      }                                                                        \
+      node = next;                                                             \
+    }                                                                          \
+  }
+
 #endif
@@ -0,0 +1,95 @@
+#ifndef PERSISTENT_MAP_H
+#define PERSISTENT_MAP_H
+
+#include "functions.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Node of a persistent AVL tree. Nodes are shared between versions and are
+ * only changed while a single version owns them, refs counts the versions and
+ * parent nodes that point to it. The key and the value are stored inline
+ * behind the node.
+ */
+typedef struct PersistentEntry {
+  atomic_size_t refs;
+  void *key;
+  void *value;
+  struct PersistentEntry *left;
+  struct PersistentEntry *right;
+  size_t height;
+} PersistentEntry;
+
+/**
+ * Immutable version of an ordered map. Put and remove never change a version
+ * but return a new one, which copies only the nodes on the path to the key and
+ * shares all other nodes with the old version. Any number of threads may read
+ * and snapshot a version while another thread derives new versions from it.
+ */
+typedef struct {
+  PersistentEntry *root;
+  size_t len;
+  size_t key_size;
+  size_t value_size;
+  Comperator comperator;
+} PersistentMap;
+
+/* Upper bound for the height of an AVL tree with up to SIZE_MAX entries. */
+#define PERSISTENT_MAP_MAX_HEIGHT 96
+
+/* Creates and returns a new empty version. */
+PersistentMap *persistent_map_new(size_t key_size, size_t value_size,
+                                  Comperator comperator);
+
+/**
+ * Releases the version. Nodes that no other version uses anymore are freed.
+ * Every version returned by this module must be freed exactly once.
+ *
+ * Time complexity: O(1) plus the number of freed nodes
+ */
+void persistent_map_free(PersistentMap *map);
+
+/**
+ * Returns a new handle to the same version, which can be freed independently.
+ * Returns NULL if the handle could not be allocated.
+ *
+ * Time complexity: O(1)
+ */
+PersistentMap *persistent_map_snapshot(PersistentMap *map);
+
+/**
+ * Returns a new version in which the key maps to the given value, or NULL if
+ * a node could not be allocated. The version passed in is not changed.
+ *
+ * Time complexity: O(log n)
+ */
+PersistentMap *persistent_map_put(PersistentMap *map, void *k, void *v);
+
+/**
+ * Returns a new version without the key, or NULL if a node could not be
+ * allocated. If the key is not present, the new version shares the whole
+ * tree. The version passed in is not changed.
+ *
+ * Time complexity: O(log n)
+ */
+PersistentMap *persistent_map_remove(PersistentMap *map, void *k);
+
+/**
+ * If the key is present, writes its value to the buffer and returns EXIT
+ * SUCCESS. Otherwise returns EXIT FAILURE.
+ *
+ * Time complexity: O(log n)
+ */
+int persistent_map_get(PersistentMap *map, void *k, void *v);
+
+/**
+ * Returns if the key is present in this version.
+ *
+ * Time complexity: O(log n)
+ */
+bool persistent_map_contains_key(PersistentMap *map, void *k);
+
+size_t persistent_map_len(PersistentMap *map);
+
+#endif
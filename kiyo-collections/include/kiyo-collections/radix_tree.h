@@ -0,0 +1,160 @@
+#ifndef RADIX_TREE_H
+#define RADIX_TREE_H
+
+#include "functions.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/* Number of bytes of a compressed path that are stored inside a node. */
+#define RADIX_TREE_MAX_PREFIX 8
+
+/* Kinds of inner nodes, named after the number of children they can hold. */
+typedef enum {
+  RADIX_NODE4,
+  RADIX_NODE16,
+  RADIX_NODE48,
+  RADIX_NODE256,
+} RadixNodeType;
+
+/**
+ * Leaf of a radix tree. It holds the whole key, so a lookup only compares the
+ * key once at the end. The value follows the key inside the same allocation.
+ */
+typedef struct RadixLeaf {
+  void *value;
+  size_t key_len;
+  unsigned char key[];
+} RadixLeaf;
+
+/**
+ * Header shared by all inner nodes. The path from the parent to this node is
+ * compressed into a prefix. Only the first RADIX_TREE_MAX_PREFIX bytes of a
+ * longer prefix are stored, the rest is checked against the key of a leaf.
+ */
+typedef struct {
+  /* One of RadixNodeType. */
+  uint8_t type;
+  /* Number of children, up to 256. */
+  uint16_t count;
+  uint32_t prefix_len;
+  unsigned char prefix[RADIX_TREE_MAX_PREFIX];
+  /* Leaf of the key that ends right after the prefix, or NULL. */
+  RadixLeaf *leaf;
+} RadixNode;
+
+/**
+ * Children are pointers to inner nodes or to leaves, a leaf pointer has its
+ * lowest bit set. Node4 and Node16 keep their key bytes sorted.
+ */
+typedef struct {
+  RadixNode node;
+  unsigned char keys[4];
+  void *children[4];
+} RadixNode4;
+
+typedef struct {
+  RadixNode node;
+  unsigned char keys[16];
+  void *children[16];
+} RadixNode16;
+
+/* Maps every byte to its child slot plus one, 0 if there is no child. */
+typedef struct {
+  RadixNode node;
+  uint8_t child_index[256];
+  void *children[48];
+} RadixNode48;
+
+typedef struct {
+  RadixNode node;
+  void *children[256];
+} RadixNode256;
+
+/**
+ * Adaptive radix tree that maps byte strings of any length to values of a
+ * fixed size. Every inner node branches on a single byte and grows from 4 to
+ * 16, 48 and 256 children as needed, and chains of nodes with a single child
+ * are compressed into the prefix of the node below. A lookup costs one step
+ * per distinct byte instead of a full key comparison per level, and keys with
+ * long common prefixes share them instead of storing and comparing them again.
+ */
+typedef struct {
+  /* Inner node or tagged leaf at the root, NULL if the tree is empty. */
+  void *root;
+  size_t len;
+  size_t value_size;
+} RadixTree;
+
+/* Receives a key, its length and a pointer to its value. */
+typedef void (*RadixConsumer)(void *key, size_t key_len, void *value);
+
+/* Creates and returns a new empty radix tree. */
+RadixTree *radix_tree_new(size_t value_size);
+
+void radix_tree_free(RadixTree *tree);
+
+/**
+ * Inserts the key with the given value or overwrites the value if the key is
+ * already present. The value is ignored if the value size is 0. Returns EXIT
+ * FAILURE if a node could not be allocated, EXIT SUCCESS otherwise.
+ *
+ * Time complexity: O(k)
+ */
+int radix_tree_put(RadixTree *tree, void *key, size_t key_len, void *v);
+
+/**
+ * If the key is present, writes its value to the buffer and returns EXIT
+ * SUCCESS. Otherwise returns EXIT FAILURE.
+ *
+ * Time complexity: O(k)
+ */
+int radix_tree_get(RadixTree *tree, void *key, size_t key_len, void *v);
+
+/**
+ * Returns a pointer to the stored value of the key, or NULL if the key is not
+ * present. The pointer stays valid until the key is removed.
+ *
+ * Time complexity: O(k)
+ */
+void *radix_tree_get_ptr(RadixTree *tree, void *key, size_t key_len);
+
+/**
+ * Removes the key and its value. Nodes shrink to the next smaller kind once
+ * they hold few enough children. Returns EXIT FAILURE if the key was not
+ * present, EXIT SUCCESS otherwise.
+ *
+ * Time complexity: O(k)
+ */
+int radix_tree_remove(RadixTree *tree, void *key, size_t key_len);
+
+/**
+ * Returns if the key is present in the tree.
+ *
+ * Time complexity: O(k)
+ */
+bool radix_tree_contains(RadixTree *tree, void *key, size_t key_len);
+
+size_t radix_tree_len(RadixTree *tree);
+
+void radix_tree_clear(RadixTree *tree);
+
+/**
+ * Calls the consumer for every key in ascending byte order, where a key comes
+ * before all keys that it is a prefix of.
+ *
+ * Time complexity: O(n)
+ */
+void radix_tree_for_each(RadixTree *tree, RadixConsumer consumer);
+
+/**
+ * Calls the consumer for every key that starts with the prefix, in ascending
+ * byte order. Only the subtree below the prefix is visited.
+ *
+ * Time complexity: O(k + m)
+ */
+void radix_tree_prefix(RadixTree *tree, void *prefix, size_t prefix_len,
+                       RadixConsumer consumer);
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef VEC_H
 #define VEC_H
 
+#include "functions.h"
 #include <stdbool.h>
 #include <stddef.h>
 
@@ -74,6 +75,16 @@ int vec_pop(Vec *vec, void *buffer);
  */
 int vec_get(Vec *vec, size_t index, void *buffer);
 
+/**
+ * Sorts the elements in ascending order of the comperator with a stable merge
+ * sort. An element a is placed before b if comperator(a, b) is positive.
+ * Returns EXIT FAILURE if the temporary buffer could not be allocated, in
+ * which case the vec is unchanged.
+ *
+ * Time complexity: O(n log n)
+ */
+int vec_sort(Vec *vec, Comperator comperator);
+
 /* Double the capacity, then reallocate data to the new capacity. */
 void vec_grow(Vec *vec);
 
@@ -0,0 +1,37 @@
+#include "align.h"
+#include <stdlib.h>
+
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+size_t align_field(size_t size) {
+  size_t alignment = 1;
+  if (size == 0)
+    return alignment;
+  while (alignment < alignof(max_align_t) && size % (alignment * 2) == 0)
+    alignment *= 2;
+  return alignment;
+}
+
+size_t align_to(size_t size, size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+void *align_alloc(size_t alignment, size_t size) {
+#ifdef _MSC_VER
+  // The C runtime of MSVC has no aligned_alloc.
+  return _aligned_malloc(size, alignment);
+#else
+  // aligned_alloc wants the size to be a multiple of the alignment.
+  return aligned_alloc(alignment, align_to(size, alignment));
+#endif
+}
+
+void align_free(void *ptr) {
+#ifdef _MSC_VER
+  _aligned_free(ptr);
+#else
+  free(ptr);
+#endif
+}
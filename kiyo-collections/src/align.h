@@ -0,0 +1,29 @@
+#ifndef ALIGN_H
+#define ALIGN_H
+
+#include <stdalign.h>
+#include <stddef.h>
+
+/* Rounds size up to the next multiple of the maximum alignment. */
+#define ALIGN_UP(size)                                                         \
+  (((size) + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1))
+
+/**
+ * Returns the alignment a field of the given size needs at most, the largest
+ * power of two that divides it, capped at the maximum alignment.
+ */
+size_t align_field(size_t size);
+
+/* Rounds size up to the next multiple of alignment. */
+size_t align_to(size_t size, size_t alignment);
+
+/**
+ * Allocates size bytes at a multiple of alignment, a power of two, or returns
+ * NULL. The memory has to be released with align_free, not free.
+ */
+void *align_alloc(size_t alignment, size_t size);
+
+/* Releases memory from align_alloc, ignores NULL. */
+void align_free(void *ptr);
+
+#endif
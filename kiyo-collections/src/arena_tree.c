@@ -0,0 +1,391 @@
+#include "kiyo-collections/arena_tree.h"
+#include "align.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Number of slots of the first arena, including the unused slot 0. */
+#define ARENA_TREE_MIN_CAPACITY 16
+
+/* Largest number of slots whose indices still fit into a link. */
+#define ARENA_TREE_MAX_CAPACITY ((size_t)UINT32_MAX + 1)
+
+ArenaTree *arena_tree_new(size_t key_size, size_t value_size,
+                          Comperator comperator) {
+  ArenaTree *created = malloc(sizeof(ArenaTree));
+  if (!created)
+    return NULL;
+
+  // Pad the header so that the key is aligned, the key so that the value is
+  // aligned and the slot so that the next header is aligned.
+  size_t key_alignment = align_field(key_size);
+  size_t value_alignment = align_field(value_size);
+  size_t node_alignment = alignof(ArenaNode);
+  if (key_alignment > node_alignment)
+    node_alignment = key_alignment;
+  if (value_alignment > node_alignment)
+    node_alignment = value_alignment;
+  created->key_offset = align_to(sizeof(ArenaNode), key_alignment);
+  created->value_offset =
+      align_to(created->key_offset + key_size, value_alignment);
+  created->node_size =
+      align_to(created->value_offset + value_size, node_alignment);
+
+  created->nodes = NULL;
+  created->capacity = 0;
+  created->used = 1;
+  created->free_list = 0;
+  created->root = 0;
+  created->len = 0;
+  created->key_size = key_size;
+  created->value_size = value_size;
+  created->comperator = comperator;
+  return created;
+}
+
+void arena_tree_free(ArenaTree *tree) {
+  free(tree->nodes);
+  free(tree);
+}
+
+ArenaNode *arena_tree_node(ArenaTree *tree, uint32_t i) {
+  return (ArenaNode *)(tree->nodes + (size_t)i * tree->node_size);
+}
+
+void *arena_tree_key(ArenaTree *tree, uint32_t i) {
+  return tree->nodes + (size_t)i * tree->node_size + tree->key_offset;
+}
+
+void *arena_tree_value(ArenaTree *tree, uint32_t i) {
+  return tree->nodes + (size_t)i * tree->node_size + tree->value_offset;
+}
+
+/**
+ * Makes sure that the next allocation does not move the arena, so pointers to
+ * links stay valid while the tree is modified.
+ */
+int arena_tree_reserve(ArenaTree *tree) {
+  if (tree->free_list != 0 || tree->used < tree->capacity)
+    return EXIT_SUCCESS;
+  if (tree->capacity >= ARENA_TREE_MAX_CAPACITY)
+    return EXIT_FAILURE;
+  size_t capacity =
+      tree->capacity ? tree->capacity * 2 : ARENA_TREE_MIN_CAPACITY;
+  if (capacity > ARENA_TREE_MAX_CAPACITY)
+    capacity = ARENA_TREE_MAX_CAPACITY;
+  if (capacity > SIZE_MAX / tree->node_size)
+    return EXIT_FAILURE;
+  char *nodes = realloc(tree->nodes, capacity * tree->node_size);
+  if (!nodes)
+    return EXIT_FAILURE;
+  tree->nodes = nodes;
+  tree->capacity = capacity;
+  return EXIT_SUCCESS;
+}
+
+/* Takes a slot from the free list or the unused end of the arena. */
+uint32_t arena_tree_alloc(ArenaTree *tree, void *k, void *v) {
+  uint32_t i = tree->free_list;
+  if (i != 0)
+    tree->free_list = arena_tree_node(tree, i)->left;
+  else
+    i = (uint32_t)tree->used++;
+
+  ArenaNode *node = arena_tree_node(tree, i);
+  node->left = 0;
+  node->right = 0;
+  node->height = 1;
+  memcpy(arena_tree_key(tree, i), k, tree->key_size);
+  if (v)
+    memcpy(arena_tree_value(tree, i), v, tree->value_size);
+  else
+    memset(arena_tree_value(tree, i), 0, tree->value_size);
+  return i;
+}
+
+unsigned arena_tree_node_height(ArenaTree *tree, uint32_t i) {
+  return i ? arena_tree_node(tree, i)->height : 0;
+}
+
+void arena_tree_update_height(ArenaTree *tree, uint32_t i) {
+  ArenaNode *node = arena_tree_node(tree, i);
+  unsigned height_left = arena_tree_node_height(tree, node->left);
+  unsigned height_right = arena_tree_node_height(tree, node->right);
+  node->height =
+      (uint8_t)((height_left > height_right ? height_left : height_right) + 1);
+}
+
+int arena_tree_get_balance_factor(ArenaTree *tree, uint32_t i) {
+  ArenaNode *node = arena_tree_node(tree, i);
+  return (int)arena_tree_node_height(tree, node->left) -
+         (int)arena_tree_node_height(tree, node->right);
+}
+
+uint32_t arena_tree_rotate_right(ArenaTree *tree, uint32_t i) {
+  ArenaNode *node = arena_tree_node(tree, i);
+  uint32_t left = node->left;
+  node->left = arena_tree_node(tree, left)->right;
+  arena_tree_node(tree, left)->right = i;
+
+  arena_tree_update_height(tree, i);
+  arena_tree_update_height(tree, left);
+  return left;
+}
+
+uint32_t arena_tree_rotate_left(ArenaTree *tree, uint32_t i) {
+  ArenaNode *node = arena_tree_node(tree, i);
+  uint32_t right = node->right;
+  node->right = arena_tree_node(tree, right)->left;
+  arena_tree_node(tree, right)->left = i;
+
+  arena_tree_update_height(tree, i);
+  arena_tree_update_height(tree, right);
+  return right;
+}
+
+/* Restores the AVL property of the node and returns the new subtree root. */
+uint32_t arena_tree_rebalance(ArenaTree *tree, uint32_t i) {
+  arena_tree_update_height(tree, i);
+  int balance_factor = arena_tree_get_balance_factor(tree, i);
+  ArenaNode *node = arena_tree_node(tree, i);
+  if (balance_factor > 1) {
+    if (arena_tree_get_balance_factor(tree, node->left) < 0)
+      node->left = arena_tree_rotate_left(tree, node->left);
+    return arena_tree_rotate_right(tree, i);
+  } else if (balance_factor < -1) {
+    if (arena_tree_get_balance_factor(tree, node->right) > 0)
+      node->right = arena_tree_rotate_right(tree, node->right);
+    return arena_tree_rotate_left(tree, i);
+  }
+  return i;
+}
+
+/**
+ * Rebalances the links on the path from the bottom up. Nodes carry no subtree
+ * sizes, so the walk stops at the first subtree that keeps its height.
+ */
+void arena_tree_rebalance_path(ArenaTree *tree, uint32_t **path,
+                               size_t depth) {
+  while (depth > 0) {
+    uint32_t *link = path[--depth];
+    unsigned height = arena_tree_node(tree, *link)->height;
+    *link = arena_tree_rebalance(tree, *link);
+    if (arena_tree_node(tree, *link)->height == height)
+      return;
+  }
+}
+
+uint32_t arena_tree_find(ArenaTree *tree, void *k) {
+  uint32_t i = tree->root;
+  while (i) {
+    int c = tree->comperator(arena_tree_key(tree, i), k);
+    if (c == 0)
+      return i;
+    ArenaNode *node = arena_tree_node(tree, i);
+    i = (c > 0) ? node->right : node->left;
+  }
+  return 0;
+}
+
+void *arena_tree_emplace(ArenaTree *tree, void *k, void *v, bool *inserted) {
+  *inserted = false;
+  // Grow up front, the path below points into the arena.
+  if (arena_tree_reserve(tree) != EXIT_SUCCESS)
+    return NULL;
+
+  uint32_t *path[ARENA_TREE_MAX_HEIGHT];
+  size_t depth = 0;
+  uint32_t *link = &(tree->root);
+  while (*link) {
+    int c = tree->comperator(arena_tree_key(tree, *link), k);
+    if (c == 0)
+      return arena_tree_value(tree, *link);
+    path[depth++] = link;
+    ArenaNode *node = arena_tree_node(tree, *link);
+    link = (c > 0) ? &(node->right) : &(node->left);
+  }
+
+  // Rotations only relink nodes, the slot of the new node stays the same.
+  uint32_t i = arena_tree_alloc(tree, k, v);
+  *link = i;
+  tree->len++;
+  *inserted = true;
+  arena_tree_rebalance_path(tree, path, depth);
+  return arena_tree_value(tree, i);
+}
+
+int arena_tree_put(ArenaTree *tree, void *k, void *v) {
+  bool inserted;
+  void *value = arena_tree_emplace(tree, k, v, &inserted);
+  if (!value)
+    return EXIT_FAILURE;
+  if (!inserted && tree->value_size > 0)
+    memcpy(value, v, tree->value_size);
+  return EXIT_SUCCESS;
+}
+
+int arena_tree_get(ArenaTree *tree, void *k, void *v) {
+  uint32_t i = arena_tree_find(tree, k);
+  if (i == 0)
+    return EXIT_FAILURE;
+  memcpy(v, arena_tree_value(tree, i), tree->value_size);
+  return EXIT_SUCCESS;
+}
+
+void *arena_tree_get_ptr(ArenaTree *tree, void *k) {
+  uint32_t i = arena_tree_find(tree, k);
+  return i ? arena_tree_value(tree, i) : NULL;
+}
+
+bool arena_tree_contains(ArenaTree *tree, void *k) {
+  return arena_tree_find(tree, k) != 0;
+}
+
+int arena_tree_remove(ArenaTree *tree, void *k) {
+  uint32_t *path[ARENA_TREE_MAX_HEIGHT];
+  size_t depth = 0;
+  uint32_t *link = &(tree->root);
+  while (*link) {
+    int c = tree->comperator(arena_tree_key(tree, *link), k);
+    if (c == 0)
+      break;
+    path[depth++] = link;
+    ArenaNode *node = arena_tree_node(tree, *link);
+    link = (c > 0) ? &(node->right) : &(node->left);
+  }
+  uint32_t i = *link;
+  if (i == 0)
+    return EXIT_FAILURE;
+
+  ArenaNode *node = arena_tree_node(tree, i);
+  if (node->left && node->right) {
+    // Move the in-order successor into this node and unlink the successor
+    // instead, it has no left child.
+    path[depth++] = link;
+    link = &(node->right);
+    while (arena_tree_node(tree, *link)->left) {
+      path[depth++] = link;
+      link = &(arena_tree_node(tree, *link)->left);
+    }
+    memcpy(arena_tree_key(tree, i), arena_tree_key(tree, *link),
+           tree->key_size);
+    if (tree->value_size > 0)
+      memcpy(arena_tree_value(tree, i), arena_tree_value(tree, *link),
+             tree->value_size);
+    i = *link;
+    node = arena_tree_node(tree, i);
+  }
+  *link = node->left ? node->left : node->right;
+  node->left = tree->free_list;
+  tree->free_list = i;
+  tree->len--;
+  arena_tree_rebalance_path(tree, path, depth);
+  return EXIT_SUCCESS;
+}
+
+void arena_tree_clear(ArenaTree *tree) {
+  // Forget every slot at once, neither the nodes nor the free list need to be
+  // visited.
+  tree->root = 0;
+  tree->len = 0;
+  tree->used = 1;
+  tree->free_list = 0;
+}
+
+size_t arena_tree_height(ArenaTree *tree) {
+  return arena_tree_node_height(tree, tree->root);
+}
+
+/* Pushes the node and its chain of left children onto the cursor stack. */
+void arena_cursor_push_left(ArenaCursor *cursor, uint32_t i) {
+  while (i) {
+    cursor->stack[cursor->depth++] = i;
+    i = arena_tree_node(cursor->tree, i)->left;
+  }
+}
+
+bool arena_tree_first(ArenaTree *tree, ArenaCursor *cursor) {
+  cursor->tree = tree;
+  cursor->depth = 0;
+  arena_cursor_push_left(cursor, tree->root);
+  return cursor->depth > 0;
+}
+
+bool arena_tree_last(ArenaTree *tree, ArenaCursor *cursor) {
+  cursor->tree = tree;
+  cursor->depth = 0;
+  uint32_t i = tree->root;
+  if (i == 0)
+    return false;
+  while (arena_tree_node(tree, i)->right)
+    i = arena_tree_node(tree, i)->right;
+  // The largest entry has no pending successors.
+  cursor->stack[cursor->depth++] = i;
+  return true;
+}
+
+bool arena_tree_lower_bound(ArenaTree *tree, void *k, ArenaCursor *cursor) {
+  cursor->tree = tree;
+  cursor->depth = 0;
+  // Keep every node on the path whose key is not less than k, these are
+  // exactly the pending nodes of an in-order walk starting at k.
+  uint32_t i = tree->root;
+  while (i) {
+    int c = tree->comperator(arena_tree_key(tree, i), k);
+    if (c > 0) {
+      i = arena_tree_node(tree, i)->right;
+    } else {
+      cursor->stack[cursor->depth++] = i;
+      i = c == 0 ? 0 : arena_tree_node(tree, i)->left;
+    }
+  }
+  return cursor->depth > 0;
+}
+
+bool arena_tree_floor(ArenaTree *tree, void *k, ArenaCursor *cursor) {
+  cursor->tree = tree;
+  cursor->depth = 0;
+  // The pending nodes of the floor are the nodes above it where the path
+  // turned left, nodes below it are inside its right subtree.
+  uint32_t best = 0;
+  size_t best_depth = 0;
+  uint32_t i = tree->root;
+  while (i) {
+    int c = tree->comperator(arena_tree_key(tree, i), k);
+    if (c == 0) {
+      best = i;
+      best_depth = cursor->depth;
+      break;
+    }
+    if (c > 0) {
+      best = i;
+      best_depth = cursor->depth;
+      i = arena_tree_node(tree, i)->right;
+    } else {
+      cursor->stack[cursor->depth++] = i;
+      i = arena_tree_node(tree, i)->left;
+    }
+  }
+  if (best == 0) {
+    cursor->depth = 0;
+    return false;
+  }
+  cursor->depth = best_depth;
+  cursor->stack[cursor->depth++] = best;
+  return true;
+}
+
+bool arena_cursor_next(ArenaCursor *cursor) {
+  if (cursor->depth == 0)
+    return false;
+  uint32_t i = cursor->stack[--cursor->depth];
+  arena_cursor_push_left(cursor, arena_tree_node(cursor->tree, i)->right);
+  return cursor->depth > 0;
+}
+
+void *arena_cursor_key(ArenaCursor *cursor) {
+  return arena_tree_key(cursor->tree, cursor->stack[cursor->depth - 1]);
+}
+
+void *arena_cursor_value(ArenaCursor *cursor) {
+  return arena_tree_value(cursor->tree, cursor->stack[cursor->depth - 1]);
+}
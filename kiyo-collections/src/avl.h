@@ -0,0 +1,105 @@
+#ifndef AVL_H
+#define AVL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Generates the AVL core of a tree of node type T under the prefix P, for
+ * trees whose nodes carry left, right and height fields. UPDATE recomputes
+ * the augmented fields of a node from its children and RELEASE frees a single
+ * node. Generates:
+ * - P_free, which frees the subtree of a node without recursion.
+ * - P_update, P_rotate_left, P_rotate_right, P_get_balance_factor and
+ *   P_rebalance, which keep the heights and the augmented fields current.
+ * - P_rebalance_path, which rebalances the links on a search path from the
+ *   bottom up. The augmented fields of every ancestor change even when no
+ *   height does, so each node on the path is updated.
+ * - P_push_left, which pushes the node and its left spine onto an iterator
+ *   stack.
+ */
+#define GENERATE_AVL(P, T, UPDATE, RELEASE)                                    \
+  void P##_free(T *node) {                                                     \
+    while (node) {                                                             \
+      if (node->left) {                                                        \
+        T *left = node->left;                                                  \
+        node->left = left->right;                                              \
+        left->right = node;                                                    \
+        node = left;                                                           \
+      } else {                                                                 \
+        T *right = node->right;                                                \
+        RELEASE(node);                                                         \
+        node = right;                                                          \
+      }                                                                        \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  void P##_update(T *node) {                                                   \
+    size_t height_left = node->left ? node->left->height : 0;                  \
+    size_t height_right = node->right ? node->right->height : 0;               \
+    node->height =                                                             \
+        (height_left > height_right ? height_left : height_right) + 1;         \
+    UPDATE(node);                                                              \
+  }                                                                            \
+                                                                               \
+  T *P##_rotate_right(T *node) {                                               \
+    T *left = node->left;                                                      \
+    node->left = left->right;                                                  \
+    left->right = node;                                                        \
+    P##_update(node);                                                          \
+    P##_update(left);                                                          \
+    return left;                                                               \
+  }                                                                            \
+                                                                               \
+  T *P##_rotate_left(T *node) {                                                \
+    T *right = node->right;                                                    \
+    node->right = right->left;                                                 \
+    right->left = node;                                                        \
+    P##_update(node);                                                          \
+    P##_update(right);                                                         \
+    return right;                                                              \
+  }                                                                            \
+                                                                               \
+  int P##_get_balance_factor(T *node) {                                        \
+    int height_left = node->left ? (int)node->left->height : 0;                \
+    int height_right = node->right ? (int)node->right->height : 0;             \
+    return height_left - height_right;                                         \
+  }                                                                            \
+                                                                               \
+  T *P##_rebalance(T *node) {                                                  \
+    P##_update(node);                                                          \
+    int balance_factor = P##_get_balance_factor(node);                         \
+    if (balance_factor > 1) {                                                  \
+      if (P##_get_balance_factor(node->left) < 0)                              \
+        node->left = P##_rotate_left(node->left);                              \
+      return P##_rotate_right(node);                                           \
+    } else if (balance_factor < -1) {                                          \
+      if (P##_get_balance_factor(node->right) > 0)                             \
+        node->right = P##_rotate_right(node->right);                           \
+      return P##_rotate_left(node);                                            \
+    }                                                                          \
+    return node;                                                               \
+  }                                                                            \
+                                                                               \
+  void P##_rebalance_path(T ***path, size_t depth) {                           \
+    bool balanced = false;                                                     \
+    while (depth > 0) {                                                        \
+      T **link = path[--depth];                                                \
+      if (balanced) {                                                          \
+        P##_update(*link);                                                     \
+        continue;                                                              \
+      }                                                                        \
+      size_t height = (*link)->height;                                         \
+      *link = P##_rebalance(*link);                                            \
+      balanced = (*link)->height == height;                                    \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  void P##_push_left(T **stack, size_t *depth, T *node) {                      \
+    while (node) {                                                             \
+      stack[(*depth)++] = node;                                                \
+      node = node->left;                                                       \
+    }                                                                          \
+  }
+
+#endif
@@ -0,0 +1,561 @@
+#include "kiyo-collections/b_plus_tree.h"
+#include "align.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Number of bytes the keys of a node should occupy, 8 cache lines. */
+#define NODE_KEY_BYTES 512
+#define MIN_NODE_CAPACITY 4
+#define MAX_NODE_CAPACITY 64
+
+char *b_plus_node_key(BPlusTree *tree, BPlusNode *node, size_t i) {
+  return (char *)node + ALIGN_UP(sizeof(BPlusNode)) + i * tree->key_size;
+}
+
+char *b_plus_node_value(BPlusTree *tree, BPlusNode *node, size_t i) {
+  return (char *)node + tree->payload_offset + i * tree->value_size;
+}
+
+BPlusNode **b_plus_node_children(BPlusTree *tree, BPlusNode *node) {
+  return (BPlusNode **)((char *)node + tree->payload_offset);
+}
+
+BPlusNode *b_plus_node_new(BPlusTree *tree, bool leaf) {
+  size_t payload = leaf ? tree->capacity * tree->value_size
+                        : (tree->capacity + 1) * sizeof(BPlusNode *);
+  BPlusNode *created = malloc(tree->payload_offset + payload);
+  if (!created)
+    return NULL;
+  created->len = 0;
+  created->leaf = leaf;
+  created->prev = NULL;
+  created->next = NULL;
+  return created;
+}
+
+void b_plus_node_free(BPlusTree *tree, BPlusNode *node) {
+  if (!node->leaf) {
+    BPlusNode **children = b_plus_node_children(tree, node);
+    for (size_t i = 0; i <= node->len; i++)
+      b_plus_node_free(tree, children[i]);
+  }
+  free(node);
+}
+
+/* Compares with the usual sign, positive if a is greater than b. */
+int b_plus_tree_compare(BPlusTree *tree, void *a, void *b) {
+  return tree->comperator(b, a);
+}
+
+/* Returns the index of the first key of the node that is not less than k. */
+size_t b_plus_node_lower_bound(BPlusTree *tree, BPlusNode *node, void *k) {
+  size_t lo = 0;
+  size_t hi = node->len;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (b_plus_tree_compare(tree, b_plus_node_key(tree, node, mid), k) < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+/* Returns the index of the first key of the node that is greater than k. */
+size_t b_plus_node_upper_bound(BPlusTree *tree, BPlusNode *node, void *k) {
+  size_t lo = 0;
+  size_t hi = node->len;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (b_plus_tree_compare(tree, b_plus_node_key(tree, node, mid), k) <= 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+void b_plus_leaf_insert(BPlusTree *tree, BPlusNode *leaf, size_t pos, void *k,
+                        void *v) {
+  size_t moved = leaf->len - pos;
+  memmove(b_plus_node_key(tree, leaf, pos + 1),
+          b_plus_node_key(tree, leaf, pos), moved * tree->key_size);
+  memcpy(b_plus_node_key(tree, leaf, pos), k, tree->key_size);
+  if (tree->value_size) {
+    memmove(b_plus_node_value(tree, leaf, pos + 1),
+            b_plus_node_value(tree, leaf, pos), moved * tree->value_size);
+    memcpy(b_plus_node_value(tree, leaf, pos), v, tree->value_size);
+  }
+  leaf->len++;
+}
+
+void b_plus_leaf_erase(BPlusTree *tree, BPlusNode *leaf, size_t pos) {
+  size_t moved = leaf->len - pos - 1;
+  memmove(b_plus_node_key(tree, leaf, pos),
+          b_plus_node_key(tree, leaf, pos + 1), moved * tree->key_size);
+  if (tree->value_size) {
+    memmove(b_plus_node_value(tree, leaf, pos),
+            b_plus_node_value(tree, leaf, pos + 1), moved * tree->value_size);
+  }
+  leaf->len--;
+}
+
+/* Inserts the key at pos and the child right of it at pos + 1. */
+void b_plus_inner_insert(BPlusTree *tree, BPlusNode *node, size_t pos, void *k,
+                         BPlusNode *child) {
+  BPlusNode **children = b_plus_node_children(tree, node);
+  memmove(b_plus_node_key(tree, node, pos + 1),
+          b_plus_node_key(tree, node, pos), (node->len - pos) * tree->key_size);
+  memcpy(b_plus_node_key(tree, node, pos), k, tree->key_size);
+  memmove(&children[pos + 2], &children[pos + 1],
+          (node->len - pos) * sizeof(BPlusNode *));
+  children[pos + 1] = child;
+  node->len++;
+}
+
+/* Removes the key at pos and the child right of it at pos + 1. */
+void b_plus_inner_erase(BPlusTree *tree, BPlusNode *node, size_t pos) {
+  BPlusNode **children = b_plus_node_children(tree, node);
+  memmove(b_plus_node_key(tree, node, pos),
+          b_plus_node_key(tree, node, pos + 1),
+          (node->len - pos - 1) * tree->key_size);
+  memmove(&children[pos + 1], &children[pos + 2],
+          (node->len - pos - 1) * sizeof(BPlusNode *));
+  node->len--;
+}
+
+/* Moves the upper half of a full leaf into the empty leaf right, linked in. */
+void b_plus_leaf_split(BPlusTree *tree, BPlusNode *leaf, BPlusNode *right) {
+  size_t keep = (leaf->len + 1) / 2;
+  right->len = leaf->len - keep;
+  memcpy(b_plus_node_key(tree, right, 0), b_plus_node_key(tree, leaf, keep),
+         right->len * tree->key_size);
+  memcpy(b_plus_node_value(tree, right, 0), b_plus_node_value(tree, leaf, keep),
+         right->len * tree->value_size);
+  leaf->len = keep;
+
+  right->next = leaf->next;
+  if (right->next)
+    right->next->prev = right;
+  right->prev = leaf;
+  leaf->next = right;
+}
+
+/**
+ * Moves the upper half of a full inner node into the empty inner node right.
+ * The middle key separates both nodes and is written to promoted.
+ */
+void b_plus_inner_split(BPlusTree *tree, BPlusNode *node, BPlusNode *right,
+                        void *promoted) {
+  size_t mid = node->len / 2;
+  memcpy(promoted, b_plus_node_key(tree, node, mid), tree->key_size);
+  right->len = node->len - mid - 1;
+  memcpy(b_plus_node_key(tree, right, 0), b_plus_node_key(tree, node, mid + 1),
+         right->len * tree->key_size);
+  memcpy(b_plus_node_children(tree, right),
+         &b_plus_node_children(tree, node)[mid + 1],
+         (right->len + 1) * sizeof(BPlusNode *));
+  node->len = mid;
+}
+
+/**
+ * Allocates the nodes that inserting k splits off before anything changes:
+ * the leaf, every full inner node above it and a new root if the splits reach
+ * the old one. spares[i] is the node for the split i levels above the leaves.
+ * Frees the nodes again and returns EXIT FAILURE if any allocation fails.
+ */
+int b_plus_tree_reserve_splits(BPlusTree *tree, void *k, BPlusNode **spares) {
+  // Number of full inner nodes directly above the current node.
+  size_t full = 0;
+  BPlusNode *node = tree->root;
+  while (!node->leaf) {
+    full = node->len == tree->capacity ? full + 1 : 0;
+    size_t idx = b_plus_node_upper_bound(tree, node, k);
+    node = b_plus_node_children(tree, node)[idx];
+  }
+  size_t pos = b_plus_node_lower_bound(tree, node, k);
+  if (node->len < tree->capacity ||
+      (pos < node->len &&
+       b_plus_tree_compare(tree, b_plus_node_key(tree, node, pos), k) == 0))
+    return EXIT_SUCCESS;
+
+  size_t needed = full + 1 + (full == tree->height - 1);
+  for (size_t i = 0; i < needed; i++) {
+    spares[i] = b_plus_node_new(tree, i == 0);
+    if (!spares[i]) {
+      while (i > 0)
+        free(spares[--i]);
+      return EXIT_FAILURE;
+    }
+  }
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Inserts the key into the subtree of node, which lies level levels above the
+ * leaves. If the node had to be split into spares[level], that right sibling
+ * is written to split and its separator key to separator.
+ */
+void b_plus_node_put(BPlusTree *tree, BPlusNode *node, size_t level,
+                     BPlusNode **spares, void *k, void *v, BPlusNode **split,
+                     void *separator) {
+  *split = NULL;
+  if (node->leaf) {
+    size_t pos = b_plus_node_lower_bound(tree, node, k);
+    if (pos < node->len &&
+        b_plus_tree_compare(tree, b_plus_node_key(tree, node, pos), k) == 0) {
+      if (tree->value_size)
+        memcpy(b_plus_node_value(tree, node, pos), v, tree->value_size);
+      return;
+    }
+    if (node->len == tree->capacity) {
+      BPlusNode *right = spares[level];
+      b_plus_leaf_split(tree, node, right);
+      if (pos > node->len)
+        b_plus_leaf_insert(tree, right, pos - node->len, k, v);
+      else
+        b_plus_leaf_insert(tree, node, pos, k, v);
+      memcpy(separator, b_plus_node_key(tree, right, 0), tree->key_size);
+      *split = right;
+    } else {
+      b_plus_leaf_insert(tree, node, pos, k, v);
+    }
+    tree->len++;
+    return;
+  }
+
+  size_t idx = b_plus_node_upper_bound(tree, node, k);
+  BPlusNode *child = b_plus_node_children(tree, node)[idx];
+  BPlusNode *child_split;
+  b_plus_node_put(tree, child, level - 1, spares, k, v, &child_split,
+                  separator);
+  if (!child_split)
+    return;
+
+  // The child was split, its separator is inside the separator buffer.
+  if (node->len == tree->capacity) {
+    char *promoted = (char *)tree->scratch + tree->key_size;
+    BPlusNode *right = spares[level];
+    b_plus_inner_split(tree, node, right, promoted);
+    if (idx <= node->len)
+      b_plus_inner_insert(tree, node, idx, separator, child_split);
+    else
+      b_plus_inner_insert(tree, right, idx - node->len - 1, separator,
+                          child_split);
+    memcpy(separator, promoted, tree->key_size);
+    *split = right;
+  } else {
+    b_plus_inner_insert(tree, node, idx, separator, child_split);
+  }
+}
+
+void b_plus_node_borrow_left(BPlusTree *tree, BPlusNode *parent, size_t idx) {
+  BPlusNode **siblings = b_plus_node_children(tree, parent);
+  BPlusNode *child = siblings[idx];
+  BPlusNode *left = siblings[idx - 1];
+  if (child->leaf) {
+    b_plus_leaf_insert(tree, child, 0,
+                       b_plus_node_key(tree, left, left->len - 1),
+                       b_plus_node_value(tree, left, left->len - 1));
+    left->len--;
+    memcpy(b_plus_node_key(tree, parent, idx - 1),
+           b_plus_node_key(tree, child, 0), tree->key_size);
+    return;
+  }
+  BPlusNode **children = b_plus_node_children(tree, child);
+  memmove(b_plus_node_key(tree, child, 1), b_plus_node_key(tree, child, 0),
+          child->len * tree->key_size);
+  memmove(&children[1], &children[0], (child->len + 1) * sizeof(BPlusNode *));
+  memcpy(b_plus_node_key(tree, child, 0),
+         b_plus_node_key(tree, parent, idx - 1), tree->key_size);
+  children[0] = b_plus_node_children(tree, left)[left->len];
+  child->len++;
+  memcpy(b_plus_node_key(tree, parent, idx - 1),
+         b_plus_node_key(tree, left, left->len - 1), tree->key_size);
+  left->len--;
+}
+
+void b_plus_node_borrow_right(BPlusTree *tree, BPlusNode *parent, size_t idx) {
+  BPlusNode **siblings = b_plus_node_children(tree, parent);
+  BPlusNode *child = siblings[idx];
+  BPlusNode *right = siblings[idx + 1];
+  if (child->leaf) {
+    b_plus_leaf_insert(tree, child, child->len, b_plus_node_key(tree, right, 0),
+                       b_plus_node_value(tree, right, 0));
+    b_plus_leaf_erase(tree, right, 0);
+    memcpy(b_plus_node_key(tree, parent, idx), b_plus_node_key(tree, right, 0),
+           tree->key_size);
+    return;
+  }
+  BPlusNode **children = b_plus_node_children(tree, right);
+  memcpy(b_plus_node_key(tree, child, child->len),
+         b_plus_node_key(tree, parent, idx), tree->key_size);
+  b_plus_node_children(tree, child)[child->len + 1] = children[0];
+  child->len++;
+  memcpy(b_plus_node_key(tree, parent, idx), b_plus_node_key(tree, right, 0),
+         tree->key_size);
+  memmove(b_plus_node_key(tree, right, 0), b_plus_node_key(tree, right, 1),
+          (right->len - 1) * tree->key_size);
+  memmove(&children[0], &children[1], right->len * sizeof(BPlusNode *));
+  right->len--;
+}
+
+/* Merges the child at idx + 1 into the child at idx. */
+void b_plus_node_merge(BPlusTree *tree, BPlusNode *parent, size_t idx) {
+  BPlusNode **siblings = b_plus_node_children(tree, parent);
+  BPlusNode *left = siblings[idx];
+  BPlusNode *right = siblings[idx + 1];
+  if (left->leaf) {
+    memcpy(b_plus_node_key(tree, left, left->len),
+           b_plus_node_key(tree, right, 0), right->len * tree->key_size);
+    memcpy(b_plus_node_value(tree, left, left->len),
+           b_plus_node_value(tree, right, 0), right->len * tree->value_size);
+    left->len += right->len;
+    left->next = right->next;
+    if (left->next)
+      left->next->prev = left;
+  } else {
+    memcpy(b_plus_node_key(tree, left, left->len),
+           b_plus_node_key(tree, parent, idx), tree->key_size);
+    memcpy(b_plus_node_key(tree, left, left->len + 1),
+           b_plus_node_key(tree, right, 0), right->len * tree->key_size);
+    memcpy(&b_plus_node_children(tree, left)[left->len + 1],
+           b_plus_node_children(tree, right),
+           (right->len + 1) * sizeof(BPlusNode *));
+    left->len += right->len + 1;
+  }
+  free(right);
+  b_plus_inner_erase(tree, parent, idx);
+}
+
+/* Restores the minimum fill of the child at idx. */
+void b_plus_node_rebalance(BPlusTree *tree, BPlusNode *parent, size_t idx) {
+  size_t min = tree->capacity / 2;
+  BPlusNode **siblings = b_plus_node_children(tree, parent);
+  if (idx > 0 && siblings[idx - 1]->len > min) {
+    b_plus_node_borrow_left(tree, parent, idx);
+  } else if (idx < parent->len && siblings[idx + 1]->len > min) {
+    b_plus_node_borrow_right(tree, parent, idx);
+  } else if (idx > 0) {
+    b_plus_node_merge(tree, parent, idx - 1);
+  } else {
+    b_plus_node_merge(tree, parent, idx);
+  }
+}
+
+bool b_plus_node_remove(BPlusTree *tree, BPlusNode *node, void *k) {
+  if (node->leaf) {
+    size_t pos = b_plus_node_lower_bound(tree, node, k);
+    if (pos == node->len ||
+        b_plus_tree_compare(tree, b_plus_node_key(tree, node, pos), k) != 0)
+      return false;
+    b_plus_leaf_erase(tree, node, pos);
+    tree->len--;
+    return true;
+  }
+
+  size_t idx = b_plus_node_upper_bound(tree, node, k);
+  BPlusNode *child = b_plus_node_children(tree, node)[idx];
+  if (!b_plus_node_remove(tree, child, k))
+    return false;
+  if (child->len < tree->capacity / 2)
+    b_plus_node_rebalance(tree, node, idx);
+  return true;
+}
+
+BPlusTree *b_plus_tree_new(size_t key_size, size_t value_size,
+                           Comperator comperator) {
+  BPlusTree *created = malloc(sizeof(BPlusTree));
+  if (!created)
+    return NULL;
+  created->scratch = malloc(2 * key_size);
+  if (!created->scratch) {
+    free(created);
+    return NULL;
+  }
+
+  size_t capacity = NODE_KEY_BYTES / (key_size ? key_size : 1);
+  if (capacity < MIN_NODE_CAPACITY)
+    capacity = MIN_NODE_CAPACITY;
+  if (capacity > MAX_NODE_CAPACITY)
+    capacity = MAX_NODE_CAPACITY;
+
+  created->root = NULL;
+  created->len = 0;
+  created->height = 0;
+  created->key_size = key_size;
+  created->value_size = value_size;
+  created->capacity = capacity;
+  created->payload_offset =
+      ALIGN_UP(sizeof(BPlusNode)) + ALIGN_UP(capacity * key_size);
+  created->comperator = comperator;
+  return created;
+}
+
+void b_plus_tree_free(BPlusTree *tree) {
+  b_plus_tree_clear(tree);
+  free(tree->scratch);
+  free(tree);
+}
+
+int b_plus_tree_put(BPlusTree *tree, void *k, void *v) {
+  if (tree->root == NULL) {
+    tree->root = b_plus_node_new(tree, true);
+    if (!tree->root)
+      return EXIT_FAILURE;
+    tree->height = 1;
+  }
+
+  BPlusNode *spares[B_PLUS_TREE_MAX_HEIGHT + 1];
+  if (b_plus_tree_reserve_splits(tree, k, spares) != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+  BPlusNode *split;
+  b_plus_node_put(tree, tree->root, tree->height - 1, spares, k, v, &split,
+                  tree->scratch);
+  if (!split)
+    return EXIT_SUCCESS;
+
+  // The root was split, grow the tree by one level.
+  BPlusNode *root = spares[tree->height];
+  memcpy(b_plus_node_key(tree, root, 0), tree->scratch, tree->key_size);
+  b_plus_node_children(tree, root)[0] = tree->root;
+  b_plus_node_children(tree, root)[1] = split;
+  root->len = 1;
+  tree->root = root;
+  tree->height++;
+  return EXIT_SUCCESS;
+}
+
+bool b_plus_tree_lower_bound(BPlusTree *tree, void *k, BPlusCursor *cursor) {
+  BPlusNode *node = tree->root;
+  if (node == NULL)
+    return false;
+  while (!node->leaf) {
+    size_t idx = b_plus_node_upper_bound(tree, node, k);
+    node = b_plus_node_children(tree, node)[idx];
+  }
+  cursor->leaf = node;
+  cursor->index = b_plus_node_lower_bound(tree, node, k);
+  if (cursor->index < node->len)
+    return true;
+  // All keys of the leaf are smaller, continue with the next leaf.
+  cursor->index = node->len - 1;
+  return b_plus_cursor_next(cursor);
+}
+
+bool b_plus_tree_upper_bound(BPlusTree *tree, void *k, BPlusCursor *cursor) {
+  BPlusNode *node = tree->root;
+  if (node == NULL)
+    return false;
+  while (!node->leaf) {
+    size_t idx = b_plus_node_upper_bound(tree, node, k);
+    node = b_plus_node_children(tree, node)[idx];
+  }
+  cursor->leaf = node;
+  cursor->index = b_plus_node_upper_bound(tree, node, k);
+  if (cursor->index < node->len)
+    return true;
+  cursor->index = node->len - 1;
+  return b_plus_cursor_next(cursor);
+}
+
+bool b_plus_tree_floor(BPlusTree *tree, void *k, BPlusCursor *cursor) {
+  if (b_plus_tree_upper_bound(tree, k, cursor))
+    return b_plus_cursor_prev(cursor);
+  // All keys are not greater than k, the largest one is the floor.
+  return b_plus_tree_last(tree, cursor);
+}
+
+int b_plus_tree_get(BPlusTree *tree, void *k, void *v) {
+  BPlusCursor cursor;
+  if (!b_plus_tree_lower_bound(tree, k, &cursor) ||
+      b_plus_tree_compare(tree, b_plus_cursor_key(tree, &cursor), k) != 0)
+    return EXIT_FAILURE;
+  memcpy(v, b_plus_cursor_value(tree, &cursor), tree->value_size);
+  return EXIT_SUCCESS;
+}
+
+bool b_plus_tree_contains(BPlusTree *tree, void *k) {
+  BPlusCursor cursor;
+  return b_plus_tree_lower_bound(tree, k, &cursor) &&
+         b_plus_tree_compare(tree, b_plus_cursor_key(tree, &cursor), k) == 0;
+}
+
+int b_plus_tree_remove(BPlusTree *tree, void *k) {
+  if (tree->root == NULL || !b_plus_node_remove(tree, tree->root, k))
+    return EXIT_FAILURE;
+
+  BPlusNode *root = tree->root;
+  if (root->len == 0) {
+    // Shrink the tree by one level, or drop the last leaf.
+    tree->root = root->leaf ? NULL : b_plus_node_children(tree, root)[0];
+    tree->height--;
+    free(root);
+  }
+  return EXIT_SUCCESS;
+}
+
+void b_plus_tree_clear(BPlusTree *tree) {
+  if (tree->root != NULL) {
+    b_plus_node_free(tree, tree->root);
+    tree->root = NULL;
+  }
+  tree->len = 0;
+  tree->height = 0;
+}
+
+size_t b_plus_tree_height(BPlusTree *tree) { return tree->height; }
+
+bool b_plus_tree_first(BPlusTree *tree, BPlusCursor *cursor) {
+  BPlusNode *node = tree->root;
+  if (node == NULL)
+    return false;
+  while (!node->leaf)
+    node = b_plus_node_children(tree, node)[0];
+  cursor->leaf = node;
+  cursor->index = 0;
+  return true;
+}
+
+bool b_plus_tree_last(BPlusTree *tree, BPlusCursor *cursor) {
+  BPlusNode *node = tree->root;
+  if (node == NULL)
+    return false;
+  while (!node->leaf)
+    node = b_plus_node_children(tree, node)[node->len];
+  cursor->leaf = node;
+  cursor->index = node->len - 1;
+  return true;
+}
+
+bool b_plus_cursor_next(BPlusCursor *cursor) {
+  if (cursor->index + 1 < cursor->leaf->len) {
+    cursor->index++;
+    return true;
+  }
+  if (cursor->leaf->next == NULL)
+    return false;
+  cursor->leaf = cursor->leaf->next;
+  cursor->index = 0;
+  return true;
+}
+
+bool b_plus_cursor_prev(BPlusCursor *cursor) {
+  if (cursor->index > 0) {
+    cursor->index--;
+    return true;
+  }
+  if (cursor->leaf->prev == NULL)
+    return false;
+  cursor->leaf = cursor->leaf->prev;
+  cursor->index = cursor->leaf->len - 1;
+  return true;
+}
+
+void *b_plus_cursor_key(BPlusTree *tree, BPlusCursor *cursor) {
+  return b_plus_node_key(tree, cursor->leaf, cursor->index);
+}
+
+void *b_plus_cursor_value(BPlusTree *tree, BPlusCursor *cursor) {
+  return b_plus_node_value(tree, cursor->leaf, cursor->index);
+}
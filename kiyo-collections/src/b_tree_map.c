@@ -1,46 +1,54 @@
 #include "kiyo-collections/b_tree_map.h"
+#include "kiyo-collections/hash.h"
+#include "kiyo-collections/vec.h"
+#include "align.h"
 #include <stdlib.h>
 #include <string.h>
 
+/* Number of lookups that get_many keeps in flight at once. */
+#define B_TREE_MAP_LANES 8
+
 BinaryEntry *binary_entry_new(void *key, void *value, int key_size,
                               int value_size) {
-  BinaryEntry *created = malloc(sizeof(BinaryEntry));
+  // The key and the value are stored inline behind the entry, so a single
+  // allocation holds the whole entry.
+  size_t key_offset = ALIGN_UP(sizeof(BinaryEntry));
+  size_t value_offset = key_offset + ALIGN_UP(key_size);
+  BinaryEntry *created = malloc(value_offset + value_size);
   if (!created) {
     return NULL;
   }
 
-  void *mkey = malloc(key_size);
-  if (!mkey) {
-    free(created);
-    return NULL;
-  }
-  void *mvalue = malloc(value_size);
-  if (!mvalue) {
-    free(created);
-    free(mkey);
-    return NULL;
-  }
-  memcpy(mkey, key, key_size);
-  memcpy(mvalue, value, value_size);
+  created->key = (char *)created + key_offset;
+  created->value = (char *)created + value_offset;
+  memcpy(created->key, key, key_size);
+  if (value)
+    memcpy(created->value, value, value_size);
+  else
+    memset(created->value, 0, value_size);
 
-  created->key = mkey;
-  created->value = mvalue;
   created->height = 1;
+  created->size = 1;
   created->left = NULL;
   created->right = NULL;
   return created;
 }
 
 void binary_entry_free(BinaryEntry *node) {
-  if (node->left) {
-    binary_entry_free(node->left);
-  }
-  if (node->right) {
-    binary_entry_free(node->right);
+  // Rotate left children up until the node has none, then free it and
+  // continue with its right child. This needs neither recursion nor a stack.
+  while (node) {
+    if (node->left) {
+      BinaryEntry *left = node->left;
+      node->left = left->right;
+      left->right = node;
+      node = left;
+    } else {
+      BinaryEntry *right = node->right;
+      free(node);
+      node = right;
+    }
   }
-  free(node->key);
-  free(node->value);
-  free(node);
 }
 
 void binary_entry_update_height(BinaryEntry *node) {
@@ -49,6 +57,13 @@ void binary_entry_update_height(BinaryEntry *node) {
   node->height = (height_left > height_right ? height_left : height_right) + 1;
 }
 
+size_t binary_entry_size(BinaryEntry *node) { return node ? node->size : 0; }
+
+void binary_entry_update_size(BinaryEntry *node) {
+  node->size =
+      binary_entry_size(node->left) + binary_entry_size(node->right) + 1;
+}
+
 BinaryEntry *binary_entry_rotate_right(BinaryEntry *node) {
   BinaryEntry *left = node->left;
   node->left = left->right;
@@ -56,6 +71,8 @@ BinaryEntry *binary_entry_rotate_right(BinaryEntry *node) {
 
   binary_entry_update_height(node);
   binary_entry_update_height(left);
+  binary_entry_update_size(node);
+  binary_entry_update_size(left);
 
   return left;
 }
@@ -67,6 +84,8 @@ BinaryEntry *binary_entry_rotate_left(BinaryEntry *node) {
 
   binary_entry_update_height(node);
   binary_entry_update_height(right);
+  binary_entry_update_size(node);
+  binary_entry_update_size(right);
 
   return right;
 }
@@ -77,67 +96,264 @@ int binary_entry_get_balance_factor(BinaryEntry *node) {
   return height_left - height_right;
 }
 
-int binary_entry_put(BTreeMap *tree, BinaryEntry **origin, void *k, void *v) {
-  BinaryEntry *node = *origin;
-  int c = tree->comperator(node->key, k);
-  if (c == 0) {
-    memcpy(node->value, v, tree->value_size);
-    return EXIT_SUCCESS;
-  }
-
-  // Pointer to the node we want to check.
-  BinaryEntry **target = (c > 0) ? &(node->right) : &(node->left);
-
-  int status;
-  if (*target == NULL) {
-    *target = binary_entry_new(k, v, tree->key_size, tree->value_size);
-    tree->len++;
-    status = *target == NULL ? EXIT_FAILURE : EXIT_SUCCESS;
-  } else {
-    status = binary_entry_put(tree, target, k, v);
-  }
+/* Restores the AVL property of the node and returns the new subtree root. */
+BinaryEntry *binary_entry_rebalance(BinaryEntry *node) {
   binary_entry_update_height(node);
+  binary_entry_update_size(node);
   int balance_factor = binary_entry_get_balance_factor(node);
   if (balance_factor > 1) {
     if (binary_entry_get_balance_factor(node->left) < 0) {
       node->left = binary_entry_rotate_left(node->left);
     }
-    *origin = binary_entry_rotate_right(node);
+    return binary_entry_rotate_right(node);
   } else if (balance_factor < -1) {
     if (binary_entry_get_balance_factor(node->right) > 0) {
       node->right = binary_entry_rotate_right(node->right);
     }
-    *origin = binary_entry_rotate_left(node);
+    return binary_entry_rotate_left(node);
   }
-  return status;
+  return node;
 }
 
-int binary_entry_get(BTreeMap *tree, BinaryEntry *node, void *k, void *v) {
-  int c = tree->comperator(node->key, k);
-  if (c == 0) {
-    memcpy(v, node->value, tree->value_size);
-    return EXIT_SUCCESS;
-  } else {
-    BinaryEntry *relevant_child = (c > 0) ? node->right : node->left;
-    if (relevant_child == NULL)
-      return EXIT_FAILURE;
-    return binary_entry_get(tree, relevant_child, k, v);
+/**
+ * Rebalances the links on the path from the bottom up. Once a subtree keeps
+ * its height nothing above it needs rotations anymore, but the sizes of all
+ * ancestors still change.
+ */
+void binary_entry_rebalance_path(BinaryEntry ***path, size_t depth) {
+  bool balanced = false;
+  while (depth > 0) {
+    BinaryEntry **link = path[--depth];
+    if (balanced) {
+      binary_entry_update_size(*link);
+      continue;
+    }
+    size_t height = (*link)->height;
+    *link = binary_entry_rebalance(*link);
+    balanced = (*link)->height == height;
   }
 }
 
-bool binary_entry_contains_key(BTreeMap *tree, BinaryEntry *node, void *e) {
-  int c = tree->comperator(node->key, e);
-  if (c == 0)
-    return true;
+int b_tree_map_compare_u64(void *left, void *right) {
+  return COMPARE_ASCENDING(*(uint64_t *)left, *(uint64_t *)right);
+}
 
-  // Pointer to the node we want to check.
-  BinaryEntry **relevant_child = (c > 0) ? &(node->right) : &(node->left);
+int b_tree_map_compare_i64(void *left, void *right) {
+  return COMPARE_ASCENDING(*(int64_t *)left, *(int64_t *)right);
+}
 
-  if ((*relevant_child) == NULL) {
-    return false;
-  } else {
-    return binary_entry_contains_key(tree, *relevant_child, e);
+/**
+ * Compares two doubles. NaN sorts after every number and equals only NaN, so
+ * that a NaN lookup cannot match, and remove, another key.
+ */
+int b_tree_map_compare_f64(void *left, void *right) {
+  double l;
+  double r;
+  memcpy(&l, left, sizeof(l));
+  memcpy(&r, right, sizeof(r));
+  bool l_nan = l != l;
+  bool r_nan = r != r;
+  if (l_nan || r_nan)
+    return COMPARE_ASCENDING(l_nan, r_nan);
+  return COMPARE_ASCENDING(l, r);
+}
+
+int b_tree_map_compare_cstr(void *left, void *right) {
+  int c = strcmp(*(char **)left, *(char **)right);
+  return COMPARE_ASCENDING(c, 0);
+}
+
+/**
+ * Compares two keys of the map. Built-in key types are compared right here,
+ * which lets the compiler inline the comparison into the search loops.
+ */
+int b_tree_map_compare(BTreeMap *tree, void *left, void *right) {
+  switch (tree->key_type) {
+  case B_TREE_KEY_U64:
+    return b_tree_map_compare_u64(left, right);
+  case B_TREE_KEY_I64:
+    return b_tree_map_compare_i64(left, right);
+  case B_TREE_KEY_F64:
+    return b_tree_map_compare_f64(left, right);
+  case B_TREE_KEY_BYTES: {
+    int c = memcmp(left, right, tree->key_size);
+    return COMPARE_ASCENDING(c, 0);
+  }
+  case B_TREE_KEY_CSTR:
+    return b_tree_map_compare_cstr(left, right);
+  default:
+    return tree->comperator(left, right);
+  }
+}
+
+/**
+ * Generates binary_entry_find_N, which searches for a scalar key of type T.
+ * The key lives in a register and is compared with plain operators.
+ */
+#define GENERATE_BINARY_ENTRY_FIND(N, T)                                       \
+  BinaryEntry *binary_entry_find_##N(BinaryEntry *node, T key) {               \
+    while (node) {                                                             \
+      T node_key = *(T *)node->key;                                            \
+      if (node_key == key)                                                     \
+        return node;                                                           \
+      node = node_key < key ? node->right : node->left;                        \
+    }                                                                          \
+    return NULL;                                                               \
+  }
+
+GENERATE_BINARY_ENTRY_FIND(u64, uint64_t)
+GENERATE_BINARY_ENTRY_FIND(i64, int64_t)
+GENERATE_BINARY_ENTRY_FIND(f64, double)
+
+BinaryEntry *binary_entry_find(BTreeMap *tree, void *k) {
+  // The key may be unaligned, it is copied once instead of on every level.
+  switch (tree->key_type) {
+  case B_TREE_KEY_U64: {
+    uint64_t key;
+    memcpy(&key, k, sizeof(key));
+    return binary_entry_find_u64(tree->root, key);
+  }
+  case B_TREE_KEY_I64: {
+    int64_t key;
+    memcpy(&key, k, sizeof(key));
+    return binary_entry_find_i64(tree->root, key);
+  }
+  case B_TREE_KEY_F64: {
+    double key;
+    memcpy(&key, k, sizeof(key));
+    return binary_entry_find_f64(tree->root, key);
+  }
+  default:
+    break;
   }
+  BinaryEntry *node = tree->root;
+  while (node) {
+    int c = b_tree_map_compare(tree, node->key, k);
+    if (c == 0)
+      return node;
+    node = (c > 0) ? node->right : node->left;
+  }
+  return NULL;
+}
+
+/**
+ * Asks the cache to load the entry and its inline key. The key is found by its
+ * offset, reading node->key would already wait for the entry.
+ */
+void binary_entry_prefetch(BinaryEntry *node) {
+#if defined(__GNUC__) || defined(__clang__)
+  if (node) {
+    __builtin_prefetch(node);
+    __builtin_prefetch((char *)node + ALIGN_UP(sizeof(BinaryEntry)));
+  }
+#else
+  (void)node;
+#endif
+}
+
+BinaryEntry *binary_entry_floor(BTreeMap *tree, void *k) {
+  BinaryEntry *node = tree->root;
+  BinaryEntry *best = NULL;
+  while (node) {
+    int c = b_tree_map_compare(tree, node->key, k);
+    if (c == 0)
+      return node;
+    if (c > 0) {
+      best = node;
+      node = node->right;
+    } else {
+      node = node->left;
+    }
+  }
+  return best;
+}
+
+BinaryEntry *binary_entry_ceiling(BTreeMap *tree, void *k) {
+  BinaryEntry *node = tree->root;
+  BinaryEntry *best = NULL;
+  while (node) {
+    int c = b_tree_map_compare(tree, node->key, k);
+    if (c == 0)
+      return node;
+    if (c < 0) {
+      best = node;
+      node = node->left;
+    } else {
+      node = node->right;
+    }
+  }
+  return best;
+}
+
+/* Returns a pointer to the i-th key of the small array. */
+char *b_tree_map_small_key(BTreeMap *tree, size_t i) {
+  return tree->small + i * tree->key_size;
+}
+
+/* Returns a pointer to the i-th value of the small array. */
+char *b_tree_map_small_value(BTreeMap *tree, size_t i) {
+  return tree->small + ALIGN_UP(tree->small_capacity * tree->key_size) +
+         i * tree->value_size;
+}
+
+/**
+ * Returns the index of the first key in the small array that is not less than
+ * k and sets found to whether that key equals k.
+ */
+size_t b_tree_map_small_search(BTreeMap *tree, void *k, bool *found) {
+  size_t lo = 0;
+  size_t hi = tree->len;
+  *found = false;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    int c = b_tree_map_compare(tree, b_tree_map_small_key(tree, mid), k);
+    if (c == 0) {
+      *found = true;
+      return mid;
+    }
+    if (c > 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+/* Moves the small array into a new allocation with room for capacity. */
+int b_tree_map_small_resize(BTreeMap *tree, size_t capacity) {
+  // Keys come first so that a binary search only touches keys.
+  size_t values_offset = ALIGN_UP(capacity * tree->key_size);
+  char *small = malloc(values_offset + capacity * tree->value_size + 1);
+  if (!small)
+    return EXIT_FAILURE;
+  // A tree that turns back into an array has no entries to move yet.
+  if (tree->small) {
+    memcpy(small, tree->small, tree->len * tree->key_size);
+    memcpy(small + values_offset, b_tree_map_small_value(tree, 0),
+           tree->len * tree->value_size);
+  }
+  free(tree->small);
+  tree->small = small;
+  tree->small_capacity = capacity;
+  return EXIT_SUCCESS;
+}
+
+/* Pushes the node and its chain of left children onto the iterator stack. */
+void b_tree_map_iter_push_left(BTreeMapIter *iter, BinaryEntry *node) {
+  while (node) {
+    iter->stack[iter->depth++] = node;
+    node = node->left;
+  }
+}
+
+/* Copies the key and the value to the buffers that are not NULL. */
+int b_tree_map_write(BTreeMap *tree, void *k, void *v, void *buffer_k,
+                     void *buffer_v) {
+  if (buffer_k)
+    memcpy(buffer_k, k, tree->key_size);
+  if (buffer_v)
+    memcpy(buffer_v, v, tree->value_size);
+  return EXIT_SUCCESS;
 }
 
 BTreeMap *b_tree_map_new(size_t key_size, size_t value_size,
@@ -148,51 +364,940 @@ BTreeMap *b_tree_map_new(size_t key_size, size_t value_size,
   created->key_size = key_size;
   created->value_size = value_size;
   created->comperator = comperator;
+  created->paged = NULL;
+  created->arena = NULL;
+  created->key_type = B_TREE_KEY_GENERIC;
+  created->small = NULL;
+  created->small_capacity = 0;
+  created->small_limit = B_TREE_MAP_SMALL_LIMIT;
+  created->filter = NULL;
+  return created;
+}
+
+/* Creates an AVL map that compares keys of the given type itself. */
+BTreeMap *b_tree_map_new_typed(BTreeKeyType key_type, size_t key_size,
+                               size_t value_size, Comperator comperator) {
+  BTreeMap *created = b_tree_map_new(key_size, value_size, comperator);
+  if (!created)
+    return NULL;
+  created->key_type = key_type;
+  return created;
+}
+
+BTreeMap *b_tree_map_new_u64(size_t value_size) {
+  return b_tree_map_new_typed(B_TREE_KEY_U64, sizeof(uint64_t), value_size,
+                              &b_tree_map_compare_u64);
+}
+
+BTreeMap *b_tree_map_new_i64(size_t value_size) {
+  return b_tree_map_new_typed(B_TREE_KEY_I64, sizeof(int64_t), value_size,
+                              &b_tree_map_compare_i64);
+}
+
+BTreeMap *b_tree_map_new_f64(size_t value_size) {
+  return b_tree_map_new_typed(B_TREE_KEY_F64, sizeof(double), value_size,
+                              &b_tree_map_compare_f64);
+}
+
+BTreeMap *b_tree_map_new_bytes(size_t key_size, size_t value_size) {
+  // A comperator cannot see the key size. AVL maps only compare through the
+  // key type, so the map works without one.
+  return b_tree_map_new_typed(B_TREE_KEY_BYTES, key_size, value_size, NULL);
+}
+
+BTreeMap *b_tree_map_new_cstr(size_t value_size) {
+  return b_tree_map_new_typed(B_TREE_KEY_CSTR, sizeof(char *), value_size,
+                              &b_tree_map_compare_cstr);
+}
+
+BTreeMap *b_tree_map_new_paged(size_t key_size, size_t value_size,
+                               Comperator comperator) {
+  BTreeMap *created = b_tree_map_new(key_size, value_size, comperator);
+  if (!created)
+    return NULL;
+  created->paged = b_plus_tree_new(key_size, value_size, comperator);
+  if (!created->paged) {
+    free(created);
+    return NULL;
+  }
+  return created;
+}
+
+BTreeMap *b_tree_map_new_arena(size_t key_size, size_t value_size,
+                               Comperator comperator) {
+  BTreeMap *created = b_tree_map_new(key_size, value_size, comperator);
+  if (!created)
+    return NULL;
+  created->arena = arena_tree_new(key_size, value_size, comperator);
+  if (!created->arena) {
+    free(created);
+    return NULL;
+  }
+  return created;
+}
+
+/**
+ * Builds a perfectly balanced subtree from the sorted entries [lo, hi). The
+ * key of entry i is at keys + i * key_stride, its value at values + i *
+ * value_stride. Sets failed if an entry could not be allocated.
+ */
+BinaryEntry *binary_entry_build(BTreeMap *tree, char *keys, size_t key_stride,
+                                char *values, size_t value_stride, size_t lo,
+                                size_t hi, bool *failed) {
+  if (lo >= hi || *failed)
+    return NULL;
+  size_t mid = lo + (hi - lo) / 2;
+  BinaryEntry *node =
+      binary_entry_new(keys + mid * key_stride, values + mid * value_stride,
+                       tree->key_size, tree->value_size);
+  if (!node) {
+    *failed = true;
+    return NULL;
+  }
+  node->left = binary_entry_build(tree, keys, key_stride, values, value_stride,
+                                  lo, mid, failed);
+  node->right = binary_entry_build(tree, keys, key_stride, values,
+                                   value_stride, mid + 1, hi, failed);
+  binary_entry_update_height(node);
+  binary_entry_update_size(node);
+  return node;
+}
+
+/* Creates a map from n sorted entries, or NULL if an allocation failed. */
+BTreeMap *b_tree_map_build(size_t key_size, size_t value_size,
+                           Comperator comperator, char *keys,
+                           size_t key_stride, char *values,
+                           size_t value_stride, size_t n) {
+  BTreeMap *created = b_tree_map_new(key_size, value_size, comperator);
+  if (!created)
+    return NULL;
+  bool failed = false;
+  created->root = binary_entry_build(created, keys, key_stride, values,
+                                     value_stride, 0, n, &failed);
+  if (failed) {
+    b_tree_map_free(created);
+    return NULL;
+  }
+  created->len = n;
+  return created;
+}
+
+BTreeMap *b_tree_map_from_sorted(size_t key_size, size_t value_size,
+                                 Comperator comperator, void *keys,
+                                 void *values, size_t n) {
+  char *k = keys;
+  for (size_t i = 1; i < n; i++) {
+    if (comperator(k + (i - 1) * key_size, k + i * key_size) <= 0)
+      return NULL;
+  }
+  return b_tree_map_build(key_size, value_size, comperator, keys, key_size,
+                          values, value_size, n);
+}
+
+BTreeMap *b_tree_map_from_unsorted(size_t key_size, size_t value_size,
+                                   Comperator comperator, void *keys,
+                                   void *values, size_t n) {
+  // Pair every key with its value in one record, the key comes first so the
+  // comperator can be used on whole records.
+  size_t value_offset = ALIGN_UP(key_size);
+  Vec records = {NULL, n, n, ALIGN_UP(value_offset + value_size)};
+  if (n > 0) {
+    records.data = malloc(n * records.element_size);
+    if (!records.data)
+      return NULL;
+  }
+  for (size_t i = 0; i < n; i++) {
+    char *record = (char *)records.data + i * records.element_size;
+    memcpy(record, (char *)keys + i * key_size, key_size);
+    memcpy(record + value_offset, (char *)values + i * value_size, value_size);
+  }
+  if (vec_sort(&records, comperator) != EXIT_SUCCESS) {
+    free(records.data);
+    return NULL;
+  }
+
+  // Collapse runs of equal keys into their last record.
+  char *data = records.data;
+  size_t unique = 0;
+  for (size_t i = 0; i < n; i++) {
+    char *record = data + i * records.element_size;
+    if (unique > 0 &&
+        comperator(data + (unique - 1) * records.element_size, record) == 0)
+      unique--;
+    memmove(data + unique * records.element_size, record,
+            records.element_size);
+    unique++;
+  }
+
+  BTreeMap *created = b_tree_map_build(
+      key_size, value_size, comperator, data, records.element_size,
+      data + value_offset, records.element_size, unique);
+  free(records.data);
   return created;
 }
 
 void b_tree_map_free(BTreeMap *tree) {
+  if (tree->paged)
+    b_plus_tree_free(tree->paged);
+  if (tree->arena)
+    arena_tree_free(tree->arena);
   if (tree->root)
     binary_entry_free(tree->root);
+  free(tree->small);
+  if (tree->filter)
+    bloom_filter_free(tree->filter);
 
   free(tree);
 }
 
+/* Builds a balanced tree from the small array and frees the array. */
+int b_tree_map_grow_tree(BTreeMap *tree) {
+  if (tree->len == 0)
+    return EXIT_SUCCESS;
+  bool failed = false;
+  BinaryEntry *root = binary_entry_build(
+      tree, tree->small, tree->key_size, b_tree_map_small_value(tree, 0),
+      tree->value_size, 0, tree->len, &failed);
+  if (failed) {
+    binary_entry_free(root);
+    return EXIT_FAILURE;
+  }
+  free(tree->small);
+  tree->small = NULL;
+  tree->small_capacity = 0;
+  tree->root = root;
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Moves the entries of the tree into a small array with room for the limit and
+ * frees the tree. Keeps the tree if the array could not be allocated.
+ */
+void b_tree_map_shrink_tree(BTreeMap *tree) {
+  if (b_tree_map_small_resize(tree, tree->small_limit) != EXIT_SUCCESS)
+    return;
+  BTreeMapIter iter;
+  void *k;
+  void *v;
+  size_t i = 0;
+  b_tree_map_iter(tree, &iter);
+  while (b_tree_map_iter_next(&iter, &k, &v)) {
+    memcpy(b_tree_map_small_key(tree, i), k, tree->key_size);
+    memcpy(b_tree_map_small_value(tree, i), v, tree->value_size);
+    i++;
+  }
+  binary_entry_free(tree->root);
+  tree->root = NULL;
+}
+
+int b_tree_map_set_small_limit(BTreeMap *tree, size_t limit) {
+  if (tree->paged || tree->arena)
+    return EXIT_SUCCESS;
+  tree->small_limit = limit;
+  if (tree->root == NULL && tree->len > limit)
+    return b_tree_map_grow_tree(tree);
+  if (tree->root == NULL && tree->small_capacity > limit)
+    return b_tree_map_small_resize(tree, limit);
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Returns whether the key may not be inserted. The search of AVL maps with
+ * double keys compares them directly and would never find a NaN again.
+ */
+bool b_tree_map_invalid_key(BTreeMap *tree, void *k) {
+  if (tree->key_type != B_TREE_KEY_F64)
+    return false;
+  double key;
+  memcpy(&key, k, sizeof(key));
+  return key != key;
+}
+
+/**
+ * Returns a pointer to the value of the key, after inserting the key with the
+ * value v if it is missing. A NULL v inserts a value of zero bytes. Sets
+ * inserted to whether the key was missing, returns NULL if the key is invalid
+ * or the entry could not be allocated.
+ */
+void *b_tree_map_emplace(BTreeMap *tree, void *k, void *v, bool *inserted) {
+  *inserted = false;
+  if (b_tree_map_invalid_key(tree, k))
+    return NULL;
+  // A filter that knows a key that failed to insert only loses a bit of
+  // selectivity, so it is updated first.
+  if (tree->filter)
+    bloom_filter_add(tree->filter, k);
+  if (tree->paged) {
+    BPlusCursor cursor;
+    if (b_plus_tree_lower_bound(tree->paged, k, &cursor) &&
+        tree->comperator(b_plus_cursor_key(tree->paged, &cursor), k) == 0)
+      return b_plus_cursor_value(tree->paged, &cursor);
+    void *zero = NULL;
+    if (!v) {
+      zero = calloc(1, tree->value_size ? tree->value_size : 1);
+      if (!zero)
+        return NULL;
+      v = zero;
+    }
+    int status = b_plus_tree_put(tree->paged, k, v);
+    free(zero);
+    tree->len = tree->paged->len;
+    if (status != EXIT_SUCCESS)
+      return NULL;
+    // Splits move entries between leaves, so the cursor has to be found anew.
+    *inserted = true;
+    b_plus_tree_lower_bound(tree->paged, k, &cursor);
+    return b_plus_cursor_value(tree->paged, &cursor);
+  }
+  if (tree->arena) {
+    void *value = arena_tree_emplace(tree->arena, k, v, inserted);
+    tree->len = tree->arena->len;
+    return value;
+  }
+  if (tree->root == NULL) {
+    bool found;
+    size_t i = b_tree_map_small_search(tree, k, &found);
+    if (found)
+      return b_tree_map_small_value(tree, i);
+    if (tree->len < tree->small_limit) {
+      if (tree->len == tree->small_capacity) {
+        size_t capacity = tree->small_capacity ? tree->small_capacity * 2 : 4;
+        if (capacity > tree->small_limit)
+          capacity = tree->small_limit;
+        if (b_tree_map_small_resize(tree, capacity) != EXIT_SUCCESS)
+          return NULL;
+      }
+      size_t after = tree->len - i;
+      memmove(b_tree_map_small_key(tree, i + 1), b_tree_map_small_key(tree, i),
+              after * tree->key_size);
+      memmove(b_tree_map_small_value(tree, i + 1),
+              b_tree_map_small_value(tree, i), after * tree->value_size);
+      memcpy(b_tree_map_small_key(tree, i), k, tree->key_size);
+      if (v)
+        memcpy(b_tree_map_small_value(tree, i), v, tree->value_size);
+      else
+        memset(b_tree_map_small_value(tree, i), 0, tree->value_size);
+      tree->len++;
+      *inserted = true;
+      return b_tree_map_small_value(tree, i);
+    }
+    // The array is full, the entry goes into a tree built from it.
+    if (b_tree_map_grow_tree(tree) != EXIT_SUCCESS)
+      return NULL;
+  }
+
+  // Remember the links we followed, they are rebalanced after the insert.
+  BinaryEntry **path[B_TREE_MAP_MAX_HEIGHT];
+  size_t depth = 0;
+  BinaryEntry **link = &(tree->root);
+  while (*link) {
+    int c = b_tree_map_compare(tree, (*link)->key, k);
+    if (c == 0)
+      return (*link)->value;
+    path[depth++] = link;
+    link = (c > 0) ? &((*link)->right) : &((*link)->left);
+  }
+
+  BinaryEntry *node = binary_entry_new(k, v, tree->key_size, tree->value_size);
+  if (node == NULL)
+    return NULL;
+  *link = node;
+  tree->len++;
+  *inserted = true;
+  binary_entry_rebalance_path(path, depth);
+  return node->value;
+}
+
+/* Hashes a double key so that 0.0 and -0.0, which compare equal, match. */
+size_t b_tree_map_hash_f64(void *k) {
+  double d;
+  memcpy(&d, k, sizeof(d));
+  if (d == 0)
+    d = 0;
+  return hash_bytes(&d, sizeof(d));
+}
+
+int b_tree_map_attach_filter(BTreeMap *tree, Hasher hasher, size_t capacity) {
+  if (!hasher && tree->key_type == B_TREE_KEY_CSTR)
+    hasher = hash_cstr;
+  if (!hasher && tree->key_type == B_TREE_KEY_F64)
+    hasher = b_tree_map_hash_f64;
+  BloomFilter *filter = bloom_filter_new(
+      tree->key_size, hasher, capacity > tree->len ? capacity : tree->len);
+  if (!filter)
+    return EXIT_FAILURE;
+  BTreeMapIter iter;
+  void *k;
+  void *v;
+  b_tree_map_iter(tree, &iter);
+  while (b_tree_map_iter_next(&iter, &k, &v))
+    bloom_filter_add(filter, k);
+  b_tree_map_detach_filter(tree);
+  tree->filter = filter;
+  return EXIT_SUCCESS;
+}
+
+void b_tree_map_detach_filter(BTreeMap *tree) {
+  if (tree->filter)
+    bloom_filter_free(tree->filter);
+  tree->filter = NULL;
+}
+
 int b_tree_map_put(BTreeMap *tree, void *k, void *v) {
+  if (b_tree_map_invalid_key(tree, k))
+    return EXIT_FAILURE;
+  if (tree->paged) {
+    if (tree->filter)
+      bloom_filter_add(tree->filter, k);
+    int status = b_plus_tree_put(tree->paged, k, v);
+    tree->len = tree->paged->len;
+    return status;
+  }
+
+  bool inserted;
+  void *value = b_tree_map_emplace(tree, k, v, &inserted);
+  if (value == NULL)
+    return EXIT_FAILURE;
+  if (!inserted)
+    memcpy(value, v, tree->value_size);
+  return EXIT_SUCCESS;
+}
+
+int b_tree_map_get(BTreeMap *tree, void *k, void *v) {
+  if (tree->filter && !bloom_filter_contains(tree->filter, k))
+    return EXIT_FAILURE;
+  if (tree->paged)
+    return b_plus_tree_get(tree->paged, k, v);
+  if (tree->arena)
+    return arena_tree_get(tree->arena, k, v);
   if (tree->root == NULL) {
-    tree->root = binary_entry_new(k, v, tree->key_size, tree->value_size);
-    tree->len++;
+    void *value = b_tree_map_get_ptr(tree, k);
+    if (value == NULL)
+      return EXIT_FAILURE;
+    memcpy(v, value, tree->value_size);
     return EXIT_SUCCESS;
-  } else {
-    return binary_entry_put(tree, &(tree->root), k, v);
   }
+
+  BinaryEntry *node = binary_entry_find(tree, k);
+  if (node == NULL)
+    return EXIT_FAILURE;
+  memcpy(v, node->value, tree->value_size);
+  return EXIT_SUCCESS;
 }
 
-int b_tree_map_get(BTreeMap *tree, void *k, void *v) {
-  if (tree->root == NULL)
+void *b_tree_map_get_ptr(BTreeMap *tree, void *k) {
+  if (tree->filter && !bloom_filter_contains(tree->filter, k))
+    return NULL;
+  if (tree->paged) {
+    BPlusCursor cursor;
+    if (b_plus_tree_lower_bound(tree->paged, k, &cursor) &&
+        tree->comperator(b_plus_cursor_key(tree->paged, &cursor), k) == 0)
+      return b_plus_cursor_value(tree->paged, &cursor);
+    return NULL;
+  }
+  if (tree->arena)
+    return arena_tree_get_ptr(tree->arena, k);
+  if (tree->root == NULL) {
+    bool found;
+    size_t i = b_tree_map_small_search(tree, k, &found);
+    return found ? b_tree_map_small_value(tree, i) : NULL;
+  }
+
+  BinaryEntry *node = binary_entry_find(tree, k);
+  return node ? node->value : NULL;
+}
+
+void *b_tree_map_get_or_insert(BTreeMap *tree, void *k, void *v) {
+  bool inserted;
+  return b_tree_map_emplace(tree, k, v, &inserted);
+}
+
+int b_tree_map_upsert(BTreeMap *tree, void *k, BiConsumer fn, void *ctx) {
+  bool inserted;
+  void *value = b_tree_map_emplace(tree, k, NULL, &inserted);
+  if (value == NULL)
+    return EXIT_FAILURE;
+  fn(value, ctx);
+  return EXIT_SUCCESS;
+}
+
+int b_tree_map_remove(BTreeMap *tree, void *k) {
+  if (tree->paged) {
+    int status = b_plus_tree_remove(tree->paged, k);
+    tree->len = tree->paged->len;
+    return status;
+  }
+  if (tree->arena) {
+    int status = arena_tree_remove(tree->arena, k);
+    tree->len = tree->arena->len;
+    return status;
+  }
+  if (tree->root == NULL) {
+    bool found;
+    size_t i = b_tree_map_small_search(tree, k, &found);
+    if (!found)
+      return EXIT_FAILURE;
+    size_t after = tree->len - i - 1;
+    memmove(b_tree_map_small_key(tree, i), b_tree_map_small_key(tree, i + 1),
+            after * tree->key_size);
+    memmove(b_tree_map_small_value(tree, i),
+            b_tree_map_small_value(tree, i + 1), after * tree->value_size);
+    tree->len--;
+    return EXIT_SUCCESS;
+  }
+
+  BinaryEntry **path[B_TREE_MAP_MAX_HEIGHT];
+  size_t depth = 0;
+  BinaryEntry **link = &(tree->root);
+  while (*link) {
+    int c = b_tree_map_compare(tree, (*link)->key, k);
+    if (c == 0)
+      break;
+    path[depth++] = link;
+    link = (c > 0) ? &((*link)->right) : &((*link)->left);
+  }
+  BinaryEntry *node = *link;
+  if (node == NULL)
     return EXIT_FAILURE;
 
-  return binary_entry_get(tree, tree->root, k, v);
+  if (node->left && node->right) {
+    // Move the in-order successor into this entry and unlink the successor
+    // instead, it has no left child.
+    path[depth++] = link;
+    link = &(node->right);
+    while ((*link)->left) {
+      path[depth++] = link;
+      link = &((*link)->left);
+    }
+    memcpy(node->key, (*link)->key, tree->key_size);
+    memcpy(node->value, (*link)->value, tree->value_size);
+    node = *link;
+  }
+  *link = node->left ? node->left : node->right;
+  free(node);
+  tree->len--;
+  binary_entry_rebalance_path(path, depth);
+  // Half the limit keeps a map that shrinks and grows around the limit from
+  // converting on every change.
+  if (tree->len <= tree->small_limit / 2)
+    b_tree_map_shrink_tree(tree);
+  return EXIT_SUCCESS;
 }
 
 bool b_tree_map_contains_key(BTreeMap *tree, void *e) {
-  if (tree->root == NULL)
+  if (tree->filter && !bloom_filter_contains(tree->filter, e))
     return false;
+  if (tree->paged)
+    return b_plus_tree_contains(tree->paged, e);
+  if (tree->arena)
+    return arena_tree_contains(tree->arena, e);
+  if (tree->root == NULL)
+    return b_tree_map_get_ptr(tree, e) != NULL;
 
-  return binary_entry_contains_key(tree, tree->root, e);
+  return binary_entry_find(tree, e) != NULL;
+}
+
+/**
+ * Returns the index of the next key, starting at next, that the filter does
+ * not rule out, or n if there is none. Skipped keys are not found.
+ */
+size_t b_tree_map_next_candidate(BTreeMap *tree, char *keys, size_t n,
+                                 size_t *next, bool *found) {
+  while (*next < n) {
+    size_t i = (*next)++;
+    if (!tree->filter ||
+        bloom_filter_contains(tree->filter, keys + i * tree->key_size))
+      return i;
+    if (found)
+      found[i] = false;
+  }
+  return n;
+}
+
+size_t b_tree_map_get_many(BTreeMap *tree, void *keys, size_t n, void *values,
+                           bool *found) {
+  char *k = keys;
+  char *v = values;
+  size_t hits = 0;
+  if (tree->paged || tree->arena || tree->root == NULL) {
+    for (size_t i = 0; i < n; i++) {
+      bool hit = b_tree_map_get(tree, k + i * tree->key_size,
+                                v + i * tree->value_size) == EXIT_SUCCESS;
+      if (found)
+        found[i] = hit;
+      hits += hit;
+    }
+    return hits;
+  }
+
+  // Every lane follows one lookup and takes the next key once it is done.
+  // Each step only touches entries that were prefetched a round earlier.
+  BinaryEntry *lanes[B_TREE_MAP_LANES];
+  size_t lane_keys[B_TREE_MAP_LANES];
+  size_t active = 0;
+  size_t next = 0;
+  for (size_t j = 0; j < B_TREE_MAP_LANES; j++) {
+    lanes[j] = tree->root;
+    lane_keys[j] = b_tree_map_next_candidate(tree, k, n, &next, found);
+    active += lane_keys[j] < n;
+  }
+  binary_entry_prefetch(tree->root);
+  while (active > 0) {
+    for (size_t j = 0; j < B_TREE_MAP_LANES; j++) {
+      size_t i = lane_keys[j];
+      if (i == n)
+        continue;
+      BinaryEntry *node = lanes[j];
+      void *key = k + i * tree->key_size;
+      int c = node ? b_tree_map_compare(tree, node->key, key) : 0;
+      if (c != 0) {
+        lanes[j] = (c > 0) ? node->right : node->left;
+        binary_entry_prefetch(lanes[j]);
+        continue;
+      }
+      if (node) {
+        memcpy(v + i * tree->value_size, node->value, tree->value_size);
+        hits++;
+      }
+      if (found)
+        found[i] = node != NULL;
+      lanes[j] = tree->root;
+      lane_keys[j] = b_tree_map_next_candidate(tree, k, n, &next, found);
+      active -= lane_keys[j] == n;
+    }
+  }
+  return hits;
 }
 
 void b_tree_map_clear(BTreeMap *tree) {
+  if (tree->paged) {
+    b_plus_tree_clear(tree->paged);
+    tree->len = 0;
+  }
+  if (tree->arena) {
+    arena_tree_clear(tree->arena);
+    tree->len = 0;
+  }
   if (tree->root != NULL) {
     binary_entry_free(tree->root);
     tree->root = NULL;
-    tree->len = 0;
   }
+  free(tree->small);
+  tree->small = NULL;
+  tree->small_capacity = 0;
+  tree->len = 0;
+  if (tree->filter)
+    bloom_filter_clear(tree->filter);
 }
 
 size_t b_tree_map_height(BTreeMap *tree) {
+  if (tree->paged)
+    return b_plus_tree_height(tree->paged);
+  if (tree->arena)
+    return arena_tree_height(tree->arena);
   if (tree->root)
     return tree->root->height;
 
-  return 0;
+  // A small array counts as a single level.
+  return tree->len > 0;
+}
+
+void b_tree_map_iter(BTreeMap *tree, BTreeMapIter *iter) {
+  iter->tree = tree;
+  iter->depth = 0;
+  iter->index = 0;
+  if (tree->paged) {
+    iter->has_cursor = b_plus_tree_first(tree->paged, &iter->cursor);
+  } else if (tree->arena) {
+    iter->has_cursor = arena_tree_first(tree->arena, &iter->arena_cursor);
+  } else {
+    iter->has_cursor = false;
+    b_tree_map_iter_push_left(iter, tree->root);
+  }
+}
+
+void b_tree_map_iter_from(BTreeMap *tree, BTreeMapIter *iter, void *k) {
+  iter->tree = tree;
+  iter->depth = 0;
+  iter->index = 0;
+  iter->has_cursor = false;
+  if (tree->paged) {
+    iter->has_cursor = b_plus_tree_lower_bound(tree->paged, k, &iter->cursor);
+    return;
+  }
+  if (tree->arena) {
+    iter->has_cursor =
+        arena_tree_lower_bound(tree->arena, k, &iter->arena_cursor);
+    return;
+  }
+  if (tree->root == NULL) {
+    bool found;
+    iter->index = b_tree_map_small_search(tree, k, &found);
+    return;
+  }
+  // Keep every entry on the path whose key is not less than k, these are
+  // exactly the pending entries of an in-order walk starting at k.
+  BinaryEntry *node = tree->root;
+  while (node) {
+    int c = b_tree_map_compare(tree, node->key, k);
+    if (c > 0) {
+      node = node->right;
+    } else {
+      iter->stack[iter->depth++] = node;
+      node = c == 0 ? NULL : node->left;
+    }
+  }
+}
+
+bool b_tree_map_iter_next(BTreeMapIter *iter, void **k, void **v) {
+  if (iter->tree->paged) {
+    if (!iter->has_cursor)
+      return false;
+    *k = b_plus_cursor_key(iter->tree->paged, &iter->cursor);
+    *v = b_plus_cursor_value(iter->tree->paged, &iter->cursor);
+    iter->has_cursor = b_plus_cursor_next(&iter->cursor);
+    return true;
+  }
+  if (iter->tree->arena) {
+    if (!iter->has_cursor)
+      return false;
+    *k = arena_cursor_key(&iter->arena_cursor);
+    *v = arena_cursor_value(&iter->arena_cursor);
+    iter->has_cursor = arena_cursor_next(&iter->arena_cursor);
+    return true;
+  }
+  BTreeMap *tree = iter->tree;
+  if (tree->root == NULL) {
+    if (iter->index >= tree->len)
+      return false;
+    *k = b_tree_map_small_key(tree, iter->index);
+    *v = b_tree_map_small_value(tree, iter->index);
+    iter->index++;
+    return true;
+  }
+  if (iter->depth == 0)
+    return false;
+  BinaryEntry *node = iter->stack[--iter->depth];
+  b_tree_map_iter_push_left(iter, node->right);
+  *k = node->key;
+  *v = node->value;
+  return true;
+}
+
+int b_tree_map_first(BTreeMap *tree, void *buffer_k, void *buffer_v) {
+  if (tree->paged) {
+    BPlusCursor cursor;
+    if (!b_plus_tree_first(tree->paged, &cursor))
+      return EXIT_FAILURE;
+    return b_tree_map_write(tree, b_plus_cursor_key(tree->paged, &cursor),
+                            b_plus_cursor_value(tree->paged, &cursor),
+                            buffer_k, buffer_v);
+  }
+  if (tree->arena) {
+    ArenaCursor cursor;
+    if (!arena_tree_first(tree->arena, &cursor))
+      return EXIT_FAILURE;
+    return b_tree_map_write(tree, arena_cursor_key(&cursor),
+                            arena_cursor_value(&cursor), buffer_k, buffer_v);
+  }
+  if (tree->root == NULL) {
+    if (tree->len == 0)
+      return EXIT_FAILURE;
+    return b_tree_map_write(tree, b_tree_map_small_key(tree, 0),
+                            b_tree_map_small_value(tree, 0), buffer_k,
+                            buffer_v);
+  }
+  BinaryEntry *node = tree->root;
+  while (node->left)
+    node = node->left;
+  return b_tree_map_write(tree, node->key, node->value, buffer_k, buffer_v);
+}
+
+int b_tree_map_last(BTreeMap *tree, void *buffer_k, void *buffer_v) {
+  if (tree->paged) {
+    BPlusCursor cursor;
+    if (!b_plus_tree_last(tree->paged, &cursor))
+      return EXIT_FAILURE;
+    return b_tree_map_write(tree, b_plus_cursor_key(tree->paged, &cursor),
+                            b_plus_cursor_value(tree->paged, &cursor),
+                            buffer_k, buffer_v);
+  }
+  if (tree->arena) {
+    ArenaCursor cursor;
+    if (!arena_tree_last(tree->arena, &cursor))
+      return EXIT_FAILURE;
+    return b_tree_map_write(tree, arena_cursor_key(&cursor),
+                            arena_cursor_value(&cursor), buffer_k, buffer_v);
+  }
+  if (tree->root == NULL) {
+    if (tree->len == 0)
+      return EXIT_FAILURE;
+    return b_tree_map_write(tree, b_tree_map_small_key(tree, tree->len - 1),
+                            b_tree_map_small_value(tree, tree->len - 1),
+                            buffer_k, buffer_v);
+  }
+  BinaryEntry *node = tree->root;
+  while (node->right)
+    node = node->right;
+  return b_tree_map_write(tree, node->key, node->value, buffer_k, buffer_v);
+}
+
+int b_tree_map_floor(BTreeMap *tree, void *k, void *buffer_k, void *buffer_v) {
+  if (tree->paged) {
+    BPlusCursor cursor;
+    if (!b_plus_tree_floor(tree->paged, k, &cursor))
+      return EXIT_FAILURE;
+    return b_tree_map_write(tree, b_plus_cursor_key(tree->paged, &cursor),
+                            b_plus_cursor_value(tree->paged, &cursor),
+                            buffer_k, buffer_v);
+  }
+  if (tree->arena) {
+    ArenaCursor cursor;
+    if (!arena_tree_floor(tree->arena, k, &cursor))
+      return EXIT_FAILURE;
+    return b_tree_map_write(tree, arena_cursor_key(&cursor),
+                            arena_cursor_value(&cursor), buffer_k, buffer_v);
+  }
+  if (tree->root == NULL) {
+    bool found;
+    size_t i = b_tree_map_small_search(tree, k, &found);
+    if (!found && i == 0)
+      return EXIT_FAILURE;
+    if (!found)
+      i--;
+    return b_tree_map_write(tree, b_tree_map_small_key(tree, i),
+                            b_tree_map_small_value(tree, i), buffer_k,
+                            buffer_v);
+  }
+  BinaryEntry *node = binary_entry_floor(tree, k);
+  if (node == NULL)
+    return EXIT_FAILURE;
+  return b_tree_map_write(tree, node->key, node->value, buffer_k, buffer_v);
+}
+
+int b_tree_map_ceiling(BTreeMap *tree, void *k, void *buffer_k,
+                       void *buffer_v) {
+  if (tree->paged) {
+    BPlusCursor cursor;
+    if (!b_plus_tree_lower_bound(tree->paged, k, &cursor))
+      return EXIT_FAILURE;
+    return b_tree_map_write(tree, b_plus_cursor_key(tree->paged, &cursor),
+                            b_plus_cursor_value(tree->paged, &cursor),
+                            buffer_k, buffer_v);
+  }
+  if (tree->arena) {
+    ArenaCursor cursor;
+    if (!arena_tree_lower_bound(tree->arena, k, &cursor))
+      return EXIT_FAILURE;
+    return b_tree_map_write(tree, arena_cursor_key(&cursor),
+                            arena_cursor_value(&cursor), buffer_k, buffer_v);
+  }
+  if (tree->root == NULL) {
+    bool found;
+    size_t i = b_tree_map_small_search(tree, k, &found);
+    if (i == tree->len)
+      return EXIT_FAILURE;
+    return b_tree_map_write(tree, b_tree_map_small_key(tree, i),
+                            b_tree_map_small_value(tree, i), buffer_k,
+                            buffer_v);
+  }
+  BinaryEntry *node = binary_entry_ceiling(tree, k);
+  if (node == NULL)
+    return EXIT_FAILURE;
+  return b_tree_map_write(tree, node->key, node->value, buffer_k, buffer_v);
+}
+
+void b_tree_map_range(BTreeMap *tree, void *lo, void *hi, BiConsumer consumer) {
+  BTreeMapIter iter;
+  void *k;
+  void *v;
+  b_tree_map_iter_from(tree, &iter, lo);
+  // Stop at the first key that is not less than hi.
+  while (b_tree_map_iter_next(&iter, &k, &v) &&
+         b_tree_map_compare(tree, k, hi) > 0)
+    consumer(k, v);
+}
+
+size_t b_tree_map_rank(BTreeMap *tree, void *k) {
+  size_t rank = 0;
+  if (tree->paged || tree->arena) {
+    BTreeMapIter iter;
+    void *key;
+    void *value;
+    b_tree_map_iter(tree, &iter);
+    while (b_tree_map_iter_next(&iter, &key, &value) &&
+           b_tree_map_compare(tree, key, k) > 0)
+      rank++;
+    return rank;
+  }
+  if (tree->root == NULL) {
+    bool found;
+    return b_tree_map_small_search(tree, k, &found);
+  }
+  // Every step to the right skips the left subtree and the entry itself.
+  BinaryEntry *node = tree->root;
+  while (node) {
+    int c = b_tree_map_compare(tree, node->key, k);
+    if (c > 0) {
+      rank += binary_entry_size(node->left) + 1;
+      node = node->right;
+    } else {
+      if (c == 0)
+        return rank + binary_entry_size(node->left);
+      node = node->left;
+    }
+  }
+  return rank;
+}
+
+int b_tree_map_select(BTreeMap *tree, size_t i, void *buffer_k,
+                      void *buffer_v) {
+  if (i >= tree->len)
+    return EXIT_FAILURE;
+  if (tree->paged || tree->arena) {
+    BTreeMapIter iter;
+    void *k;
+    void *v;
+    b_tree_map_iter(tree, &iter);
+    for (size_t skipped = 0; skipped <= i; skipped++)
+      b_tree_map_iter_next(&iter, &k, &v);
+    return b_tree_map_write(tree, k, v, buffer_k, buffer_v);
+  }
+  if (tree->root == NULL)
+    return b_tree_map_write(tree, b_tree_map_small_key(tree, i),
+                            b_tree_map_small_value(tree, i), buffer_k,
+                            buffer_v);
+  BinaryEntry *node = tree->root;
+  while (node) {
+    size_t left = binary_entry_size(node->left);
+    if (i == left)
+      break;
+    if (i < left) {
+      node = node->left;
+    } else {
+      i -= left + 1;
+      node = node->right;
+    }
+  }
+  return b_tree_map_write(tree, node->key, node->value, buffer_k, buffer_v);
+}
+
+size_t b_tree_map_count_range(BTreeMap *tree, void *lo, void *hi) {
+  if (b_tree_map_compare(tree, lo, hi) <= 0)
+    return 0;
+  return b_tree_map_rank(tree, hi) - b_tree_map_rank(tree, lo);
+}
+
+int b_tree_map_percentile(BTreeMap *tree, double p, void *buffer_k,
+                          void *buffer_v) {
+  if (tree->len == 0 || !(p >= 0.0 && p <= 100.0))
+    return EXIT_FAILURE;
+  // The nearest rank is the smallest rank that covers p percent, at least 1.
+  double exact = p / 100.0 * (double)tree->len;
+  size_t rank = (size_t)exact;
+  if ((double)rank < exact)
+    rank++;
+  if (rank == 0)
+    rank = 1;
+  return b_tree_map_select(tree, rank - 1, buffer_k, buffer_v);
 }
@@ -0,0 +1,265 @@
+#include "kiyo-collections/b_tree_multi_map.h"
+#include "align.h"
+#include "avl.h"
+#include <stdlib.h>
+#include <string.h>
+
+MultiEntry *multi_entry_new(void *key, size_t key_size) {
+  // The key is stored inline behind the entry, the values get their own run.
+  size_t key_offset = ALIGN_UP(sizeof(MultiEntry));
+  MultiEntry *created = malloc(key_offset + key_size);
+  if (!created)
+    return NULL;
+
+  created->key = (char *)created + key_offset;
+  memcpy(created->key, key, key_size);
+
+  created->values = NULL;
+  created->count = 0;
+  created->capacity = 0;
+  created->height = 1;
+  created->total = 0;
+  created->left = NULL;
+  created->right = NULL;
+  return created;
+}
+
+/* Frees the entry with its values. */
+void multi_entry_release(MultiEntry *node) {
+  free(node->values);
+  free(node);
+}
+
+size_t multi_entry_total(MultiEntry *node) { return node ? node->total : 0; }
+
+/* Recomputes the values of the subtree of the entry. */
+void multi_entry_update_total(MultiEntry *node) {
+  node->total = multi_entry_total(node->left) + multi_entry_total(node->right) +
+                node->count;
+}
+
+GENERATE_AVL(multi_entry, MultiEntry, multi_entry_update_total,
+             multi_entry_release)
+
+/**
+ * Follows the path to the key, writing the links in front of it to path and
+ * their number to depth. Returns the link that holds the key, or the empty
+ * link where it belongs.
+ */
+MultiEntry **b_tree_multi_map_search(BTreeMultiMap *tree, void *k,
+                                     MultiEntry ***path, size_t *depth) {
+  MultiEntry **link = &(tree->root);
+  *depth = 0;
+  while (*link) {
+    int c = tree->comperator((*link)->key, k);
+    if (c == 0)
+      break;
+    path[(*depth)++] = link;
+    link = (c > 0) ? &((*link)->right) : &((*link)->left);
+  }
+  return link;
+}
+
+MultiEntry *b_tree_multi_map_find(BTreeMultiMap *tree, void *k) {
+  MultiEntry *node = tree->root;
+  while (node) {
+    int c = tree->comperator(node->key, k);
+    if (c == 0)
+      return node;
+    node = (c > 0) ? node->right : node->left;
+  }
+  return NULL;
+}
+
+BTreeMultiMap *b_tree_multi_map_new(size_t key_size, size_t value_size,
+                                    Comperator comperator) {
+  BTreeMultiMap *created = malloc(sizeof(BTreeMultiMap));
+  if (!created)
+    return NULL;
+  created->root = NULL;
+  created->len = 0;
+  created->distinct_len = 0;
+  created->key_size = key_size;
+  created->value_size = value_size;
+  created->comperator = comperator;
+  return created;
+}
+
+void b_tree_multi_map_free(BTreeMultiMap *tree) {
+  multi_entry_free(tree->root);
+  free(tree);
+}
+
+/* Appends the value to the run of the entry, growing the run if it is full. */
+int multi_entry_push(BTreeMultiMap *tree, MultiEntry *node, void *v) {
+  if (tree->value_size > 0 && node->count == node->capacity) {
+    size_t capacity = node->capacity ? node->capacity * 2 : 1;
+    char *values = realloc(node->values, capacity * tree->value_size);
+    if (!values)
+      return EXIT_FAILURE;
+    node->values = values;
+    node->capacity = capacity;
+  }
+  if (tree->value_size > 0)
+    memcpy(node->values + node->count * tree->value_size, v, tree->value_size);
+  node->count++;
+  node->total++;
+  return EXIT_SUCCESS;
+}
+
+int b_tree_multi_map_put(BTreeMultiMap *tree, void *k, void *v) {
+  MultiEntry **path[B_TREE_MULTI_MAP_MAX_HEIGHT];
+  size_t depth;
+  MultiEntry **link = b_tree_multi_map_search(tree, k, path, &depth);
+  if (*link) {
+    // Only the counts on the path change, the shape stays the same.
+    if (multi_entry_push(tree, *link, v) != EXIT_SUCCESS)
+      return EXIT_FAILURE;
+    for (size_t i = 0; i < depth; i++)
+      (*path[i])->total++;
+    tree->len++;
+    return EXIT_SUCCESS;
+  }
+
+  MultiEntry *node = multi_entry_new(k, tree->key_size);
+  if (node == NULL)
+    return EXIT_FAILURE;
+  if (multi_entry_push(tree, node, v) != EXIT_SUCCESS) {
+    free(node);
+    return EXIT_FAILURE;
+  }
+  *link = node;
+  tree->len++;
+  tree->distinct_len++;
+  multi_entry_rebalance_path(path, depth);
+  return EXIT_SUCCESS;
+}
+
+void *b_tree_multi_map_get(BTreeMultiMap *tree, void *k, size_t *count) {
+  MultiEntry *node = b_tree_multi_map_find(tree, k);
+  *count = node ? node->count : 0;
+  return node ? node->values : NULL;
+}
+
+size_t b_tree_multi_map_count(BTreeMultiMap *tree, void *k) {
+  MultiEntry *node = b_tree_multi_map_find(tree, k);
+  return node ? node->count : 0;
+}
+
+bool b_tree_multi_map_contains_key(BTreeMultiMap *tree, void *k) {
+  return b_tree_multi_map_find(tree, k) != NULL;
+}
+
+/* Unlinks the entry that the link holds and frees it with its values. */
+void b_tree_multi_map_unlink(BTreeMultiMap *tree, MultiEntry ***path,
+                             size_t depth, MultiEntry **link) {
+  MultiEntry *node = *link;
+  free(node->values);
+  if (node->left && node->right) {
+    // Move the in-order successor with its run into this entry and unlink
+    // the successor instead, it has no left child.
+    path[depth++] = link;
+    link = &(node->right);
+    while ((*link)->left) {
+      path[depth++] = link;
+      link = &((*link)->left);
+    }
+    memcpy(node->key, (*link)->key, tree->key_size);
+    node->values = (*link)->values;
+    node->count = (*link)->count;
+    node->capacity = (*link)->capacity;
+    node = *link;
+  }
+  *link = node->left ? node->left : node->right;
+  free(node);
+  tree->distinct_len--;
+  multi_entry_rebalance_path(path, depth);
+}
+
+int b_tree_multi_map_remove(BTreeMultiMap *tree, void *k) {
+  MultiEntry **path[B_TREE_MULTI_MAP_MAX_HEIGHT];
+  size_t depth;
+  MultiEntry **link = b_tree_multi_map_search(tree, k, path, &depth);
+  if (*link == NULL)
+    return EXIT_FAILURE;
+  tree->len -= (*link)->count;
+  b_tree_multi_map_unlink(tree, path, depth, link);
+  return EXIT_SUCCESS;
+}
+
+int b_tree_multi_map_remove_at(BTreeMultiMap *tree, void *k, size_t i) {
+  MultiEntry **path[B_TREE_MULTI_MAP_MAX_HEIGHT];
+  size_t depth;
+  MultiEntry **link = b_tree_multi_map_search(tree, k, path, &depth);
+  MultiEntry *node = *link;
+  if (node == NULL || i >= node->count)
+    return EXIT_FAILURE;
+  tree->len--;
+  if (node->count == 1) {
+    b_tree_multi_map_unlink(tree, path, depth, link);
+    return EXIT_SUCCESS;
+  }
+  if (tree->value_size > 0)
+    memmove(node->values + i * tree->value_size,
+            node->values + (i + 1) * tree->value_size,
+            (node->count - i - 1) * tree->value_size);
+  node->count--;
+  node->total--;
+  for (size_t j = 0; j < depth; j++)
+    (*path[j])->total--;
+  return EXIT_SUCCESS;
+}
+
+size_t b_tree_multi_map_len(BTreeMultiMap *tree) { return tree->len; }
+
+size_t b_tree_multi_map_distinct_len(BTreeMultiMap *tree) {
+  return tree->distinct_len;
+}
+
+void b_tree_multi_map_clear(BTreeMultiMap *tree) {
+  multi_entry_free(tree->root);
+  tree->root = NULL;
+  tree->len = 0;
+  tree->distinct_len = 0;
+}
+
+void b_tree_multi_map_iter(BTreeMultiMap *tree, BTreeMultiMapIter *iter) {
+  iter->depth = 0;
+  multi_entry_push_left(iter->stack, &iter->depth, tree->root);
+}
+
+bool b_tree_multi_map_iter_next(BTreeMultiMapIter *iter, void **k,
+                                void **values, size_t *count) {
+  if (iter->depth == 0)
+    return false;
+  MultiEntry *node = iter->stack[--iter->depth];
+  multi_entry_push_left(iter->stack, &iter->depth, node->right);
+  *k = node->key;
+  *values = node->values;
+  *count = node->count;
+  return true;
+}
+
+/* Returns the number of values of all keys that are less than k. */
+size_t b_tree_multi_map_rank(BTreeMultiMap *tree, void *k) {
+  size_t rank = 0;
+  MultiEntry *node = tree->root;
+  while (node) {
+    int c = tree->comperator(node->key, k);
+    if (c > 0) {
+      rank += multi_entry_total(node->left) + node->count;
+      node = node->right;
+    } else {
+      if (c == 0)
+        return rank + multi_entry_total(node->left);
+      node = node->left;
+    }
+  }
+  return rank;
+}
+
+size_t b_tree_multi_map_count_range(BTreeMultiMap *tree, void *lo, void *hi) {
+  if (tree->comperator(lo, hi) <= 0)
+    return 0;
+  return b_tree_multi_map_rank(tree, hi) - b_tree_multi_map_rank(tree, lo);
+}
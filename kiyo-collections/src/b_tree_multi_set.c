@@ -0,0 +1,244 @@
+#include "kiyo-collections/b_tree_multi_set.h"
+#include "align.h"
+#include "avl.h"
+#include <stdlib.h>
+#include <string.h>
+
+MultiNode *multi_node_new(void *element, size_t element_size, size_t count) {
+  // The element is stored inline behind the node.
+  size_t value_offset = ALIGN_UP(sizeof(MultiNode));
+  MultiNode *created = malloc(value_offset + element_size);
+  if (!created)
+    return NULL;
+
+  created->value = (char *)created + value_offset;
+  memcpy(created->value, element, element_size);
+
+  created->height = 1;
+  created->count = count;
+  created->total = count;
+  created->left = NULL;
+  created->right = NULL;
+  return created;
+}
+
+size_t multi_node_total(MultiNode *node) { return node ? node->total : 0; }
+
+/* Recomputes the copies of the subtree of the node. */
+void multi_node_update_total(MultiNode *node) {
+  node->total = multi_node_total(node->left) + multi_node_total(node->right) +
+                node->count;
+}
+
+GENERATE_AVL(multi_node, MultiNode, multi_node_update_total, free)
+
+/**
+ * Follows the path to the element, writing the links in front of it to path
+ * and their number to depth. Returns the link that holds the element, or the
+ * empty link where it belongs.
+ */
+MultiNode **b_tree_multi_set_search(BTreeMultiSet *tree, void *e,
+                                    MultiNode ***path, size_t *depth) {
+  MultiNode **link = &(tree->root);
+  *depth = 0;
+  while (*link) {
+    int c = tree->comperator((*link)->value, e);
+    if (c == 0)
+      break;
+    path[(*depth)++] = link;
+    link = (c > 0) ? &((*link)->right) : &((*link)->left);
+  }
+  return link;
+}
+
+MultiNode *b_tree_multi_set_find(BTreeMultiSet *tree, void *e) {
+  MultiNode *node = tree->root;
+  while (node) {
+    int c = tree->comperator(node->value, e);
+    if (c == 0)
+      return node;
+    node = (c > 0) ? node->right : node->left;
+  }
+  return NULL;
+}
+
+BTreeMultiSet *b_tree_multi_set_new(size_t element_size,
+                                    Comperator comperator) {
+  BTreeMultiSet *created = malloc(sizeof(BTreeMultiSet));
+  if (!created)
+    return NULL;
+  created->root = NULL;
+  created->len = 0;
+  created->distinct_len = 0;
+  created->element_size = element_size;
+  created->comperator = comperator;
+  return created;
+}
+
+void b_tree_multi_set_free(BTreeMultiSet *tree) {
+  multi_node_free(tree->root);
+  free(tree);
+}
+
+int b_tree_multi_set_add_count(BTreeMultiSet *tree, void *e, size_t n) {
+  if (n == 0)
+    return EXIT_SUCCESS;
+  MultiNode **path[B_TREE_MULTI_SET_MAX_HEIGHT];
+  size_t depth;
+  MultiNode **link = b_tree_multi_set_search(tree, e, path, &depth);
+  if (*link) {
+    // Only the counts on the path change, the shape stays the same.
+    (*link)->count += n;
+    (*link)->total += n;
+    for (size_t i = 0; i < depth; i++)
+      (*path[i])->total += n;
+    tree->len += n;
+    return EXIT_SUCCESS;
+  }
+
+  *link = multi_node_new(e, tree->element_size, n);
+  if (*link == NULL)
+    return EXIT_FAILURE;
+  tree->len += n;
+  tree->distinct_len++;
+  multi_node_rebalance_path(path, depth);
+  return EXIT_SUCCESS;
+}
+
+int b_tree_multi_set_add(BTreeMultiSet *tree, void *e) {
+  return b_tree_multi_set_add_count(tree, e, 1);
+}
+
+/* Unlinks the node that the link holds and frees it. */
+void b_tree_multi_set_unlink(BTreeMultiSet *tree, MultiNode ***path,
+                             size_t depth, MultiNode **link) {
+  MultiNode *node = *link;
+  if (node->left && node->right) {
+    // Move the in-order successor into this node and unlink the successor
+    // instead, it has no left child.
+    path[depth++] = link;
+    link = &(node->right);
+    while ((*link)->left) {
+      path[depth++] = link;
+      link = &((*link)->left);
+    }
+    memcpy(node->value, (*link)->value, tree->element_size);
+    node->count = (*link)->count;
+    node = *link;
+  }
+  *link = node->left ? node->left : node->right;
+  free(node);
+  tree->distinct_len--;
+  multi_node_rebalance_path(path, depth);
+}
+
+int b_tree_multi_set_remove(BTreeMultiSet *tree, void *e) {
+  MultiNode **path[B_TREE_MULTI_SET_MAX_HEIGHT];
+  size_t depth;
+  MultiNode **link = b_tree_multi_set_search(tree, e, path, &depth);
+  if (*link == NULL)
+    return EXIT_FAILURE;
+  tree->len--;
+  if ((*link)->count > 1) {
+    (*link)->count--;
+    (*link)->total--;
+    for (size_t i = 0; i < depth; i++)
+      (*path[i])->total--;
+    return EXIT_SUCCESS;
+  }
+  b_tree_multi_set_unlink(tree, path, depth, link);
+  return EXIT_SUCCESS;
+}
+
+size_t b_tree_multi_set_remove_all(BTreeMultiSet *tree, void *e) {
+  MultiNode **path[B_TREE_MULTI_SET_MAX_HEIGHT];
+  size_t depth;
+  MultiNode **link = b_tree_multi_set_search(tree, e, path, &depth);
+  if (*link == NULL)
+    return 0;
+  size_t count = (*link)->count;
+  tree->len -= count;
+  b_tree_multi_set_unlink(tree, path, depth, link);
+  return count;
+}
+
+size_t b_tree_multi_set_count(BTreeMultiSet *tree, void *e) {
+  MultiNode *node = b_tree_multi_set_find(tree, e);
+  return node ? node->count : 0;
+}
+
+bool b_tree_multi_set_contains(BTreeMultiSet *tree, void *e) {
+  return b_tree_multi_set_find(tree, e) != NULL;
+}
+
+size_t b_tree_multi_set_len(BTreeMultiSet *tree) { return tree->len; }
+
+size_t b_tree_multi_set_distinct_len(BTreeMultiSet *tree) {
+  return tree->distinct_len;
+}
+
+void b_tree_multi_set_clear(BTreeMultiSet *tree) {
+  multi_node_free(tree->root);
+  tree->root = NULL;
+  tree->len = 0;
+  tree->distinct_len = 0;
+}
+
+void b_tree_multi_set_iter(BTreeMultiSet *tree, BTreeMultiSetIter *iter) {
+  iter->depth = 0;
+  multi_node_push_left(iter->stack, &iter->depth, tree->root);
+}
+
+bool b_tree_multi_set_iter_next(BTreeMultiSetIter *iter, void **e,
+                                size_t *count) {
+  if (iter->depth == 0)
+    return false;
+  MultiNode *node = iter->stack[--iter->depth];
+  multi_node_push_left(iter->stack, &iter->depth, node->right);
+  *e = node->value;
+  *count = node->count;
+  return true;
+}
+
+size_t b_tree_multi_set_rank(BTreeMultiSet *tree, void *e) {
+  // Every step to the right skips the left subtree and the copies of the node.
+  size_t rank = 0;
+  MultiNode *node = tree->root;
+  while (node) {
+    int c = tree->comperator(node->value, e);
+    if (c > 0) {
+      rank += multi_node_total(node->left) + node->count;
+      node = node->right;
+    } else {
+      if (c == 0)
+        return rank + multi_node_total(node->left);
+      node = node->left;
+    }
+  }
+  return rank;
+}
+
+int b_tree_multi_set_select(BTreeMultiSet *tree, size_t i, void *buffer) {
+  if (i >= tree->len)
+    return EXIT_FAILURE;
+  MultiNode *node = tree->root;
+  while (node) {
+    size_t left = multi_node_total(node->left);
+    if (i < left) {
+      node = node->left;
+    } else if (i < left + node->count) {
+      break;
+    } else {
+      i -= left + node->count;
+      node = node->right;
+    }
+  }
+  memcpy(buffer, node->value, tree->element_size);
+  return EXIT_SUCCESS;
+}
+
+size_t b_tree_multi_set_count_range(BTreeMultiSet *tree, void *lo, void *hi) {
+  if (tree->comperator(lo, hi) <= 0)
+    return 0;
+  return b_tree_multi_set_rank(tree, hi) - b_tree_multi_set_rank(tree, lo);
+}
@@ -1,37 +1,45 @@
 #include "kiyo-collections/b_tree_set.h"
+#include "align.h"
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 
+/* Number of lookups that contains_many keeps in flight at once. */
+#define B_TREE_SET_LANES 8
+
 BinaryNode *binary_node_new(void *element, size_t element_size) {
-  BinaryNode *created = malloc(sizeof(BinaryNode));
+  // The element is stored inline behind the node.
+  size_t value_offset = ALIGN_UP(sizeof(BinaryNode));
+  BinaryNode *created = malloc(value_offset + element_size);
   if (!created) {
     return NULL;
   }
 
-  void *value = malloc(element_size);
-  if (!value) {
-    free(created);
-    return NULL;
-  }
-  memcpy(value, element, element_size);
+  created->value = (char *)created + value_offset;
+  memcpy(created->value, element, element_size);
 
-  created->value = value;
   created->height = 1;
+  created->size = 1;
   created->left = NULL;
   created->right = NULL;
   return created;
 }
 
 void binary_node_free(BinaryNode *node) {
-  if (node->left) {
-    binary_node_free(node->left);
-  }
-  if (node->right) {
-    binary_node_free(node->right);
+  // Rotate left children up until the node has none, then free it and
+  // continue with its right child. This needs neither recursion nor a stack.
+  while (node) {
+    if (node->left) {
+      BinaryNode *left = node->left;
+      node->left = left->right;
+      left->right = node;
+      node = left;
+    } else {
+      BinaryNode *right = node->right;
+      free(node);
+      node = right;
+    }
   }
-  free(node->value);
-  free(node);
 }
 
 void binary_node_update_height(BinaryNode *node) {
@@ -40,6 +48,12 @@ void binary_node_update_height(BinaryNode *node) {
   node->height = (height_left > height_right ? height_left : height_right) + 1;
 }
 
+size_t binary_node_size(BinaryNode *node) { return node ? node->size : 0; }
+
+void binary_node_update_size(BinaryNode *node) {
+  node->size = binary_node_size(node->left) + binary_node_size(node->right) + 1;
+}
+
 BinaryNode *binary_node_rotate_right(BinaryNode *node) {
   BinaryNode *left = node->left;
   node->left = left->right;
@@ -47,6 +61,8 @@ BinaryNode *binary_node_rotate_right(BinaryNode *node) {
 
   binary_node_update_height(node);
   binary_node_update_height(left);
+  binary_node_update_size(node);
+  binary_node_update_size(left);
 
   return left;
 }
@@ -58,6 +74,8 @@ BinaryNode *binary_node_rotate_left(BinaryNode *node) {
 
   binary_node_update_height(node);
   binary_node_update_height(right);
+  binary_node_update_size(node);
+  binary_node_update_size(right);
 
   return right;
 }
@@ -68,51 +86,125 @@ int binary_node_get_balance_factor(BinaryNode *node) {
   return height_left - height_right;
 }
 
-int binary_node_add(BTreeSet *tree, BinaryNode **origin, void *e) {
-  BinaryNode *node = *origin;
-  int c = tree->comperator(node->value, e);
-  if (c == 0)
-    return EXIT_SUCCESS;
-
-  // Pointer to the node we want to check.
-  BinaryNode **target = (c > 0) ? &(node->right) : &(node->left);
-
-  int status;
-  if (*target == NULL) {
-    *target = binary_node_new(e, tree->element_size);
-    tree->len++;
-    status = *target == NULL ? EXIT_FAILURE : EXIT_SUCCESS;
-  } else {
-    status = binary_node_add(tree, target, e);
-  }
+/* Restores the AVL property of the node and returns the new subtree root. */
+BinaryNode *binary_node_rebalance(BinaryNode *node) {
   binary_node_update_height(node);
+  binary_node_update_size(node);
   int balance_factor = binary_node_get_balance_factor(node);
   if (balance_factor > 1) {
     if (binary_node_get_balance_factor(node->left) < 0) {
       node->left = binary_node_rotate_left(node->left);
     }
-    *origin = binary_node_rotate_right(node);
+    return binary_node_rotate_right(node);
   } else if (balance_factor < -1) {
     if (binary_node_get_balance_factor(node->right) > 0) {
       node->right = binary_node_rotate_right(node->right);
     }
-    *origin = binary_node_rotate_left(node);
+    return binary_node_rotate_left(node);
   }
-  return status;
+  return node;
 }
 
-bool binary_node_contains(BTreeSet *tree, BinaryNode *node, void *e) {
-  int c = tree->comperator(node->value, e);
-  if (c == 0)
-    return true;
+/**
+ * Rebalances the links on the path from the bottom up. Once a subtree keeps
+ * its height nothing above it needs rotations anymore, but the sizes of all
+ * ancestors still change.
+ */
+void binary_node_rebalance_path(BinaryNode ***path, size_t depth) {
+  bool balanced = false;
+  while (depth > 0) {
+    BinaryNode **link = path[--depth];
+    if (balanced) {
+      binary_node_update_size(*link);
+      continue;
+    }
+    size_t height = (*link)->height;
+    *link = binary_node_rebalance(*link);
+    balanced = (*link)->height == height;
+  }
+}
 
-  // Pointer to the node we want to check.
-  BinaryNode **relevant_child = (c > 0) ? &(node->right) : &(node->left);
+BinaryNode *binary_node_floor(BTreeSet *tree, void *e) {
+  BinaryNode *node = tree->root;
+  BinaryNode *best = NULL;
+  while (node) {
+    int c = tree->comperator(node->value, e);
+    if (c == 0)
+      return node;
+    if (c > 0) {
+      best = node;
+      node = node->right;
+    } else {
+      node = node->left;
+    }
+  }
+  return best;
+}
 
-  if ((*relevant_child) == NULL) {
-    return false;
-  } else {
-    return binary_node_contains(tree, *relevant_child, e);
+BinaryNode *binary_node_ceiling(BTreeSet *tree, void *e) {
+  BinaryNode *node = tree->root;
+  BinaryNode *best = NULL;
+  while (node) {
+    int c = tree->comperator(node->value, e);
+    if (c == 0)
+      return node;
+    if (c < 0) {
+      best = node;
+      node = node->left;
+    } else {
+      node = node->right;
+    }
+  }
+  return best;
+}
+
+/* Returns a pointer to the i-th element of the small array. */
+char *b_tree_set_small_element(BTreeSet *tree, size_t i) {
+  return tree->small + i * tree->element_size;
+}
+
+/**
+ * Returns the index of the first element in the small array that is not less
+ * than e and sets found to whether that element equals e.
+ */
+size_t b_tree_set_small_search(BTreeSet *tree, void *e, bool *found) {
+  size_t lo = 0;
+  size_t hi = tree->len;
+  *found = false;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    int c = tree->comperator(b_tree_set_small_element(tree, mid), e);
+    if (c == 0) {
+      *found = true;
+      return mid;
+    }
+    if (c > 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+/* Moves the small array into a new allocation with room for capacity. */
+int b_tree_set_small_resize(BTreeSet *tree, size_t capacity) {
+  char *small = malloc(capacity * tree->element_size + 1);
+  if (!small)
+    return EXIT_FAILURE;
+  // A tree that turns back into an array has no elements to move yet.
+  if (tree->small)
+    memcpy(small, tree->small, tree->len * tree->element_size);
+  free(tree->small);
+  tree->small = small;
+  tree->small_capacity = capacity;
+  return EXIT_SUCCESS;
+}
+
+/* Pushes the node and its chain of left children onto the iterator stack. */
+void b_tree_set_iter_push_left(BTreeSetIter *iter, BinaryNode *node) {
+  while (node) {
+    iter->stack[iter->depth++] = node;
+    node = node->left;
   }
 }
 
@@ -122,31 +214,816 @@ BTreeSet *b_tree_set_new(size_t element_size, Comperator comperator) {
   created->len = 0;
   created->element_size = element_size;
   created->comperator = comperator;
+  created->paged = NULL;
+  created->arena = NULL;
+  created->small = NULL;
+  created->small_capacity = 0;
+  created->small_limit = B_TREE_SET_SMALL_LIMIT;
+  created->filter = NULL;
+  return created;
+}
+
+BTreeSet *b_tree_set_new_paged(size_t element_size, Comperator comperator) {
+  BTreeSet *created = b_tree_set_new(element_size, comperator);
+  if (!created)
+    return NULL;
+  created->paged = b_plus_tree_new(element_size, 0, comperator);
+  if (!created->paged) {
+    free(created);
+    return NULL;
+  }
+  return created;
+}
+
+BTreeSet *b_tree_set_new_arena(size_t element_size, Comperator comperator) {
+  BTreeSet *created = b_tree_set_new(element_size, comperator);
+  if (!created)
+    return NULL;
+  created->arena = arena_tree_new(element_size, 0, comperator);
+  if (!created->arena) {
+    free(created);
+    return NULL;
+  }
+  return created;
+}
+
+/**
+ * Builds a perfectly balanced subtree from the sorted elements [lo, hi). Sets
+ * failed if a node could not be allocated.
+ */
+BinaryNode *binary_node_build(BTreeSet *tree, char *elements, size_t lo,
+                              size_t hi, bool *failed) {
+  if (lo >= hi || *failed)
+    return NULL;
+  size_t mid = lo + (hi - lo) / 2;
+  BinaryNode *node =
+      binary_node_new(elements + mid * tree->element_size, tree->element_size);
+  if (!node) {
+    *failed = true;
+    return NULL;
+  }
+  node->left = binary_node_build(tree, elements, lo, mid, failed);
+  node->right = binary_node_build(tree, elements, mid + 1, hi, failed);
+  binary_node_update_height(node);
+  binary_node_update_size(node);
+  return node;
+}
+
+/* Creates a set from n sorted elements, or NULL if an allocation failed. */
+BTreeSet *b_tree_set_build(size_t element_size, Comperator comperator,
+                           char *elements, size_t n) {
+  BTreeSet *created = b_tree_set_new(element_size, comperator);
+  if (!created)
+    return NULL;
+  bool failed = false;
+  created->root = binary_node_build(created, elements, 0, n, &failed);
+  if (failed) {
+    b_tree_set_free(created);
+    return NULL;
+  }
+  created->len = n;
+  return created;
+}
+
+BTreeSet *b_tree_set_from_sorted(Vec *vec, Comperator comperator) {
+  char *data = vec->data;
+  for (size_t i = 1; i < vec->len; i++) {
+    if (comperator(data + (i - 1) * vec->element_size,
+                   data + i * vec->element_size) <= 0)
+      return NULL;
+  }
+  return b_tree_set_build(vec->element_size, comperator, data, vec->len);
+}
+
+BTreeSet *b_tree_set_from_unsorted(Vec *vec, Comperator comperator) {
+  size_t size = vec->element_size;
+  Vec sorted = {NULL, vec->len, vec->len, size};
+  if (vec->len > 0) {
+    sorted.data = malloc(vec->len * size);
+    if (!sorted.data)
+      return NULL;
+    memcpy(sorted.data, vec->data, vec->len * size);
+  }
+  if (vec_sort(&sorted, comperator) != EXIT_SUCCESS) {
+    free(sorted.data);
+    return NULL;
+  }
+
+  // Drop duplicates, they are next to each other after sorting.
+  char *data = sorted.data;
+  size_t unique = 0;
+  for (size_t i = 0; i < sorted.len; i++) {
+    if (unique > 0 &&
+        comperator(data + (unique - 1) * size, data + i * size) == 0)
+      continue;
+    memmove(data + unique * size, data + i * size, size);
+    unique++;
+  }
+
+  BTreeSet *created = b_tree_set_build(size, comperator, data, unique);
+  free(sorted.data);
   return created;
 }
 
 void b_tree_set_free(BTreeSet *tree) {
+  if (tree->paged)
+    b_plus_tree_free(tree->paged);
+  if (tree->arena)
+    arena_tree_free(tree->arena);
   if (tree->root)
     binary_node_free(tree->root);
+  free(tree->small);
+  if (tree->filter)
+    bloom_filter_free(tree->filter);
 
   free(tree);
 }
 
+/* Builds a balanced tree from the small array and frees the array. */
+int b_tree_set_grow_tree(BTreeSet *tree) {
+  if (tree->len == 0)
+    return EXIT_SUCCESS;
+  bool failed = false;
+  BinaryNode *root =
+      binary_node_build(tree, tree->small, 0, tree->len, &failed);
+  if (failed) {
+    binary_node_free(root);
+    return EXIT_FAILURE;
+  }
+  free(tree->small);
+  tree->small = NULL;
+  tree->small_capacity = 0;
+  tree->root = root;
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Moves the elements of the tree into a small array with room for the limit
+ * and frees the tree. Keeps the tree if the array could not be allocated.
+ */
+void b_tree_set_shrink_tree(BTreeSet *tree) {
+  if (b_tree_set_small_resize(tree, tree->small_limit) != EXIT_SUCCESS)
+    return;
+  BTreeSetIter iter;
+  void *e;
+  size_t i = 0;
+  b_tree_set_iter(tree, &iter);
+  while (b_tree_set_iter_next(&iter, &e))
+    memcpy(b_tree_set_small_element(tree, i++), e, tree->element_size);
+  binary_node_free(tree->root);
+  tree->root = NULL;
+}
+
+int b_tree_set_set_small_limit(BTreeSet *tree, size_t limit) {
+  if (tree->paged || tree->arena)
+    return EXIT_SUCCESS;
+  tree->small_limit = limit;
+  if (tree->root == NULL && tree->len > limit)
+    return b_tree_set_grow_tree(tree);
+  if (tree->root == NULL && tree->small_capacity > limit)
+    return b_tree_set_small_resize(tree, limit);
+  return EXIT_SUCCESS;
+}
+
+int b_tree_set_attach_filter(BTreeSet *tree, Hasher hasher, size_t capacity) {
+  BloomFilter *filter = bloom_filter_new(
+      tree->element_size, hasher, capacity > tree->len ? capacity : tree->len);
+  if (!filter)
+    return EXIT_FAILURE;
+  BTreeSetIter iter;
+  void *e;
+  b_tree_set_iter(tree, &iter);
+  while (b_tree_set_iter_next(&iter, &e))
+    bloom_filter_add(filter, e);
+  b_tree_set_detach_filter(tree);
+  tree->filter = filter;
+  return EXIT_SUCCESS;
+}
+
+void b_tree_set_detach_filter(BTreeSet *tree) {
+  if (tree->filter)
+    bloom_filter_free(tree->filter);
+  tree->filter = NULL;
+}
+
 int b_tree_set_add(BTreeSet *tree, void *e) {
+  // A filter that knows an element that failed to insert only loses a bit of
+  // selectivity, so it is updated first.
+  if (tree->filter)
+    bloom_filter_add(tree->filter, e);
+  if (tree->paged) {
+    int status = b_plus_tree_put(tree->paged, e, NULL);
+    tree->len = tree->paged->len;
+    return status;
+  }
+  if (tree->arena) {
+    int status = arena_tree_put(tree->arena, e, NULL);
+    tree->len = tree->arena->len;
+    return status;
+  }
+  if (tree->root == NULL) {
+    bool found;
+    size_t i = b_tree_set_small_search(tree, e, &found);
+    if (found)
+      return EXIT_SUCCESS;
+    if (tree->len < tree->small_limit) {
+      if (tree->len == tree->small_capacity) {
+        size_t capacity = tree->small_capacity ? tree->small_capacity * 2 : 4;
+        if (capacity > tree->small_limit)
+          capacity = tree->small_limit;
+        if (b_tree_set_small_resize(tree, capacity) != EXIT_SUCCESS)
+          return EXIT_FAILURE;
+      }
+      memmove(b_tree_set_small_element(tree, i + 1),
+              b_tree_set_small_element(tree, i),
+              (tree->len - i) * tree->element_size);
+      memcpy(b_tree_set_small_element(tree, i), e, tree->element_size);
+      tree->len++;
+      return EXIT_SUCCESS;
+    }
+    // The array is full, the element goes into a tree built from it.
+    if (b_tree_set_grow_tree(tree) != EXIT_SUCCESS)
+      return EXIT_FAILURE;
+  }
+
+  // Remember the links we followed, they are rebalanced after the insert.
+  BinaryNode **path[B_TREE_SET_MAX_HEIGHT];
+  size_t depth = 0;
+  BinaryNode **link = &(tree->root);
+  while (*link) {
+    int c = tree->comperator((*link)->value, e);
+    if (c == 0)
+      return EXIT_SUCCESS;
+    path[depth++] = link;
+    link = (c > 0) ? &((*link)->right) : &((*link)->left);
+  }
+
+  *link = binary_node_new(e, tree->element_size);
+  if (*link == NULL)
+    return EXIT_FAILURE;
+  tree->len++;
+  binary_node_rebalance_path(path, depth);
+  return EXIT_SUCCESS;
+}
+
+int b_tree_set_remove(BTreeSet *tree, void *e) {
+  if (tree->paged) {
+    int status = b_plus_tree_remove(tree->paged, e);
+    tree->len = tree->paged->len;
+    return status;
+  }
+  if (tree->arena) {
+    int status = arena_tree_remove(tree->arena, e);
+    tree->len = tree->arena->len;
+    return status;
+  }
   if (tree->root == NULL) {
-    tree->root = binary_node_new(e, tree->element_size);
-    tree->len++;
+    bool found;
+    size_t i = b_tree_set_small_search(tree, e, &found);
+    if (!found)
+      return EXIT_FAILURE;
+    memmove(b_tree_set_small_element(tree, i),
+            b_tree_set_small_element(tree, i + 1),
+            (tree->len - i - 1) * tree->element_size);
+    tree->len--;
     return EXIT_SUCCESS;
-  } else {
-    return binary_node_add(tree, &(tree->root), e);
   }
+
+  BinaryNode **path[B_TREE_SET_MAX_HEIGHT];
+  size_t depth = 0;
+  BinaryNode **link = &(tree->root);
+  while (*link) {
+    int c = tree->comperator((*link)->value, e);
+    if (c == 0)
+      break;
+    path[depth++] = link;
+    link = (c > 0) ? &((*link)->right) : &((*link)->left);
+  }
+  BinaryNode *node = *link;
+  if (node == NULL)
+    return EXIT_FAILURE;
+
+  if (node->left && node->right) {
+    // Move the in-order successor into this node and unlink the successor
+    // instead, it has no left child.
+    path[depth++] = link;
+    link = &(node->right);
+    while ((*link)->left) {
+      path[depth++] = link;
+      link = &((*link)->left);
+    }
+    memcpy(node->value, (*link)->value, tree->element_size);
+    node = *link;
+  }
+  *link = node->left ? node->left : node->right;
+  free(node);
+  tree->len--;
+  binary_node_rebalance_path(path, depth);
+  // Half the limit keeps a set that shrinks and grows around the limit from
+  // converting on every change.
+  if (tree->len <= tree->small_limit / 2)
+    b_tree_set_shrink_tree(tree);
+  return EXIT_SUCCESS;
 }
 
 bool b_tree_set_contains(BTreeSet *tree, void *e) {
-  if (tree->root == NULL)
+  if (tree->filter && !bloom_filter_contains(tree->filter, e))
     return false;
+  if (tree->paged)
+    return b_plus_tree_contains(tree->paged, e);
+  if (tree->arena)
+    return arena_tree_contains(tree->arena, e);
+  if (tree->root == NULL) {
+    bool found;
+    b_tree_set_small_search(tree, e, &found);
+    return found;
+  }
 
-  return binary_node_contains(tree, tree->root, e);
+  BinaryNode *node = tree->root;
+  while (node) {
+    int c = tree->comperator(node->value, e);
+    if (c == 0)
+      return true;
+    node = (c > 0) ? node->right : node->left;
+  }
+  return false;
+}
+
+/**
+ * Asks the cache to load the node and its inline element. The element is found
+ * by its offset, reading node->value would already wait for the node.
+ */
+void binary_node_prefetch(BinaryNode *node) {
+#if defined(__GNUC__) || defined(__clang__)
+  if (node) {
+    __builtin_prefetch(node);
+    __builtin_prefetch((char *)node + ALIGN_UP(sizeof(BinaryNode)));
+  }
+#else
+  (void)node;
+#endif
+}
+
+/**
+ * Returns the index of the next element, starting at next, that the filter
+ * does not rule out, or n if there is none. Skipped elements are not found.
+ */
+size_t b_tree_set_next_candidate(BTreeSet *tree, char *elements, size_t n,
+                                 size_t *next, bool *found) {
+  while (*next < n) {
+    size_t i = (*next)++;
+    if (!tree->filter ||
+        bloom_filter_contains(tree->filter, elements + i * tree->element_size))
+      return i;
+    if (found)
+      found[i] = false;
+  }
+  return n;
+}
+
+size_t b_tree_set_contains_many(BTreeSet *tree, void *elements, size_t n,
+                                bool *found) {
+  char *e = elements;
+  size_t hits = 0;
+  if (tree->paged || tree->arena || tree->root == NULL) {
+    for (size_t i = 0; i < n; i++) {
+      bool hit = b_tree_set_contains(tree, e + i * tree->element_size);
+      if (found)
+        found[i] = hit;
+      hits += hit;
+    }
+    return hits;
+  }
+
+  // Every lane follows one lookup and takes the next element once it is done.
+  // Each step only touches nodes that were prefetched a round earlier.
+  BinaryNode *lanes[B_TREE_SET_LANES];
+  size_t lane_elements[B_TREE_SET_LANES];
+  size_t active = 0;
+  size_t next = 0;
+  for (size_t j = 0; j < B_TREE_SET_LANES; j++) {
+    lanes[j] = tree->root;
+    lane_elements[j] = b_tree_set_next_candidate(tree, e, n, &next, found);
+    active += lane_elements[j] < n;
+  }
+  binary_node_prefetch(tree->root);
+  while (active > 0) {
+    for (size_t j = 0; j < B_TREE_SET_LANES; j++) {
+      size_t i = lane_elements[j];
+      if (i == n)
+        continue;
+      BinaryNode *node = lanes[j];
+      int c =
+          node ? tree->comperator(node->value, e + i * tree->element_size) : 0;
+      if (c != 0) {
+        lanes[j] = (c > 0) ? node->right : node->left;
+        binary_node_prefetch(lanes[j]);
+        continue;
+      }
+      if (found)
+        found[i] = node != NULL;
+      hits += node != NULL;
+      lanes[j] = tree->root;
+      lane_elements[j] = b_tree_set_next_candidate(tree, e, n, &next, found);
+      active -= lane_elements[j] == n;
+    }
+  }
+  return hits;
 }
 
 size_t b_tree_set_len(BTreeSet *tree) { return tree->len; }
+
+void b_tree_set_iter(BTreeSet *tree, BTreeSetIter *iter) {
+  iter->tree = tree;
+  iter->depth = 0;
+  iter->index = 0;
+  if (tree->paged) {
+    iter->has_cursor = b_plus_tree_first(tree->paged, &iter->cursor);
+  } else if (tree->arena) {
+    iter->has_cursor = arena_tree_first(tree->arena, &iter->arena_cursor);
+  } else {
+    iter->has_cursor = false;
+    b_tree_set_iter_push_left(iter, tree->root);
+  }
+}
+
+void b_tree_set_iter_from(BTreeSet *tree, BTreeSetIter *iter, void *e) {
+  iter->tree = tree;
+  iter->depth = 0;
+  iter->index = 0;
+  iter->has_cursor = false;
+  if (tree->paged) {
+    iter->has_cursor = b_plus_tree_lower_bound(tree->paged, e, &iter->cursor);
+    return;
+  }
+  if (tree->arena) {
+    iter->has_cursor =
+        arena_tree_lower_bound(tree->arena, e, &iter->arena_cursor);
+    return;
+  }
+  if (tree->root == NULL) {
+    bool found;
+    iter->index = b_tree_set_small_search(tree, e, &found);
+    return;
+  }
+  // Keep every node on the path that is not less than e, these are exactly
+  // the pending nodes of an in-order walk starting at e.
+  BinaryNode *node = tree->root;
+  while (node) {
+    int c = tree->comperator(node->value, e);
+    if (c > 0) {
+      node = node->right;
+    } else {
+      iter->stack[iter->depth++] = node;
+      node = c == 0 ? NULL : node->left;
+    }
+  }
+}
+
+bool b_tree_set_iter_next(BTreeSetIter *iter, void **e) {
+  if (iter->tree->paged) {
+    if (!iter->has_cursor)
+      return false;
+    *e = b_plus_cursor_key(iter->tree->paged, &iter->cursor);
+    iter->has_cursor = b_plus_cursor_next(&iter->cursor);
+    return true;
+  }
+  if (iter->tree->arena) {
+    if (!iter->has_cursor)
+      return false;
+    *e = arena_cursor_key(&iter->arena_cursor);
+    iter->has_cursor = arena_cursor_next(&iter->arena_cursor);
+    return true;
+  }
+  if (iter->tree->root == NULL) {
+    if (iter->index >= iter->tree->len)
+      return false;
+    *e = b_tree_set_small_element(iter->tree, iter->index++);
+    return true;
+  }
+  if (iter->depth == 0)
+    return false;
+  BinaryNode *node = iter->stack[--iter->depth];
+  b_tree_set_iter_push_left(iter, node->right);
+  *e = node->value;
+  return true;
+}
+
+int b_tree_set_first(BTreeSet *tree, void *buffer) {
+  if (tree->paged) {
+    BPlusCursor cursor;
+    if (!b_plus_tree_first(tree->paged, &cursor))
+      return EXIT_FAILURE;
+    memcpy(buffer, b_plus_cursor_key(tree->paged, &cursor), tree->element_size);
+    return EXIT_SUCCESS;
+  }
+  if (tree->arena) {
+    ArenaCursor cursor;
+    if (!arena_tree_first(tree->arena, &cursor))
+      return EXIT_FAILURE;
+    memcpy(buffer, arena_cursor_key(&cursor), tree->element_size);
+    return EXIT_SUCCESS;
+  }
+  if (tree->root == NULL) {
+    if (tree->len == 0)
+      return EXIT_FAILURE;
+    memcpy(buffer, tree->small, tree->element_size);
+    return EXIT_SUCCESS;
+  }
+  BinaryNode *node = tree->root;
+  while (node->left)
+    node = node->left;
+  memcpy(buffer, node->value, tree->element_size);
+  return EXIT_SUCCESS;
+}
+
+int b_tree_set_last(BTreeSet *tree, void *buffer) {
+  if (tree->paged) {
+    BPlusCursor cursor;
+    if (!b_plus_tree_last(tree->paged, &cursor))
+      return EXIT_FAILURE;
+    memcpy(buffer, b_plus_cursor_key(tree->paged, &cursor), tree->element_size);
+    return EXIT_SUCCESS;
+  }
+  if (tree->arena) {
+    ArenaCursor cursor;
+    if (!arena_tree_last(tree->arena, &cursor))
+      return EXIT_FAILURE;
+    memcpy(buffer, arena_cursor_key(&cursor), tree->element_size);
+    return EXIT_SUCCESS;
+  }
+  if (tree->root == NULL) {
+    if (tree->len == 0)
+      return EXIT_FAILURE;
+    memcpy(buffer, b_tree_set_small_element(tree, tree->len - 1),
+           tree->element_size);
+    return EXIT_SUCCESS;
+  }
+  BinaryNode *node = tree->root;
+  while (node->right)
+    node = node->right;
+  memcpy(buffer, node->value, tree->element_size);
+  return EXIT_SUCCESS;
+}
+
+int b_tree_set_floor(BTreeSet *tree, void *e, void *buffer) {
+  if (tree->paged) {
+    BPlusCursor cursor;
+    if (!b_plus_tree_floor(tree->paged, e, &cursor))
+      return EXIT_FAILURE;
+    memcpy(buffer, b_plus_cursor_key(tree->paged, &cursor), tree->element_size);
+    return EXIT_SUCCESS;
+  }
+  if (tree->arena) {
+    ArenaCursor cursor;
+    if (!arena_tree_floor(tree->arena, e, &cursor))
+      return EXIT_FAILURE;
+    memcpy(buffer, arena_cursor_key(&cursor), tree->element_size);
+    return EXIT_SUCCESS;
+  }
+  if (tree->root == NULL) {
+    bool found;
+    size_t i = b_tree_set_small_search(tree, e, &found);
+    if (!found && i == 0)
+      return EXIT_FAILURE;
+    if (!found)
+      i--;
+    memcpy(buffer, b_tree_set_small_element(tree, i), tree->element_size);
+    return EXIT_SUCCESS;
+  }
+  BinaryNode *node = binary_node_floor(tree, e);
+  if (node == NULL)
+    return EXIT_FAILURE;
+  memcpy(buffer, node->value, tree->element_size);
+  return EXIT_SUCCESS;
+}
+
+int b_tree_set_ceiling(BTreeSet *tree, void *e, void *buffer) {
+  if (tree->paged) {
+    BPlusCursor cursor;
+    if (!b_plus_tree_lower_bound(tree->paged, e, &cursor))
+      return EXIT_FAILURE;
+    memcpy(buffer, b_plus_cursor_key(tree->paged, &cursor), tree->element_size);
+    return EXIT_SUCCESS;
+  }
+  if (tree->arena) {
+    ArenaCursor cursor;
+    if (!arena_tree_lower_bound(tree->arena, e, &cursor))
+      return EXIT_FAILURE;
+    memcpy(buffer, arena_cursor_key(&cursor), tree->element_size);
+    return EXIT_SUCCESS;
+  }
+  if (tree->root == NULL) {
+    bool found;
+    size_t i = b_tree_set_small_search(tree, e, &found);
+    if (i == tree->len)
+      return EXIT_FAILURE;
+    memcpy(buffer, b_tree_set_small_element(tree, i), tree->element_size);
+    return EXIT_SUCCESS;
+  }
+  BinaryNode *node = binary_node_ceiling(tree, e);
+  if (node == NULL)
+    return EXIT_FAILURE;
+  memcpy(buffer, node->value, tree->element_size);
+  return EXIT_SUCCESS;
+}
+
+void b_tree_set_range(BTreeSet *tree, void *lo, void *hi, Consumer consumer) {
+  BTreeSetIter iter;
+  void *e;
+  b_tree_set_iter_from(tree, &iter, lo);
+  // Stop at the first element that is not less than hi.
+  while (b_tree_set_iter_next(&iter, &e) && tree->comperator(e, hi) > 0)
+    consumer(e);
+}
+
+size_t b_tree_set_rank(BTreeSet *tree, void *e) {
+  size_t rank = 0;
+  if (tree->paged || tree->arena) {
+    BTreeSetIter iter;
+    void *element;
+    b_tree_set_iter(tree, &iter);
+    while (b_tree_set_iter_next(&iter, &element) &&
+           tree->comperator(element, e) > 0)
+      rank++;
+    return rank;
+  }
+  if (tree->root == NULL) {
+    bool found;
+    return b_tree_set_small_search(tree, e, &found);
+  }
+  // Every step to the right skips the left subtree and the node itself.
+  BinaryNode *node = tree->root;
+  while (node) {
+    int c = tree->comperator(node->value, e);
+    if (c > 0) {
+      rank += binary_node_size(node->left) + 1;
+      node = node->right;
+    } else {
+      if (c == 0)
+        return rank + binary_node_size(node->left);
+      node = node->left;
+    }
+  }
+  return rank;
+}
+
+int b_tree_set_select(BTreeSet *tree, size_t i, void *buffer) {
+  if (i >= tree->len)
+    return EXIT_FAILURE;
+  if (tree->paged || tree->arena) {
+    BTreeSetIter iter;
+    void *e;
+    b_tree_set_iter(tree, &iter);
+    for (size_t skipped = 0; skipped <= i; skipped++)
+      b_tree_set_iter_next(&iter, &e);
+    memcpy(buffer, e, tree->element_size);
+    return EXIT_SUCCESS;
+  }
+  if (tree->root == NULL) {
+    memcpy(buffer, b_tree_set_small_element(tree, i), tree->element_size);
+    return EXIT_SUCCESS;
+  }
+  BinaryNode *node = tree->root;
+  while (node) {
+    size_t left = binary_node_size(node->left);
+    if (i == left)
+      break;
+    if (i < left) {
+      node = node->left;
+    } else {
+      i -= left + 1;
+      node = node->right;
+    }
+  }
+  memcpy(buffer, node->value, tree->element_size);
+  return EXIT_SUCCESS;
+}
+
+size_t b_tree_set_count_range(BTreeSet *tree, void *lo, void *hi) {
+  if (tree->comperator(lo, hi) <= 0)
+    return 0;
+  return b_tree_set_rank(tree, hi) - b_tree_set_rank(tree, lo);
+}
+
+int b_tree_set_percentile(BTreeSet *tree, double p, void *buffer) {
+  if (tree->len == 0 || !(p >= 0.0 && p <= 100.0))
+    return EXIT_FAILURE;
+  // The nearest rank is the smallest rank that covers p percent, at least 1.
+  double exact = p / 100.0 * (double)tree->len;
+  size_t rank = (size_t)exact;
+  if ((double)rank < exact)
+    rank++;
+  if (rank == 0)
+    rank = 1;
+  return b_tree_set_select(tree, rank - 1, buffer);
+}
+
+void b_tree_set_merge(BTreeSet *left, BTreeSet *right,
+                      BTreeSetOperation operation, Vec *out) {
+  bool keep_left = operation != B_TREE_SET_INTERSECTION;
+  bool keep_both = operation == B_TREE_SET_UNION ||
+                   operation == B_TREE_SET_INTERSECTION;
+  bool keep_right = operation == B_TREE_SET_UNION ||
+                    operation == B_TREE_SET_SYMMETRIC_DIFFERENCE;
+
+  BTreeSetIter left_iter;
+  BTreeSetIter right_iter;
+  void *l;
+  void *r;
+  b_tree_set_iter(left, &left_iter);
+  b_tree_set_iter(right, &right_iter);
+  bool has_left = b_tree_set_iter_next(&left_iter, &l);
+  bool has_right = b_tree_set_iter_next(&right_iter, &r);
+  while (has_left && has_right) {
+    int c = left->comperator(l, r);
+    if (c > 0) {
+      if (keep_left)
+        vec_push(out, l);
+      has_left = b_tree_set_iter_next(&left_iter, &l);
+    } else if (c < 0) {
+      if (keep_right)
+        vec_push(out, r);
+      has_right = b_tree_set_iter_next(&right_iter, &r);
+    } else {
+      if (keep_both)
+        vec_push(out, l);
+      has_left = b_tree_set_iter_next(&left_iter, &l);
+      has_right = b_tree_set_iter_next(&right_iter, &r);
+    }
+  }
+  // At most one of the sets has elements left, none of them are in the other.
+  for (; has_left && keep_left; has_left = b_tree_set_iter_next(&left_iter, &l))
+    vec_push(out, l);
+  for (; has_right && keep_right;
+       has_right = b_tree_set_iter_next(&right_iter, &r))
+    vec_push(out, r);
+}
+
+BTreeSet *b_tree_set_combine(BTreeSet *left, BTreeSet *right,
+                             BTreeSetOperation operation) {
+  Vec merged = {NULL, 0, 0, left->element_size};
+  b_tree_set_merge(left, right, operation, &merged);
+  // The merge is strictly ascending, so the set can be built directly.
+  BTreeSet *created = b_tree_set_build(left->element_size, left->comperator,
+                                       merged.data, merged.len);
+  free(merged.data);
+  return created;
+}
+
+BTreeSet *b_tree_set_union(BTreeSet *left, BTreeSet *right) {
+  return b_tree_set_combine(left, right, B_TREE_SET_UNION);
+}
+
+BTreeSet *b_tree_set_intersection(BTreeSet *left, BTreeSet *right) {
+  return b_tree_set_combine(left, right, B_TREE_SET_INTERSECTION);
+}
+
+BTreeSet *b_tree_set_difference(BTreeSet *left, BTreeSet *right) {
+  return b_tree_set_combine(left, right, B_TREE_SET_DIFFERENCE);
+}
+
+BTreeSet *b_tree_set_symmetric_difference(BTreeSet *left, BTreeSet *right) {
+  return b_tree_set_combine(left, right, B_TREE_SET_SYMMETRIC_DIFFERENCE);
+}
+
+bool b_tree_set_is_subset(BTreeSet *left, BTreeSet *right) {
+  if (left->len > right->len)
+    return false;
+  BTreeSetIter left_iter;
+  BTreeSetIter right_iter;
+  void *l;
+  void *r;
+  b_tree_set_iter(left, &left_iter);
+  b_tree_set_iter(right, &right_iter);
+  while (b_tree_set_iter_next(&left_iter, &l)) {
+    // Skip the elements of the right set that are less than l.
+    int c = -1;
+    while (c < 0 && b_tree_set_iter_next(&right_iter, &r))
+      c = left->comperator(l, r);
+    if (c != 0)
+      return false;
+  }
+  return true;
+}
+
+bool b_tree_set_is_disjoint(BTreeSet *left, BTreeSet *right) {
+  BTreeSetIter left_iter;
+  BTreeSetIter right_iter;
+  void *l;
+  void *r;
+  b_tree_set_iter(left, &left_iter);
+  b_tree_set_iter(right, &right_iter);
+  bool has_left = b_tree_set_iter_next(&left_iter, &l);
+  bool has_right = b_tree_set_iter_next(&right_iter, &r);
+  while (has_left && has_right) {
+    int c = left->comperator(l, r);
+    if (c == 0)
+      return false;
+    if (c > 0)
+      has_left = b_tree_set_iter_next(&left_iter, &l);
+    else
+      has_right = b_tree_set_iter_next(&right_iter, &r);
+  }
+  return true;
+}
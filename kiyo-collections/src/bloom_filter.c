@@ -0,0 +1,114 @@
+#include "kiyo-collections/bloom_filter.h"
+#include "kiyo-collections/hash.h"
+#include "align.h"
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+/* Size of a block in bytes, the alignment of the blocks. */
+#define BLOOM_FILTER_BLOCK_SIZE (BLOOM_FILTER_BLOCK_WORDS * sizeof(uint64_t))
+
+/**
+ * Odd multipliers that derive the bit of every word from the same 32 bit key,
+ * taken from the split block Bloom filter of Parquet.
+ */
+const uint32_t BLOOM_FILTER_SALTS[BLOOM_FILTER_BLOCK_WORDS] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U,
+};
+
+BloomFilter *bloom_filter_new(size_t element_size, Hasher hasher,
+                              size_t capacity) {
+  size_t bits = capacity * BLOOM_FILTER_BITS_PER_ELEMENT;
+  size_t block_count = 1;
+  while (block_count * BLOOM_FILTER_BLOCK_SIZE * 8 < bits)
+    block_count *= 2;
+
+  BloomFilter *created = malloc(sizeof(BloomFilter));
+  if (!created)
+    return NULL;
+  created->blocks = align_alloc(BLOOM_FILTER_BLOCK_SIZE,
+                                block_count * BLOOM_FILTER_BLOCK_SIZE);
+  if (!created->blocks) {
+    free(created);
+    return NULL;
+  }
+  memset(created->blocks, 0, block_count * BLOOM_FILTER_BLOCK_SIZE);
+  created->block_count = block_count;
+  created->len = 0;
+  created->element_size = element_size;
+  created->hasher = hasher;
+  return created;
+}
+
+void bloom_filter_free(BloomFilter *filter) {
+  align_free(filter->blocks);
+  free(filter);
+}
+
+uint64_t bloom_filter_hash(BloomFilter *filter, void *e) {
+  if (filter->hasher)
+    return filter->hasher(e);
+  return hash_bytes(e, filter->element_size);
+}
+
+/**
+ * Returns the block of the hash and writes the bit to set in each of its words
+ * to masks. The low bits of the hash pick the block, the high bits the bits.
+ */
+uint64_t *bloom_filter_masks(BloomFilter *filter, uint64_t hash,
+                             uint64_t *masks) {
+  uint32_t key = (uint32_t)(hash >> 32);
+  // The loop has a fixed trip count and no branches, so it vectorizes.
+  for (size_t i = 0; i < BLOOM_FILTER_BLOCK_WORDS; i++)
+    masks[i] = (uint64_t)1 << ((uint32_t)(key * BLOOM_FILTER_SALTS[i]) >> 26);
+  size_t block = (size_t)hash & (filter->block_count - 1);
+  return filter->blocks + block * BLOOM_FILTER_BLOCK_WORDS;
+}
+
+void bloom_filter_add_hash(BloomFilter *filter, uint64_t hash) {
+  uint64_t masks[BLOOM_FILTER_BLOCK_WORDS];
+  uint64_t *block = bloom_filter_masks(filter, hash, masks);
+  for (size_t i = 0; i < BLOOM_FILTER_BLOCK_WORDS; i++)
+    block[i] |= masks[i];
+  filter->len++;
+}
+
+bool bloom_filter_contains_hash(BloomFilter *filter, uint64_t hash) {
+  uint64_t masks[BLOOM_FILTER_BLOCK_WORDS];
+  uint64_t *block = bloom_filter_masks(filter, hash, masks);
+  // Check all words at once instead of stopping at the first missing bit, a
+  // data dependent branch per word costs more than the few extra ands.
+#if defined(__SSE2__) || defined(_M_X64)
+  __m128i missing = _mm_setzero_si128();
+  for (size_t i = 0; i < BLOOM_FILTER_BLOCK_WORDS; i += 2) {
+    __m128i words = _mm_load_si128((const __m128i *)(block + i));
+    __m128i mask = _mm_loadu_si128((const __m128i *)(masks + i));
+    missing = _mm_or_si128(missing, _mm_andnot_si128(words, mask));
+  }
+  __m128i zero = _mm_cmpeq_epi8(missing, _mm_setzero_si128());
+  return _mm_movemask_epi8(zero) == 0xFFFF;
+#else
+  uint64_t missing = 0;
+  for (size_t i = 0; i < BLOOM_FILTER_BLOCK_WORDS; i++)
+    missing |= masks[i] & ~block[i];
+  return missing == 0;
+#endif
+}
+
+void bloom_filter_add(BloomFilter *filter, void *e) {
+  bloom_filter_add_hash(filter, bloom_filter_hash(filter, e));
+}
+
+bool bloom_filter_contains(BloomFilter *filter, void *e) {
+  return bloom_filter_contains_hash(filter, bloom_filter_hash(filter, e));
+}
+
+size_t bloom_filter_len(BloomFilter *filter) { return filter->len; }
+
+void bloom_filter_clear(BloomFilter *filter) {
+  memset(filter->blocks, 0, filter->block_count * BLOOM_FILTER_BLOCK_SIZE);
+  filter->len = 0;
+}
@@ -0,0 +1,138 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "kiyo-collections/concurrent_map.h"
+#include "kiyo-collections/hash.h"
+#include "kiyo-collections/hash_map.h"
+#include "align.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+/* Size of a cache line, shards never share one. */
+#define CACHE_LINE_SIZE 64
+
+struct ConcurrentShard {
+  alignas(CACHE_LINE_SIZE) pthread_rwlock_t lock;
+  HashMap *table;
+  /* Buffer for values computed by compute_if_absent. */
+  void *scratch;
+};
+
+ConcurrentMap *concurrent_map_new(size_t key_size, size_t value_size,
+                                  Hasher hasher, Comperator comperator,
+                                  size_t shards) {
+  size_t shard_count = 1;
+  if (shards == 0)
+    shards = CONCURRENT_MAP_DEFAULT_SHARDS;
+  while (shard_count < shards)
+    shard_count *= 2;
+
+  ConcurrentMap *created = malloc(sizeof(ConcurrentMap));
+  if (!created)
+    return NULL;
+  created->shards =
+      align_alloc(CACHE_LINE_SIZE, shard_count * sizeof(ConcurrentShard));
+  if (!created->shards) {
+    free(created);
+    return NULL;
+  }
+  created->shard_count = 0;
+  created->hasher = hasher;
+
+  for (size_t i = 0; i < shard_count; i++) {
+    ConcurrentShard *shard = &created->shards[i];
+    shard->table = hash_map_new(key_size, value_size, hasher, comperator);
+    shard->scratch = malloc(value_size > 0 ? value_size : 1);
+    if (!shard->table || !shard->scratch ||
+        pthread_rwlock_init(&shard->lock, NULL) != 0) {
+      if (shard->table)
+        hash_map_free(shard->table);
+      free(shard->scratch);
+      concurrent_map_free(created);
+      return NULL;
+    }
+    created->shard_count++;
+  }
+  return created;
+}
+
+void concurrent_map_free(ConcurrentMap *map) {
+  for (size_t i = 0; i < map->shard_count; i++) {
+    pthread_rwlock_destroy(&map->shards[i].lock);
+    hash_map_free(map->shards[i].table);
+    free(map->shards[i].scratch);
+  }
+  align_free(map->shards);
+  free(map);
+}
+
+ConcurrentShard *concurrent_map_shard(ConcurrentMap *map, void *k) {
+  // The shard tables use the low bits of the same hash, so pick the shard
+  // from the bits of a second mix.
+  uint64_t hash = hash_mix64(map->hasher(k));
+  return &map->shards[(hash >> 32) & (map->shard_count - 1)];
+}
+
+int concurrent_map_put(ConcurrentMap *map, void *k, void *v) {
+  ConcurrentShard *shard = concurrent_map_shard(map, k);
+  pthread_rwlock_wrlock(&shard->lock);
+  int status = hash_map_put(shard->table, k, v);
+  pthread_rwlock_unlock(&shard->lock);
+  return status;
+}
+
+int concurrent_map_get(ConcurrentMap *map, void *k, void *v) {
+  ConcurrentShard *shard = concurrent_map_shard(map, k);
+  pthread_rwlock_rdlock(&shard->lock);
+  int status = hash_map_get(shard->table, k, v);
+  pthread_rwlock_unlock(&shard->lock);
+  return status;
+}
+
+int concurrent_map_remove(ConcurrentMap *map, void *k) {
+  ConcurrentShard *shard = concurrent_map_shard(map, k);
+  pthread_rwlock_wrlock(&shard->lock);
+  int status = hash_map_remove(shard->table, k);
+  pthread_rwlock_unlock(&shard->lock);
+  return status;
+}
+
+bool concurrent_map_contains_key(ConcurrentMap *map, void *k) {
+  ConcurrentShard *shard = concurrent_map_shard(map, k);
+  pthread_rwlock_rdlock(&shard->lock);
+  bool contains = hash_map_contains_key(shard->table, k);
+  pthread_rwlock_unlock(&shard->lock);
+  return contains;
+}
+
+int concurrent_map_compute_if_absent(ConcurrentMap *map, void *k,
+                                     BiConsumer factory, void *v) {
+  ConcurrentShard *shard = concurrent_map_shard(map, k);
+  // Most calls find the key, try that under the shared lock first.
+  pthread_rwlock_rdlock(&shard->lock);
+  int status = hash_map_get(shard->table, k, v);
+  pthread_rwlock_unlock(&shard->lock);
+  if (status == EXIT_SUCCESS)
+    return status;
+
+  // Another thread may have inserted the key in between, look again.
+  pthread_rwlock_wrlock(&shard->lock);
+  status = hash_map_get(shard->table, k, v);
+  if (status != EXIT_SUCCESS) {
+    factory(k, shard->scratch);
+    status = hash_map_put(shard->table, k, shard->scratch);
+    if (status == EXIT_SUCCESS)
+      status = hash_map_get(shard->table, k, v);
+  }
+  pthread_rwlock_unlock(&shard->lock);
+  return status;
+}
+
+size_t concurrent_map_len(ConcurrentMap *map) {
+  size_t len = 0;
+  for (size_t i = 0; i < map->shard_count; i++) {
+    pthread_rwlock_rdlock(&map->shards[i].lock);
+    len += map->shards[i].table->len;
+    pthread_rwlock_unlock(&map->shards[i].lock);
+  }
+  return len;
+}
@@ -0,0 +1,321 @@
+#include "kiyo-collections/flat_map.h"
+#include "align.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Smallest capacity of a vec that grows from empty. */
+#define FLAT_MAP_MIN_CAPACITY 4
+
+FlatMap *flat_map_new(size_t key_size, size_t value_size,
+                      Comperator comperator) {
+  FlatMap *created = malloc(sizeof(FlatMap));
+  if (!created)
+    return NULL;
+
+  // A buffered record is a key and a value, padded so that both stay aligned
+  // in every record of the buffer.
+  size_t value_alignment = align_field(value_size);
+  size_t key_alignment = align_field(key_size);
+  size_t record_alignment =
+      value_alignment > key_alignment ? value_alignment : key_alignment;
+  created->value_offset =
+      (key_size + value_alignment - 1) / value_alignment * value_alignment;
+  size_t record_end = created->value_offset + value_size;
+  size_t record_size =
+      (record_end + record_alignment - 1) / record_alignment * record_alignment;
+
+  created->keys = (Vec){NULL, 0, 0, key_size};
+  created->values = (Vec){NULL, 0, 0, value_size};
+  created->pending = (Vec){NULL, 0, 0, record_size};
+  created->comperator = comperator;
+  // Like a new vec the map starts with a little room, so data is never NULL.
+  if (flat_map_reserve(created, FLAT_MAP_MIN_CAPACITY) != EXIT_SUCCESS) {
+    flat_map_free(created);
+    return NULL;
+  }
+  return created;
+}
+
+void flat_map_free(FlatMap *map) {
+  free(map->keys.data);
+  free(map->values.data);
+  free(map->pending.data);
+  free(map);
+}
+
+/**
+ * Grows the capacity of the vec to at least n elements by doubling it. Unlike
+ * vec_grow, a failed allocation is reported and leaves the vec unchanged.
+ */
+int flat_map_vec_reserve(Vec *vec, size_t n) {
+  if (n <= vec->capacity)
+    return EXIT_SUCCESS;
+  size_t capacity = vec->capacity ? vec->capacity : FLAT_MAP_MIN_CAPACITY;
+  while (capacity < n)
+    capacity *= 2;
+  // One extra byte keeps the allocation valid for values of size 0.
+  void *data = realloc(vec->data, capacity * vec->element_size + 1);
+  if (!data)
+    return EXIT_FAILURE;
+  vec->data = data;
+  vec->capacity = capacity;
+  return EXIT_SUCCESS;
+}
+
+int flat_map_reserve(FlatMap *map, size_t n) {
+  if (flat_map_vec_reserve(&map->keys, n) != EXIT_SUCCESS ||
+      flat_map_vec_reserve(&map->values, n) != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+  return EXIT_SUCCESS;
+}
+
+/* Returns a pointer to the i-th key. */
+char *flat_map_key(FlatMap *map, size_t i) {
+  return (char *)map->keys.data + i * map->keys.element_size;
+}
+
+/* Returns a pointer to the i-th value. */
+char *flat_map_value(FlatMap *map, size_t i) {
+  return (char *)map->values.data + i * map->values.element_size;
+}
+
+/**
+ * Returns the index of the first key that is not less than k and sets found to
+ * whether that key equals k.
+ */
+size_t flat_map_search(FlatMap *map, void *k, bool *found) {
+  size_t lo = 0;
+  size_t hi = map->keys.len;
+  *found = false;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    int c = map->comperator(flat_map_key(map, mid), k);
+    if (c == 0) {
+      *found = true;
+      return mid;
+    }
+    if (c > 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+/* Copies the i-th entry to the buffers, either of which may be NULL. */
+int flat_map_write(FlatMap *map, size_t i, void *buffer_k, void *buffer_v) {
+  if (buffer_k)
+    memcpy(buffer_k, flat_map_key(map, i), map->keys.element_size);
+  if (buffer_v)
+    memcpy(buffer_v, flat_map_value(map, i), map->values.element_size);
+  return EXIT_SUCCESS;
+}
+
+int flat_map_put(FlatMap *map, void *k, void *v) {
+  if (flat_map_flush(map) != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+  bool found;
+  size_t i = flat_map_search(map, k, &found);
+  if (found) {
+    if (map->values.element_size > 0)
+      memcpy(flat_map_value(map, i), v, map->values.element_size);
+    return EXIT_SUCCESS;
+  }
+  if (flat_map_reserve(map, map->keys.len + 1) != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+  size_t after = map->keys.len - i;
+  memmove(flat_map_key(map, i + 1), flat_map_key(map, i),
+          after * map->keys.element_size);
+  memmove(flat_map_value(map, i + 1), flat_map_value(map, i),
+          after * map->values.element_size);
+  memcpy(flat_map_key(map, i), k, map->keys.element_size);
+  if (map->values.element_size > 0)
+    memcpy(flat_map_value(map, i), v, map->values.element_size);
+  map->keys.len++;
+  map->values.len++;
+  return EXIT_SUCCESS;
+}
+
+int flat_map_buffer(FlatMap *map, void *k, void *v) {
+  Vec *pending = &map->pending;
+  if (flat_map_vec_reserve(pending, pending->len + 1) != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+  char *record = (char *)pending->data + pending->len * pending->element_size;
+  memcpy(record, k, map->keys.element_size);
+  if (map->values.element_size > 0)
+    memcpy(record + map->value_offset, v, map->values.element_size);
+  pending->len++;
+  return EXIT_SUCCESS;
+}
+
+int flat_map_flush(FlatMap *map) {
+  Vec *pending = &map->pending;
+  if (pending->len == 0)
+    return EXIT_SUCCESS;
+  // Records start with their key, so the comperator sorts them as is.
+  if (vec_sort(pending, map->comperator) != EXIT_SUCCESS ||
+      flat_map_reserve(map, map->keys.len + pending->len) != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+
+  // The sort is stable, so of equal keys the last buffered one comes last and
+  // is the one to keep.
+  size_t size = pending->element_size;
+  char *records = pending->data;
+  size_t unique = 0;
+  for (size_t j = 0; j < pending->len; j++) {
+    if (j + 1 < pending->len &&
+        map->comperator(records + j * size, records + (j + 1) * size) == 0)
+      continue;
+    memmove(records + unique * size, records + j * size, size);
+    unique++;
+  }
+
+  // Merge from the back, so every entry moves at most once and no second
+  // array is needed. A buffered key that is already present replaces the old
+  // entry, which leaves a gap that is closed at the end.
+  size_t key_size = map->keys.element_size;
+  size_t value_size = map->values.element_size;
+  size_t i = map->keys.len;
+  size_t j = unique;
+  size_t w = i + j;
+  size_t end = w;
+  while (j > 0) {
+    char *record = records + (j - 1) * size;
+    int c = i > 0 ? map->comperator(flat_map_key(map, i - 1), record) : 1;
+    w--;
+    if (c < 0) {
+      memmove(flat_map_key(map, w), flat_map_key(map, i - 1), key_size);
+      memmove(flat_map_value(map, w), flat_map_value(map, i - 1), value_size);
+      i--;
+    } else {
+      memcpy(flat_map_key(map, w), record, key_size);
+      memcpy(flat_map_value(map, w), record + map->value_offset, value_size);
+      j--;
+      if (c == 0)
+        i--;
+    }
+  }
+  memmove(flat_map_key(map, i), flat_map_key(map, w), (end - w) * key_size);
+  memmove(flat_map_value(map, i), flat_map_value(map, w),
+          (end - w) * value_size);
+  map->keys.len = i + end - w;
+  map->values.len = map->keys.len;
+  pending->len = 0;
+  return EXIT_SUCCESS;
+}
+
+int flat_map_get(FlatMap *map, void *k, void *v) {
+  void *value = flat_map_get_ptr(map, k);
+  if (value == NULL)
+    return EXIT_FAILURE;
+  memcpy(v, value, map->values.element_size);
+  return EXIT_SUCCESS;
+}
+
+void *flat_map_get_ptr(FlatMap *map, void *k) {
+  bool found;
+  size_t i = flat_map_search(map, k, &found);
+  return found ? flat_map_value(map, i) : NULL;
+}
+
+int flat_map_remove(FlatMap *map, void *k) {
+  if (flat_map_flush(map) != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+  bool found;
+  size_t i = flat_map_search(map, k, &found);
+  if (!found)
+    return EXIT_FAILURE;
+  size_t after = map->keys.len - i - 1;
+  memmove(flat_map_key(map, i), flat_map_key(map, i + 1),
+          after * map->keys.element_size);
+  memmove(flat_map_value(map, i), flat_map_value(map, i + 1),
+          after * map->values.element_size);
+  map->keys.len--;
+  map->values.len--;
+  return EXIT_SUCCESS;
+}
+
+bool flat_map_contains_key(FlatMap *map, void *k) {
+  bool found;
+  flat_map_search(map, k, &found);
+  return found;
+}
+
+size_t flat_map_len(FlatMap *map) { return map->keys.len; }
+
+void flat_map_clear(FlatMap *map) {
+  map->keys.len = 0;
+  map->values.len = 0;
+  map->pending.len = 0;
+}
+
+void flat_map_iter(FlatMap *map, FlatMapIter *iter) {
+  iter->map = map;
+  iter->index = 0;
+}
+
+void flat_map_iter_from(FlatMap *map, FlatMapIter *iter, void *k) {
+  bool found;
+  iter->map = map;
+  iter->index = flat_map_search(map, k, &found);
+}
+
+bool flat_map_iter_next(FlatMapIter *iter, void **k, void **v) {
+  if (iter->index >= iter->map->keys.len)
+    return false;
+  *k = flat_map_key(iter->map, iter->index);
+  *v = flat_map_value(iter->map, iter->index);
+  iter->index++;
+  return true;
+}
+
+int flat_map_first(FlatMap *map, void *buffer_k, void *buffer_v) {
+  if (map->keys.len == 0)
+    return EXIT_FAILURE;
+  return flat_map_write(map, 0, buffer_k, buffer_v);
+}
+
+int flat_map_last(FlatMap *map, void *buffer_k, void *buffer_v) {
+  if (map->keys.len == 0)
+    return EXIT_FAILURE;
+  return flat_map_write(map, map->keys.len - 1, buffer_k, buffer_v);
+}
+
+int flat_map_floor(FlatMap *map, void *k, void *buffer_k, void *buffer_v) {
+  bool found;
+  size_t i = flat_map_search(map, k, &found);
+  if (!found && i == 0)
+    return EXIT_FAILURE;
+  return flat_map_write(map, found ? i : i - 1, buffer_k, buffer_v);
+}
+
+int flat_map_ceiling(FlatMap *map, void *k, void *buffer_k, void *buffer_v) {
+  bool found;
+  size_t i = flat_map_search(map, k, &found);
+  if (i == map->keys.len)
+    return EXIT_FAILURE;
+  return flat_map_write(map, i, buffer_k, buffer_v);
+}
+
+size_t flat_map_range(FlatMap *map, void *lo, void *hi, void **keys,
+                      void **values) {
+  bool found;
+  size_t first = flat_map_search(map, lo, &found);
+  size_t last = flat_map_search(map, hi, &found);
+  if (keys)
+    *keys = flat_map_key(map, first);
+  if (values)
+    *values = flat_map_value(map, first);
+  return last > first ? last - first : 0;
+}
+
+size_t flat_map_rank(FlatMap *map, void *k) {
+  bool found;
+  return flat_map_search(map, k, &found);
+}
+
+int flat_map_select(FlatMap *map, size_t i, void *buffer_k, void *buffer_v) {
+  if (i >= map->keys.len)
+    return EXIT_FAILURE;
+  return flat_map_write(map, i, buffer_k, buffer_v);
+}
@@ -0,0 +1,86 @@
+#include "kiyo-collections/flat_set.h"
+#include <stdlib.h>
+
+FlatSet *flat_set_new(size_t element_size, Comperator comperator) {
+  FlatSet *created = malloc(sizeof(FlatSet));
+  if (!created)
+    return NULL;
+  created->table = flat_map_new(element_size, 0, comperator);
+  if (!created->table) {
+    free(created);
+    return NULL;
+  }
+  return created;
+}
+
+void flat_set_free(FlatSet *set) {
+  flat_map_free(set->table);
+  free(set);
+}
+
+int flat_set_reserve(FlatSet *set, size_t n) {
+  return flat_map_reserve(set->table, n);
+}
+
+int flat_set_add(FlatSet *set, void *e) {
+  return flat_map_put(set->table, e, NULL);
+}
+
+int flat_set_buffer(FlatSet *set, void *e) {
+  return flat_map_buffer(set->table, e, NULL);
+}
+
+int flat_set_flush(FlatSet *set) { return flat_map_flush(set->table); }
+
+int flat_set_remove(FlatSet *set, void *e) {
+  return flat_map_remove(set->table, e);
+}
+
+bool flat_set_contains(FlatSet *set, void *e) {
+  return flat_map_contains_key(set->table, e);
+}
+
+size_t flat_set_len(FlatSet *set) { return flat_map_len(set->table); }
+
+void flat_set_clear(FlatSet *set) { flat_map_clear(set->table); }
+
+void flat_set_iter(FlatSet *set, FlatSetIter *iter) {
+  flat_map_iter(set->table, &iter->inner);
+}
+
+void flat_set_iter_from(FlatSet *set, FlatSetIter *iter, void *e) {
+  flat_map_iter_from(set->table, &iter->inner, e);
+}
+
+bool flat_set_iter_next(FlatSetIter *iter, void **e) {
+  void *v;
+  return flat_map_iter_next(&iter->inner, e, &v);
+}
+
+int flat_set_first(FlatSet *set, void *buffer) {
+  return flat_map_first(set->table, buffer, NULL);
+}
+
+int flat_set_last(FlatSet *set, void *buffer) {
+  return flat_map_last(set->table, buffer, NULL);
+}
+
+int flat_set_floor(FlatSet *set, void *e, void *buffer) {
+  return flat_map_floor(set->table, e, buffer, NULL);
+}
+
+int flat_set_ceiling(FlatSet *set, void *e, void *buffer) {
+  return flat_map_ceiling(set->table, e, buffer, NULL);
+}
+
+size_t flat_set_range(FlatSet *set, void *lo, void *hi, void **elements) {
+  return flat_map_range(set->table, lo, hi, elements, NULL);
+}
+
+size_t flat_set_rank(FlatSet *set, void *e) {
+  return flat_map_rank(set->table, e);
+}
+
+int flat_set_select(FlatSet *set, size_t i, void *buffer) {
+  return flat_map_select(set->table, i, buffer, NULL);
+}
@@ -0,0 +1,167 @@
+#include "kiyo-collections/frozen_map.h"
+#include "align.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Identifies the data of a frozen map. */
+#define FROZEN_MAGIC "KIYOFRZ1"
+
+/* Returns the number of bytes of the data of a frozen map. */
+size_t frozen_map_bytes(size_t len, size_t key_size, size_t value_size) {
+  return ALIGN_UP(sizeof(FrozenHeader)) + ALIGN_UP((len + 1) * key_size) +
+         (len + 1) * value_size;
+}
+
+/* Points the map to its data and sets the key and value arrays. */
+void frozen_map_layout(FrozenMap *map, void *data, size_t len,
+                       size_t key_size, size_t value_size) {
+  size_t keys_offset = ALIGN_UP(sizeof(FrozenHeader));
+  map->data = data;
+  map->size = frozen_map_bytes(len, key_size, value_size);
+  map->len = len;
+  map->key_size = key_size;
+  map->value_size = value_size;
+  map->keys = (char *)data + keys_offset;
+  map->values = map->keys + ALIGN_UP((len + 1) * key_size);
+}
+
+FrozenMap *frozen_map_alloc(size_t len, size_t key_size, size_t value_size,
+                            Comperator comperator) {
+  FrozenMap *created = malloc(sizeof(FrozenMap));
+  if (!created)
+    return NULL;
+  void *data = calloc(1, frozen_map_bytes(len, key_size, value_size));
+  if (!data) {
+    free(created);
+    return NULL;
+  }
+  frozen_map_layout(created, data, len, key_size, value_size);
+  created->comperator = comperator;
+  created->owned = true;
+
+  FrozenHeader *header = data;
+  memcpy(header->magic, FROZEN_MAGIC, sizeof(header->magic));
+  header->len = len;
+  header->key_size = key_size;
+  header->value_size = value_size;
+  return created;
+}
+
+size_t frozen_map_first_slot(size_t len) {
+  // The smallest key lives in the leftmost slot.
+  size_t i = 1;
+  while (2 * i <= len)
+    i *= 2;
+  return i;
+}
+
+size_t frozen_map_next_slot(size_t i, size_t len) {
+  if (2 * i + 1 <= len) {
+    // The successor is the leftmost slot of the right subtree.
+    i = 2 * i + 1;
+    while (2 * i <= len)
+      i *= 2;
+    return i;
+  }
+  // Climb while this is a right child, then once more to the parent.
+  while (i & 1)
+    i >>= 1;
+  return i >> 1;
+}
+
+FrozenMap *b_tree_map_freeze(BTreeMap *tree) {
+  if (tree->comperator == NULL)
+    return NULL;
+  FrozenMap *created = frozen_map_alloc(tree->len, tree->key_size,
+                                        tree->value_size, tree->comperator);
+  if (!created)
+    return NULL;
+  BTreeMapIter iter;
+  void *k;
+  void *v;
+  size_t i = frozen_map_first_slot(tree->len);
+  b_tree_map_iter(tree, &iter);
+  while (b_tree_map_iter_next(&iter, &k, &v)) {
+    memcpy(created->keys + i * tree->key_size, k, tree->key_size);
+    memcpy(created->values + i * tree->value_size, v, tree->value_size);
+    i = frozen_map_next_slot(i, tree->len);
+  }
+  return created;
+}
+
+FrozenMap *frozen_map_view(void *data, size_t size, Comperator comperator) {
+  FrozenHeader *header = data;
+  if (size < sizeof(FrozenHeader) ||
+      memcmp(header->magic, FROZEN_MAGIC, sizeof(header->magic)) != 0)
+    return NULL;
+  // Reject headers whose arrays would not fit, before computing their size.
+  size_t slots = header->len + 1;
+  if (slots == 0 || (header->key_size && slots > size / header->key_size) ||
+      (header->value_size && slots > size / header->value_size) ||
+      frozen_map_bytes(header->len, header->key_size, header->value_size) >
+          size)
+    return NULL;
+
+  FrozenMap *created = malloc(sizeof(FrozenMap));
+  if (!created)
+    return NULL;
+  frozen_map_layout(created, data, header->len, header->key_size,
+                    header->value_size);
+  created->comperator = comperator;
+  created->owned = false;
+  return created;
+}
+
+void frozen_map_free(FrozenMap *map) {
+  if (map->owned)
+    free(map->data);
+  free(map);
+}
+
+void *frozen_map_data(FrozenMap *map) { return map->data; }
+
+size_t frozen_map_size(FrozenMap *map) { return map->size; }
+
+size_t frozen_map_len(FrozenMap *map) { return map->len; }
+
+size_t frozen_map_search(FrozenMap *map, void *k) {
+  size_t i = 1;
+  while (i <= map->len) {
+#if defined(__GNUC__) || defined(__clang__)
+    // The 16 descendants four levels below are adjacent.
+    __builtin_prefetch(map->keys + 16 * i * map->key_size);
+#endif
+    // Go right if the key of the slot is less than k.
+    i = 2 * i + (map->comperator(map->keys + i * map->key_size, k) > 0);
+  }
+  // The path ends with a left turn at the answer followed by right turns,
+  // strip the right turns and the left turn.
+  while (i & 1)
+    i >>= 1;
+  return i >> 1;
+}
+
+int frozen_map_get(FrozenMap *map, void *k, void *v) {
+  size_t i = frozen_map_search(map, k);
+  if (i == 0 || map->comperator(map->keys + i * map->key_size, k) != 0)
+    return EXIT_FAILURE;
+  memcpy(v, map->values + i * map->value_size, map->value_size);
+  return EXIT_SUCCESS;
+}
+
+bool frozen_map_contains_key(FrozenMap *map, void *k) {
+  size_t i = frozen_map_search(map, k);
+  return i != 0 && map->comperator(map->keys + i * map->key_size, k) == 0;
+}
+
+int frozen_map_lower_bound(FrozenMap *map, void *k, void *buffer_k,
+                           void *buffer_v) {
+  size_t i = frozen_map_search(map, k);
+  if (i == 0)
+    return EXIT_FAILURE;
+  if (buffer_k)
+    memcpy(buffer_k, map->keys + i * map->key_size, map->key_size);
+  if (buffer_v)
+    memcpy(buffer_v, map->values + i * map->value_size, map->value_size);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,59 @@
+#include "kiyo-collections/frozen_set.h"
+#include <stdlib.h>
+#include <string.h>
+
+FrozenSet *frozen_set_wrap(FrozenMap *table) {
+  if (!table)
+    return NULL;
+  FrozenSet *created = malloc(sizeof(FrozenSet));
+  if (!created) {
+    frozen_map_free(table);
+    return NULL;
+  }
+  created->table = table;
+  return created;
+}
+
+FrozenSet *b_tree_set_freeze(BTreeSet *tree) {
+  FrozenMap *table =
+      frozen_map_alloc(tree->len, tree->element_size, 0, tree->comperator);
+  if (!table)
+    return NULL;
+  BTreeSetIter iter;
+  void *e;
+  size_t i = frozen_map_first_slot(tree->len);
+  b_tree_set_iter(tree, &iter);
+  while (b_tree_set_iter_next(&iter, &e)) {
+    memcpy(table->keys + i * tree->element_size, e, tree->element_size);
+    i = frozen_map_next_slot(i, tree->len);
+  }
+  return frozen_set_wrap(table);
+}
+
+FrozenSet *frozen_set_view(void *data, size_t size, Comperator comperator) {
+  FrozenMap *table = frozen_map_view(data, size, comperator);
+  if (table && table->value_size != 0) {
+    frozen_map_free(table);
+    return NULL;
+  }
+  return frozen_set_wrap(table);
+}
+
+void frozen_set_free(FrozenSet *set) {
+  frozen_map_free(set->table);
+  free(set);
+}
+
+void *frozen_set_data(FrozenSet *set) { return frozen_map_data(set->table); }
+
+size_t frozen_set_size(FrozenSet *set) { return frozen_map_size(set->table); }
+
+size_t frozen_set_len(FrozenSet *set) { return frozen_map_len(set->table); }
+
+bool frozen_set_contains(FrozenSet *set, void *e) {
+  return frozen_map_contains_key(set->table, e);
+}
+
+int frozen_set_lower_bound(FrozenSet *set, void *e, void *buffer) {
+  return frozen_map_lower_bound(set->table, e, buffer, NULL);
+}
@@ -0,0 +1,42 @@
+#include "kiyo-collections/hash.h"
+#include <string.h>
+
+#define HASH_MULTIPLIER 0x9E3779B97F4A7C15ULL
+
+uint64_t hash_mix64(uint64_t x) {
+  // Finalizer of MurmurHash3, every input bit affects every output bit.
+  x ^= x >> 33;
+  x *= 0xFF51AFD7ED558CCDULL;
+  x ^= x >> 33;
+  x *= 0xC4CEB9FE1A85EC53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+uint64_t hash_bytes(const void *data, size_t len) {
+  const unsigned char *bytes = data;
+  uint64_t h = len * HASH_MULTIPLIER;
+  uint64_t chunk;
+  for (; len >= sizeof(chunk); len -= sizeof(chunk)) {
+    memcpy(&chunk, bytes, sizeof(chunk));
+    h = (h ^ hash_mix64(chunk)) * HASH_MULTIPLIER;
+    bytes += sizeof(chunk);
+  }
+  if (len > 0) {
+    chunk = 0;
+    memcpy(&chunk, bytes, len);
+    h = (h ^ hash_mix64(chunk)) * HASH_MULTIPLIER;
+  }
+  return hash_mix64(h);
+}
+
+size_t hash_int(void *k) { return hash_mix64((uint64_t)(int64_t)*(int *)k); }
+
+size_t hash_u32(void *k) { return hash_mix64(*(uint32_t *)k); }
+
+size_t hash_u64(void *k) { return hash_mix64(*(uint64_t *)k); }
+
+size_t hash_cstr(void *k) {
+  char *s = *(char **)k;
+  return hash_bytes(s, strlen(s));
+}
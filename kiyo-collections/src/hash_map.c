@@ -0,0 +1,280 @@
+#include "kiyo-collections/hash_map.h"
+#include "align.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+/* Smallest capacity, a single group. */
+#define HASH_MIN_CAPACITY HASH_GROUP_WIDTH
+
+uint32_t hash_group_match(int8_t *group, int8_t h2) {
+#if defined(__SSE2__) || defined(_M_X64)
+  __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+  return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(h2)));
+#else
+  uint32_t mask = 0;
+  for (unsigned i = 0; i < HASH_GROUP_WIDTH; i++)
+    mask |= (uint32_t)(group[i] == h2) << i;
+  return mask;
+#endif
+}
+
+uint32_t hash_group_match_empty(int8_t *group) {
+  return hash_group_match(group, HASH_CTRL_EMPTY);
+}
+
+uint32_t hash_group_match_free(int8_t *group) {
+  // Empty and deleted slots are the only negative control bytes.
+#if defined(__SSE2__) || defined(_M_X64)
+  __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+  return (uint32_t)_mm_movemask_epi8(ctrl);
+#else
+  uint32_t mask = 0;
+  for (unsigned i = 0; i < HASH_GROUP_WIDTH; i++)
+    mask |= (uint32_t)(group[i] < 0) << i;
+  return mask;
+#endif
+}
+
+unsigned hash_group_lowest(uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+  return (unsigned)__builtin_ctz(mask);
+#else
+  unsigned i = 0;
+  while (!(mask & 1)) {
+    mask >>= 1;
+    i++;
+  }
+  return i;
+#endif
+}
+
+size_t hash_capacity_for(size_t n) {
+  if (n == 0)
+    return 0;
+  size_t capacity = HASH_MIN_CAPACITY;
+  while (capacity - capacity / 8 < n)
+    capacity *= 2;
+  return capacity;
+}
+
+size_t hash_capacity_grow(size_t capacity, size_t len) {
+  if (capacity == 0)
+    return hash_capacity_for(len + 1);
+  if (capacity > HASH_GROUP_WIDTH && len <= capacity * 25 / 32)
+    return capacity;
+  return capacity * 2;
+}
+
+HashMap *hash_map_new(size_t key_size, size_t value_size, Hasher hasher,
+                      Comperator comperator) {
+  HashMap *created = malloc(sizeof(HashMap));
+  if (!created)
+    return NULL;
+
+  // Pad the key so that the value is aligned, and the slot so that the key of
+  // the next slot is aligned.
+  size_t value_alignment = align_field(value_size);
+  size_t key_alignment = align_field(key_size);
+  size_t slot_alignment =
+      value_alignment > key_alignment ? value_alignment : key_alignment;
+  created->value_offset =
+      (key_size + value_alignment - 1) / value_alignment * value_alignment;
+  size_t slot_end = created->value_offset + value_size;
+  created->slot_size =
+      (slot_end + slot_alignment - 1) / slot_alignment * slot_alignment;
+  if (created->slot_size == 0)
+    created->slot_size = 1;
+
+  created->ctrl = NULL;
+  created->slots = NULL;
+  created->len = 0;
+  created->capacity = 0;
+  created->growth_left = 0;
+  created->key_size = key_size;
+  created->value_size = value_size;
+  created->hasher = hasher;
+  created->comperator = comperator;
+  return created;
+}
+
+void hash_map_free(HashMap *map) {
+  free(map->slots);
+  free(map);
+}
+
+void *hash_map_slot(HashMap *map, size_t i) {
+  return (char *)map->slots + i * map->slot_size;
+}
+
+/* Returns the index of the slot that holds the key, or capacity if absent. */
+size_t hash_map_find(HashMap *map, void *k) {
+  if (map->capacity == 0)
+    return 0;
+  size_t hash = map->hasher(k);
+  int8_t h2 = (int8_t)(hash & 0x7F);
+  size_t groups = map->capacity / HASH_GROUP_WIDTH;
+  size_t group = (hash >> 7) & (groups - 1);
+  // Triangular steps visit every group once, because groups is a power of two.
+  for (size_t step = 1;; step++) {
+    int8_t *ctrl = map->ctrl + group * HASH_GROUP_WIDTH;
+    uint32_t match = hash_group_match(ctrl, h2);
+    while (match) {
+      size_t i = group * HASH_GROUP_WIDTH + hash_group_lowest(match);
+      if (map->comperator(hash_map_slot(map, i), k) == 0)
+        return i;
+      match &= match - 1;
+    }
+    // An empty slot ends the probe, the key would have been inserted there.
+    if (hash_group_match_empty(ctrl) || step >= groups)
+      return map->capacity;
+    group = (group + step) & (groups - 1);
+  }
+}
+
+/* Returns the first empty or deleted slot on the probe sequence of the hash. */
+size_t hash_map_find_free(int8_t *ctrl, size_t capacity, size_t hash) {
+  size_t groups = capacity / HASH_GROUP_WIDTH;
+  size_t group = (hash >> 7) & (groups - 1);
+  for (size_t step = 1;; step++) {
+    int8_t *group_ctrl = ctrl + group * HASH_GROUP_WIDTH;
+    uint32_t free_slots = hash_group_match_free(group_ctrl);
+    if (free_slots)
+      return group * HASH_GROUP_WIDTH + hash_group_lowest(free_slots);
+    group = (group + step) & (groups - 1);
+  }
+}
+
+/**
+ * Moves all entries into new slots with the given capacity, which drops all
+ * deleted slots as well.
+ */
+int hash_map_resize(HashMap *map, size_t capacity) {
+  char *slots = NULL;
+  int8_t *ctrl = NULL;
+  if (capacity > 0) {
+    // The control bytes live behind the slots in the same allocation.
+    slots = malloc(capacity * (map->slot_size + 1));
+    if (!slots)
+      return EXIT_FAILURE;
+    ctrl = (int8_t *)(slots + capacity * map->slot_size);
+    memset(ctrl, HASH_CTRL_EMPTY, capacity);
+  }
+  for (size_t i = 0; i < map->capacity; i++) {
+    if (map->ctrl[i] < 0)
+      continue;
+    void *slot = hash_map_slot(map, i);
+    size_t hash = map->hasher(slot);
+    size_t j = hash_map_find_free(ctrl, capacity, hash);
+    ctrl[j] = (int8_t)(hash & 0x7F);
+    memcpy(slots + j * map->slot_size, slot, map->slot_size);
+  }
+  free(map->slots);
+  map->slots = slots;
+  map->ctrl = ctrl;
+  map->capacity = capacity;
+  map->growth_left = capacity - capacity / 8 - map->len;
+  return EXIT_SUCCESS;
+}
+
+int hash_map_put(HashMap *map, void *k, void *v) {
+  size_t i = hash_map_find(map, k);
+  if (i < map->capacity) {
+    if (map->value_size > 0)
+      memcpy((char *)hash_map_slot(map, i) + map->value_offset, v,
+             map->value_size);
+    return EXIT_SUCCESS;
+  }
+
+  // Out of empty slots, either grow or drop the deleted slots.
+  if (map->growth_left == 0 &&
+      hash_map_resize(map, hash_capacity_grow(map->capacity, map->len)) !=
+          EXIT_SUCCESS)
+    return EXIT_FAILURE;
+  size_t hash = map->hasher(k);
+  i = hash_map_find_free(map->ctrl, map->capacity, hash);
+  if (map->ctrl[i] == HASH_CTRL_EMPTY)
+    map->growth_left--;
+  map->ctrl[i] = (int8_t)(hash & 0x7F);
+  char *slot = hash_map_slot(map, i);
+  memcpy(slot, k, map->key_size);
+  if (map->value_size > 0)
+    memcpy(slot + map->value_offset, v, map->value_size);
+  map->len++;
+  return EXIT_SUCCESS;
+}
+
+int hash_map_get(HashMap *map, void *k, void *v) {
+  size_t i = hash_map_find(map, k);
+  if (i >= map->capacity)
+    return EXIT_FAILURE;
+  memcpy(v, (char *)hash_map_slot(map, i) + map->value_offset,
+         map->value_size);
+  return EXIT_SUCCESS;
+}
+
+int hash_map_remove(HashMap *map, void *k) {
+  size_t i = hash_map_find(map, k);
+  if (i >= map->capacity)
+    return EXIT_FAILURE;
+  // A probe never continues past a group with an empty slot, so the slot can
+  // become empty again. Otherwise later keys may have probed past it.
+  int8_t *group = map->ctrl + i / HASH_GROUP_WIDTH * HASH_GROUP_WIDTH;
+  if (hash_group_match_empty(group)) {
+    map->ctrl[i] = HASH_CTRL_EMPTY;
+    map->growth_left++;
+  } else {
+    map->ctrl[i] = HASH_CTRL_DELETED;
+  }
+  map->len--;
+  return EXIT_SUCCESS;
+}
+
+bool hash_map_contains_key(HashMap *map, void *k) {
+  return hash_map_find(map, k) < map->capacity;
+}
+
+size_t hash_map_len(HashMap *map) { return map->len; }
+
+void hash_map_clear(HashMap *map) {
+  if (map->capacity > 0)
+    memset(map->ctrl, HASH_CTRL_EMPTY, map->capacity);
+  map->len = 0;
+  map->growth_left = map->capacity - map->capacity / 8;
+}
+
+int hash_map_reserve(HashMap *map, size_t n) {
+  size_t capacity = hash_capacity_for(n);
+  if (capacity <= map->capacity)
+    return EXIT_SUCCESS;
+  return hash_map_resize(map, capacity);
+}
+
+int hash_map_shrink_to_fit(HashMap *map) {
+  size_t capacity = hash_capacity_for(map->len);
+  if (capacity >= map->capacity)
+    return EXIT_SUCCESS;
+  return hash_map_resize(map, capacity);
+}
+
+void hash_map_iter(HashMap *map, HashMapIter *iter) {
+  iter->map = map;
+  iter->index = 0;
+}
+
+bool hash_map_iter_next(HashMapIter *iter, void **k, void **v) {
+  HashMap *map = iter->map;
+  while (iter->index < map->capacity) {
+    size_t i = iter->index++;
+    if (map->ctrl[i] >= 0) {
+      *k = hash_map_slot(map, i);
+      *v = (char *)*k + map->value_offset;
+      return true;
+    }
+  }
+  return false;
+}
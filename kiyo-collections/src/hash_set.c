@@ -0,0 +1,53 @@
+#include "kiyo-collections/hash_set.h"
+#include <stdlib.h>
+
+HashSet *hash_set_new(size_t element_size, Hasher hasher,
+                      Comperator comperator) {
+  HashSet *created = malloc(sizeof(HashSet));
+  if (!created)
+    return NULL;
+  created->table = hash_map_new(element_size, 0, hasher, comperator);
+  if (!created->table) {
+    free(created);
+    return NULL;
+  }
+  return created;
+}
+
+void hash_set_free(HashSet *set) {
+  hash_map_free(set->table);
+  free(set);
+}
+
+int hash_set_add(HashSet *set, void *e) {
+  return hash_map_put(set->table, e, NULL);
+}
+
+int hash_set_remove(HashSet *set, void *e) {
+  return hash_map_remove(set->table, e);
+}
+
+bool hash_set_contains(HashSet *set, void *e) {
+  return hash_map_contains_key(set->table, e);
+}
+
+size_t hash_set_len(HashSet *set) { return set->table->len; }
+
+void hash_set_clear(HashSet *set) { hash_map_clear(set->table); }
+
+int hash_set_reserve(HashSet *set, size_t n) {
+  return hash_map_reserve(set->table, n);
+}
+
+int hash_set_shrink_to_fit(HashSet *set) {
+  return hash_map_shrink_to_fit(set->table);
+}
+
+void hash_set_iter(HashSet *set, HashSetIter *iter) {
+  hash_map_iter(set->table, &iter->inner);
+}
+
+bool hash_set_iter_next(HashSetIter *iter, void **e) {
+  void *v;
+  return hash_map_iter_next(&iter->inner, e, &v);
+}
@@ -0,0 +1,287 @@
+#include "kiyo-collections/interval_map.h"
+#include "align.h"
+#include <stdlib.h>
+#include <string.h>
+
+IntervalEntry *interval_entry_new(IntervalMap *map, void *lo, void *hi,
+                                  void *value) {
+  // Both endpoints and the value are stored inline behind the entry.
+  size_t key_offset = ALIGN_UP(sizeof(IntervalEntry));
+  size_t value_offset = key_offset + ALIGN_UP(2 * map->key_size);
+  IntervalEntry *created = malloc(value_offset + map->value_size);
+  if (!created)
+    return NULL;
+
+  created->lo = (char *)created + key_offset;
+  created->hi = (char *)created->lo + map->key_size;
+  created->value = (char *)created + value_offset;
+  memcpy(created->lo, lo, map->key_size);
+  memcpy(created->hi, hi, map->key_size);
+  memcpy(created->value, value, map->value_size);
+
+  created->max = created;
+  created->height = 1;
+  created->left = NULL;
+  created->right = NULL;
+  return created;
+}
+
+void interval_entry_free(IntervalEntry *node) {
+  while (node) {
+    if (node->left) {
+      IntervalEntry *left = node->left;
+      node->left = left->right;
+      left->right = node;
+      node = left;
+    } else {
+      IntervalEntry *right = node->right;
+      free(node);
+      node = right;
+    }
+  }
+}
+
+/* Recomputes the height and the entry with the largest end of the subtree. */
+void interval_entry_update(IntervalMap *map, IntervalEntry *node) {
+  size_t height_left = node->left ? node->left->height : 0;
+  size_t height_right = node->right ? node->right->height : 0;
+  node->height = (height_left > height_right ? height_left : height_right) + 1;
+
+  node->max = node;
+  if (node->left && map->comperator(node->max->hi, node->left->max->hi) > 0)
+    node->max = node->left->max;
+  if (node->right && map->comperator(node->max->hi, node->right->max->hi) > 0)
+    node->max = node->right->max;
+}
+
+IntervalEntry *interval_entry_rotate_right(IntervalMap *map,
+                                           IntervalEntry *node) {
+  IntervalEntry *left = node->left;
+  node->left = left->right;
+  left->right = node;
+
+  interval_entry_update(map, node);
+  interval_entry_update(map, left);
+
+  return left;
+}
+
+IntervalEntry *interval_entry_rotate_left(IntervalMap *map,
+                                          IntervalEntry *node) {
+  IntervalEntry *right = node->right;
+  node->right = right->left;
+  right->left = node;
+
+  interval_entry_update(map, node);
+  interval_entry_update(map, right);
+
+  return right;
+}
+
+int interval_entry_get_balance_factor(IntervalEntry *node) {
+  int height_left = node->left ? (int)node->left->height : 0;
+  int height_right = node->right ? (int)node->right->height : 0;
+  return height_left - height_right;
+}
+
+/* Restores the AVL property of the node and returns the new subtree root. */
+IntervalEntry *interval_entry_rebalance(IntervalMap *map,
+                                        IntervalEntry *node) {
+  interval_entry_update(map, node);
+  int balance_factor = interval_entry_get_balance_factor(node);
+  if (balance_factor > 1) {
+    if (interval_entry_get_balance_factor(node->left) < 0) {
+      node->left = interval_entry_rotate_left(map, node->left);
+    }
+    return interval_entry_rotate_right(map, node);
+  } else if (balance_factor < -1) {
+    if (interval_entry_get_balance_factor(node->right) > 0) {
+      node->right = interval_entry_rotate_right(map, node->right);
+    }
+    return interval_entry_rotate_left(map, node);
+  }
+  return node;
+}
+
+/**
+ * Rebalances the links on the path from the bottom up. The largest end of
+ * every ancestor may change even after the heights settle, so each entry on
+ * the path is updated.
+ */
+void interval_entry_rebalance_path(IntervalMap *map, IntervalEntry ***path,
+                                   size_t depth) {
+  bool balanced = false;
+  while (depth > 0) {
+    IntervalEntry **link = path[--depth];
+    if (balanced) {
+      interval_entry_update(map, *link);
+      continue;
+    }
+    size_t height = (*link)->height;
+    *link = interval_entry_rebalance(map, *link);
+    balanced = (*link)->height == height;
+  }
+}
+
+/* Compares the interval of the entry with [lo, hi), by start, then by end. */
+int interval_map_compare(IntervalMap *map, IntervalEntry *node, void *lo,
+                         void *hi) {
+  int c = map->comperator(node->lo, lo);
+  return c != 0 ? c : map->comperator(node->hi, hi);
+}
+
+IntervalMap *interval_map_new(size_t key_size, size_t value_size,
+                              Comperator comperator) {
+  IntervalMap *created = malloc(sizeof(IntervalMap));
+  if (!created)
+    return NULL;
+  created->root = NULL;
+  created->len = 0;
+  created->key_size = key_size;
+  created->value_size = value_size;
+  created->comperator = comperator;
+  return created;
+}
+
+void interval_map_free(IntervalMap *map) {
+  interval_entry_free(map->root);
+  free(map);
+}
+
+int interval_map_put(IntervalMap *map, void *lo, void *hi, void *v) {
+  if (map->comperator(lo, hi) <= 0)
+    return EXIT_FAILURE;
+
+  // Remember the links we followed, they are rebalanced after the insert.
+  IntervalEntry **path[INTERVAL_MAP_MAX_HEIGHT];
+  size_t depth = 0;
+  IntervalEntry **link = &(map->root);
+  while (*link) {
+    int c = interval_map_compare(map, *link, lo, hi);
+    if (c == 0) {
+      memcpy((*link)->value, v, map->value_size);
+      return EXIT_SUCCESS;
+    }
+    path[depth++] = link;
+    link = (c > 0) ? &((*link)->right) : &((*link)->left);
+  }
+
+  *link = interval_entry_new(map, lo, hi, v);
+  if (*link == NULL)
+    return EXIT_FAILURE;
+  map->len++;
+  interval_entry_rebalance_path(map, path, depth);
+  return EXIT_SUCCESS;
+}
+
+/* Returns the entry of the interval [lo, hi) or NULL if it is not present. */
+IntervalEntry *interval_map_find(IntervalMap *map, void *lo, void *hi) {
+  IntervalEntry *node = map->root;
+  while (node) {
+    int c = interval_map_compare(map, node, lo, hi);
+    if (c == 0)
+      return node;
+    node = (c > 0) ? node->right : node->left;
+  }
+  return NULL;
+}
+
+int interval_map_get(IntervalMap *map, void *lo, void *hi, void *v) {
+  IntervalEntry *node = interval_map_find(map, lo, hi);
+  if (node == NULL)
+    return EXIT_FAILURE;
+  memcpy(v, node->value, map->value_size);
+  return EXIT_SUCCESS;
+}
+
+int interval_map_remove(IntervalMap *map, void *lo, void *hi) {
+  IntervalEntry **path[INTERVAL_MAP_MAX_HEIGHT];
+  size_t depth = 0;
+  IntervalEntry **link = &(map->root);
+  while (*link) {
+    int c = interval_map_compare(map, *link, lo, hi);
+    if (c == 0)
+      break;
+    path[depth++] = link;
+    link = (c > 0) ? &((*link)->right) : &((*link)->left);
+  }
+  IntervalEntry *node = *link;
+  if (node == NULL)
+    return EXIT_FAILURE;
+
+  if (node->left && node->right) {
+    // Move the in-order successor into this entry and unlink the successor
+    // instead, it has no left child.
+    path[depth++] = link;
+    link = &(node->right);
+    while ((*link)->left) {
+      path[depth++] = link;
+      link = &((*link)->left);
+    }
+    memcpy(node->lo, (*link)->lo, 2 * map->key_size);
+    memcpy(node->value, (*link)->value, map->value_size);
+    node = *link;
+  }
+  *link = node->left ? node->left : node->right;
+  free(node);
+  map->len--;
+  interval_entry_rebalance_path(map, path, depth);
+  return EXIT_SUCCESS;
+}
+
+bool interval_map_contains(IntervalMap *map, void *lo, void *hi) {
+  return interval_map_find(map, lo, hi) != NULL;
+}
+
+size_t interval_map_len(IntervalMap *map) { return map->len; }
+
+void interval_map_clear(IntervalMap *map) {
+  interval_entry_free(map->root);
+  map->root = NULL;
+  map->len = 0;
+}
+
+/**
+ * Calls the consumer for every interval below the node that ends after lo and
+ * starts before hi, or at hi if closed is set, in ascending order.
+ */
+void interval_entry_query(IntervalMap *map, IntervalEntry *node, void *lo,
+                          void *hi, bool closed, BiConsumer consumer) {
+  // A subtree whose largest end is not after lo has nothing to report. Every
+  // visited entry lies on the path to a reported interval or is pruned next to
+  // one, so a query takes O(min(n, k log n)), not O(log n + k).
+  while (node && map->comperator(lo, node->max->hi) > 0) {
+    interval_entry_query(map, node->left, lo, hi, closed, consumer);
+    // Everything from here on starts at or after the start of this entry.
+    int c = map->comperator(node->lo, hi);
+    if (c < 0 || (c == 0 && !closed))
+      return;
+    if (map->comperator(lo, node->hi) > 0)
+      consumer(node->lo, node->value);
+    node = node->right;
+  }
+}
+
+void interval_map_stab(IntervalMap *map, void *point, BiConsumer consumer) {
+  interval_entry_query(map, map->root, point, point, true, consumer);
+}
+
+void interval_map_overlap(IntervalMap *map, void *lo, void *hi,
+                          BiConsumer consumer) {
+  interval_entry_query(map, map->root, lo, hi, false, consumer);
+}
+
+bool interval_map_overlaps(IntervalMap *map, void *lo, void *hi) {
+  IntervalEntry *node = map->root;
+  while (node) {
+    if (map->comperator(node->lo, hi) > 0 && map->comperator(lo, node->hi) > 0)
+      return true;
+    // If the left subtree reaches past lo but holds no overlap, all of its
+    // intervals start at or after hi, and so do those on the right.
+    if (node->left && map->comperator(lo, node->left->max->hi) > 0)
+      node = node->left;
+    else
+      node = node->right;
+  }
+  return false;
+}
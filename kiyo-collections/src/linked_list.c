@@ -1,5 +1,7 @@
 #include "kiyo-collections/linked_list.h"
 #include "kiyo-collections/functions.h"
+#include "align.h"
+#include <stdint.h>
 #include <string.h>
 
 LinkedNode *linked_node_new(void *element, size_t element_size) {
@@ -18,11 +20,48 @@ LinkedNode *linked_node_new(void *element, size_t element_size) {
 
   created->next = NULL;
   created->prev = NULL;
+  created->block = NULL;
 
   return created;
 }
 
+LinkedNode *linked_block_new(size_t n, size_t element_size,
+                             LinkedNode **last) {
+  // Every slot stores a node directly followed by its value, so walking the
+  // list also walks the values sequentially.
+  size_t header = ALIGN_UP(sizeof(LinkedBlock));
+  size_t stride = ALIGN_UP(sizeof(LinkedNode) + element_size);
+  if (n == 0 || n > (SIZE_MAX - header) / stride)
+    return NULL;
+
+  LinkedBlock *block = malloc(header + n * stride);
+  if (!block)
+    return NULL;
+  block->live = n;
+
+  char *slot = (char *)block + header;
+  LinkedNode *prev = NULL;
+  for (size_t i = 0; i < n; i++, slot += stride) {
+    LinkedNode *node = (LinkedNode *)slot;
+    node->value = slot + sizeof(LinkedNode);
+    node->block = block;
+    node->prev = prev;
+    node->next = NULL;
+    if (prev)
+      prev->next = node;
+    prev = node;
+  }
+  *last = prev;
+  return (LinkedNode *)((char *)block + header);
+}
+
 void linked_node_free(LinkedNode *node) {
+  if (node->block) {
+    // The block is released together with its last node.
+    if (--node->block->live == 0)
+      free(node->block);
+    return;
+  }
   free(node->value);
   free(node);
 }
@@ -39,6 +78,17 @@ LinkedList *linked_list_new(size_t element_size) {
   return created;
 }
 
+LinkedList *linked_list_from_array(size_t element_size, void *data, size_t n) {
+  LinkedList *created = linked_list_new(element_size);
+  if (!created)
+    return NULL;
+  if (linked_list_push_back_n(created, data, n) != EXIT_SUCCESS) {
+    free(created);
+    return NULL;
+  }
+  return created;
+}
+
 void linked_list_free_data(LinkedList *linked_list) {
   LinkedNode *back = linked_list->tail;
   while (back) {
@@ -91,6 +141,30 @@ void linked_list_push_back(LinkedList *linked_list, void *value) {
   linked_list->len++;
 }
 
+int linked_list_push_back_n(LinkedList *linked_list, void *data, size_t n) {
+  if (n == 0)
+    return EXIT_SUCCESS;
+
+  LinkedNode *last;
+  LinkedNode *first = linked_block_new(n, linked_list->element_size, &last);
+  if (!first)
+    return EXIT_FAILURE;
+  size_t i = 0;
+  for (LinkedNode *node = first; node; node = node->next, i++)
+    memcpy(node->value, (char *)data + i * linked_list->element_size,
+           linked_list->element_size);
+
+  if (linked_list->head) {
+    linked_list->tail->next = first;
+    first->prev = linked_list->tail;
+  } else {
+    linked_list->head = first;
+  }
+  linked_list->tail = last;
+  linked_list->len += n;
+  return EXIT_SUCCESS;
+}
+
 int linked_list_front(LinkedList *linked_list, void *buffer) {
   if (linked_list->head) {
     memcpy(buffer, linked_list->head->value, linked_list->element_size);
@@ -221,6 +295,39 @@ void linked_list_remove_if(LinkedList *linked_list, Test test) {
   }
 }
 
+int linked_list_compact(LinkedList *linked_list) {
+  if (linked_list->len == 0)
+    return EXIT_SUCCESS;
+
+  LinkedNode *last;
+  LinkedNode *first =
+      linked_block_new(linked_list->len, linked_list->element_size, &last);
+  if (!first)
+    return EXIT_FAILURE;
+  // Copy the values in list order, then drop the old nodes.
+  LinkedNode *from = linked_list->head;
+  for (LinkedNode *to = first; to; to = to->next, from = from->next)
+    memcpy(to->value, from->value, linked_list->element_size);
+  linked_list_free_data(linked_list);
+
+  linked_list->head = first;
+  linked_list->tail = last;
+  return EXIT_SUCCESS;
+}
+
+double linked_list_fragmentation(LinkedList *linked_list) {
+  if (linked_list->len < 2)
+    return 0.0;
+
+  double total = 0.0;
+  for (LinkedNode *node = linked_list->head; node->next; node = node->next) {
+    uintptr_t a = (uintptr_t)node;
+    uintptr_t b = (uintptr_t)node->next;
+    total += (double)(a < b ? b - a : a - b);
+  }
+  return total / (double)(linked_list->len - 1);
+}
+
 size_t linked_list_len(LinkedList *linked_list) { return linked_list->len; }
 
 bool linked_list_is_empty(LinkedList *linked_list) {
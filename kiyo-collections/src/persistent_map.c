@@ -0,0 +1,293 @@
+#include "kiyo-collections/persistent_map.h"
+#include "align.h"
+#include <stdlib.h>
+#include <string.h>
+
+PersistentEntry *persistent_entry_new(PersistentMap *map, void *k, void *v,
+                                      PersistentEntry *left,
+                                      PersistentEntry *right, size_t height) {
+  size_t key_offset = ALIGN_UP(sizeof(PersistentEntry));
+  size_t value_offset = key_offset + ALIGN_UP(map->key_size);
+  PersistentEntry *created = malloc(value_offset + map->value_size);
+  if (!created)
+    return NULL;
+
+  atomic_init(&created->refs, 1);
+  created->key = (char *)created + key_offset;
+  created->value = (char *)created + value_offset;
+  memcpy(created->key, k, map->key_size);
+  memcpy(created->value, v, map->value_size);
+  created->left = left;
+  created->right = right;
+  created->height = height;
+  return created;
+}
+
+void persistent_entry_retain(PersistentEntry *node) {
+  if (node)
+    atomic_fetch_add_explicit(&node->refs, 1, memory_order_relaxed);
+}
+
+/* Drops one reference and frees every node that is no longer referenced. */
+void persistent_entry_release(PersistentEntry *node) {
+  // A freed node releases both children, so the stack holds at most one
+  // pending sibling per level.
+  PersistentEntry *stack[2 * PERSISTENT_MAP_MAX_HEIGHT];
+  size_t depth = 0;
+  if (node)
+    stack[depth++] = node;
+  while (depth > 0) {
+    node = stack[--depth];
+    if (atomic_fetch_sub_explicit(&node->refs, 1, memory_order_acq_rel) != 1)
+      continue;
+    if (node->left)
+      stack[depth++] = node->left;
+    if (node->right)
+      stack[depth++] = node->right;
+    free(node);
+  }
+}
+
+/**
+ * Makes sure the link points to a node that only this version uses, copying
+ * the node if it is shared. Returns EXIT FAILURE if the copy could not be
+ * allocated.
+ */
+int persistent_entry_own(PersistentMap *map, PersistentEntry **link) {
+  PersistentEntry *node = *link;
+  if (atomic_load_explicit(&node->refs, memory_order_acquire) == 1)
+    return EXIT_SUCCESS;
+  PersistentEntry *copy = persistent_entry_new(
+      map, node->key, node->value, node->left, node->right, node->height);
+  if (!copy)
+    return EXIT_FAILURE;
+  persistent_entry_retain(node->left);
+  persistent_entry_retain(node->right);
+  persistent_entry_release(node);
+  *link = copy;
+  return EXIT_SUCCESS;
+}
+
+size_t persistent_entry_height(PersistentEntry *node) {
+  return node ? node->height : 0;
+}
+
+void persistent_entry_update_height(PersistentEntry *node) {
+  size_t left = persistent_entry_height(node->left);
+  size_t right = persistent_entry_height(node->right);
+  node->height = (left > right ? left : right) + 1;
+}
+
+int persistent_entry_get_balance_factor(PersistentEntry *node) {
+  return (int)persistent_entry_height(node->left) -
+         (int)persistent_entry_height(node->right);
+}
+
+PersistentEntry *persistent_entry_rotate_right(PersistentEntry *node) {
+  PersistentEntry *left = node->left;
+  node->left = left->right;
+  left->right = node;
+  persistent_entry_update_height(node);
+  persistent_entry_update_height(left);
+  return left;
+}
+
+PersistentEntry *persistent_entry_rotate_left(PersistentEntry *node) {
+  PersistentEntry *right = node->right;
+  node->right = right->left;
+  right->left = node;
+  persistent_entry_update_height(node);
+  persistent_entry_update_height(right);
+  return right;
+}
+
+/**
+ * Restores the AVL property of an owned node. Every node a rotation changes is
+ * taken over first, after a remove these can be nodes of the sibling subtree
+ * that are still shared with other versions.
+ */
+int persistent_entry_rebalance(PersistentMap *map, PersistentEntry **link) {
+  PersistentEntry *node = *link;
+  persistent_entry_update_height(node);
+  int balance_factor = persistent_entry_get_balance_factor(node);
+  if (balance_factor > 1) {
+    if (persistent_entry_own(map, &node->left) != EXIT_SUCCESS)
+      return EXIT_FAILURE;
+    if (persistent_entry_get_balance_factor(node->left) < 0) {
+      if (persistent_entry_own(map, &node->left->right) != EXIT_SUCCESS)
+        return EXIT_FAILURE;
+      node->left = persistent_entry_rotate_left(node->left);
+    }
+    *link = persistent_entry_rotate_right(node);
+  } else if (balance_factor < -1) {
+    if (persistent_entry_own(map, &node->right) != EXIT_SUCCESS)
+      return EXIT_FAILURE;
+    if (persistent_entry_get_balance_factor(node->right) > 0) {
+      if (persistent_entry_own(map, &node->right->left) != EXIT_SUCCESS)
+        return EXIT_FAILURE;
+      node->right = persistent_entry_rotate_right(node->right);
+    }
+    *link = persistent_entry_rotate_left(node);
+  }
+  return EXIT_SUCCESS;
+}
+
+/* Rebalances the owned links on the path from the bottom up. */
+int persistent_entry_rebalance_path(PersistentMap *map,
+                                    PersistentEntry ***path, size_t depth) {
+  while (depth > 0) {
+    PersistentEntry **link = path[--depth];
+    size_t height = (*link)->height;
+    if (persistent_entry_rebalance(map, link) != EXIT_SUCCESS)
+      return EXIT_FAILURE;
+    if ((*link)->height == height)
+      break;
+  }
+  return EXIT_SUCCESS;
+}
+
+PersistentEntry *persistent_entry_find(PersistentMap *map, void *k) {
+  PersistentEntry *node = map->root;
+  while (node) {
+    int c = map->comperator(node->key, k);
+    if (c == 0)
+      return node;
+    node = (c > 0) ? node->right : node->left;
+  }
+  return NULL;
+}
+
+PersistentMap *persistent_map_new(size_t key_size, size_t value_size,
+                                  Comperator comperator) {
+  PersistentMap *created = malloc(sizeof(PersistentMap));
+  if (!created)
+    return NULL;
+  created->root = NULL;
+  created->len = 0;
+  created->key_size = key_size;
+  created->value_size = value_size;
+  created->comperator = comperator;
+  return created;
+}
+
+void persistent_map_free(PersistentMap *map) {
+  persistent_entry_release(map->root);
+  free(map);
+}
+
+PersistentMap *persistent_map_snapshot(PersistentMap *map) {
+  PersistentMap *created = malloc(sizeof(PersistentMap));
+  if (!created)
+    return NULL;
+  *created = *map;
+  persistent_entry_retain(map->root);
+  return created;
+}
+
+/* Inserts the entry into a version that was just created by a snapshot. */
+int persistent_map_insert(PersistentMap *map, void *k, void *v) {
+  // Take over every node on the way down, the new version then owns the
+  // whole path and can change it in place.
+  PersistentEntry **path[PERSISTENT_MAP_MAX_HEIGHT];
+  size_t depth = 0;
+  PersistentEntry **link = &(map->root);
+  while (*link) {
+    if (persistent_entry_own(map, link) != EXIT_SUCCESS)
+      return EXIT_FAILURE;
+    int c = map->comperator((*link)->key, k);
+    if (c == 0) {
+      memcpy((*link)->value, v, map->value_size);
+      return EXIT_SUCCESS;
+    }
+    path[depth++] = link;
+    link = (c > 0) ? &((*link)->right) : &((*link)->left);
+  }
+
+  *link = persistent_entry_new(map, k, v, NULL, NULL, 1);
+  if (*link == NULL)
+    return EXIT_FAILURE;
+  map->len++;
+  return persistent_entry_rebalance_path(map, path, depth);
+}
+
+/* Removes a present key from a version that was just created by a snapshot. */
+int persistent_map_erase(PersistentMap *map, void *k) {
+  PersistentEntry **path[PERSISTENT_MAP_MAX_HEIGHT];
+  size_t depth = 0;
+  PersistentEntry **link = &(map->root);
+  while (true) {
+    if (persistent_entry_own(map, link) != EXIT_SUCCESS)
+      return EXIT_FAILURE;
+    int c = map->comperator((*link)->key, k);
+    if (c == 0)
+      break;
+    path[depth++] = link;
+    link = (c > 0) ? &((*link)->right) : &((*link)->left);
+  }
+  PersistentEntry *node = *link;
+
+  if (node->left && node->right) {
+    // Move the in-order successor into this entry and unlink the successor
+    // instead, it has no left child.
+    path[depth++] = link;
+    link = &(node->right);
+    if (persistent_entry_own(map, link) != EXIT_SUCCESS)
+      return EXIT_FAILURE;
+    while ((*link)->left) {
+      path[depth++] = link;
+      link = &((*link)->left);
+      if (persistent_entry_own(map, link) != EXIT_SUCCESS)
+        return EXIT_FAILURE;
+    }
+    memcpy(node->key, (*link)->key, map->key_size);
+    memcpy(node->value, (*link)->value, map->value_size);
+    node = *link;
+  }
+  // The child moves up into the link, which takes over the reference the
+  // removed node had on it.
+  PersistentEntry *child = node->left ? node->left : node->right;
+  persistent_entry_retain(child);
+  *link = child;
+  persistent_entry_release(node);
+  map->len--;
+  return persistent_entry_rebalance_path(map, path, depth);
+}
+
+PersistentMap *persistent_map_put(PersistentMap *map, void *k, void *v) {
+  PersistentMap *created = persistent_map_snapshot(map);
+  if (!created)
+    return NULL;
+  if (persistent_map_insert(created, k, v) != EXIT_SUCCESS) {
+    persistent_map_free(created);
+    return NULL;
+  }
+  return created;
+}
+
+PersistentMap *persistent_map_remove(PersistentMap *map, void *k) {
+  PersistentMap *created = persistent_map_snapshot(map);
+  if (!created)
+    return NULL;
+  // Without the key there is nothing to copy.
+  if (persistent_entry_find(map, k) == NULL)
+    return created;
+  if (persistent_map_erase(created, k) != EXIT_SUCCESS) {
+    persistent_map_free(created);
+    return NULL;
+  }
+  return created;
+}
+
+int persistent_map_get(PersistentMap *map, void *k, void *v) {
+  PersistentEntry *node = persistent_entry_find(map, k);
+  if (node == NULL)
+    return EXIT_FAILURE;
+  memcpy(v, node->value, map->value_size);
+  return EXIT_SUCCESS;
+}
+
+bool persistent_map_contains_key(PersistentMap *map, void *k) {
+  return persistent_entry_find(map, k) != NULL;
+}
+
+size_t persistent_map_len(PersistentMap *map) { return map->len; }
@@ -0,0 +1,774 @@
+#include "kiyo-collections/radix_tree.h"
+#include "align.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+/* Returns if the child pointer is a tagged leaf. */
+bool radix_is_leaf(void *child) { return (uintptr_t)child & 1; }
+
+/* Returns the leaf a tagged child pointer points to. */
+RadixLeaf *radix_leaf(void *child) {
+  return (RadixLeaf *)((uintptr_t)child & ~(uintptr_t)1);
+}
+
+/* Returns the tagged child pointer of the leaf. */
+void *radix_tag(RadixLeaf *leaf) { return (void *)((uintptr_t)leaf | 1); }
+
+size_t radix_min(size_t a, size_t b) { return a < b ? a : b; }
+
+RadixLeaf *radix_leaf_new(RadixTree *tree, unsigned char *key, size_t key_len,
+                          void *value) {
+  // The key follows the header, the value follows the key.
+  size_t value_offset = ALIGN_UP(sizeof(RadixLeaf) + key_len);
+  RadixLeaf *created = malloc(value_offset + tree->value_size);
+  if (!created)
+    return NULL;
+  created->value = (char *)created + value_offset;
+  created->key_len = key_len;
+  memcpy(created->key, key, key_len);
+  if (value && tree->value_size > 0)
+    memcpy(created->value, value, tree->value_size);
+  else
+    memset(created->value, 0, tree->value_size);
+  return created;
+}
+
+bool radix_leaf_matches(RadixLeaf *leaf, unsigned char *key, size_t key_len) {
+  return leaf->key_len == key_len && memcmp(leaf->key, key, key_len) == 0;
+}
+
+RadixNode *radix_node_new(RadixNodeType type) {
+  size_t sizes[] = {sizeof(RadixNode4), sizeof(RadixNode16),
+                    sizeof(RadixNode48), sizeof(RadixNode256)};
+  RadixNode *created = calloc(1, sizes[type]);
+  if (!created)
+    return NULL;
+  created->type = type;
+  return created;
+}
+
+/* Copies everything but the type and the children from one node to another. */
+void radix_node_copy_header(RadixNode *dst, RadixNode *src) {
+  dst->count = src->count;
+  dst->prefix_len = src->prefix_len;
+  memcpy(dst->prefix, src->prefix, RADIX_TREE_MAX_PREFIX);
+  dst->leaf = src->leaf;
+}
+
+void radix_node_free(void *child) {
+  if (child == NULL)
+    return;
+  if (radix_is_leaf(child)) {
+    free(radix_leaf(child));
+    return;
+  }
+  RadixNode *node = child;
+  free(node->leaf);
+  switch (node->type) {
+  case RADIX_NODE4:
+    for (int i = 0; i < node->count; i++)
+      radix_node_free(((RadixNode4 *)node)->children[i]);
+    break;
+  case RADIX_NODE16:
+    for (int i = 0; i < node->count; i++)
+      radix_node_free(((RadixNode16 *)node)->children[i]);
+    break;
+  case RADIX_NODE48:
+    for (int i = 0; i < 48; i++)
+      radix_node_free(((RadixNode48 *)node)->children[i]);
+    break;
+  case RADIX_NODE256:
+    for (int i = 0; i < 256; i++)
+      radix_node_free(((RadixNode256 *)node)->children[i]);
+    break;
+  }
+  free(node);
+}
+
+/* Returns the index of the lowest set bit of a non-zero mask. */
+unsigned radix_lowest(unsigned mask) {
+#if defined(__GNUC__) || defined(__clang__)
+  return (unsigned)__builtin_ctz(mask);
+#else
+  unsigned i = 0;
+  while (!(mask & 1)) {
+    mask >>= 1;
+    i++;
+  }
+  return i;
+#endif
+}
+
+/* Returns the slot of the child for the byte, or NULL if there is none. */
+void **radix_node_find_child(RadixNode *node, unsigned char byte) {
+  switch (node->type) {
+  case RADIX_NODE4: {
+    RadixNode4 *n = (RadixNode4 *)node;
+    for (int i = 0; i < node->count; i++) {
+      if (n->keys[i] == byte)
+        return &n->children[i];
+    }
+    return NULL;
+  }
+  case RADIX_NODE16: {
+    RadixNode16 *n = (RadixNode16 *)node;
+    // Compare all 16 key bytes at once and drop the unused ones.
+#if defined(__SSE2__) || defined(_M_X64)
+    __m128i keys = _mm_loadu_si128((const __m128i *)n->keys);
+    __m128i cmp = _mm_cmpeq_epi8(keys, _mm_set1_epi8((char)byte));
+    unsigned mask = (unsigned)_mm_movemask_epi8(cmp);
+#else
+    unsigned mask = 0;
+    for (unsigned i = 0; i < 16; i++)
+      mask |= (unsigned)(n->keys[i] == byte) << i;
+#endif
+    mask &= (1u << node->count) - 1;
+    return mask ? &n->children[radix_lowest(mask)] : NULL;
+  }
+  case RADIX_NODE48: {
+    RadixNode48 *n = (RadixNode48 *)node;
+    uint8_t i = n->child_index[byte];
+    return i ? &n->children[i - 1] : NULL;
+  }
+  case RADIX_NODE256: {
+    RadixNode256 *n = (RadixNode256 *)node;
+    return n->children[byte] ? &n->children[byte] : NULL;
+  }
+  }
+  return NULL;
+}
+
+/* Inserts into the sorted keys and children of a Node4 or Node16. */
+void radix_node_insert_sorted(unsigned char *keys, void **children,
+                              uint16_t count, unsigned char byte,
+                              void *child) {
+  uint16_t i = 0;
+  while (i < count && keys[i] < byte)
+    i++;
+  memmove(keys + i + 1, keys + i, count - i);
+  memmove(children + i + 1, children + i, (count - i) * sizeof(void *));
+  keys[i] = byte;
+  children[i] = child;
+}
+
+/**
+ * Adds the child for the byte, which must not have a child yet. A full node is
+ * replaced by the next larger kind, ref is updated to point to it. Returns
+ * EXIT FAILURE if the larger node could not be allocated.
+ */
+int radix_node_add_child(void **ref, RadixNode *node, unsigned char byte,
+                         void *child) {
+  switch (node->type) {
+  case RADIX_NODE4: {
+    RadixNode4 *n = (RadixNode4 *)node;
+    if (node->count < 4) {
+      radix_node_insert_sorted(n->keys, n->children, node->count, byte, child);
+      node->count++;
+      return EXIT_SUCCESS;
+    }
+    RadixNode16 *bigger = (RadixNode16 *)radix_node_new(RADIX_NODE16);
+    if (!bigger)
+      return EXIT_FAILURE;
+    radix_node_copy_header(&bigger->node, node);
+    memcpy(bigger->keys, n->keys, 4);
+    memcpy(bigger->children, n->children, 4 * sizeof(void *));
+    *ref = bigger;
+    free(node);
+    return radix_node_add_child(ref, &bigger->node, byte, child);
+  }
+  case RADIX_NODE16: {
+    RadixNode16 *n = (RadixNode16 *)node;
+    if (node->count < 16) {
+      radix_node_insert_sorted(n->keys, n->children, node->count, byte, child);
+      node->count++;
+      return EXIT_SUCCESS;
+    }
+    RadixNode48 *bigger = (RadixNode48 *)radix_node_new(RADIX_NODE48);
+    if (!bigger)
+      return EXIT_FAILURE;
+    radix_node_copy_header(&bigger->node, node);
+    for (int i = 0; i < 16; i++) {
+      bigger->child_index[n->keys[i]] = (uint8_t)(i + 1);
+      bigger->children[i] = n->children[i];
+    }
+    *ref = bigger;
+    free(node);
+    return radix_node_add_child(ref, &bigger->node, byte, child);
+  }
+  case RADIX_NODE48: {
+    RadixNode48 *n = (RadixNode48 *)node;
+    if (node->count < 48) {
+      // Removed children leave holes, take the first free slot.
+      int i = 0;
+      while (n->children[i])
+        i++;
+      n->children[i] = child;
+      n->child_index[byte] = (uint8_t)(i + 1);
+      node->count++;
+      return EXIT_SUCCESS;
+    }
+    RadixNode256 *bigger = (RadixNode256 *)radix_node_new(RADIX_NODE256);
+    if (!bigger)
+      return EXIT_FAILURE;
+    radix_node_copy_header(&bigger->node, node);
+    for (int b = 0; b < 256; b++) {
+      if (n->child_index[b])
+        bigger->children[b] = n->children[n->child_index[b] - 1];
+    }
+    *ref = bigger;
+    free(node);
+    return radix_node_add_child(ref, &bigger->node, byte, child);
+  }
+  case RADIX_NODE256: {
+    RadixNode256 *n = (RadixNode256 *)node;
+    n->children[byte] = child;
+    node->count++;
+    return EXIT_SUCCESS;
+  }
+  }
+  return EXIT_FAILURE;
+}
+
+/**
+ * Replaces a node that has become too small by the next smaller kind, and a
+ * Node4 with a single child and no leaf by that child. A failed allocation
+ * keeps the larger node, which stays valid.
+ */
+void radix_node_shrink(void **ref) {
+  RadixNode *node = *ref;
+  switch (node->type) {
+  case RADIX_NODE4: {
+    RadixNode4 *n = (RadixNode4 *)node;
+    if (node->count == 0) {
+      *ref = node->leaf ? radix_tag(node->leaf) : NULL;
+      free(node);
+      return;
+    }
+    if (node->count > 1 || node->leaf)
+      return;
+    // Merge this node into its only child, the prefix of the child grows by
+    // this prefix and the byte in between.
+    void *child = n->children[0];
+    if (!radix_is_leaf(child)) {
+      RadixNode *below = child;
+      size_t stored = radix_min(node->prefix_len, RADIX_TREE_MAX_PREFIX);
+      if (stored < RADIX_TREE_MAX_PREFIX)
+        node->prefix[stored++] = n->keys[0];
+      if (stored < RADIX_TREE_MAX_PREFIX) {
+        size_t extra = radix_min(below->prefix_len,
+                                 RADIX_TREE_MAX_PREFIX - stored);
+        memcpy(node->prefix + stored, below->prefix, extra);
+        stored += extra;
+      }
+      memcpy(below->prefix, node->prefix, stored);
+      below->prefix_len += node->prefix_len + 1;
+    }
+    *ref = child;
+    free(node);
+    return;
+  }
+  case RADIX_NODE16: {
+    RadixNode16 *n = (RadixNode16 *)node;
+    if (node->count > 3)
+      return;
+    RadixNode4 *smaller = (RadixNode4 *)radix_node_new(RADIX_NODE4);
+    if (!smaller)
+      return;
+    radix_node_copy_header(&smaller->node, node);
+    memcpy(smaller->keys, n->keys, node->count);
+    memcpy(smaller->children, n->children, node->count * sizeof(void *));
+    *ref = smaller;
+    free(node);
+    return;
+  }
+  case RADIX_NODE48: {
+    RadixNode48 *n = (RadixNode48 *)node;
+    if (node->count > 12)
+      return;
+    RadixNode16 *smaller = (RadixNode16 *)radix_node_new(RADIX_NODE16);
+    if (!smaller)
+      return;
+    radix_node_copy_header(&smaller->node, node);
+    int j = 0;
+    for (int b = 0; b < 256; b++) {
+      if (n->child_index[b]) {
+        smaller->keys[j] = (unsigned char)b;
+        smaller->children[j++] = n->children[n->child_index[b] - 1];
+      }
+    }
+    *ref = smaller;
+    free(node);
+    return;
+  }
+  case RADIX_NODE256: {
+    RadixNode256 *n = (RadixNode256 *)node;
+    if (node->count > 37)
+      return;
+    RadixNode48 *smaller = (RadixNode48 *)radix_node_new(RADIX_NODE48);
+    if (!smaller)
+      return;
+    radix_node_copy_header(&smaller->node, node);
+    int j = 0;
+    for (int b = 0; b < 256; b++) {
+      if (n->children[b]) {
+        smaller->children[j++] = n->children[b];
+        smaller->child_index[b] = (uint8_t)j;
+      }
+    }
+    *ref = smaller;
+    free(node);
+    return;
+  }
+  }
+}
+
+/* Removes the child in the slot, which belongs to the byte. */
+void radix_node_remove_child(RadixNode *node, unsigned char byte,
+                             void **slot) {
+  switch (node->type) {
+  case RADIX_NODE4: {
+    RadixNode4 *n = (RadixNode4 *)node;
+    size_t i = (size_t)(slot - n->children);
+    memmove(n->keys + i, n->keys + i + 1, node->count - i - 1);
+    memmove(n->children + i, n->children + i + 1,
+            (node->count - i - 1) * sizeof(void *));
+    break;
+  }
+  case RADIX_NODE16: {
+    RadixNode16 *n = (RadixNode16 *)node;
+    size_t i = (size_t)(slot - n->children);
+    memmove(n->keys + i, n->keys + i + 1, node->count - i - 1);
+    memmove(n->children + i, n->children + i + 1,
+            (node->count - i - 1) * sizeof(void *));
+    break;
+  }
+  case RADIX_NODE48: {
+    RadixNode48 *n = (RadixNode48 *)node;
+    n->children[n->child_index[byte] - 1] = NULL;
+    n->child_index[byte] = 0;
+    break;
+  }
+  case RADIX_NODE256:
+    *slot = NULL;
+    break;
+  }
+  node->count--;
+}
+
+/**
+ * Returns a leaf below the node. All of them share the prefix of the node, so
+ * any of them holds the bytes of a prefix that is too long to be stored.
+ */
+RadixLeaf *radix_node_minimum(void *child) {
+  while (!radix_is_leaf(child)) {
+    RadixNode *node = child;
+    if (node->leaf)
+      return node->leaf;
+    switch (node->type) {
+    case RADIX_NODE4:
+      child = ((RadixNode4 *)node)->children[0];
+      break;
+    case RADIX_NODE16:
+      child = ((RadixNode16 *)node)->children[0];
+      break;
+    case RADIX_NODE48: {
+      RadixNode48 *n = (RadixNode48 *)node;
+      int b = 0;
+      while (!n->child_index[b])
+        b++;
+      child = n->children[n->child_index[b] - 1];
+      break;
+    }
+    case RADIX_NODE256: {
+      RadixNode256 *n = (RadixNode256 *)node;
+      int b = 0;
+      while (!n->children[b])
+        b++;
+      child = n->children[b];
+      break;
+    }
+    }
+  }
+  return radix_leaf(child);
+}
+
+/**
+ * Returns the number of stored prefix bytes of the node that match the key at
+ * depth. Bytes of a longer prefix are not checked, the leaf at the end of the
+ * search compares the whole key anyway.
+ */
+size_t radix_node_check_prefix(RadixNode *node, unsigned char *key,
+                               size_t key_len, size_t depth) {
+  size_t max = radix_min(radix_min(node->prefix_len, RADIX_TREE_MAX_PREFIX),
+                         key_len - depth);
+  size_t i = 0;
+  while (i < max && node->prefix[i] == key[depth + i])
+    i++;
+  return i;
+}
+
+/**
+ * Returns the number of bytes of the prefix of the node that match the key at
+ * depth, looking up the bytes that are not stored in a leaf below the node.
+ * The result never exceeds the prefix length.
+ */
+size_t radix_node_prefix_mismatch(RadixNode *node, unsigned char *key,
+                                  size_t key_len, size_t depth) {
+  size_t i = radix_node_check_prefix(node, key, key_len, depth);
+  if (i < RADIX_TREE_MAX_PREFIX || node->prefix_len <= RADIX_TREE_MAX_PREFIX)
+    return i;
+  RadixLeaf *leaf = radix_node_minimum(node);
+  size_t max = radix_min(radix_min(leaf->key_len, key_len) - depth,
+                         node->prefix_len);
+  while (i < max && leaf->key[depth + i] == key[depth + i])
+    i++;
+  return i;
+}
+
+RadixTree *radix_tree_new(size_t value_size) {
+  RadixTree *created = malloc(sizeof(RadixTree));
+  if (!created)
+    return NULL;
+  created->root = NULL;
+  created->len = 0;
+  created->value_size = value_size;
+  return created;
+}
+
+void radix_tree_free(RadixTree *tree) {
+  radix_node_free(tree->root);
+  free(tree);
+}
+
+/**
+ * Places the leaf below a node whose children start at depth: as the leaf of
+ * the node if the key ends there, otherwise as the child for its next byte.
+ */
+int radix_node_attach(void **ref, RadixNode *node, RadixLeaf *leaf,
+                      size_t depth) {
+  if (leaf->key_len == depth) {
+    node->leaf = leaf;
+    return EXIT_SUCCESS;
+  }
+  return radix_node_add_child(ref, node, leaf->key[depth], radix_tag(leaf));
+}
+
+/**
+ * Returns a pointer to the value of the key, after inserting the key with the
+ * value v if it is missing. Sets inserted to whether the key was missing.
+ * Returns NULL if a node could not be allocated.
+ */
+void *radix_tree_emplace(RadixTree *tree, unsigned char *key, size_t key_len,
+                         void *v, bool *inserted) {
+  *inserted = false;
+  void **ref = &tree->root;
+  size_t depth = 0;
+  while (true) {
+    void *child = *ref;
+    if (child == NULL || radix_is_leaf(child)) {
+      RadixLeaf *existing = child ? radix_leaf(child) : NULL;
+      if (existing && radix_leaf_matches(existing, key, key_len))
+        return existing->value;
+      RadixLeaf *leaf = radix_leaf_new(tree, key, key_len, v);
+      if (!leaf)
+        return NULL;
+      if (existing) {
+        // Split the leaf into a node that holds the common part of both keys
+        // as its prefix and both leaves below it.
+        RadixNode *node = radix_node_new(RADIX_NODE4);
+        if (!node) {
+          free(leaf);
+          return NULL;
+        }
+        size_t max = radix_min(existing->key_len, key_len);
+        size_t common = 0;
+        while (depth + common < max &&
+               existing->key[depth + common] == key[depth + common])
+          common++;
+        node->prefix_len = (uint32_t)common;
+        memcpy(node->prefix, key + depth,
+               radix_min(common, RADIX_TREE_MAX_PREFIX));
+        // A Node4 has room for both, attaching them cannot fail.
+        void *node_ref = node;
+        radix_node_attach(&node_ref, node, existing, depth + common);
+        radix_node_attach(&node_ref, node, leaf, depth + common);
+        child = node;
+      } else {
+        child = radix_tag(leaf);
+      }
+      *ref = child;
+      tree->len++;
+      *inserted = true;
+      return leaf->value;
+    }
+
+    RadixNode *node = child;
+    if (node->prefix_len > 0) {
+      size_t common = radix_node_prefix_mismatch(node, key, key_len, depth);
+      if (common < node->prefix_len) {
+        // The key leaves the compressed path, split it where they differ.
+        RadixNode *split = radix_node_new(RADIX_NODE4);
+        RadixLeaf *leaf = radix_leaf_new(tree, key, key_len, v);
+        if (!split || !leaf) {
+          free(split);
+          free(leaf);
+          return NULL;
+        }
+        split->prefix_len = (uint32_t)common;
+        memcpy(split->prefix, node->prefix,
+               radix_min(common, RADIX_TREE_MAX_PREFIX));
+        unsigned char byte;
+        if (node->prefix_len <= RADIX_TREE_MAX_PREFIX) {
+          byte = node->prefix[common];
+          node->prefix_len -= (uint32_t)common + 1;
+          memmove(node->prefix, node->prefix + common + 1,
+                  radix_min(node->prefix_len, RADIX_TREE_MAX_PREFIX));
+        } else {
+          // The remaining prefix bytes have to come from a leaf.
+          RadixLeaf *min = radix_node_minimum(node);
+          byte = min->key[depth + common];
+          node->prefix_len -= (uint32_t)common + 1;
+          memcpy(node->prefix, min->key + depth + common + 1,
+                 radix_min(node->prefix_len, RADIX_TREE_MAX_PREFIX));
+        }
+        void *split_ref = split;
+        radix_node_add_child(&split_ref, split, byte, node);
+        radix_node_attach(&split_ref, split, leaf, depth + common);
+        *ref = split;
+        tree->len++;
+        *inserted = true;
+        return leaf->value;
+      }
+      depth += node->prefix_len;
+    }
+
+    if (depth == key_len) {
+      if (node->leaf)
+        return node->leaf->value;
+      node->leaf = radix_leaf_new(tree, key, key_len, v);
+      if (!node->leaf)
+        return NULL;
+      tree->len++;
+      *inserted = true;
+      return node->leaf->value;
+    }
+
+    void **slot = radix_node_find_child(node, key[depth]);
+    if (slot) {
+      ref = slot;
+      depth++;
+      continue;
+    }
+    RadixLeaf *leaf = radix_leaf_new(tree, key, key_len, v);
+    if (!leaf)
+      return NULL;
+    if (radix_node_add_child(ref, node, key[depth], radix_tag(leaf)) !=
+        EXIT_SUCCESS) {
+      free(leaf);
+      return NULL;
+    }
+    tree->len++;
+    *inserted = true;
+    return leaf->value;
+  }
+}
+
+int radix_tree_put(RadixTree *tree, void *key, size_t key_len, void *v) {
+  bool inserted;
+  void *value = radix_tree_emplace(tree, key, key_len, v, &inserted);
+  if (value == NULL)
+    return EXIT_FAILURE;
+  if (!inserted && tree->value_size > 0)
+    memcpy(value, v, tree->value_size);
+  return EXIT_SUCCESS;
+}
+
+/* Returns the leaf of the key or NULL if the key is not present. */
+RadixLeaf *radix_tree_find(RadixTree *tree, unsigned char *key,
+                           size_t key_len) {
+  void *child = tree->root;
+  size_t depth = 0;
+  while (child) {
+    if (radix_is_leaf(child)) {
+      RadixLeaf *leaf = radix_leaf(child);
+      return radix_leaf_matches(leaf, key, key_len) ? leaf : NULL;
+    }
+    RadixNode *node = child;
+    if (node->prefix_len > 0) {
+      if (radix_node_check_prefix(node, key, key_len, depth) !=
+          radix_min(node->prefix_len, RADIX_TREE_MAX_PREFIX))
+        return NULL;
+      depth += node->prefix_len;
+      if (depth > key_len)
+        return NULL;
+    }
+    if (depth == key_len) {
+      RadixLeaf *leaf = node->leaf;
+      return leaf && radix_leaf_matches(leaf, key, key_len) ? leaf : NULL;
+    }
+    void **slot = radix_node_find_child(node, key[depth]);
+    child = slot ? *slot : NULL;
+    depth++;
+  }
+  return NULL;
+}
+
+int radix_tree_get(RadixTree *tree, void *key, size_t key_len, void *v) {
+  RadixLeaf *leaf = radix_tree_find(tree, key, key_len);
+  if (leaf == NULL)
+    return EXIT_FAILURE;
+  memcpy(v, leaf->value, tree->value_size);
+  return EXIT_SUCCESS;
+}
+
+void *radix_tree_get_ptr(RadixTree *tree, void *key, size_t key_len) {
+  RadixLeaf *leaf = radix_tree_find(tree, key, key_len);
+  return leaf ? leaf->value : NULL;
+}
+
+int radix_tree_remove(RadixTree *tree, void *k, size_t key_len) {
+  unsigned char *key = k;
+  void **ref = &tree->root;
+  size_t depth = 0;
+  while (*ref) {
+    if (radix_is_leaf(*ref)) {
+      // Only a leaf at the root is reached here, others are removed from the
+      // node above them.
+      RadixLeaf *leaf = radix_leaf(*ref);
+      if (!radix_leaf_matches(leaf, key, key_len))
+        return EXIT_FAILURE;
+      free(leaf);
+      *ref = NULL;
+      tree->len--;
+      return EXIT_SUCCESS;
+    }
+    RadixNode *node = *ref;
+    if (node->prefix_len > 0) {
+      if (radix_node_check_prefix(node, key, key_len, depth) !=
+          radix_min(node->prefix_len, RADIX_TREE_MAX_PREFIX))
+        return EXIT_FAILURE;
+      depth += node->prefix_len;
+      if (depth > key_len)
+        return EXIT_FAILURE;
+    }
+    if (depth == key_len) {
+      RadixLeaf *leaf = node->leaf;
+      if (!leaf || !radix_leaf_matches(leaf, key, key_len))
+        return EXIT_FAILURE;
+      free(leaf);
+      node->leaf = NULL;
+      tree->len--;
+      radix_node_shrink(ref);
+      return EXIT_SUCCESS;
+    }
+    void **slot = radix_node_find_child(node, key[depth]);
+    if (!slot)
+      return EXIT_FAILURE;
+    if (radix_is_leaf(*slot)) {
+      RadixLeaf *leaf = radix_leaf(*slot);
+      if (!radix_leaf_matches(leaf, key, key_len))
+        return EXIT_FAILURE;
+      radix_node_remove_child(node, key[depth], slot);
+      free(leaf);
+      tree->len--;
+      radix_node_shrink(ref);
+      return EXIT_SUCCESS;
+    }
+    ref = slot;
+    depth++;
+  }
+  return EXIT_FAILURE;
+}
+
+bool radix_tree_contains(RadixTree *tree, void *key, size_t key_len) {
+  return radix_tree_find(tree, key, key_len) != NULL;
+}
+
+size_t radix_tree_len(RadixTree *tree) { return tree->len; }
+
+void radix_tree_clear(RadixTree *tree) {
+  radix_node_free(tree->root);
+  tree->root = NULL;
+  tree->len = 0;
+}
+
+/* Calls the consumer for every leaf below the child in ascending order. */
+void radix_node_for_each(void *child, RadixConsumer consumer) {
+  if (child == NULL)
+    return;
+  if (radix_is_leaf(child)) {
+    RadixLeaf *leaf = radix_leaf(child);
+    consumer(leaf->key, leaf->key_len, leaf->value);
+    return;
+  }
+  RadixNode *node = child;
+  // The key that ends at this node is a prefix of all keys below it.
+  if (node->leaf)
+    consumer(node->leaf->key, node->leaf->key_len, node->leaf->value);
+  switch (node->type) {
+  case RADIX_NODE4:
+    for (int i = 0; i < node->count; i++)
+      radix_node_for_each(((RadixNode4 *)node)->children[i], consumer);
+    break;
+  case RADIX_NODE16:
+    for (int i = 0; i < node->count; i++)
+      radix_node_for_each(((RadixNode16 *)node)->children[i], consumer);
+    break;
+  case RADIX_NODE48: {
+    RadixNode48 *n = (RadixNode48 *)node;
+    for (int b = 0; b < 256; b++) {
+      if (n->child_index[b])
+        radix_node_for_each(n->children[n->child_index[b] - 1], consumer);
+    }
+    break;
+  }
+  case RADIX_NODE256:
+    for (int b = 0; b < 256; b++)
+      radix_node_for_each(((RadixNode256 *)node)->children[b], consumer);
+    break;
+  }
+}
+
+void radix_tree_for_each(RadixTree *tree, RadixConsumer consumer) {
+  radix_node_for_each(tree->root, consumer);
+}
+
+void radix_tree_prefix(RadixTree *tree, void *p, size_t prefix_len,
+                       RadixConsumer consumer) {
+  unsigned char *prefix = p;
+  void *child = tree->root;
+  size_t depth = 0;
+  while (child) {
+    if (radix_is_leaf(child)) {
+      RadixLeaf *leaf = radix_leaf(child);
+      if (leaf->key_len >= prefix_len &&
+          memcmp(leaf->key, prefix, prefix_len) == 0)
+        consumer(leaf->key, leaf->key_len, leaf->value);
+      return;
+    }
+    RadixNode *node = child;
+    if (depth == prefix_len)
+      break;
+    if (node->prefix_len > 0) {
+      size_t common =
+          radix_node_prefix_mismatch(node, prefix, prefix_len, depth);
+      if (common < node->prefix_len) {
+        // The prefix ends inside the compressed path, every key below matches.
+        if (depth + common == prefix_len)
+          break;
+        return;
+      }
+      depth += node->prefix_len;
+      if (depth == prefix_len)
+        break;
+    }
+    void **slot = radix_node_find_child(node, prefix[depth]);
+    child = slot ? *slot : NULL;
+    depth++;
+  }
+  radix_node_for_each(child, consumer);
+}
@@ -115,6 +115,46 @@ int vec_get(Vec *vec, size_t index, void *buffer) {
   return EXIT_FAILURE;
 }
 
+int vec_sort(Vec *vec, Comperator comperator) {
+  if (vec->len < 2)
+    return EXIT_SUCCESS;
+  char *buffer = malloc(vec->len * vec->element_size);
+  if (!buffer)
+    return EXIT_FAILURE;
+
+  // Bottom up merge sort, runs of width elements are merged from src to dst.
+  size_t size = vec->element_size;
+  char *src = vec->data;
+  char *dst = buffer;
+  for (size_t width = 1; width < vec->len; width *= 2) {
+    for (size_t lo = 0; lo < vec->len; lo += 2 * width) {
+      size_t mid = lo + width < vec->len ? lo + width : vec->len;
+      size_t hi = mid + width < vec->len ? mid + width : vec->len;
+      size_t i = lo;
+      size_t j = mid;
+      size_t k = lo;
+      while (i < mid && j < hi) {
+        // Only take from the right run if it is strictly smaller to keep the
+        // sort stable.
+        if (comperator(src + i * size, src + j * size) < 0)
+          memcpy(dst + k++ * size, src + j++ * size, size);
+        else
+          memcpy(dst + k++ * size, src + i++ * size, size);
+      }
+      memcpy(dst + k * size, src + i * size, (mid - i) * size);
+      k += mid - i;
+      memcpy(dst + k * size, src + j * size, (hi - j) * size);
+    }
+    char *swap = src;
+    src = dst;
+    dst = swap;
+  }
+  if (src != vec->data)
+    memcpy(vec->data, src, vec->len * size);
+  free(buffer);
+  return EXIT_SUCCESS;
+}
+
 void vec_grow(Vec *vec) {
   // Calculate new capacity. The new capacity is the current capacity doubled.
   int new_capacity = vec->capacity * 2;
@@ -0,0 +1,146 @@
+#include <stdlib.h>
+#include <unity.h>
+
+#include "kiyo-collections/arena_tree.h"
+
+ArenaTree *tree;
+
+int compere(void *left, void *right) { return *(int *)right - *(int *)left; }
+
+void setUp(void) { tree = arena_tree_new(sizeof(int), sizeof(int), &compere); }
+
+void tearDown(void) { arena_tree_free(tree); }
+
+/* Validates heights and balance below the node, returns its height. */
+unsigned check_avl(uint32_t i) {
+  if (i == 0)
+    return 0;
+  ArenaNode *node = (ArenaNode *)(tree->nodes + i * tree->node_size);
+  unsigned left = check_avl(node->left);
+  unsigned right = check_avl(node->right);
+  TEST_ASSERT(left <= right + 1 && right <= left + 1);
+  TEST_ASSERT_EQUAL_INT((left > right ? left : right) + 1, node->height);
+  return node->height;
+}
+
+void test_arena_tree_put() {
+  // Header, key and value of an int map fit into 20 bytes.
+  TEST_ASSERT_EQUAL_INT(20, tree->node_size);
+  for (int k = 0; k < 1000; k++) {
+    int v = k * k;
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, arena_tree_put(tree, &k, &v));
+  }
+  TEST_ASSERT_EQUAL_INT(1000, tree->len);
+  TEST_ASSERT_EQUAL_INT(1001, tree->used);
+  check_avl(tree->root);
+
+  int k = 5;
+  int v = -1;
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, arena_tree_put(tree, &k, &v));
+  TEST_ASSERT_EQUAL_INT(1000, tree->len);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, arena_tree_get(tree, &k, &v));
+  TEST_ASSERT_EQUAL_INT(-1, v);
+  k = 1000;
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, arena_tree_get(tree, &k, &v));
+}
+
+void test_arena_tree_remove() {
+  int k = 0;
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, arena_tree_remove(tree, &k));
+  for (k = 0; k < 1000; k++) {
+    arena_tree_put(tree, &k, &k);
+  }
+  for (k = 0; k < 1000; k += 2) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, arena_tree_remove(tree, &k));
+  }
+  TEST_ASSERT_EQUAL_INT(500, tree->len);
+  check_avl(tree->root);
+  for (k = 0; k < 1000; k++) {
+    TEST_ASSERT_EQUAL_INT(k % 2 == 1, arena_tree_contains(tree, &k));
+  }
+
+  // Removed slots are reused before the arena grows.
+  for (k = 1000; k < 1500; k++) {
+    arena_tree_put(tree, &k, &k);
+  }
+  TEST_ASSERT_EQUAL_INT(1001, tree->used);
+  TEST_ASSERT_EQUAL_INT(0, tree->free_list);
+}
+
+void test_arena_tree_random() {
+  bool present[512] = {false};
+  size_t len = 0;
+  srand(42);
+  for (int i = 0; i < 20000; i++) {
+    int k = rand() % 512;
+    if (rand() % 3) {
+      if (!present[k])
+        len++;
+      present[k] = true;
+      arena_tree_put(tree, &k, &k);
+    } else {
+      int status = arena_tree_remove(tree, &k);
+      TEST_ASSERT_EQUAL_INT(present[k] ? EXIT_SUCCESS : EXIT_FAILURE, status);
+      if (present[k])
+        len--;
+      present[k] = false;
+    }
+  }
+  TEST_ASSERT_EQUAL_INT(len, tree->len);
+  check_avl(tree->root);
+  for (int k = 0; k < 512; k++) {
+    TEST_ASSERT_EQUAL_INT(present[k], arena_tree_contains(tree, &k));
+  }
+}
+
+void test_arena_tree_clear() {
+  for (int k = 0; k < 100; k++) {
+    arena_tree_put(tree, &k, &k);
+  }
+  arena_tree_clear(tree);
+  TEST_ASSERT_EQUAL_INT(0, tree->len);
+  TEST_ASSERT_EQUAL_INT(0, arena_tree_height(tree));
+  int k = 50;
+  TEST_ASSERT_FALSE(arena_tree_contains(tree, &k));
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, arena_tree_put(tree, &k, &k));
+  TEST_ASSERT_EQUAL_INT(1, tree->len);
+}
+
+void test_arena_tree_cursor() {
+  ArenaCursor cursor;
+  int k = 0;
+  TEST_ASSERT_FALSE(arena_tree_first(tree, &cursor));
+  TEST_ASSERT_FALSE(arena_tree_floor(tree, &k, &cursor));
+  for (k = 0; k < 1000; k += 10) {
+    arena_tree_put(tree, &k, &k);
+  }
+  TEST_ASSERT(arena_tree_last(tree, &cursor));
+  TEST_ASSERT_EQUAL_INT(990, *(int *)arena_cursor_key(&cursor));
+  TEST_ASSERT_FALSE(arena_cursor_next(&cursor));
+  for (k = 0; k < 990; k++) {
+    TEST_ASSERT(arena_tree_lower_bound(tree, &k, &cursor));
+    TEST_ASSERT_EQUAL_INT((k + 9) / 10 * 10, *(int *)arena_cursor_key(&cursor));
+    // The floor continues in order up to the largest key.
+    TEST_ASSERT(arena_tree_floor(tree, &k, &cursor));
+    int expected = k / 10 * 10;
+    do {
+      TEST_ASSERT_EQUAL_INT(expected, *(int *)arena_cursor_value(&cursor));
+      expected += 10;
+    } while (arena_cursor_next(&cursor));
+    TEST_ASSERT_EQUAL_INT(1000, expected);
+  }
+  k = 991;
+  TEST_ASSERT_FALSE(arena_tree_lower_bound(tree, &k, &cursor));
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_arena_tree_put);
+  RUN_TEST(test_arena_tree_remove);
+  RUN_TEST(test_arena_tree_random);
+  RUN_TEST(test_arena_tree_clear);
+  RUN_TEST(test_arena_tree_cursor);
+
+  return UNITY_END();
+}
@@ -0,0 +1,206 @@
+#include <stdlib.h>
+#include <unity.h>
+
+#include "kiyo-collections/b_plus_tree.h"
+
+BPlusTree *tree;
+
+int compere(void *left, void *right) { return *(int *)right - *(int *)left; }
+
+void setUp(void) { tree = b_plus_tree_new(sizeof(int), sizeof(int), &compere); }
+
+void tearDown(void) { b_plus_tree_free(tree); }
+
+/* Checks that a walk over the leaves yields all keys in ascending order. */
+void assert_ordered(size_t expected_len) {
+  BPlusCursor cursor;
+  size_t len = 0;
+  if (b_plus_tree_first(tree, &cursor)) {
+    int prev = *(int *)b_plus_cursor_key(tree, &cursor);
+    len++;
+    while (b_plus_cursor_next(&cursor)) {
+      int current = *(int *)b_plus_cursor_key(tree, &cursor);
+      TEST_ASSERT(prev < current);
+      prev = current;
+      len++;
+    }
+  }
+  TEST_ASSERT_EQUAL_INT(expected_len, len);
+}
+
+void test_b_plus_tree_put() {
+  for (int k = 0; k < 1000; k++) {
+    int v = k * k;
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_plus_tree_put(tree, &k, &v));
+  }
+  TEST_ASSERT_EQUAL_INT(1000, tree->len);
+  TEST_ASSERT_EQUAL_INT(2, b_plus_tree_height(tree));
+  assert_ordered(1000);
+
+  int k = 5;
+  int v = -1;
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_plus_tree_put(tree, &k, &v));
+  TEST_ASSERT_EQUAL_INT(1000, tree->len);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_plus_tree_get(tree, &k, &v));
+  TEST_ASSERT_EQUAL_INT(-1, v);
+}
+
+void test_b_plus_tree_get() {
+  for (int k = 999; k >= 0; k--) {
+    int v = k * k;
+    b_plus_tree_put(tree, &k, &v);
+  }
+  int v;
+  for (int k = 0; k < 1000; k++) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_plus_tree_get(tree, &k, &v));
+    TEST_ASSERT_EQUAL_INT(k * k, v);
+    TEST_ASSERT(b_plus_tree_contains(tree, &k));
+  }
+  int k = -1;
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, b_plus_tree_get(tree, &k, &v));
+  k = 1000;
+  TEST_ASSERT_FALSE(b_plus_tree_contains(tree, &k));
+}
+
+void test_b_plus_tree_remove() {
+  int k = 0;
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, b_plus_tree_remove(tree, &k));
+  for (k = 0; k < 1000; k++) {
+    b_plus_tree_put(tree, &k, &k);
+  }
+  for (k = 0; k < 1000; k += 2) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_plus_tree_remove(tree, &k));
+  }
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, b_plus_tree_remove(tree, &k));
+  TEST_ASSERT_EQUAL_INT(500, tree->len);
+  assert_ordered(500);
+  for (k = 0; k < 1000; k++) {
+    TEST_ASSERT_EQUAL_INT(k % 2 == 1, b_plus_tree_contains(tree, &k));
+  }
+  for (k = 1; k < 1000; k += 2) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_plus_tree_remove(tree, &k));
+  }
+  TEST_ASSERT_EQUAL_INT(0, tree->len);
+  TEST_ASSERT_EQUAL_INT(0, b_plus_tree_height(tree));
+  TEST_ASSERT_NULL(tree->root);
+}
+
+void test_b_plus_tree_random() {
+  bool present[512] = {false};
+  size_t len = 0;
+  srand(42);
+  for (int i = 0; i < 20000; i++) {
+    int k = rand() % 512;
+    if (rand() % 3) {
+      if (!present[k])
+        len++;
+      present[k] = true;
+      b_plus_tree_put(tree, &k, &k);
+    } else {
+      int status = b_plus_tree_remove(tree, &k);
+      TEST_ASSERT_EQUAL_INT(present[k] ? EXIT_SUCCESS : EXIT_FAILURE, status);
+      if (present[k])
+        len--;
+      present[k] = false;
+    }
+  }
+  TEST_ASSERT_EQUAL_INT(len, tree->len);
+  assert_ordered(len);
+  for (int k = 0; k < 512; k++) {
+    TEST_ASSERT_EQUAL_INT(present[k], b_plus_tree_contains(tree, &k));
+  }
+}
+
+typedef struct {
+  int k;
+  char padding[252];
+} WideKey;
+
+void test_b_plus_tree_narrow_nodes() {
+  // Wide keys shrink the node capacity, which builds deep trees.
+  BPlusTree *deep = b_plus_tree_new(sizeof(WideKey), sizeof(int), &compere);
+  TEST_ASSERT_EQUAL_INT(4, deep->capacity);
+  bool present[2048] = {false};
+  size_t len = 0;
+  srand(7);
+  WideKey key = {0};
+  for (int i = 0; i < 50000; i++) {
+    key.k = rand() % 2048;
+    if (rand() % 2) {
+      if (!present[key.k])
+        len++;
+      present[key.k] = true;
+      TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_plus_tree_put(deep, &key, &key.k));
+    } else {
+      int status = b_plus_tree_remove(deep, &key);
+      TEST_ASSERT_EQUAL_INT(present[key.k] ? EXIT_SUCCESS : EXIT_FAILURE,
+                            status);
+      if (present[key.k])
+        len--;
+      present[key.k] = false;
+    }
+  }
+  TEST_ASSERT_EQUAL_INT(len, deep->len);
+  TEST_ASSERT(b_plus_tree_height(deep) > 4);
+  int v;
+  for (key.k = 0; key.k < 2048; key.k++) {
+    if (present[key.k]) {
+      TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_plus_tree_get(deep, &key, &v));
+      TEST_ASSERT_EQUAL_INT(key.k, v);
+    } else {
+      TEST_ASSERT_FALSE(b_plus_tree_contains(deep, &key));
+    }
+  }
+  BPlusCursor cursor;
+  size_t walked = 0;
+  int prev = -1;
+  if (b_plus_tree_first(deep, &cursor)) {
+    do {
+      int current = *(int *)b_plus_cursor_key(deep, &cursor);
+      TEST_ASSERT(prev < current);
+      prev = current;
+      walked++;
+    } while (b_plus_cursor_next(&cursor));
+  }
+  TEST_ASSERT_EQUAL_INT(len, walked);
+  for (key.k = 0; key.k < 2048; key.k++) {
+    b_plus_tree_remove(deep, &key);
+  }
+  TEST_ASSERT_EQUAL_INT(0, deep->len);
+  TEST_ASSERT_NULL(deep->root);
+  b_plus_tree_free(deep);
+}
+
+void test_b_plus_tree_cursor() {
+  BPlusCursor cursor;
+  int k = 0;
+  TEST_ASSERT_FALSE(b_plus_tree_first(tree, &cursor));
+  TEST_ASSERT_FALSE(b_plus_tree_lower_bound(tree, &k, &cursor));
+  for (k = 0; k < 1000; k += 10) {
+    b_plus_tree_put(tree, &k, &k);
+  }
+  TEST_ASSERT(b_plus_tree_last(tree, &cursor));
+  TEST_ASSERT_EQUAL_INT(990, *(int *)b_plus_cursor_key(tree, &cursor));
+  TEST_ASSERT(b_plus_cursor_prev(&cursor));
+  TEST_ASSERT_EQUAL_INT(980, *(int *)b_plus_cursor_value(tree, &cursor));
+  for (k = 0; k < 990; k++) {
+    TEST_ASSERT(b_plus_tree_lower_bound(tree, &k, &cursor));
+    TEST_ASSERT_EQUAL_INT((k + 9) / 10 * 10,
+                          *(int *)b_plus_cursor_key(tree, &cursor));
+  }
+  k = 991;
+  TEST_ASSERT_FALSE(b_plus_tree_lower_bound(tree, &k, &cursor));
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_b_plus_tree_put);
+  RUN_TEST(test_b_plus_tree_get);
+  RUN_TEST(test_b_plus_tree_remove);
+  RUN_TEST(test_b_plus_tree_random);
+  RUN_TEST(test_b_plus_tree_narrow_nodes);
+  RUN_TEST(test_b_plus_tree_cursor);
+
+  return UNITY_END();
+}
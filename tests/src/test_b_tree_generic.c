@@ -0,0 +1,104 @@
+#include <unity.h>
+
+#include "test_b_tree_generic.h"
+
+GENERATE_B_TREE_MAP_C(u64, uint64_t, uint64_t, COMPARE_ASCENDING)
+GENERATE_B_TREE_SET_C(int, int, COMPARE_ASCENDING)
+
+BTreeMapu64 *tree_map;
+BTreeSetint *tree_set;
+
+void setUp(void) {
+  tree_map = b_tree_map_u64_new();
+  tree_set = b_tree_set_int_new();
+}
+
+void tearDown(void) {
+  b_tree_map_u64_free(tree_map);
+  b_tree_set_int_free(tree_set);
+}
+
+/* Checks the AVL property of every entry and returns the subtree height. */
+size_t check_avl(BinaryEntryu64 *node) {
+  if (node == NULL)
+    return 0;
+  size_t left = check_avl(node->left);
+  size_t right = check_avl(node->right);
+  TEST_ASSERT(left <= right + 1 && right <= left + 1);
+  if (node->left)
+    TEST_ASSERT(node->left->key < node->key);
+  if (node->right)
+    TEST_ASSERT(node->right->key > node->key);
+  size_t height = (left > right ? left : right) + 1;
+  TEST_ASSERT_EQUAL_size_t(height, node->height);
+  return height;
+}
+
+void test_b_tree_map_put_get() {
+  // Keys above INT64_MAX would overflow a comparison by subtraction.
+  for (uint64_t k = 0; k < 1000; k++) {
+    uint64_t key = UINT64_MAX - k * 7919;
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_u64_put(tree_map, key, k));
+  }
+  TEST_ASSERT_EQUAL_INT(1000, b_tree_map_u64_len(tree_map));
+  check_avl(tree_map->root);
+
+  uint64_t v;
+  for (uint64_t k = 0; k < 1000; k++) {
+    uint64_t key = UINT64_MAX - k * 7919;
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_u64_get(tree_map, key, &v));
+    TEST_ASSERT_EQUAL_UINT64(k, v);
+  }
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, b_tree_map_u64_get(tree_map, 1, &v));
+  TEST_ASSERT_FALSE(b_tree_map_u64_contains_key(tree_map, 1));
+
+  b_tree_map_u64_put(tree_map, UINT64_MAX, 42);
+  TEST_ASSERT_EQUAL_INT(1000, b_tree_map_u64_len(tree_map));
+  b_tree_map_u64_get(tree_map, UINT64_MAX, &v);
+  TEST_ASSERT_EQUAL_UINT64(42, v);
+}
+
+void test_b_tree_map_remove() {
+  for (uint64_t k = 0; k < 500; k++) {
+    b_tree_map_u64_put(tree_map, k, k * k);
+  }
+  for (uint64_t k = 0; k < 500; k += 3) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_u64_remove(tree_map, k));
+  }
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, b_tree_map_u64_remove(tree_map, 0));
+  check_avl(tree_map->root);
+  for (uint64_t k = 0; k < 500; k++) {
+    TEST_ASSERT_EQUAL_INT(k % 3 != 0,
+                          b_tree_map_u64_contains_key(tree_map, k));
+  }
+  b_tree_map_u64_clear(tree_map);
+  TEST_ASSERT_EQUAL_INT(0, b_tree_map_u64_len(tree_map));
+  TEST_ASSERT_NULL(tree_map->root);
+}
+
+void test_b_tree_set_add_remove() {
+  for (int i = -100; i < 100; i++) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_set_int_add(tree_set, i));
+  }
+  b_tree_set_int_add(tree_set, 0);
+  TEST_ASSERT_EQUAL_INT(200, b_tree_set_int_len(tree_set));
+  TEST_ASSERT_EQUAL_INT(8, tree_set->root->height);
+  for (int i = -100; i < 100; i += 2) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_set_int_remove(tree_set, i));
+  }
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, b_tree_set_int_remove(tree_set, 100));
+  TEST_ASSERT_EQUAL_INT(100, b_tree_set_int_len(tree_set));
+  for (int i = -100; i < 100; i++) {
+    TEST_ASSERT_EQUAL_INT(i % 2 != 0, b_tree_set_int_contains(tree_set, i));
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_b_tree_map_put_get);
+  RUN_TEST(test_b_tree_map_remove);
+  RUN_TEST(test_b_tree_set_add_remove);
+
+  return UNITY_END();
+}
@@ -0,0 +1,6 @@
+#include "kiyo-collections/b_tree_map.h"
+#include "kiyo-collections/b_tree_set.h"
+#include <stdint.h>
+
+GENERATE_B_TREE_MAP_H(u64, uint64_t, uint64_t)
+GENERATE_B_TREE_SET_H(int, int)
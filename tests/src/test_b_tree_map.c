@@ -1,3 +1,4 @@
+#include <math.h>
 #include <stdlib.h>
 #include <unity.h>
 
@@ -58,6 +59,7 @@ void test_b_tree_map_get() {
 
 void test_b_tree_map_put_unbalanced() {
   b_tree_map_clear(tree_map);
+  b_tree_map_set_small_limit(tree_map, 0);
   int k = 0;
   b_tree_map_put(tree_map, &k, &k);
   k = 2;
@@ -72,13 +74,687 @@ void test_b_tree_map_put_unbalanced() {
   }
 }
 
+void test_b_tree_map_inline_entries() {
+  int k = 7;
+  int v = 49;
+  b_tree_map_set_small_limit(tree_map, 0);
+  b_tree_map_put(tree_map, &k, &v);
+  BinaryEntry *root = tree_map->root;
+  TEST_ASSERT((char *)root->key >= (char *)(root + 1));
+  TEST_ASSERT((char *)root->value > (char *)root->key);
+  TEST_ASSERT_EQUAL_INT(7, *(int *)root->key);
+  TEST_ASSERT_EQUAL_INT(49, *(int *)root->value);
+}
+
+void test_b_tree_map_paged() {
+  BTreeMap *paged = b_tree_map_new_paged(sizeof(int), sizeof(int), &compere);
+  for (int k = 0; k < 1000; k++) {
+    int v = k * k;
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_put(paged, &k, &v));
+  }
+  TEST_ASSERT_EQUAL_INT(1000, paged->len);
+  TEST_ASSERT_NULL(paged->root);
+  TEST_ASSERT(b_tree_map_height(paged) < 4);
+
+  int v;
+  int k = 30;
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_get(paged, &k, &v));
+  TEST_ASSERT_EQUAL_INT(900, v);
+  TEST_ASSERT(b_tree_map_contains_key(paged, &k));
+  k = 1000;
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, b_tree_map_get(paged, &k, &v));
+  TEST_ASSERT_FALSE(b_tree_map_contains_key(paged, &k));
+
+  b_tree_map_clear(paged);
+  TEST_ASSERT_EQUAL_INT(0, paged->len);
+  k = 30;
+  TEST_ASSERT_FALSE(b_tree_map_contains_key(paged, &k));
+  b_tree_map_free(paged);
+}
+
+void test_b_tree_map_arena() {
+  BTreeMap *arena = b_tree_map_new_arena(sizeof(int), sizeof(int), &compere);
+  for (int k = 0; k < 1000; k++) {
+    int v = k * k;
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_put(arena, &k, &v));
+  }
+  TEST_ASSERT_EQUAL_INT(1000, arena->len);
+  TEST_ASSERT_NULL(arena->root);
+  TEST_ASSERT_EQUAL_INT(10, b_tree_map_height(arena));
+
+  int v;
+  int k = 30;
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_get(arena, &k, &v));
+  TEST_ASSERT_EQUAL_INT(900, v);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_remove(arena, &k));
+  TEST_ASSERT_FALSE(b_tree_map_contains_key(arena, &k));
+  TEST_ASSERT_EQUAL_INT(999, arena->len);
+
+  // Clearing keeps the arena, refilling it does not grow it again.
+  size_t capacity = arena->arena->capacity;
+  b_tree_map_clear(arena);
+  TEST_ASSERT_EQUAL_INT(0, arena->len);
+  TEST_ASSERT_FALSE(b_tree_map_contains_key(arena, &k));
+  for (k = 0; k < 1000; k++) {
+    b_tree_map_put(arena, &k, &k);
+  }
+  TEST_ASSERT_EQUAL_INT(capacity, arena->arena->capacity);
+  k = 30;
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_get(arena, &k, &v));
+  TEST_ASSERT_EQUAL_INT(30, v);
+  b_tree_map_free(arena);
+}
+
+/* Looks up every key below 300 in a map of the even keys below 200. */
+void check_get_many(BTreeMap *map) {
+  int keys[300];
+  int values[300];
+  bool found[300];
+  TEST_ASSERT_EQUAL_INT(0, b_tree_map_get_many(map, keys, 0, values, found));
+  for (int k = 0; k < 200; k += 2) {
+    int v = -k;
+    b_tree_map_put(map, &k, &v);
+  }
+  // Lookups in reverse order, so that lanes finish at different depths.
+  for (int i = 0; i < 300; i++) {
+    keys[i] = 299 - i;
+    values[i] = 1;
+  }
+  TEST_ASSERT_EQUAL_INT(100,
+                        b_tree_map_get_many(map, keys, 300, values, found));
+  for (int i = 0; i < 300; i++) {
+    bool present = keys[i] < 200 && keys[i] % 2 == 0;
+    TEST_ASSERT_EQUAL_INT(present, found[i]);
+    TEST_ASSERT_EQUAL_INT(present ? -keys[i] : 1, values[i]);
+  }
+  TEST_ASSERT_EQUAL_INT(1,
+                        b_tree_map_get_many(map, keys + 101, 2, values, NULL));
+}
+
+void test_b_tree_map_get_many() { check_get_many(tree_map); }
+
+void test_b_tree_map_get_many_paged() {
+  BTreeMap *paged = b_tree_map_new_paged(sizeof(int), sizeof(int), &compere);
+  check_get_many(paged);
+  b_tree_map_free(paged);
+}
+
+void test_b_tree_map_get_many_filtered() {
+  // Keys added before and after attaching must both be found.
+  int k = 0;
+  int v = 0;
+  b_tree_map_put(tree_map, &k, &v);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,
+                        b_tree_map_attach_filter(tree_map, NULL, 1000));
+  check_get_many(tree_map);
+}
+
+void test_b_tree_map_filter() {
+  for (int k = 0; k < 100; k++)
+    b_tree_map_put(tree_map, &k, &k);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,
+                        b_tree_map_attach_filter(tree_map, NULL, 0));
+  int k = 42;
+  TEST_ASSERT_TRUE(b_tree_map_contains_key(tree_map, &k));
+  TEST_ASSERT_EQUAL_INT(42, *(int *)b_tree_map_get_ptr(tree_map, &k));
+  b_tree_map_remove(tree_map, &k);
+  TEST_ASSERT_FALSE(b_tree_map_contains_key(tree_map, &k));
+  k = 100;
+  int v = -1;
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, b_tree_map_get(tree_map, &k, &v));
+  TEST_ASSERT_EQUAL_INT(-1, v);
+
+  b_tree_map_clear(tree_map);
+  TEST_ASSERT_EQUAL_INT(0, bloom_filter_len(tree_map->filter));
+  b_tree_map_put(tree_map, &k, &k);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_get(tree_map, &k, &v));
+  TEST_ASSERT_EQUAL_INT(100, v);
+  b_tree_map_detach_filter(tree_map);
+  TEST_ASSERT_NULL(tree_map->filter);
+  TEST_ASSERT_TRUE(b_tree_map_contains_key(tree_map, &k));
+}
+
+void test_b_tree_map_filter_paged() {
+  BTreeMap *paged = b_tree_map_new_paged(sizeof(int), sizeof(int), &compere);
+  b_tree_map_attach_filter(paged, NULL, 100);
+  for (int k = 0; k < 100; k += 2)
+    b_tree_map_put(paged, &k, &k);
+  for (int k = 0; k < 100; k++)
+    TEST_ASSERT_EQUAL_INT(k % 2 == 0, b_tree_map_contains_key(paged, &k));
+  b_tree_map_free(paged);
+}
+
+void add_to_counter(void *value, void *ctx) { *(int *)value += *(int *)ctx; }
+
+/* Counts words with upsert, then checks get_ptr and get_or_insert. */
+void check_entry_api(BTreeMap *map) {
+  int k = 3;
+  TEST_ASSERT_NULL(b_tree_map_get_ptr(map, &k));
+  int one = 1;
+  for (int i = 0; i < 1000; i++) {
+    k = i % 100;
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,
+                          b_tree_map_upsert(map, &k, add_to_counter, &one));
+  }
+  TEST_ASSERT_EQUAL_INT(100, map->len);
+
+  k = 3;
+  int *count = b_tree_map_get_ptr(map, &k);
+  TEST_ASSERT_NOT_NULL(count);
+  TEST_ASSERT_EQUAL_INT(10, *count);
+  *count = 42;
+  int v;
+  b_tree_map_get(map, &k, &v);
+  TEST_ASSERT_EQUAL_INT(42, v);
+
+  int fallback = -1;
+  int *present = b_tree_map_get_or_insert(map, &k, &fallback);
+  TEST_ASSERT_EQUAL_INT(42, *present);
+  k = 500;
+  int *inserted = b_tree_map_get_or_insert(map, &k, &fallback);
+  TEST_ASSERT_EQUAL_INT(-1, *inserted);
+  TEST_ASSERT_EQUAL_INT(101, map->len);
+  (*inserted)++;
+  TEST_ASSERT_EQUAL_INT(0, *(int *)b_tree_map_get_ptr(map, &k));
+}
+
+void test_b_tree_map_entry_api() { check_entry_api(tree_map); }
+
+void test_b_tree_map_entry_api_paged() {
+  BTreeMap *paged = b_tree_map_new_paged(sizeof(int), sizeof(int), &compere);
+  check_entry_api(paged);
+  b_tree_map_free(paged);
+}
+
+void test_b_tree_map_entry_api_arena() {
+  BTreeMap *arena = b_tree_map_new_arena(sizeof(int), sizeof(int), &compere);
+  check_entry_api(arena);
+  b_tree_map_free(arena);
+}
+
+void test_b_tree_map_u64_keys() {
+  BTreeMap *map = b_tree_map_new_u64(sizeof(int));
+  // Keys far apart, a subtracting comperator would overflow on them.
+  uint64_t keys[] = {UINT64_MAX, 0, 1ull << 63, 42, (1ull << 63) - 1};
+  for (int i = 0; i < 5; i++) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_put(map, &keys[i], &i));
+  }
+  int v;
+  for (int i = 0; i < 5; i++) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_get(map, &keys[i], &v));
+    TEST_ASSERT_EQUAL_INT(i, v);
+  }
+  uint64_t k = 43;
+  TEST_ASSERT_FALSE(b_tree_map_contains_key(map, &k));
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_ceiling(map, &k, &k, NULL));
+  TEST_ASSERT(k == (1ull << 63) - 1);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_last(map, &k, &v));
+  TEST_ASSERT(k == UINT64_MAX);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_remove(map, &keys[0]));
+  TEST_ASSERT_EQUAL_INT(4, map->len);
+  b_tree_map_free(map);
+}
+
+void test_b_tree_map_scalar_keys() {
+  BTreeMap *signed_map = b_tree_map_new_i64(sizeof(int));
+  BTreeMap *double_map = b_tree_map_new_f64(sizeof(int));
+  for (int i = -50; i < 50; i++) {
+    int64_t k = (int64_t)i * 1000000007;
+    double d = i * 0.5;
+    b_tree_map_put(signed_map, &k, &i);
+    b_tree_map_put(double_map, &d, &i);
+  }
+  int64_t k;
+  double d;
+  int v;
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_first(signed_map, &k, &v));
+  TEST_ASSERT_EQUAL_INT(-50, v);
+  d = -0.25;
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_floor(double_map, &d, &d, &v));
+  TEST_ASSERT_EQUAL_INT(-1, v);
+  d = 24.5;
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_get(double_map, &d, &v));
+  TEST_ASSERT_EQUAL_INT(49, v);
+  d = 0.25;
+  TEST_ASSERT_FALSE(b_tree_map_contains_key(double_map, &d));
+
+  // NaN compares equal to every key and must not overwrite any entry.
+  d = NAN;
+  v = -1;
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, b_tree_map_put(double_map, &d, &v));
+  TEST_ASSERT_NULL(b_tree_map_get_or_insert(double_map, &d, &v));
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE,
+                        b_tree_map_upsert(double_map, &d, add_to_counter, &v));
+  TEST_ASSERT_EQUAL_INT(100, double_map->len);
+  for (int i = -50; i < 50; i++) {
+    d = i * 0.5;
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_get(double_map, &d, &v));
+    TEST_ASSERT_EQUAL_INT(i, v);
+  }
+  b_tree_map_free(signed_map);
+  b_tree_map_free(double_map);
+}
+
+/* Looks up and removes NaN on a double map with the keys 0 to n - 1. */
+void check_nan_lookups(BTreeMap *map, int n) {
+  for (int i = 0; i < n; i++) {
+    double d = i;
+    b_tree_map_put(map, &d, &i);
+  }
+  double nan = NAN;
+  int v = -1;
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, b_tree_map_get(map, &nan, &v));
+  TEST_ASSERT_EQUAL_INT(-1, v);
+  TEST_ASSERT_NULL(b_tree_map_get_ptr(map, &nan));
+  TEST_ASSERT_FALSE(b_tree_map_contains_key(map, &nan));
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, b_tree_map_remove(map, &nan));
+  TEST_ASSERT_EQUAL_INT(n, map->len);
+  for (int i = 0; i < n; i++) {
+    double d = i;
+    TEST_ASSERT_TRUE(b_tree_map_contains_key(map, &d));
+  }
+  b_tree_map_free(map);
+}
+
+void test_b_tree_map_nan_keys() {
+  check_nan_lookups(b_tree_map_new_f64(sizeof(int)), 5);
+  BTreeMap *tree = b_tree_map_new_f64(sizeof(int));
+  b_tree_map_set_small_limit(tree, 0);
+  check_nan_lookups(tree, 40);
+}
+
+void test_b_tree_map_string_keys() {
+  BTreeMap *strings = b_tree_map_new_cstr(sizeof(int));
+  char *words[] = {"pear", "apple", "fig", "banana", "cherry"};
+  for (int i = 0; i < 5; i++) {
+    b_tree_map_put(strings, &words[i], &i);
+  }
+  // A different pointer to an equal string finds the same entry.
+  char buffer[] = "fig";
+  char *probe = buffer;
+  int v;
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_get(strings, &probe, &v));
+  TEST_ASSERT_EQUAL_INT(2, v);
+  char *first;
+  b_tree_map_first(strings, &first, NULL);
+  TEST_ASSERT_EQUAL_STRING("apple", first);
+  b_tree_map_free(strings);
+
+  BTreeMap *bytes = b_tree_map_new_bytes(4, sizeof(int));
+  unsigned char keys[][4] = {{1, 0, 0, 0}, {0, 0, 0, 255}, {0, 0, 1, 0}};
+  for (int i = 0; i < 3; i++) {
+    b_tree_map_put(bytes, keys[i], &i);
+  }
+  BTreeMapIter iter;
+  void *pk;
+  void *pv;
+  int expected[] = {1, 2, 0};
+  b_tree_map_iter(bytes, &iter);
+  for (int i = 0; b_tree_map_iter_next(&iter, &pk, &pv); i++) {
+    TEST_ASSERT_EQUAL_INT(expected[i], *(int *)pv);
+  }
+  b_tree_map_free(bytes);
+}
+
+/* Validates heights, sizes and balance below the entry, returns its height. */
+size_t check_avl(BinaryEntry *node) {
+  if (node == NULL)
+    return 0;
+  size_t left = check_avl(node->left);
+  size_t right = check_avl(node->right);
+  TEST_ASSERT(left <= right + 1 && right <= left + 1);
+  TEST_ASSERT_EQUAL_INT((left > right ? left : right) + 1, node->height);
+  size_t size = 1;
+  size += node->left ? node->left->size : 0;
+  size += node->right ? node->right->size : 0;
+  TEST_ASSERT_EQUAL_INT(size, node->size);
+  return node->height;
+}
+
+void test_b_tree_map_remove() {
+  int k = 0;
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, b_tree_map_remove(tree_map, &k));
+  for (k = 0; k < 256; k++) {
+    int v = -k;
+    b_tree_map_put(tree_map, &k, &v);
+  }
+  for (k = 0; k < 256; k += 3) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_remove(tree_map, &k));
+    TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, b_tree_map_remove(tree_map, &k));
+  }
+  check_avl(tree_map->root);
+  TEST_ASSERT_EQUAL_INT(256 - 86, tree_map->len);
+  int v;
+  for (k = 0; k < 256; k++) {
+    if (k % 3 == 0) {
+      TEST_ASSERT_FALSE(b_tree_map_contains_key(tree_map, &k));
+    } else {
+      TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_get(tree_map, &k, &v));
+      TEST_ASSERT_EQUAL_INT(-k, v);
+    }
+  }
+}
+
+void test_b_tree_map_remove_random() {
+  bool present[1024] = {false};
+  size_t len = 0;
+  srand(3);
+  for (int i = 0; i < 20000; i++) {
+    int k = rand() % 1024;
+    if (rand() % 2) {
+      len += !present[k];
+      present[k] = true;
+      b_tree_map_put(tree_map, &k, &k);
+    } else {
+      int status = b_tree_map_remove(tree_map, &k);
+      TEST_ASSERT_EQUAL_INT(present[k] ? EXIT_SUCCESS : EXIT_FAILURE, status);
+      len -= present[k];
+      present[k] = false;
+    }
+  }
+  check_avl(tree_map->root);
+  TEST_ASSERT_EQUAL_INT(len, tree_map->len);
+  for (int k = 0; k < 1024; k++) {
+    TEST_ASSERT_EQUAL_INT(present[k], b_tree_map_contains_key(tree_map, &k));
+  }
+}
+
+void test_b_tree_map_remove_paged() {
+  BTreeMap *paged = b_tree_map_new_paged(sizeof(int), sizeof(int), &compere);
+  for (int k = 0; k < 256; k++) {
+    b_tree_map_put(paged, &k, &k);
+  }
+  for (int k = 0; k < 256; k += 2) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_remove(paged, &k));
+  }
+  TEST_ASSERT_EQUAL_INT(128, paged->len);
+  for (int k = 0; k < 256; k++) {
+    TEST_ASSERT_EQUAL_INT(k % 2, b_tree_map_contains_key(paged, &k));
+  }
+  b_tree_map_free(paged);
+}
+
+void test_b_tree_map_from_sorted() {
+  int keys[100];
+  int values[100];
+  for (int i = 0; i < 100; i++) {
+    keys[i] = i;
+    values[i] = i * i;
+  }
+  BTreeMap *built = b_tree_map_from_sorted(sizeof(int), sizeof(int), &compere,
+                                           keys, values, 100);
+  TEST_ASSERT_EQUAL_INT(100, built->len);
+  TEST_ASSERT_EQUAL_INT(7, b_tree_map_height(built));
+  check_avl(built->root);
+  int v;
+  for (int k = 0; k < 100; k++) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_get(built, &k, &v));
+    TEST_ASSERT_EQUAL_INT(k * k, v);
+  }
+  int k = 100;
+  b_tree_map_put(built, &k, &k);
+  check_avl(built->root);
+  b_tree_map_free(built);
+
+  keys[50] = 49;
+  TEST_ASSERT_NULL(b_tree_map_from_sorted(sizeof(int), sizeof(int), &compere,
+                                          keys, values, 100));
+  built = b_tree_map_from_sorted(sizeof(int), sizeof(int), &compere, keys,
+                                 values, 0);
+  TEST_ASSERT_EQUAL_INT(0, built->len);
+  b_tree_map_free(built);
+}
+
+void test_b_tree_map_from_unsorted() {
+  int keys[100];
+  int values[100];
+  for (int i = 0; i < 100; i++) {
+    keys[i] = (i * 37) % 50;
+    values[i] = i;
+  }
+  BTreeMap *built = b_tree_map_from_unsorted(sizeof(int), sizeof(int),
+                                             &compere, keys, values, 100);
+  TEST_ASSERT_EQUAL_INT(50, built->len);
+  check_avl(built->root);
+  int v;
+  for (int k = 0; k < 50; k++) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_get(built, &k, &v));
+    // The key occurs at i and i + 50, the later value wins.
+    TEST_ASSERT_EQUAL_INT(k, (v * 37) % 50);
+    TEST_ASSERT(v >= 50);
+  }
+  b_tree_map_free(built);
+}
+
+/* Fills the map with the multiples of 3 below 300, then checks the ranks. */
+void check_order_statistics(BTreeMap *map) {
+  int k;
+  int v;
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, b_tree_map_select(map, 0, &k, &v));
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, b_tree_map_percentile(map, 50, &k, &v));
+  for (int i = 99; i >= 0; i--) {
+    k = 3 * i;
+    v = -i;
+    b_tree_map_put(map, &k, &v);
+  }
+  for (k = -1; k < 301; k++) {
+    TEST_ASSERT_EQUAL_INT(k < 0 ? 0 : (k + 2) / 3, b_tree_map_rank(map, &k));
+  }
+  for (size_t i = 0; i < 100; i++) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_select(map, i, &k, &v));
+    TEST_ASSERT_EQUAL_INT(3 * i, k);
+    TEST_ASSERT_EQUAL_INT(-(int)i, v);
+  }
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, b_tree_map_select(map, 100, &k, &v));
+
+  int lo = 10;
+  int hi = 31;
+  TEST_ASSERT_EQUAL_INT(7, b_tree_map_count_range(map, &lo, &hi));
+  TEST_ASSERT_EQUAL_INT(0, b_tree_map_count_range(map, &hi, &lo));
+
+  b_tree_map_percentile(map, 50, &k, NULL);
+  TEST_ASSERT_EQUAL_INT(147, k);
+  b_tree_map_percentile(map, 99, &k, NULL);
+  TEST_ASSERT_EQUAL_INT(294, k);
+  b_tree_map_percentile(map, 0, &k, NULL);
+  TEST_ASSERT_EQUAL_INT(0, k);
+  b_tree_map_percentile(map, 100, &k, NULL);
+  TEST_ASSERT_EQUAL_INT(297, k);
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE,
+                        b_tree_map_percentile(map, 101, &k, NULL));
+}
+
+void test_b_tree_map_order_statistics() {
+  check_order_statistics(tree_map);
+  check_avl(tree_map->root);
+  // Sizes stay correct when entries leave the tree.
+  for (int k = 0; k < 150; k += 3) {
+    b_tree_map_remove(tree_map, &k);
+  }
+  check_avl(tree_map->root);
+  int k = 150;
+  TEST_ASSERT_EQUAL_INT(0, b_tree_map_rank(tree_map, &k));
+}
+
+void test_b_tree_map_order_statistics_small() {
+  // All 100 entries stay in the array.
+  b_tree_map_set_small_limit(tree_map, 128);
+  check_order_statistics(tree_map);
+  TEST_ASSERT_NULL(tree_map->root);
+}
+
+void test_b_tree_map_small() {
+  int v;
+  for (int k = B_TREE_MAP_SMALL_LIMIT - 1; k >= 0; k--) {
+    v = -k;
+    b_tree_map_put(tree_map, &k, &v);
+    TEST_ASSERT_NULL(tree_map->root);
+  }
+  TEST_ASSERT_EQUAL_INT(1, b_tree_map_height(tree_map));
+  for (int k = 0; k < B_TREE_MAP_SMALL_LIMIT; k++) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_get(tree_map, &k, &v));
+    TEST_ASSERT_EQUAL_INT(-k, v);
+  }
+
+  // One more entry builds the tree, removing down to half the limit undoes it.
+  int k = B_TREE_MAP_SMALL_LIMIT;
+  b_tree_map_put(tree_map, &k, &k);
+  TEST_ASSERT_NOT_NULL(tree_map->root);
+  check_avl(tree_map->root);
+  for (k = 0; tree_map->len > B_TREE_MAP_SMALL_LIMIT / 2 + 1; k++) {
+    b_tree_map_remove(tree_map, &k);
+    TEST_ASSERT_NOT_NULL(tree_map->root);
+  }
+  b_tree_map_remove(tree_map, &k);
+  TEST_ASSERT_NULL(tree_map->root);
+  TEST_ASSERT_EQUAL_INT(B_TREE_MAP_SMALL_LIMIT / 2, tree_map->len);
+  for (k++; k < B_TREE_MAP_SMALL_LIMIT; k++) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_get(tree_map, &k, &v));
+    TEST_ASSERT_EQUAL_INT(-k, v);
+  }
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_get(tree_map, &k, &v));
+  TEST_ASSERT_EQUAL_INT(B_TREE_MAP_SMALL_LIMIT, v);
+
+  // A lower limit converts right away, a limit of 0 always keeps a tree.
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_set_small_limit(tree_map, 4));
+  TEST_ASSERT_NOT_NULL(tree_map->root);
+  check_avl(tree_map->root);
+  b_tree_map_clear(tree_map);
+  b_tree_map_set_small_limit(tree_map, 0);
+  b_tree_map_put(tree_map, &k, &k);
+  TEST_ASSERT_NOT_NULL(tree_map->root);
+}
+
+void test_b_tree_map_order_statistics_paged() {
+  BTreeMap *paged = b_tree_map_new_paged(sizeof(int), sizeof(int), &compere);
+  check_order_statistics(paged);
+  b_tree_map_free(paged);
+}
+
+void test_b_tree_map_order_statistics_arena() {
+  BTreeMap *arena = b_tree_map_new_arena(sizeof(int), sizeof(int), &compere);
+  check_order_statistics(arena);
+  b_tree_map_free(arena);
+}
+
+int range_sum;
+
+void sum_values(void *k, void *v) {
+  (void)k;
+  range_sum += *(int *)v;
+}
+
+/* Fills the map with the even keys below 64, then checks the ordered API. */
+void check_ordered(BTreeMap *map) {
+  int k;
+  int v;
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, b_tree_map_first(map, &k, &v));
+  for (k = 62; k >= 0; k -= 2) {
+    v = k * k;
+    b_tree_map_put(map, &k, &v);
+  }
+
+  BTreeMapIter iter;
+  void *pk;
+  void *pv;
+  int expected = 0;
+  b_tree_map_iter(map, &iter);
+  while (b_tree_map_iter_next(&iter, &pk, &pv)) {
+    TEST_ASSERT_EQUAL_INT(expected, *(int *)pk);
+    TEST_ASSERT_EQUAL_INT(expected * expected, *(int *)pv);
+    expected += 2;
+  }
+  TEST_ASSERT_EQUAL_INT(64, expected);
+
+  k = 31;
+  b_tree_map_iter_from(map, &iter, &k);
+  TEST_ASSERT(b_tree_map_iter_next(&iter, &pk, &pv));
+  TEST_ASSERT_EQUAL_INT(32, *(int *)pk);
+
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_first(map, &k, &v));
+  TEST_ASSERT_EQUAL_INT(0, k);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_last(map, &k, NULL));
+  TEST_ASSERT_EQUAL_INT(62, k);
+
+  int out;
+  k = 7;
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_floor(map, &k, &out, &v));
+  TEST_ASSERT_EQUAL_INT(6, out);
+  TEST_ASSERT_EQUAL_INT(36, v);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_ceiling(map, &k, &out, &v));
+  TEST_ASSERT_EQUAL_INT(8, out);
+  k = 8;
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_map_floor(map, &k, &out, NULL));
+  TEST_ASSERT_EQUAL_INT(8, out);
+  k = -1;
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, b_tree_map_floor(map, &k, &out, NULL));
+  k = 63;
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, b_tree_map_ceiling(map, &k, &out, NULL));
+
+  int lo = 3;
+  int hi = 10;
+  range_sum = 0;
+  b_tree_map_range(map, &lo, &hi, sum_values);
+  TEST_ASSERT_EQUAL_INT(16 + 36 + 64, range_sum);
+}
+
+void test_b_tree_map_ordered() { check_ordered(tree_map); }
+
+void test_b_tree_map_ordered_small() {
+  // The 32 entries fit the array, so the ordered API runs on the array.
+  b_tree_map_set_small_limit(tree_map, 64);
+  check_ordered(tree_map);
+  TEST_ASSERT_NULL(tree_map->root);
+}
+
+void test_b_tree_map_ordered_arena() {
+  BTreeMap *arena = b_tree_map_new_arena(sizeof(int), sizeof(int), &compere);
+  check_ordered(arena);
+  b_tree_map_free(arena);
+}
+
+void test_b_tree_map_ordered_paged() {
+  BTreeMap *paged = b_tree_map_new_paged(sizeof(int), sizeof(int), &compere);
+  check_ordered(paged);
+  b_tree_map_free(paged);
+}
+
 int main() {
   UNITY_BEGIN();
 
   RUN_TEST(test_b_tree_map_put);
   RUN_TEST(test_b_tree_map_contains);
   RUN_TEST(test_b_tree_map_get);
+  RUN_TEST(test_b_tree_map_get_many);
+  RUN_TEST(test_b_tree_map_get_many_paged);
+  RUN_TEST(test_b_tree_map_get_many_filtered);
+  RUN_TEST(test_b_tree_map_filter);
+  RUN_TEST(test_b_tree_map_filter_paged);
+  RUN_TEST(test_b_tree_map_entry_api);
+  RUN_TEST(test_b_tree_map_entry_api_paged);
+  RUN_TEST(test_b_tree_map_entry_api_arena);
   RUN_TEST(test_b_tree_map_put_unbalanced);
+  RUN_TEST(test_b_tree_map_inline_entries);
+  RUN_TEST(test_b_tree_map_u64_keys);
+  RUN_TEST(test_b_tree_map_scalar_keys);
+  RUN_TEST(test_b_tree_map_nan_keys);
+  RUN_TEST(test_b_tree_map_string_keys);
+  RUN_TEST(test_b_tree_map_paged);
+  RUN_TEST(test_b_tree_map_arena);
+  RUN_TEST(test_b_tree_map_ordered);
+  RUN_TEST(test_b_tree_map_ordered_paged);
+  RUN_TEST(test_b_tree_map_ordered_arena);
+  RUN_TEST(test_b_tree_map_ordered_small);
+  RUN_TEST(test_b_tree_map_small);
+  RUN_TEST(test_b_tree_map_remove);
+  RUN_TEST(test_b_tree_map_remove_random);
+  RUN_TEST(test_b_tree_map_remove_paged);
+  RUN_TEST(test_b_tree_map_from_sorted);
+  RUN_TEST(test_b_tree_map_from_unsorted);
+  RUN_TEST(test_b_tree_map_order_statistics);
+  RUN_TEST(test_b_tree_map_order_statistics_paged);
+  RUN_TEST(test_b_tree_map_order_statistics_arena);
+  RUN_TEST(test_b_tree_map_order_statistics_small);
 
   return UNITY_END();
 }
\ No newline at end of file
@@ -0,0 +1,143 @@
+#include <stdlib.h>
+#include <unity.h>
+
+#include "kiyo-collections/b_tree_multi_map.h"
+
+BTreeMultiMap *multi_map;
+
+int compere(void *left, void *right) { return *(int *)right - *(int *)left; }
+
+void setUp(void) {
+  multi_map = b_tree_multi_map_new(sizeof(int), sizeof(int), &compere);
+}
+
+void tearDown(void) { b_tree_multi_map_free(multi_map); }
+
+/* Validates heights, balance and values below the entry, returns its height. */
+size_t check_avl(MultiEntry *node) {
+  if (node == NULL)
+    return 0;
+  size_t left = check_avl(node->left);
+  size_t right = check_avl(node->right);
+  TEST_ASSERT(left <= right + 1 && right <= left + 1);
+  TEST_ASSERT_EQUAL_INT((left > right ? left : right) + 1, node->height);
+  TEST_ASSERT(node->count > 0 && node->count <= node->capacity);
+  size_t total = node->count;
+  total += node->left ? node->left->total : 0;
+  total += node->right ? node->right->total : 0;
+  TEST_ASSERT_EQUAL_INT(total, node->total);
+  return node->height;
+}
+
+void test_b_tree_multi_map_put() {
+  int k = 1;
+  for (int v = 0; v < 5; v++) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,
+                          b_tree_multi_map_put(multi_map, &k, &v));
+  }
+  k = 0;
+  int v = 42;
+  b_tree_multi_map_put(multi_map, &k, &v);
+  TEST_ASSERT_EQUAL_INT(6, b_tree_multi_map_len(multi_map));
+  TEST_ASSERT_EQUAL_INT(2, b_tree_multi_map_distinct_len(multi_map));
+
+  // The values of a key are one array in the order they were put.
+  k = 1;
+  size_t count;
+  int *values = b_tree_multi_map_get(multi_map, &k, &count);
+  TEST_ASSERT_EQUAL_INT(5, count);
+  for (int i = 0; i < 5; i++)
+    TEST_ASSERT_EQUAL_INT(i, values[i]);
+  k = 2;
+  TEST_ASSERT_NULL(b_tree_multi_map_get(multi_map, &k, &count));
+  TEST_ASSERT_EQUAL_INT(0, count);
+  TEST_ASSERT_FALSE(b_tree_multi_map_contains_key(multi_map, &k));
+
+  BTreeMultiMapIter iter;
+  void *key;
+  void *run;
+  b_tree_multi_map_iter(multi_map, &iter);
+  TEST_ASSERT_TRUE(b_tree_multi_map_iter_next(&iter, &key, &run, &count));
+  TEST_ASSERT_EQUAL_INT(0, *(int *)key);
+  TEST_ASSERT_EQUAL_INT(1, count);
+  TEST_ASSERT_EQUAL_INT(42, *(int *)run);
+  TEST_ASSERT_TRUE(b_tree_multi_map_iter_next(&iter, &key, &run, &count));
+  TEST_ASSERT_EQUAL_INT(1, *(int *)key);
+  TEST_ASSERT_EQUAL_INT(5, count);
+  TEST_ASSERT_FALSE(b_tree_multi_map_iter_next(&iter, &key, &run, &count));
+}
+
+void test_b_tree_multi_map_remove() {
+  int k = 3;
+  for (int v = 0; v < 4; v++)
+    b_tree_multi_map_put(multi_map, &k, &v);
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE,
+                        b_tree_multi_map_remove_at(multi_map, &k, 4));
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,
+                        b_tree_multi_map_remove_at(multi_map, &k, 1));
+  size_t count;
+  int *values = b_tree_multi_map_get(multi_map, &k, &count);
+  TEST_ASSERT_EQUAL_INT(3, count);
+  TEST_ASSERT_EQUAL_INT(0, values[0]);
+  TEST_ASSERT_EQUAL_INT(2, values[1]);
+  TEST_ASSERT_EQUAL_INT(3, values[2]);
+  for (int i = 0; i < 3; i++)
+    b_tree_multi_map_remove_at(multi_map, &k, 0);
+  TEST_ASSERT_FALSE(b_tree_multi_map_contains_key(multi_map, &k));
+  TEST_ASSERT_EQUAL_INT(0, b_tree_multi_map_len(multi_map));
+
+  b_tree_multi_map_put(multi_map, &k, &k);
+  b_tree_multi_map_put(multi_map, &k, &k);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_multi_map_remove(multi_map, &k));
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, b_tree_multi_map_remove(multi_map, &k));
+  TEST_ASSERT_EQUAL_INT(0, b_tree_multi_map_len(multi_map));
+  b_tree_multi_map_put(multi_map, &k, &k);
+  b_tree_multi_map_clear(multi_map);
+  TEST_ASSERT_EQUAL_INT(0, b_tree_multi_map_distinct_len(multi_map));
+}
+
+void test_b_tree_multi_map_random() {
+  // Key k holds the values k * 1000 + j for j below counts[k].
+  int counts[300] = {0};
+  srand(9);
+  for (int i = 0; i < 2000; i++) {
+    int k = rand() % 300;
+    int v = k * 1000 + counts[k]++;
+    b_tree_multi_map_put(multi_map, &k, &v);
+  }
+  for (int k = 0; k < 300; k += 3) {
+    if (counts[k] > 0)
+      b_tree_multi_map_remove(multi_map, &k);
+    counts[k] = 0;
+  }
+  check_avl(multi_map->root);
+
+  size_t len = 0;
+  for (int k = 0; k < 300; k++) {
+    size_t count;
+    int *values = b_tree_multi_map_get(multi_map, &k, &count);
+    TEST_ASSERT_EQUAL_INT(counts[k], count);
+    for (int j = 0; j < counts[k]; j++)
+      TEST_ASSERT_EQUAL_INT(k * 1000 + j, values[j]);
+    len += count;
+  }
+  TEST_ASSERT_EQUAL_INT(len, b_tree_multi_map_len(multi_map));
+
+  int lo = 100;
+  int hi = 200;
+  size_t expected = 0;
+  for (int k = lo; k < hi; k++)
+    expected += counts[k];
+  TEST_ASSERT_EQUAL_INT(expected,
+                        b_tree_multi_map_count_range(multi_map, &lo, &hi));
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_b_tree_multi_map_put);
+  RUN_TEST(test_b_tree_multi_map_remove);
+  RUN_TEST(test_b_tree_multi_map_random);
+
+  return UNITY_END();
+}
@@ -0,0 +1,136 @@
+#include <stdlib.h>
+#include <unity.h>
+
+#include "kiyo-collections/b_tree_multi_set.h"
+
+BTreeMultiSet *multi_set;
+
+int compere(void *left, void *right) { return *(int *)right - *(int *)left; }
+
+void setUp(void) { multi_set = b_tree_multi_set_new(sizeof(int), &compere); }
+
+void tearDown(void) { b_tree_multi_set_free(multi_set); }
+
+/* Validates heights, balance and copies below the node, returns its height. */
+size_t check_avl(MultiNode *node) {
+  if (node == NULL)
+    return 0;
+  size_t left = check_avl(node->left);
+  size_t right = check_avl(node->right);
+  TEST_ASSERT(left <= right + 1 && right <= left + 1);
+  TEST_ASSERT_EQUAL_INT((left > right ? left : right) + 1, node->height);
+  TEST_ASSERT(node->count > 0);
+  size_t total = node->count;
+  total += node->left ? node->left->total : 0;
+  total += node->right ? node->right->total : 0;
+  TEST_ASSERT_EQUAL_INT(total, node->total);
+  return node->height;
+}
+
+void test_b_tree_multi_set_add() {
+  int e = 7;
+  for (int i = 0; i < 3; i++)
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_multi_set_add(multi_set, &e));
+  e = 2;
+  b_tree_multi_set_add_count(multi_set, &e, 5);
+  b_tree_multi_set_add_count(multi_set, &e, 0);
+  TEST_ASSERT_EQUAL_INT(8, b_tree_multi_set_len(multi_set));
+  TEST_ASSERT_EQUAL_INT(2, b_tree_multi_set_distinct_len(multi_set));
+  TEST_ASSERT_EQUAL_INT(5, b_tree_multi_set_count(multi_set, &e));
+  e = 7;
+  TEST_ASSERT_EQUAL_INT(3, b_tree_multi_set_count(multi_set, &e));
+  e = 3;
+  TEST_ASSERT_EQUAL_INT(0, b_tree_multi_set_count(multi_set, &e));
+  TEST_ASSERT_FALSE(b_tree_multi_set_contains(multi_set, &e));
+
+  BTreeMultiSetIter iter;
+  void *element;
+  size_t count;
+  b_tree_multi_set_iter(multi_set, &iter);
+  TEST_ASSERT_TRUE(b_tree_multi_set_iter_next(&iter, &element, &count));
+  TEST_ASSERT_EQUAL_INT(2, *(int *)element);
+  TEST_ASSERT_EQUAL_INT(5, count);
+  TEST_ASSERT_TRUE(b_tree_multi_set_iter_next(&iter, &element, &count));
+  TEST_ASSERT_EQUAL_INT(7, *(int *)element);
+  TEST_ASSERT_EQUAL_INT(3, count);
+  TEST_ASSERT_FALSE(b_tree_multi_set_iter_next(&iter, &element, &count));
+}
+
+void test_b_tree_multi_set_remove() {
+  int e = 4;
+  b_tree_multi_set_add_count(multi_set, &e, 2);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_multi_set_remove(multi_set, &e));
+  TEST_ASSERT_EQUAL_INT(1, b_tree_multi_set_count(multi_set, &e));
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_multi_set_remove(multi_set, &e));
+  TEST_ASSERT_FALSE(b_tree_multi_set_contains(multi_set, &e));
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, b_tree_multi_set_remove(multi_set, &e));
+  TEST_ASSERT_EQUAL_INT(0, b_tree_multi_set_distinct_len(multi_set));
+
+  b_tree_multi_set_add_count(multi_set, &e, 6);
+  TEST_ASSERT_EQUAL_INT(6, b_tree_multi_set_remove_all(multi_set, &e));
+  TEST_ASSERT_EQUAL_INT(0, b_tree_multi_set_remove_all(multi_set, &e));
+  TEST_ASSERT_EQUAL_INT(0, b_tree_multi_set_len(multi_set));
+  b_tree_multi_set_add(multi_set, &e);
+  b_tree_multi_set_clear(multi_set);
+  TEST_ASSERT_EQUAL_INT(0, b_tree_multi_set_len(multi_set));
+  TEST_ASSERT_NULL(multi_set->root);
+}
+
+void test_b_tree_multi_set_order_statistics() {
+  // Element i is present i % 4 times.
+  int counts[200] = {0};
+  srand(3);
+  for (int i = 0; i < 200; i++) {
+    int e = rand() % 200;
+    int n = e % 4;
+    if (n > 0 && counts[e] == 0) {
+      b_tree_multi_set_add_count(multi_set, &e, (size_t)n);
+      counts[e] = n;
+    }
+  }
+  // Remove copies one by one from every fifth element.
+  for (int e = 0; e < 200; e += 5) {
+    while (counts[e] > 0) {
+      TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,
+                            b_tree_multi_set_remove(multi_set, &e));
+      counts[e]--;
+    }
+  }
+  check_avl(multi_set->root);
+
+  size_t below = 0;
+  for (int e = 0; e < 200; e++) {
+    TEST_ASSERT_EQUAL_INT(below, b_tree_multi_set_rank(multi_set, &e));
+    TEST_ASSERT_EQUAL_INT(counts[e], b_tree_multi_set_count(multi_set, &e));
+    for (int j = 0; j < counts[e]; j++) {
+      int selected = -1;
+      TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_multi_set_select(
+                                              multi_set, below + j, &selected));
+      TEST_ASSERT_EQUAL_INT(e, selected);
+    }
+    below += counts[e];
+  }
+  TEST_ASSERT_EQUAL_INT(below, b_tree_multi_set_len(multi_set));
+  int buffer;
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE,
+                        b_tree_multi_set_select(multi_set, below, &buffer));
+
+  int lo = 50;
+  int hi = 100;
+  size_t expected = 0;
+  for (int e = lo; e < hi; e++)
+    expected += counts[e];
+  TEST_ASSERT_EQUAL_INT(expected,
+                        b_tree_multi_set_count_range(multi_set, &lo, &hi));
+  TEST_ASSERT_EQUAL_INT(0, b_tree_multi_set_count_range(multi_set, &hi, &lo));
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_b_tree_multi_set_add);
+  RUN_TEST(test_b_tree_multi_set_remove);
+  RUN_TEST(test_b_tree_multi_set_order_statistics);
+
+  return UNITY_END();
+}
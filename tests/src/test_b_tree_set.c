@@ -34,11 +34,360 @@ void test_b_tree_set_contains() {
   TEST_ASSERT_FALSE(b_tree_set_contains(tree_set, &i));
 }
 
+void test_b_tree_set_paged() {
+  BTreeSet *paged = b_tree_set_new_paged(sizeof(int), &compere);
+  for (int i = 0; i < 1000; i += 2) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_set_add(paged, &i));
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_set_add(paged, &i));
+  }
+  TEST_ASSERT_EQUAL_INT(500, b_tree_set_len(paged));
+  for (int i = 0; i < 1000; i++) {
+    TEST_ASSERT_EQUAL_INT(i % 2 == 0, b_tree_set_contains(paged, &i));
+  }
+  b_tree_set_free(paged);
+}
+
+void test_b_tree_set_arena() {
+  BTreeSet *arena = b_tree_set_new_arena(sizeof(int), &compere);
+  for (int i = 0; i < 1000; i += 2) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_set_add(arena, &i));
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_set_add(arena, &i));
+  }
+  TEST_ASSERT_EQUAL_INT(500, b_tree_set_len(arena));
+  for (int i = 0; i < 1000; i += 4) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_set_remove(arena, &i));
+  }
+  TEST_ASSERT_EQUAL_INT(250, b_tree_set_len(arena));
+  for (int i = 0; i < 1000; i++) {
+    TEST_ASSERT_EQUAL_INT(i % 4 == 2, b_tree_set_contains(arena, &i));
+  }
+  b_tree_set_free(arena);
+}
+
+void test_b_tree_set_contains_many() {
+  int elements[1000];
+  bool found[1000];
+  for (int i = 0; i < 1000; i += 3) {
+    b_tree_set_add(tree_set, &i);
+  }
+  for (int i = 0; i < 1000; i++) {
+    elements[i] = (i * 7919) % 1000;
+  }
+  size_t hits = b_tree_set_contains_many(tree_set, elements, 1000, found);
+  TEST_ASSERT_EQUAL_INT(334, hits);
+  for (int i = 0; i < 1000; i++) {
+    TEST_ASSERT_EQUAL_INT(elements[i] % 3 == 0, found[i]);
+  }
+  TEST_ASSERT_EQUAL_INT(
+      334, b_tree_set_contains_many(tree_set, elements, 1000, NULL));
+}
+
+void test_b_tree_set_filter() {
+  int elements[1000];
+  bool found[1000];
+  for (int i = 0; i < 500; i += 3) {
+    b_tree_set_add(tree_set, &i);
+  }
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,
+                        b_tree_set_attach_filter(tree_set, NULL, 1000));
+  for (int i = 501; i < 1000; i += 3) {
+    b_tree_set_add(tree_set, &i);
+  }
+  for (int i = 0; i < 1000; i++) {
+    elements[i] = (i * 7919) % 1000;
+  }
+  size_t hits = b_tree_set_contains_many(tree_set, elements, 1000, found);
+  TEST_ASSERT_EQUAL_INT(334, hits);
+  for (int i = 0; i < 1000; i++) {
+    TEST_ASSERT_EQUAL_INT(elements[i] % 3 == 0, found[i]);
+    TEST_ASSERT_EQUAL_INT(elements[i] % 3 == 0,
+                          b_tree_set_contains(tree_set, &elements[i]));
+  }
+  TEST_ASSERT_EQUAL_INT(
+      334, b_tree_set_contains_many(tree_set, elements, 1000, NULL));
+  int e = 3;
+  b_tree_set_remove(tree_set, &e);
+  TEST_ASSERT_FALSE(b_tree_set_contains(tree_set, &e));
+  b_tree_set_detach_filter(tree_set);
+  TEST_ASSERT_NULL(tree_set->filter);
+}
+
+/* Validates heights, sizes and balance below the node, returns its height. */
+size_t check_avl(BinaryNode *node) {
+  if (node == NULL)
+    return 0;
+  size_t left = check_avl(node->left);
+  size_t right = check_avl(node->right);
+  TEST_ASSERT(left <= right + 1 && right <= left + 1);
+  TEST_ASSERT_EQUAL_INT((left > right ? left : right) + 1, node->height);
+  size_t size = 1;
+  size += node->left ? node->left->size : 0;
+  size += node->right ? node->right->size : 0;
+  TEST_ASSERT_EQUAL_INT(size, node->size);
+  return node->height;
+}
+
+void test_b_tree_set_remove() {
+  bool present[1024] = {false};
+  size_t len = 0;
+  srand(5);
+  for (int n = 0; n < 20000; n++) {
+    int i = rand() % 1024;
+    if (rand() % 2) {
+      len += !present[i];
+      present[i] = true;
+      b_tree_set_add(tree_set, &i);
+    } else {
+      int status = b_tree_set_remove(tree_set, &i);
+      TEST_ASSERT_EQUAL_INT(present[i] ? EXIT_SUCCESS : EXIT_FAILURE, status);
+      len -= present[i];
+      present[i] = false;
+    }
+  }
+  check_avl(tree_set->root);
+  TEST_ASSERT_EQUAL_INT(len, b_tree_set_len(tree_set));
+  for (int i = 0; i < 1024; i++) {
+    TEST_ASSERT_EQUAL_INT(present[i], b_tree_set_contains(tree_set, &i));
+  }
+  for (int i = 0; i < 1024; i++) {
+    b_tree_set_remove(tree_set, &i);
+  }
+  TEST_ASSERT_EQUAL_INT(0, b_tree_set_len(tree_set));
+  TEST_ASSERT_NULL(tree_set->root);
+}
+
+void test_b_tree_set_from_sorted() {
+  Vec *vec = vec_new(sizeof(int));
+  for (int i = 0; i < 100; i++) {
+    vec_push(vec, &i);
+  }
+  BTreeSet *built = b_tree_set_from_sorted(vec, &compere);
+  TEST_ASSERT_EQUAL_INT(100, b_tree_set_len(built));
+  TEST_ASSERT_EQUAL_INT(7, built->root->height);
+  check_avl(built->root);
+  for (int i = 0; i < 100; i++) {
+    TEST_ASSERT(b_tree_set_contains(built, &i));
+  }
+  b_tree_set_free(built);
+
+  vec_push(vec, &(int){99});
+  TEST_ASSERT_NULL(b_tree_set_from_sorted(vec, &compere));
+  vec_free(vec);
+}
+
+void test_b_tree_set_from_unsorted() {
+  Vec *vec = vec_new(sizeof(int));
+  for (int i = 0; i < 100; i++) {
+    int e = (i * 37) % 50;
+    vec_push(vec, &e);
+  }
+  BTreeSet *built = b_tree_set_from_unsorted(vec, &compere);
+  TEST_ASSERT_EQUAL_INT(50, b_tree_set_len(built));
+  check_avl(built->root);
+  for (int i = 0; i < 50; i++) {
+    TEST_ASSERT(b_tree_set_contains(built, &i));
+  }
+  int first;
+  vec_get(vec, 1, &first);
+  TEST_ASSERT_EQUAL_INT(37, first);
+  b_tree_set_free(built);
+  vec_free(vec);
+}
+
+void test_b_tree_set_order_statistics() {
+  Vec *vec = vec_new(sizeof(int));
+  for (int i = 0; i < 1000; i++) {
+    vec_push(vec, &i);
+  }
+  // Built sets and sets filled one by one both know their subtree sizes.
+  BTreeSet *built = b_tree_set_from_sorted(vec, &compere);
+  check_avl(built->root);
+  for (int i = 999; i >= 0; i--) {
+    b_tree_set_add(tree_set, &i);
+  }
+  BTreeSet *sets[] = {built, tree_set};
+  for (int s = 0; s < 2; s++) {
+    int e = 500;
+    TEST_ASSERT_EQUAL_INT(500, b_tree_set_rank(sets[s], &e));
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_set_select(sets[s], 123, &e));
+    TEST_ASSERT_EQUAL_INT(123, e);
+    b_tree_set_percentile(sets[s], 99, &e);
+    TEST_ASSERT_EQUAL_INT(989, e);
+    int lo = 100;
+    int hi = 200;
+    TEST_ASSERT_EQUAL_INT(100, b_tree_set_count_range(sets[s], &lo, &hi));
+  }
+  b_tree_set_free(built);
+  vec_free(vec);
+}
+
+int range_sum;
+
+void sum_elements(void *e) { range_sum += *(int *)e; }
+
+/* Fills the set with the even numbers below 64, then checks the ordered API. */
+void check_ordered(BTreeSet *set) {
+  int i;
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, b_tree_set_first(set, &i));
+  for (i = 62; i >= 0; i -= 2) {
+    b_tree_set_add(set, &i);
+  }
+
+  BTreeSetIter iter;
+  void *e;
+  int expected = 0;
+  b_tree_set_iter(set, &iter);
+  while (b_tree_set_iter_next(&iter, &e)) {
+    TEST_ASSERT_EQUAL_INT(expected, *(int *)e);
+    expected += 2;
+  }
+  TEST_ASSERT_EQUAL_INT(64, expected);
+
+  i = 31;
+  b_tree_set_iter_from(set, &iter, &i);
+  TEST_ASSERT(b_tree_set_iter_next(&iter, &e));
+  TEST_ASSERT_EQUAL_INT(32, *(int *)e);
+
+  int out;
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_set_first(set, &out));
+  TEST_ASSERT_EQUAL_INT(0, out);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_set_last(set, &out));
+  TEST_ASSERT_EQUAL_INT(62, out);
+  i = 7;
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_set_floor(set, &i, &out));
+  TEST_ASSERT_EQUAL_INT(6, out);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_set_ceiling(set, &i, &out));
+  TEST_ASSERT_EQUAL_INT(8, out);
+  i = -1;
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, b_tree_set_floor(set, &i, &out));
+  i = 63;
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, b_tree_set_ceiling(set, &i, &out));
+
+  int lo = 3;
+  int hi = 10;
+  range_sum = 0;
+  b_tree_set_range(set, &lo, &hi, sum_elements);
+  TEST_ASSERT_EQUAL_INT(4 + 6 + 8, range_sum);
+}
+
+void test_b_tree_set_ordered() { check_ordered(tree_set); }
+
+void test_b_tree_set_ordered_small() {
+  b_tree_set_set_small_limit(tree_set, 64);
+  check_ordered(tree_set);
+  TEST_ASSERT_NULL(tree_set->root);
+}
+
+void test_b_tree_set_small() {
+  for (int i = B_TREE_SET_SMALL_LIMIT - 1; i >= 0; i--) {
+    b_tree_set_add(tree_set, &i);
+    b_tree_set_add(tree_set, &i);
+    TEST_ASSERT_NULL(tree_set->root);
+  }
+  TEST_ASSERT_EQUAL_INT(B_TREE_SET_SMALL_LIMIT, b_tree_set_len(tree_set));
+  int i = B_TREE_SET_SMALL_LIMIT;
+  b_tree_set_add(tree_set, &i);
+  TEST_ASSERT_NOT_NULL(tree_set->root);
+  check_avl(tree_set->root);
+  for (i = 0; i <= B_TREE_SET_SMALL_LIMIT / 2; i++) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_set_remove(tree_set, &i));
+  }
+  TEST_ASSERT_NULL(tree_set->root);
+  TEST_ASSERT_EQUAL_INT(B_TREE_SET_SMALL_LIMIT / 2, b_tree_set_len(tree_set));
+  for (i = 0; i <= B_TREE_SET_SMALL_LIMIT; i++) {
+    TEST_ASSERT_EQUAL_INT(i > B_TREE_SET_SMALL_LIMIT / 2,
+                          b_tree_set_contains(tree_set, &i));
+  }
+  int out;
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, b_tree_set_select(tree_set, 0, &out));
+  TEST_ASSERT_EQUAL_INT(B_TREE_SET_SMALL_LIMIT / 2 + 1, out);
+}
+
+void test_b_tree_set_ordered_arena() {
+  BTreeSet *arena = b_tree_set_new_arena(sizeof(int), &compere);
+  check_ordered(arena);
+  b_tree_set_free(arena);
+}
+
+void test_b_tree_set_ordered_paged() {
+  BTreeSet *paged = b_tree_set_new_paged(sizeof(int), &compere);
+  check_ordered(paged);
+  b_tree_set_free(paged);
+}
+
+void test_b_tree_set_algebra() {
+  // Multiples of 2 in the AVL set, multiples of 3 in a paged set.
+  BTreeSet *threes = b_tree_set_new_paged(sizeof(int), &compere);
+  for (int i = 0; i < 60; i++) {
+    if (i % 2 == 0)
+      b_tree_set_add(tree_set, &i);
+    if (i % 3 == 0)
+      b_tree_set_add(threes, &i);
+  }
+
+  BTreeSet *united = b_tree_set_union(tree_set, threes);
+  BTreeSet *shared = b_tree_set_intersection(tree_set, threes);
+  BTreeSet *only = b_tree_set_difference(tree_set, threes);
+  BTreeSet *either = b_tree_set_symmetric_difference(tree_set, threes);
+  TEST_ASSERT_EQUAL_INT(40, b_tree_set_len(united));
+  TEST_ASSERT_EQUAL_INT(10, b_tree_set_len(shared));
+  TEST_ASSERT_EQUAL_INT(20, b_tree_set_len(only));
+  TEST_ASSERT_EQUAL_INT(30, b_tree_set_len(either));
+  for (int i = 0; i < 60; i++) {
+    bool two = i % 2 == 0;
+    bool three = i % 3 == 0;
+    TEST_ASSERT_EQUAL_INT(two || three, b_tree_set_contains(united, &i));
+    TEST_ASSERT_EQUAL_INT(two && three, b_tree_set_contains(shared, &i));
+    TEST_ASSERT_EQUAL_INT(two && !three, b_tree_set_contains(only, &i));
+    TEST_ASSERT_EQUAL_INT(two != three, b_tree_set_contains(either, &i));
+  }
+  check_avl(united->root);
+
+  TEST_ASSERT(b_tree_set_is_subset(shared, tree_set));
+  TEST_ASSERT(b_tree_set_is_subset(shared, threes));
+  TEST_ASSERT(b_tree_set_is_subset(tree_set, united));
+  TEST_ASSERT_FALSE(b_tree_set_is_subset(tree_set, threes));
+  TEST_ASSERT_FALSE(b_tree_set_is_subset(only, shared));
+  TEST_ASSERT(b_tree_set_is_disjoint(only, threes));
+  TEST_ASSERT(b_tree_set_is_disjoint(only, shared));
+  TEST_ASSERT_FALSE(b_tree_set_is_disjoint(tree_set, threes));
+
+  Vec *merged = vec_new(sizeof(int));
+  b_tree_set_merge(threes, tree_set, B_TREE_SET_DIFFERENCE, merged);
+  TEST_ASSERT_EQUAL_INT(10, merged->len);
+  int e;
+  for (size_t i = 0; i < merged->len; i++) {
+    vec_get(merged, i, &e);
+    TEST_ASSERT_EQUAL_INT(6 * i + 3, e);
+  }
+  vec_free(merged);
+
+  b_tree_set_free(united);
+  b_tree_set_free(shared);
+  b_tree_set_free(only);
+  b_tree_set_free(either);
+  b_tree_set_free(threes);
+}
+
 int main() {
   UNITY_BEGIN();
 
   RUN_TEST(test_b_tree_set_add);
   RUN_TEST(test_b_tree_set_contains);
+  RUN_TEST(test_b_tree_set_contains_many);
+  RUN_TEST(test_b_tree_set_filter);
+  RUN_TEST(test_b_tree_set_paged);
+  RUN_TEST(test_b_tree_set_arena);
+  RUN_TEST(test_b_tree_set_ordered);
+  RUN_TEST(test_b_tree_set_ordered_small);
+  RUN_TEST(test_b_tree_set_small);
+  RUN_TEST(test_b_tree_set_ordered_paged);
+  RUN_TEST(test_b_tree_set_ordered_arena);
+  RUN_TEST(test_b_tree_set_remove);
+  RUN_TEST(test_b_tree_set_from_sorted);
+  RUN_TEST(test_b_tree_set_from_unsorted);
+  RUN_TEST(test_b_tree_set_algebra);
+  RUN_TEST(test_b_tree_set_order_statistics);
 
   return UNITY_END();
 }
\ No newline at end of file
@@ -0,0 +1,59 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <unity.h>
+
+#include "kiyo-collections/bloom_filter.h"
+#include "kiyo-collections/hash.h"
+
+BloomFilter *filter;
+
+void setUp(void) { filter = bloom_filter_new(sizeof(int), NULL, 10000); }
+
+void tearDown(void) { bloom_filter_free(filter); }
+
+void test_bloom_filter_add() {
+  for (int i = 0; i < 10000; i++)
+    bloom_filter_add(filter, &i);
+  TEST_ASSERT_EQUAL_INT(10000, bloom_filter_len(filter));
+  // There are no false negatives.
+  for (int i = 0; i < 10000; i++)
+    TEST_ASSERT_TRUE(bloom_filter_contains(filter, &i));
+
+  bloom_filter_clear(filter);
+  TEST_ASSERT_EQUAL_INT(0, bloom_filter_len(filter));
+  int missing = 0;
+  for (int i = 0; i < 10000; i++)
+    missing += !bloom_filter_contains(filter, &i);
+  TEST_ASSERT_EQUAL_INT(10000, missing);
+}
+
+void test_bloom_filter_false_positives() {
+  for (int i = 0; i < 10000; i++)
+    bloom_filter_add(filter, &i);
+  int false_positives = 0;
+  for (int i = 10000; i < 110000; i++)
+    false_positives += bloom_filter_contains(filter, &i);
+  // At most about 0.1% of 100000 elements, allow some slack.
+  TEST_ASSERT(false_positives < 500);
+}
+
+void test_bloom_filter_hasher() {
+  BloomFilter *hashed = bloom_filter_new(sizeof(uint64_t), hash_u64, 0);
+  TEST_ASSERT_EQUAL_INT(1, hashed->block_count);
+  uint64_t e = 42;
+  TEST_ASSERT_FALSE(bloom_filter_contains(hashed, &e));
+  bloom_filter_add(hashed, &e);
+  TEST_ASSERT_TRUE(bloom_filter_contains(hashed, &e));
+  TEST_ASSERT_TRUE(bloom_filter_contains_hash(hashed, hash_u64(&e)));
+  bloom_filter_free(hashed);
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_bloom_filter_add);
+  RUN_TEST(test_bloom_filter_false_positives);
+  RUN_TEST(test_bloom_filter_hasher);
+
+  return UNITY_END();
+}
@@ -0,0 +1,121 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unity.h>
+
+#include "kiyo-collections/concurrent_map.h"
+#include "kiyo-collections/hash.h"
+
+#define THREADS 8
+#define KEYS_PER_THREAD 2000
+
+ConcurrentMap *map;
+
+int compere(void *left, void *right) { return *(int *)right - *(int *)left; }
+
+void setUp(void) {
+  map = concurrent_map_new(sizeof(int), sizeof(int), &hash_int, &compere, 0);
+}
+
+void tearDown(void) { concurrent_map_free(map); }
+
+void test_concurrent_map_put_get() {
+  TEST_ASSERT_EQUAL_INT(CONCURRENT_MAP_DEFAULT_SHARDS, map->shard_count);
+  for (int k = 0; k < 1000; k++) {
+    int v = k * k;
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, concurrent_map_put(map, &k, &v));
+  }
+  TEST_ASSERT_EQUAL_INT(1000, concurrent_map_len(map));
+  int v;
+  for (int k = 0; k < 1000; k++) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, concurrent_map_get(map, &k, &v));
+    TEST_ASSERT_EQUAL_INT(k * k, v);
+  }
+  for (int k = 0; k < 1000; k += 2) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, concurrent_map_remove(map, &k));
+  }
+  for (int k = 0; k < 1000; k++) {
+    TEST_ASSERT_EQUAL_INT(k % 2, concurrent_map_contains_key(map, &k));
+  }
+  TEST_ASSERT_EQUAL_INT(500, concurrent_map_len(map));
+}
+
+int factory_calls;
+
+void square(void *k, void *v) {
+  // Only ever called with the shard locked, so the counter needs no atomics
+  // as long as all keys land in one shard.
+  factory_calls++;
+  *(int *)v = *(int *)k * *(int *)k;
+}
+
+void test_concurrent_map_compute_if_absent() {
+  ConcurrentMap *single =
+      concurrent_map_new(sizeof(int), sizeof(int), &hash_int, &compere, 1);
+  factory_calls = 0;
+  int k = 12;
+  int v = 0;
+  int status = concurrent_map_compute_if_absent(single, &k, square, &v);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, status);
+  TEST_ASSERT_EQUAL_INT(144, v);
+  v = 0;
+  concurrent_map_compute_if_absent(single, &k, square, &v);
+  TEST_ASSERT_EQUAL_INT(144, v);
+  TEST_ASSERT_EQUAL_INT(1, factory_calls);
+  concurrent_map_free(single);
+}
+
+void *writer(void *arg) {
+  int offset = *(int *)arg * KEYS_PER_THREAD;
+  for (int k = offset; k < offset + KEYS_PER_THREAD; k++) {
+    concurrent_map_put(map, &k, &k);
+  }
+  for (int k = offset; k < offset + KEYS_PER_THREAD; k += 2) {
+    concurrent_map_remove(map, &k);
+  }
+  return NULL;
+}
+
+void *reader(void *arg) {
+  (void)arg;
+  int v;
+  // Every value that is visible at all must be complete.
+  for (int k = 0; k < THREADS * KEYS_PER_THREAD; k++) {
+    if (concurrent_map_get(map, &k, &v) == EXIT_SUCCESS && v != k)
+      return arg;
+  }
+  return NULL;
+}
+
+void test_concurrent_map_threads() {
+  pthread_t writers[THREADS];
+  pthread_t readers[THREADS];
+  int ids[THREADS];
+  for (int i = 0; i < THREADS; i++) {
+    ids[i] = i;
+    pthread_create(&writers[i], NULL, writer, &ids[i]);
+    pthread_create(&readers[i], NULL, reader, &ids[i]);
+  }
+  for (int i = 0; i < THREADS; i++) {
+    void *result;
+    pthread_join(writers[i], NULL);
+    pthread_join(readers[i], &result);
+    TEST_ASSERT_NULL(result);
+  }
+  TEST_ASSERT_EQUAL_INT(THREADS * KEYS_PER_THREAD / 2,
+                        concurrent_map_len(map));
+  for (int k = 0; k < THREADS * KEYS_PER_THREAD; k++) {
+    TEST_ASSERT_EQUAL_INT(k % 2, concurrent_map_contains_key(map, &k));
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_concurrent_map_put_get);
+  RUN_TEST(test_concurrent_map_compute_if_absent);
+  RUN_TEST(test_concurrent_map_threads);
+
+  return UNITY_END();
+}
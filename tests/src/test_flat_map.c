@@ -0,0 +1,194 @@
+#include <stdlib.h>
+#include <unity.h>
+
+#include "kiyo-collections/flat_map.h"
+
+FlatMap *flat_map;
+
+int compere(void *left, void *right) { return *(int *)right - *(int *)left; }
+
+void setUp(void) {
+  flat_map = flat_map_new(sizeof(int), sizeof(int), &compere);
+}
+
+void tearDown(void) { flat_map_free(flat_map); }
+
+void test_flat_map_put() {
+  TEST_ASSERT_EQUAL_INT(0, flat_map_len(flat_map));
+  for (int i = 0; i < 100; i++) {
+    int k = (i * 37) % 100;
+    int v = k * k;
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, flat_map_put(flat_map, &k, &v));
+  }
+  TEST_ASSERT_EQUAL_INT(100, flat_map_len(flat_map));
+  int k = 5;
+  int v = -5;
+  flat_map_put(flat_map, &k, &v);
+  TEST_ASSERT_EQUAL_INT(100, flat_map_len(flat_map));
+
+  for (k = 0; k < 100; k++) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, flat_map_get(flat_map, &k, &v));
+    TEST_ASSERT_EQUAL_INT(k == 5 ? -5 : k * k, v);
+  }
+  k = 100;
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, flat_map_get(flat_map, &k, &v));
+  TEST_ASSERT_FALSE(flat_map_contains_key(flat_map, &k));
+  TEST_ASSERT_NULL(flat_map_get_ptr(flat_map, &k));
+  k = 7;
+  *(int *)flat_map_get_ptr(flat_map, &k) = 0;
+  flat_map_get(flat_map, &k, &v);
+  TEST_ASSERT_EQUAL_INT(0, v);
+
+  // The keys are stored contiguously in ascending order.
+  int *keys = flat_map->keys.data;
+  for (int i = 0; i < 100; i++) {
+    TEST_ASSERT_EQUAL_INT(i, keys[i]);
+  }
+}
+
+void test_flat_map_remove() {
+  int k = 0;
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, flat_map_remove(flat_map, &k));
+  for (k = 0; k < 256; k++) {
+    int v = -k;
+    flat_map_put(flat_map, &k, &v);
+  }
+  for (k = 0; k < 256; k += 3) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, flat_map_remove(flat_map, &k));
+    TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, flat_map_remove(flat_map, &k));
+  }
+  TEST_ASSERT_EQUAL_INT(256 - 86, flat_map_len(flat_map));
+  int v;
+  for (k = 0; k < 256; k++) {
+    if (k % 3 == 0) {
+      TEST_ASSERT_FALSE(flat_map_contains_key(flat_map, &k));
+    } else {
+      TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, flat_map_get(flat_map, &k, &v));
+      TEST_ASSERT_EQUAL_INT(-k, v);
+    }
+  }
+  flat_map_clear(flat_map);
+  TEST_ASSERT_EQUAL_INT(0, flat_map_len(flat_map));
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, flat_map_first(flat_map, &k, &v));
+}
+
+void test_flat_map_buffer() {
+  for (int k = 0; k < 100; k += 2) {
+    flat_map_put(flat_map, &k, &k);
+  }
+  // Buffer the odd keys in descending order and overwrite some even ones,
+  // twice, the later value has to win.
+  for (int k = 199; k >= 0; k -= 2) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, flat_map_buffer(flat_map, &k, &k));
+  }
+  for (int k = 0; k < 20; k += 4) {
+    int v = -1;
+    flat_map_buffer(flat_map, &k, &v);
+    v = -k;
+    flat_map_buffer(flat_map, &k, &v);
+  }
+  int k = 1;
+  TEST_ASSERT_FALSE(flat_map_contains_key(flat_map, &k));
+  TEST_ASSERT_EQUAL_INT(50, flat_map_len(flat_map));
+
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, flat_map_flush(flat_map));
+  TEST_ASSERT_EQUAL_INT(150, flat_map_len(flat_map));
+  int v;
+  for (k = 0; k < 200; k++) {
+    int expected = k < 20 && k % 4 == 0 ? -k : k;
+    if (k >= 100 && k % 2 == 0) {
+      TEST_ASSERT_FALSE(flat_map_contains_key(flat_map, &k));
+      continue;
+    }
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, flat_map_get(flat_map, &k, &v));
+    TEST_ASSERT_EQUAL_INT(expected, v);
+  }
+  int *keys = flat_map->keys.data;
+  for (size_t i = 1; i < flat_map_len(flat_map); i++) {
+    TEST_ASSERT(keys[i - 1] < keys[i]);
+  }
+
+  // A put merges what is still buffered before it.
+  k = 500;
+  flat_map_buffer(flat_map, &k, &k);
+  k = 501;
+  flat_map_put(flat_map, &k, &k);
+  TEST_ASSERT_EQUAL_INT(152, flat_map_len(flat_map));
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, flat_map_last(flat_map, &k, NULL));
+  TEST_ASSERT_EQUAL_INT(501, k);
+}
+
+void test_flat_map_ordered() {
+  int k;
+  int v;
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, flat_map_first(flat_map, &k, &v));
+  for (k = 62; k >= 0; k -= 2) {
+    v = k * k;
+    flat_map_buffer(flat_map, &k, &v);
+  }
+  flat_map_flush(flat_map);
+
+  FlatMapIter iter;
+  void *pk;
+  void *pv;
+  int expected = 0;
+  flat_map_iter(flat_map, &iter);
+  while (flat_map_iter_next(&iter, &pk, &pv)) {
+    TEST_ASSERT_EQUAL_INT(expected, *(int *)pk);
+    TEST_ASSERT_EQUAL_INT(expected * expected, *(int *)pv);
+    expected += 2;
+  }
+  TEST_ASSERT_EQUAL_INT(64, expected);
+  k = 31;
+  flat_map_iter_from(flat_map, &iter, &k);
+  TEST_ASSERT(flat_map_iter_next(&iter, &pk, &pv));
+  TEST_ASSERT_EQUAL_INT(32, *(int *)pk);
+
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, flat_map_first(flat_map, &k, &v));
+  TEST_ASSERT_EQUAL_INT(0, k);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, flat_map_last(flat_map, &k, NULL));
+  TEST_ASSERT_EQUAL_INT(62, k);
+  int out;
+  k = 7;
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, flat_map_floor(flat_map, &k, &out, &v));
+  TEST_ASSERT_EQUAL_INT(6, out);
+  TEST_ASSERT_EQUAL_INT(36, v);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,
+                        flat_map_ceiling(flat_map, &k, &out, &v));
+  TEST_ASSERT_EQUAL_INT(8, out);
+  k = -1;
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, flat_map_floor(flat_map, &k, &out, NULL));
+  k = 63;
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE,
+                        flat_map_ceiling(flat_map, &k, &out, NULL));
+
+  int lo = 3;
+  int hi = 10;
+  int *keys;
+  int *values;
+  size_t n =
+      flat_map_range(flat_map, &lo, &hi, (void **)&keys, (void **)&values);
+  TEST_ASSERT_EQUAL_INT(3, n);
+  for (size_t i = 0; i < n; i++) {
+    TEST_ASSERT_EQUAL_INT(4 + 2 * i, keys[i]);
+    TEST_ASSERT_EQUAL_INT(keys[i] * keys[i], values[i]);
+  }
+  TEST_ASSERT_EQUAL_INT(0, flat_map_range(flat_map, &hi, &lo, NULL, NULL));
+
+  k = 11;
+  TEST_ASSERT_EQUAL_INT(6, flat_map_rank(flat_map, &k));
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, flat_map_select(flat_map, 6, &k, &v));
+  TEST_ASSERT_EQUAL_INT(12, k);
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, flat_map_select(flat_map, 32, &k, &v));
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_flat_map_put);
+  RUN_TEST(test_flat_map_remove);
+  RUN_TEST(test_flat_map_buffer);
+  RUN_TEST(test_flat_map_ordered);
+
+  return UNITY_END();
+}
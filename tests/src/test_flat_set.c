@@ -0,0 +1,105 @@
+#include <stdlib.h>
+#include <unity.h>
+
+#include "kiyo-collections/flat_set.h"
+
+FlatSet *flat_set;
+
+int compere(void *left, void *right) { return *(int *)right - *(int *)left; }
+
+void setUp(void) { flat_set = flat_set_new(sizeof(int), &compere); }
+
+void tearDown(void) { flat_set_free(flat_set); }
+
+void test_flat_set_add() {
+  for (int i = 0; i < 1000; i += 2) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, flat_set_add(flat_set, &i));
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, flat_set_add(flat_set, &i));
+  }
+  TEST_ASSERT_EQUAL_INT(500, flat_set_len(flat_set));
+  for (int i = 0; i < 1000; i += 4) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, flat_set_remove(flat_set, &i));
+  }
+  TEST_ASSERT_EQUAL_INT(250, flat_set_len(flat_set));
+  for (int i = 0; i < 1000; i++) {
+    TEST_ASSERT_EQUAL_INT(i % 4 == 2, flat_set_contains(flat_set, &i));
+  }
+}
+
+void test_flat_set_buffer() {
+  srand(7);
+  bool present[1000] = {false};
+  size_t len = 0;
+  for (int round = 0; round < 10; round++) {
+    for (int n = 0; n < 300; n++) {
+      int i = rand() % 1000;
+      len += !present[i];
+      present[i] = true;
+      TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, flat_set_buffer(flat_set, &i));
+    }
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, flat_set_flush(flat_set));
+    TEST_ASSERT_EQUAL_INT(len, flat_set_len(flat_set));
+  }
+  for (int i = 0; i < 1000; i++) {
+    TEST_ASSERT_EQUAL_INT(present[i], flat_set_contains(flat_set, &i));
+  }
+
+  FlatSetIter iter;
+  void *e;
+  int previous = -1;
+  size_t visited = 0;
+  flat_set_iter(flat_set, &iter);
+  while (flat_set_iter_next(&iter, &e)) {
+    TEST_ASSERT(previous < *(int *)e);
+    previous = *(int *)e;
+    visited++;
+  }
+  TEST_ASSERT_EQUAL_INT(len, visited);
+}
+
+void test_flat_set_ordered() {
+  int out;
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, flat_set_first(flat_set, &out));
+  for (int i = 62; i >= 0; i -= 2) {
+    flat_set_buffer(flat_set, &i);
+  }
+  flat_set_flush(flat_set);
+
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, flat_set_first(flat_set, &out));
+  TEST_ASSERT_EQUAL_INT(0, out);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, flat_set_last(flat_set, &out));
+  TEST_ASSERT_EQUAL_INT(62, out);
+  int i = 7;
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, flat_set_floor(flat_set, &i, &out));
+  TEST_ASSERT_EQUAL_INT(6, out);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, flat_set_ceiling(flat_set, &i, &out));
+  TEST_ASSERT_EQUAL_INT(8, out);
+  TEST_ASSERT_EQUAL_INT(4, flat_set_rank(flat_set, &i));
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, flat_set_select(flat_set, 4, &out));
+  TEST_ASSERT_EQUAL_INT(8, out);
+
+  FlatSetIter iter;
+  void *e;
+  flat_set_iter_from(flat_set, &iter, &i);
+  TEST_ASSERT(flat_set_iter_next(&iter, &e));
+  TEST_ASSERT_EQUAL_INT(8, *(int *)e);
+
+  int lo = 10;
+  int hi = 31;
+  int *elements;
+  size_t n = flat_set_range(flat_set, &lo, &hi, (void **)&elements);
+  TEST_ASSERT_EQUAL_INT(11, n);
+  for (size_t j = 0; j < n; j++) {
+    TEST_ASSERT_EQUAL_INT(10 + 2 * j, elements[j]);
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_flat_set_add);
+  RUN_TEST(test_flat_set_buffer);
+  RUN_TEST(test_flat_set_ordered);
+
+  return UNITY_END();
+}
@@ -0,0 +1,122 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+
+#include "kiyo-collections/frozen_map.h"
+
+BTreeMap *tree_map;
+
+int compere(void *left, void *right) { return *(int *)right - *(int *)left; }
+
+void setUp(void) {
+  tree_map = b_tree_map_new(sizeof(int), sizeof(int), &compere);
+}
+
+void tearDown(void) { b_tree_map_free(tree_map); }
+
+/* Checks every lookup of a frozen copy of the even keys below 2 * n. */
+void check_frozen(FrozenMap *frozen, int n) {
+  TEST_ASSERT_EQUAL_INT(n, frozen_map_len(frozen));
+  int k;
+  int v;
+  for (int i = -1; i <= 2 * n; i++) {
+    TEST_ASSERT_EQUAL_INT(i >= 0 && i % 2 == 0 && i < 2 * n,
+                          frozen_map_contains_key(frozen, &i));
+    int status = frozen_map_lower_bound(frozen, &i, &k, &v);
+    if (i < 2 * n - 1) {
+      TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, status);
+      int expected = i < 0 ? 0 : (i + 1) / 2 * 2;
+      TEST_ASSERT_EQUAL_INT(expected, k);
+      TEST_ASSERT_EQUAL_INT(expected * 10, v);
+    } else {
+      TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, status);
+    }
+  }
+}
+
+void test_frozen_map_sizes() {
+  // Every size up to a few full levels, to hit all shapes of the last level.
+  for (int n = 0; n < 70; n++) {
+    if (n > 0) {
+      int k = 2 * (n - 1);
+      int v = k * 10;
+      b_tree_map_put(tree_map, &k, &v);
+    }
+    FrozenMap *frozen = b_tree_map_freeze(tree_map);
+    TEST_ASSERT_NOT_NULL(frozen);
+    check_frozen(frozen, n);
+    frozen_map_free(frozen);
+  }
+}
+
+void test_frozen_map_get() {
+  BTreeMap *paged = b_tree_map_new_paged(sizeof(int), sizeof(int), &compere);
+  for (int k = 0; k < 2000; k += 2) {
+    int v = k * 10;
+    b_tree_map_put(paged, &k, &v);
+  }
+  FrozenMap *frozen = b_tree_map_freeze(paged);
+  b_tree_map_free(paged);
+  int v;
+  for (int k = 0; k < 2000; k++) {
+    int status = frozen_map_get(frozen, &k, &v);
+    TEST_ASSERT_EQUAL_INT(k % 2 == 0 ? EXIT_SUCCESS : EXIT_FAILURE, status);
+    if (k % 2 == 0)
+      TEST_ASSERT_EQUAL_INT(k * 10, v);
+  }
+  frozen_map_free(frozen);
+}
+
+void test_frozen_map_view() {
+  for (int k = 0; k < 200; k += 2) {
+    int v = k * 10;
+    b_tree_map_put(tree_map, &k, &v);
+  }
+  FrozenMap *frozen = b_tree_map_freeze(tree_map);
+  // A copy at another address stands in for a file that is mapped back in.
+  size_t size = frozen_map_size(frozen);
+  void *copy = malloc(size);
+  memcpy(copy, frozen_map_data(frozen), size);
+  frozen_map_free(frozen);
+
+  TEST_ASSERT_NULL(frozen_map_view(copy, size - 1, &compere));
+  FrozenMap *view = frozen_map_view(copy, size, &compere);
+  TEST_ASSERT_NOT_NULL(view);
+  check_frozen(view, 100);
+  frozen_map_free(view);
+
+  memset(copy, 0, 8);
+  TEST_ASSERT_NULL(frozen_map_view(copy, size, &compere));
+  free(copy);
+}
+
+void test_frozen_map_typed_keys() {
+  BTreeMap *numbers = b_tree_map_new_u64(sizeof(int));
+  for (uint64_t k = 0; k < 100; k++) {
+    int v = (int)k;
+    b_tree_map_put(numbers, &k, &v);
+  }
+  FrozenMap *frozen = b_tree_map_freeze(numbers);
+  uint64_t k = 77;
+  int v;
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, frozen_map_get(frozen, &k, &v));
+  TEST_ASSERT_EQUAL_INT(77, v);
+  frozen_map_free(frozen);
+  b_tree_map_free(numbers);
+
+  // Byte string keys have no comperator the frozen map could search with.
+  BTreeMap *bytes = b_tree_map_new_bytes(3, sizeof(int));
+  TEST_ASSERT_NULL(b_tree_map_freeze(bytes));
+  b_tree_map_free(bytes);
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_frozen_map_sizes);
+  RUN_TEST(test_frozen_map_get);
+  RUN_TEST(test_frozen_map_view);
+  RUN_TEST(test_frozen_map_typed_keys);
+
+  return UNITY_END();
+}
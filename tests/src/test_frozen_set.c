@@ -0,0 +1,58 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+
+#include "kiyo-collections/frozen_set.h"
+
+BTreeSet *tree_set;
+
+int compere(void *left, void *right) { return *(int *)right - *(int *)left; }
+
+void setUp(void) { tree_set = b_tree_set_new(sizeof(int), &compere); }
+
+void tearDown(void) { b_tree_set_free(tree_set); }
+
+void test_frozen_set_contains() {
+  for (int e = 0; e < 1000; e += 3) {
+    b_tree_set_add(tree_set, &e);
+  }
+  FrozenSet *frozen = b_tree_set_freeze(tree_set);
+  TEST_ASSERT_EQUAL_INT(334, frozen_set_len(frozen));
+  int out;
+  for (int e = 0; e < 1000; e++) {
+    TEST_ASSERT_EQUAL_INT(e % 3 == 0, frozen_set_contains(frozen, &e));
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,
+                          frozen_set_lower_bound(frozen, &e, &out));
+    TEST_ASSERT_EQUAL_INT((e + 2) / 3 * 3, out);
+  }
+  int e = 1000;
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, frozen_set_lower_bound(frozen, &e, &out));
+  frozen_set_free(frozen);
+}
+
+void test_frozen_set_view() {
+  for (int e = 0; e < 100; e++) {
+    b_tree_set_add(tree_set, &e);
+  }
+  FrozenSet *frozen = b_tree_set_freeze(tree_set);
+  size_t size = frozen_set_size(frozen);
+  void *copy = malloc(size);
+  memcpy(copy, frozen_set_data(frozen), size);
+  frozen_set_free(frozen);
+
+  FrozenSet *view = frozen_set_view(copy, size, &compere);
+  for (int e = -10; e < 110; e++) {
+    TEST_ASSERT_EQUAL_INT(e >= 0 && e < 100, frozen_set_contains(view, &e));
+  }
+  frozen_set_free(view);
+  free(copy);
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_frozen_set_contains);
+  RUN_TEST(test_frozen_set_view);
+
+  return UNITY_END();
+}
@@ -0,0 +1,82 @@
+#include <unity.h>
+
+#include "test_hash_generic.h"
+
+#define EQUAL(a, b) ((a) == (b))
+#define HASH_INT(e) hash_mix64((uint64_t)(int64_t)(e))
+
+GENERATE_HASH_MAP_C(u64, uint64_t, uint64_t, hash_mix64, EQUAL)
+GENERATE_HASH_SET_C(int, int, HASH_INT, EQUAL)
+
+HashMapu64 *hash_map;
+HashSetint *hash_set;
+
+void setUp(void) {
+  hash_map = hash_map_u64_new();
+  hash_set = hash_set_int_new();
+}
+
+void tearDown(void) {
+  hash_map_u64_free(hash_map);
+  hash_set_int_free(hash_set);
+}
+
+void test_hash_map_put_get() {
+  for (uint64_t k = 0; k < 1000; k++) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, hash_map_u64_put(hash_map, k, k * 3));
+  }
+  hash_map_u64_put(hash_map, 5, 0);
+  TEST_ASSERT_EQUAL_INT(1000, hash_map_u64_len(hash_map));
+  TEST_ASSERT_EQUAL_INT(2 * sizeof(uint64_t), sizeof(HashSlotu64));
+  uint64_t v;
+  for (uint64_t k = 0; k < 1000; k++) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, hash_map_u64_get(hash_map, k, &v));
+    TEST_ASSERT_EQUAL_UINT64(k == 5 ? 0 : k * 3, v);
+  }
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, hash_map_u64_get(hash_map, 1000, &v));
+}
+
+void test_hash_map_remove() {
+  for (int round = 0; round < 5; round++) {
+    for (uint64_t k = 0; k < 300; k++) {
+      hash_map_u64_put(hash_map, k, k);
+    }
+    for (uint64_t k = 0; k < 300; k += 3) {
+      TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, hash_map_u64_remove(hash_map, k));
+    }
+  }
+  TEST_ASSERT_EQUAL_INT(200, hash_map_u64_len(hash_map));
+  for (uint64_t k = 0; k < 300; k++) {
+    TEST_ASSERT_EQUAL_INT(k % 3 != 0, hash_map_u64_contains_key(hash_map, k));
+  }
+  hash_map_u64_clear(hash_map);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, hash_map_u64_shrink_to_fit(hash_map));
+  TEST_ASSERT_EQUAL_INT(0, hash_map->capacity);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, hash_map_u64_reserve(hash_map, 100));
+  TEST_ASSERT_EQUAL_INT(128, hash_map->capacity);
+}
+
+void test_hash_set_add_remove() {
+  for (int i = -500; i < 500; i++) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, hash_set_int_add(hash_set, i));
+  }
+  hash_set_int_add(hash_set, 0);
+  TEST_ASSERT_EQUAL_INT(1000, hash_set_int_len(hash_set));
+  for (int i = -500; i < 500; i += 2) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, hash_set_int_remove(hash_set, i));
+  }
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, hash_set_int_remove(hash_set, -500));
+  for (int i = -500; i < 500; i++) {
+    TEST_ASSERT_EQUAL_INT(i % 2 != 0, hash_set_int_contains(hash_set, i));
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_hash_map_put_get);
+  RUN_TEST(test_hash_map_remove);
+  RUN_TEST(test_hash_set_add_remove);
+
+  return UNITY_END();
+}
@@ -0,0 +1,6 @@
+#include "kiyo-collections/hash_map.h"
+#include "kiyo-collections/hash_set.h"
+#include <stdint.h>
+
+GENERATE_HASH_MAP_H(u64, uint64_t, uint64_t)
+GENERATE_HASH_SET_H(int, int)
@@ -0,0 +1,196 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+
+#include "kiyo-collections/hash_map.h"
+
+HashMap *hash_map;
+
+int compere(void *left, void *right) { return *(int *)right - *(int *)left; }
+
+void setUp(void) {
+  hash_map = hash_map_new(sizeof(int), sizeof(int), &hash_int, &compere);
+}
+
+void tearDown(void) { hash_map_free(hash_map); }
+
+void test_hash_map_put_get() {
+  int v;
+  int k = 0;
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, hash_map_get(hash_map, &k, &v));
+  for (k = 0; k < 1000; k++) {
+    v = k * k;
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, hash_map_put(hash_map, &k, &v));
+  }
+  TEST_ASSERT_EQUAL_INT(1000, hash_map_len(hash_map));
+  TEST_ASSERT_EQUAL_INT(2048, hash_map->capacity);
+  for (k = 0; k < 1000; k++) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, hash_map_get(hash_map, &k, &v));
+    TEST_ASSERT_EQUAL_INT(k * k, v);
+  }
+  k = 1000;
+  TEST_ASSERT_FALSE(hash_map_contains_key(hash_map, &k));
+
+  k = 7;
+  v = -1;
+  hash_map_put(hash_map, &k, &v);
+  TEST_ASSERT_EQUAL_INT(1000, hash_map_len(hash_map));
+  hash_map_get(hash_map, &k, &v);
+  TEST_ASSERT_EQUAL_INT(-1, v);
+}
+
+void test_hash_map_remove() {
+  int k = 0;
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, hash_map_remove(hash_map, &k));
+  for (int round = 0; round < 5; round++) {
+    for (k = 0; k < 500; k++) {
+      hash_map_put(hash_map, &k, &k);
+    }
+    for (k = 0; k < 500; k += 2) {
+      TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, hash_map_remove(hash_map, &k));
+    }
+    TEST_ASSERT_EQUAL_INT(250, hash_map_len(hash_map));
+    for (k = 0; k < 500; k++) {
+      TEST_ASSERT_EQUAL_INT(k % 2, hash_map_contains_key(hash_map, &k));
+    }
+  }
+  // Reinserting removed keys reuses their slots instead of growing.
+  TEST_ASSERT_EQUAL_INT(1024, hash_map->capacity);
+}
+
+void test_hash_map_random() {
+  bool present[4096] = {false};
+  size_t len = 0;
+  srand(3);
+  for (int i = 0; i < 100000; i++) {
+    int k = rand() % 4096;
+    if (rand() % 2) {
+      if (!present[k])
+        len++;
+      present[k] = true;
+      TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, hash_map_put(hash_map, &k, &k));
+    } else {
+      int status = hash_map_remove(hash_map, &k);
+      TEST_ASSERT_EQUAL_INT(present[k] ? EXIT_SUCCESS : EXIT_FAILURE, status);
+      if (present[k])
+        len--;
+      present[k] = false;
+    }
+  }
+  TEST_ASSERT_EQUAL_INT(len, hash_map_len(hash_map));
+  int v;
+  for (int k = 0; k < 4096; k++) {
+    if (present[k]) {
+      TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, hash_map_get(hash_map, &k, &v));
+      TEST_ASSERT_EQUAL_INT(k, v);
+    } else {
+      TEST_ASSERT_FALSE(hash_map_contains_key(hash_map, &k));
+    }
+  }
+}
+
+void test_hash_map_reserve_shrink() {
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, hash_map_reserve(hash_map, 1000));
+  size_t capacity = hash_map->capacity;
+  TEST_ASSERT(capacity - capacity / 8 >= 1000);
+  for (int k = 0; k < 1000; k++) {
+    hash_map_put(hash_map, &k, &k);
+  }
+  TEST_ASSERT_EQUAL_INT(capacity, hash_map->capacity);
+
+  for (int k = 10; k < 1000; k++) {
+    hash_map_remove(hash_map, &k);
+  }
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, hash_map_shrink_to_fit(hash_map));
+  TEST_ASSERT_EQUAL_INT(16, hash_map->capacity);
+  int v;
+  for (int k = 0; k < 10; k++) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, hash_map_get(hash_map, &k, &v));
+    TEST_ASSERT_EQUAL_INT(k, v);
+  }
+
+  hash_map_clear(hash_map);
+  TEST_ASSERT_EQUAL_INT(0, hash_map_len(hash_map));
+  hash_map_shrink_to_fit(hash_map);
+  TEST_ASSERT_EQUAL_INT(0, hash_map->capacity);
+  TEST_ASSERT_NULL(hash_map->slots);
+}
+
+/* Replaces entries of a map holding keys 0 to len - 1 with fresh keys. */
+void churn(int len) {
+  for (int k = 0; k < len; k++)
+    hash_map_put(hash_map, &k, &k);
+  for (int k = len; k < len + 20000; k++) {
+    int old = k - len;
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, hash_map_remove(hash_map, &old));
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, hash_map_put(hash_map, &k, &k));
+  }
+  for (int k = 20000; k < len + 20000; k++)
+    TEST_ASSERT_TRUE(hash_map_contains_key(hash_map, &k));
+  TEST_ASSERT_EQUAL_INT(len, hash_map_len(hash_map));
+}
+
+void test_hash_map_deleted_slots() {
+  // Up to 25/32 full, deleted slots are dropped at the same capacity.
+  churn(500);
+  TEST_ASSERT_EQUAL_INT(1024, hash_map->capacity);
+  hash_map_clear(hash_map);
+  // A fuller table doubles instead of rehashing after every few inserts.
+  churn(895);
+  TEST_ASSERT_EQUAL_INT(2048, hash_map->capacity);
+}
+
+void test_hash_map_iter() {
+  for (int k = 0; k < 100; k++) {
+    int v = 2 * k;
+    hash_map_put(hash_map, &k, &v);
+  }
+  bool seen[100] = {false};
+  size_t count = 0;
+  HashMapIter iter;
+  void *k;
+  void *v;
+  hash_map_iter(hash_map, &iter);
+  while (hash_map_iter_next(&iter, &k, &v)) {
+    TEST_ASSERT_FALSE(seen[*(int *)k]);
+    TEST_ASSERT_EQUAL_INT(2 * *(int *)k, *(int *)v);
+    seen[*(int *)k] = true;
+    count++;
+  }
+  TEST_ASSERT_EQUAL_INT(100, count);
+}
+
+int compere_cstr(void *left, void *right) {
+  return strcmp(*(char **)right, *(char **)left);
+}
+
+void test_hash_map_cstr() {
+  HashMap *words =
+      hash_map_new(sizeof(char *), sizeof(int), &hash_cstr, &compere_cstr);
+  char *keys[] = {"alpha", "beta", "gamma", "delta"};
+  for (int i = 0; i < 4; i++) {
+    hash_map_put(words, &keys[i], &i);
+  }
+  // Equal strings at a different address find the same entry.
+  char buffer[] = "gamma";
+  char *lookup = buffer;
+  int v;
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, hash_map_get(words, &lookup, &v));
+  TEST_ASSERT_EQUAL_INT(2, v);
+  hash_map_free(words);
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_hash_map_put_get);
+  RUN_TEST(test_hash_map_remove);
+  RUN_TEST(test_hash_map_random);
+  RUN_TEST(test_hash_map_reserve_shrink);
+  RUN_TEST(test_hash_map_deleted_slots);
+  RUN_TEST(test_hash_map_iter);
+  RUN_TEST(test_hash_map_cstr);
+
+  return UNITY_END();
+}
@@ -0,0 +1,71 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <unity.h>
+
+#include "kiyo-collections/hash_set.h"
+
+HashSet *hash_set;
+
+int compere(void *left, void *right) {
+  uint64_t l = *(uint64_t *)left;
+  uint64_t r = *(uint64_t *)right;
+  return COMPARE_ASCENDING(l, r);
+}
+
+void setUp(void) {
+  hash_set = hash_set_new(sizeof(uint64_t), &hash_u64, &compere);
+}
+
+void tearDown(void) { hash_set_free(hash_set); }
+
+void test_hash_set_add() {
+  for (uint64_t e = 0; e < 200; e++) {
+    uint64_t wide = e << 40;
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, hash_set_add(hash_set, &wide));
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, hash_set_add(hash_set, &wide));
+  }
+  TEST_ASSERT_EQUAL_INT(200, hash_set_len(hash_set));
+  TEST_ASSERT_EQUAL_INT(sizeof(uint64_t), hash_set->table->slot_size);
+  for (uint64_t e = 0; e < 200; e++) {
+    uint64_t wide = e << 40;
+    TEST_ASSERT(hash_set_contains(hash_set, &wide));
+    wide++;
+    TEST_ASSERT_FALSE(hash_set_contains(hash_set, &wide));
+  }
+}
+
+void test_hash_set_remove() {
+  for (uint64_t e = 0; e < 200; e++) {
+    hash_set_add(hash_set, &e);
+  }
+  for (uint64_t e = 0; e < 200; e += 4) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, hash_set_remove(hash_set, &e));
+    TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, hash_set_remove(hash_set, &e));
+  }
+  TEST_ASSERT_EQUAL_INT(150, hash_set_len(hash_set));
+
+  size_t count = 0;
+  HashSetIter iter;
+  void *e;
+  hash_set_iter(hash_set, &iter);
+  while (hash_set_iter_next(&iter, &e)) {
+    TEST_ASSERT(*(uint64_t *)e % 4 != 0);
+    count++;
+  }
+  TEST_ASSERT_EQUAL_INT(150, count);
+
+  hash_set_clear(hash_set);
+  TEST_ASSERT_EQUAL_INT(0, hash_set_len(hash_set));
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, hash_set_shrink_to_fit(hash_set));
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, hash_set_reserve(hash_set, 10));
+  TEST_ASSERT_EQUAL_INT(16, hash_set->table->capacity);
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_hash_set_add);
+  RUN_TEST(test_hash_set_remove);
+
+  return UNITY_END();
+}
@@ -0,0 +1,150 @@
+#include <stdlib.h>
+#include <unity.h>
+
+#include "kiyo-collections/interval_map.h"
+
+IntervalMap *interval_map;
+
+int compere(void *left, void *right) { return *(int *)right - *(int *)left; }
+
+void setUp(void) {
+  interval_map = interval_map_new(sizeof(int), sizeof(int), &compere);
+}
+
+void tearDown(void) { interval_map_free(interval_map); }
+
+/* Validates heights, balance and the largest ends, returns the height. */
+size_t check_avl(IntervalEntry *node) {
+  if (node == NULL)
+    return 0;
+  size_t left = check_avl(node->left);
+  size_t right = check_avl(node->right);
+  TEST_ASSERT(left <= right + 1 && right <= left + 1);
+  TEST_ASSERT_EQUAL_INT((left > right ? left : right) + 1, node->height);
+  int max = *(int *)node->hi;
+  if (node->left && *(int *)node->left->max->hi > max)
+    max = *(int *)node->left->max->hi;
+  if (node->right && *(int *)node->right->max->hi > max)
+    max = *(int *)node->right->max->hi;
+  TEST_ASSERT_EQUAL_INT(max, *(int *)node->max->hi);
+  return node->height;
+}
+
+int found_count;
+int found_previous;
+
+void count_found(void *interval, void *value) {
+  int *endpoints = interval;
+  // Intervals arrive in ascending order of their start.
+  TEST_ASSERT(found_previous <= endpoints[0]);
+  found_previous = endpoints[0];
+  TEST_ASSERT_EQUAL_INT(endpoints[0] * 1000 + endpoints[1], *(int *)value);
+  found_count++;
+}
+
+void test_interval_map_put() {
+  int lo = 5;
+  int hi = 10;
+  int v = 1;
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,
+                        interval_map_put(interval_map, &lo, &hi, &v));
+  v = 2;
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,
+                        interval_map_put(interval_map, &lo, &hi, &v));
+  hi = 12;
+  interval_map_put(interval_map, &lo, &hi, &v);
+  TEST_ASSERT_EQUAL_INT(2, interval_map_len(interval_map));
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE,
+                        interval_map_put(interval_map, &lo, &lo, &v));
+
+  hi = 10;
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,
+                        interval_map_get(interval_map, &lo, &hi, &v));
+  TEST_ASSERT_EQUAL_INT(2, v);
+  hi = 11;
+  TEST_ASSERT_FALSE(interval_map_contains(interval_map, &lo, &hi));
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE,
+                        interval_map_remove(interval_map, &lo, &hi));
+  hi = 12;
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,
+                        interval_map_remove(interval_map, &lo, &hi));
+  TEST_ASSERT_EQUAL_INT(1, interval_map_len(interval_map));
+  interval_map_clear(interval_map);
+  TEST_ASSERT_EQUAL_INT(0, interval_map_len(interval_map));
+}
+
+void test_interval_map_queries() {
+  // Half-open intervals touch but do not overlap.
+  int lo = 10;
+  int hi = 20;
+  int v = lo * 1000 + hi;
+  interval_map_put(interval_map, &lo, &hi, &v);
+  TEST_ASSERT_TRUE(interval_map_overlaps(interval_map, &lo, &hi));
+  int before = 5;
+  TEST_ASSERT_FALSE(interval_map_overlaps(interval_map, &before, &lo));
+  int after = 25;
+  TEST_ASSERT_FALSE(interval_map_overlaps(interval_map, &hi, &after));
+  found_count = 0;
+  found_previous = 0;
+  interval_map_stab(interval_map, &hi, count_found);
+  TEST_ASSERT_EQUAL_INT(0, found_count);
+  interval_map_stab(interval_map, &lo, count_found);
+  TEST_ASSERT_EQUAL_INT(1, found_count);
+}
+
+void test_interval_map_random() {
+  int starts[512];
+  int ends[512];
+  bool present[512] = {false};
+  srand(11);
+  for (int i = 0; i < 512; i++) {
+    starts[i] = rand() % 10000;
+    ends[i] = starts[i] + 1 + rand() % 300;
+    int v = starts[i] * 1000 + ends[i];
+    // Duplicate intervals keep their index and just overwrite the value.
+    present[i] = !interval_map_contains(interval_map, &starts[i], &ends[i]);
+    interval_map_put(interval_map, &starts[i], &ends[i], &v);
+  }
+  for (int i = 0; i < 512; i += 3) {
+    if (present[i]) {
+      int status = interval_map_remove(interval_map, &starts[i], &ends[i]);
+      TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, status);
+      present[i] = false;
+    }
+  }
+  check_avl(interval_map->root);
+
+  for (int point = -5; point < 10400; point += 7) {
+    int expected = 0;
+    for (int i = 0; i < 512; i++) {
+      expected += present[i] && starts[i] <= point && point < ends[i];
+    }
+    found_count = 0;
+    found_previous = -1;
+    interval_map_stab(interval_map, &point, count_found);
+    TEST_ASSERT_EQUAL_INT(expected, found_count);
+
+    int lo = point;
+    int hi = point + 50;
+    expected = 0;
+    for (int i = 0; i < 512; i++) {
+      expected += present[i] && starts[i] < hi && lo < ends[i];
+    }
+    found_count = 0;
+    found_previous = -1;
+    interval_map_overlap(interval_map, &lo, &hi, count_found);
+    TEST_ASSERT_EQUAL_INT(expected, found_count);
+    TEST_ASSERT_EQUAL_INT(expected > 0,
+                          interval_map_overlaps(interval_map, &lo, &hi));
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_interval_map_put);
+  RUN_TEST(test_interval_map_queries);
+  RUN_TEST(test_interval_map_random);
+
+  return UNITY_END();
+}
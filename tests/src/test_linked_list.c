@@ -28,6 +28,47 @@ void test_linked_list_push_back() {
   TEST_ASSERT_EQUAL_INT(16, linked_list_len(linked_list));
 }
 
+void test_linked_list_push_back_n() {
+  int data[64];
+  for (int i = 0; i < 64; i++)
+    data[i] = i;
+  int i = -1;
+  linked_list_push_back(linked_list, &i);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,
+                        linked_list_push_back_n(linked_list, data, 64));
+  TEST_ASSERT_EQUAL_INT(65, linked_list_len(linked_list));
+  int buf;
+  for (i = 0; i < 64; i++) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,
+                          linked_list_get(linked_list, i + 1, &buf));
+    TEST_ASSERT_EQUAL_INT(i, buf);
+  }
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, linked_list_pop_back(linked_list, &buf));
+  TEST_ASSERT_EQUAL_INT(63, buf);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,
+                        linked_list_push_back_n(linked_list, data, 0));
+  TEST_ASSERT_EQUAL_INT(64, linked_list_len(linked_list));
+}
+
+void test_linked_list_from_array() {
+  int data[64];
+  for (int i = 0; i < 64; i++)
+    data[i] = i;
+  LinkedList *other = linked_list_from_array(sizeof(int), data, 64);
+  TEST_ASSERT_EQUAL_INT(64, linked_list_len(other));
+  // Nodes are linked in address order.
+  for (LinkedNode *node = other->head; node->next; node = node->next)
+    TEST_ASSERT(node < node->next);
+  int buf;
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, linked_list_remove(other, 10, &buf));
+  TEST_ASSERT_EQUAL_INT(10, buf);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, linked_list_pop_front(other, &buf));
+  TEST_ASSERT_EQUAL_INT(0, buf);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, linked_list_back(other, &buf));
+  TEST_ASSERT_EQUAL_INT(63, buf);
+  linked_list_free(other);
+}
+
 void test_linked_list_get() {
   for (int i = 0; i < 64; i++) {
     linked_list_push_back(linked_list, &i);
@@ -98,6 +139,39 @@ void test_linked_list_remove_if() {
   TEST_ASSERT_EQUAL_INT(10, linked_list_len(linked_list));
 }
 
+bool is_odd(void *v) { return *(int *)v % 2; }
+
+void test_linked_list_compact() {
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, linked_list_compact(linked_list));
+  for (int i = 0; i < 64; i++) {
+    linked_list_push_front(linked_list, &i);
+  }
+  linked_list_remove_if(linked_list, is_odd);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, linked_list_compact(linked_list));
+  TEST_ASSERT_EQUAL_INT(32, linked_list_len(linked_list));
+  for (LinkedNode *node = linked_list->head; node->next; node = node->next)
+    TEST_ASSERT(node < node->next);
+  int buf;
+  for (int i = 0; i < 32; i++) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, linked_list_get(linked_list, i, &buf));
+    TEST_ASSERT_EQUAL_INT(62 - 2 * i, buf);
+  }
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, linked_list_back(linked_list, &buf));
+  TEST_ASSERT_EQUAL_INT(0, buf);
+  TEST_ASSERT(linked_list->tail->prev->next == linked_list->tail);
+}
+
+void test_linked_list_fragmentation() {
+  TEST_ASSERT(linked_list_fragmentation(linked_list) == 0.0);
+  for (int i = 0; i < 64; i++) {
+    linked_list_push_back(linked_list, &i);
+  }
+  linked_list_compact(linked_list);
+  double compacted = linked_list_fragmentation(linked_list);
+  TEST_ASSERT(compacted > 0.0);
+  TEST_ASSERT(compacted <= 2 * (sizeof(LinkedNode) + sizeof(int)));
+}
+
 void test_linked_list_is_empty() {
   TEST_ASSERT(linked_list_is_empty(linked_list));
   int i = 0;
@@ -131,11 +205,15 @@ int main() {
 
   RUN_TEST(test_linked_list_push_front);
   RUN_TEST(test_linked_list_push_back);
+  RUN_TEST(test_linked_list_push_back_n);
+  RUN_TEST(test_linked_list_from_array);
   RUN_TEST(test_linked_list_get);
   RUN_TEST(test_linked_list_pop_front);
   RUN_TEST(test_linked_list_pop_back);
   RUN_TEST(test_linked_list_remove);
   RUN_TEST(test_linked_list_remove_if);
+  RUN_TEST(test_linked_list_compact);
+  RUN_TEST(test_linked_list_fragmentation);
   RUN_TEST(test_linked_list_is_empty);
   RUN_TEST(test_linked_list_clear);
 
@@ -2,7 +2,12 @@
 
 #include "test_linked_list_generic.h"
 
+#define LONG_EQ(a, b) ((a) == (b))
+#define LONG_GREATER_EQ_10(v) ((v) >= 10)
+
 GENERATE_LINKED_LIST_C(long)
+GENERATE_LINKED_LIST_CONTAINS_C(long, long, eq, LONG_EQ)
+GENERATE_LINKED_LIST_REMOVE_IF_C(long, greater_eq_10, LONG_GREATER_EQ_10)
 
 LinkedListlong *linked_list;
 
@@ -28,6 +33,38 @@ void test_linked_list_push_back() {
   TEST_ASSERT_EQUAL_INT(16, linked_list_long_len(linked_list));
 }
 
+void test_linked_list_push_back_n() {
+  long data[64];
+  for (long i = 0; i < 64; i++)
+    data[i] = i;
+  linked_list_long_push_back(linked_list, -1);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,
+                        linked_list_long_push_back_n(linked_list, data, 64));
+  TEST_ASSERT_EQUAL_INT(65, linked_list_long_len(linked_list));
+  long buf;
+  for (long i = 0; i < 64; i++) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,
+                          linked_list_long_get(linked_list, i + 1, &buf));
+    TEST_ASSERT_EQUAL_INT64(i, buf);
+  }
+}
+
+void test_linked_list_from_array() {
+  long data[64];
+  for (long i = 0; i < 64; i++)
+    data[i] = i;
+  LinkedListlong *other = linked_list_long_from_array(data, 64);
+  TEST_ASSERT_EQUAL_INT(64, linked_list_long_len(other));
+  for (LinkedNodelong *node = other->head; node->next; node = node->next)
+    TEST_ASSERT(node < node->next);
+  long buf;
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, linked_list_long_remove(other, 10, &buf));
+  TEST_ASSERT_EQUAL_INT64(10, buf);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, linked_list_long_pop_back(other, &buf));
+  TEST_ASSERT_EQUAL_INT64(63, buf);
+  linked_list_long_free(other);
+}
+
 void test_linked_list_get() {
   for (long i = 0; i < 64; i++) {
     linked_list_long_push_back(linked_list, i);
@@ -102,6 +139,50 @@ void test_linked_list_remove_if() {
   TEST_ASSERT_EQUAL_INT(10, linked_list_long_len(linked_list));
 }
 
+void test_linked_list_compact() {
+  for (long i = 0; i < 64; i++) {
+    linked_list_long_push_front(linked_list, i);
+  }
+  linked_list_long_remove_if(linked_list, greater_eq_10);
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, linked_list_long_compact(linked_list));
+  TEST_ASSERT_EQUAL_INT(10, linked_list_long_len(linked_list));
+  for (LinkedNodelong *node = linked_list->head; node->next; node = node->next)
+    TEST_ASSERT(node < node->next);
+  long buf;
+  for (long i = 0; i < 10; i++) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,
+                          linked_list_long_get(linked_list, i, &buf));
+    TEST_ASSERT_EQUAL_INT64(9 - i, buf);
+  }
+  TEST_ASSERT(linked_list_long_fragmentation(linked_list) ==
+              sizeof(LinkedNodelong));
+}
+
+void test_linked_list_contains_eq() {
+  TEST_ASSERT_FALSE(linked_list_long_contains_eq(linked_list, 0));
+  for (long i = 0; i < 64; i++) {
+    linked_list_long_push_back(linked_list, i);
+  }
+  for (long i = 0; i < 64; i++) {
+    TEST_ASSERT(linked_list_long_contains_eq(linked_list, i));
+  }
+  TEST_ASSERT_FALSE(linked_list_long_contains_eq(linked_list, -1));
+  TEST_ASSERT_FALSE(linked_list_long_contains_eq(linked_list, 64));
+}
+
+void test_linked_list_remove_if_specialized() {
+  for (long i = 0; i < 64; i++) {
+    linked_list_long_push_back(linked_list, i);
+  }
+  linked_list_long_remove_if_greater_eq_10(linked_list);
+  TEST_ASSERT_EQUAL_INT(10, linked_list_long_len(linked_list));
+  long buf;
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, linked_list_long_back(linked_list, &buf));
+  TEST_ASSERT_EQUAL_INT64(9, buf);
+  linked_list_long_remove_if_greater_eq_10(linked_list);
+  TEST_ASSERT_EQUAL_INT(10, linked_list_long_len(linked_list));
+}
+
 void test_linked_list_is_empty() {
   TEST_ASSERT(linked_list_long_is_empty(linked_list));
   long i = 0;
@@ -129,11 +210,16 @@ int main() {
 
   RUN_TEST(test_linked_list_push_front);
   RUN_TEST(test_linked_list_push_back);
+  RUN_TEST(test_linked_list_push_back_n);
+  RUN_TEST(test_linked_list_from_array);
   RUN_TEST(test_linked_list_get);
   RUN_TEST(test_linked_list_pop_front);
   RUN_TEST(test_linked_list_pop_back);
   RUN_TEST(test_linked_list_remove);
   RUN_TEST(test_linked_list_remove_if);
+  RUN_TEST(test_linked_list_compact);
+  RUN_TEST(test_linked_list_contains_eq);
+  RUN_TEST(test_linked_list_remove_if_specialized);
   RUN_TEST(test_linked_list_is_empty);
   RUN_TEST(test_linked_list_clear);
 
@@ -1,3 +1,5 @@
 #include "kiyo-collections/linked_list.h"
 
 GENERATE_LINKED_LIST_H(long)
+GENERATE_LINKED_LIST_CONTAINS_H(long, long, eq)
+GENERATE_LINKED_LIST_REMOVE_IF_H(long, greater_eq_10)
@@ -0,0 +1,140 @@
+#include <stdlib.h>
+#include <unity.h>
+
+#include "kiyo-collections/persistent_map.h"
+
+PersistentMap *persistent_map;
+
+int compere(void *left, void *right) { return *(int *)right - *(int *)left; }
+
+void setUp(void) {
+  persistent_map = persistent_map_new(sizeof(int), sizeof(int), &compere);
+}
+
+void tearDown(void) { persistent_map_free(persistent_map); }
+
+/* Checks the AVL property of every entry and returns the subtree height. */
+size_t check_avl(PersistentEntry *node) {
+  if (node == NULL)
+    return 0;
+  size_t left = check_avl(node->left);
+  size_t right = check_avl(node->right);
+  TEST_ASSERT(left <= right + 1 && right <= left + 1);
+  size_t height = (left > right ? left : right) + 1;
+  TEST_ASSERT_EQUAL_size_t(height, node->height);
+  return height;
+}
+
+/* Replaces the current version with the one derived from it. */
+void advance(PersistentMap *next) {
+  TEST_ASSERT_NOT_NULL(next);
+  persistent_map_free(persistent_map);
+  persistent_map = next;
+}
+
+void test_persistent_map_put_get() {
+  for (int k = 0; k < 1000; k++) {
+    int v = k * k;
+    advance(persistent_map_put(persistent_map, &k, &v));
+  }
+  TEST_ASSERT_EQUAL_INT(1000, persistent_map_len(persistent_map));
+  check_avl(persistent_map->root);
+  int v;
+  for (int k = 0; k < 1000; k++) {
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS,
+                          persistent_map_get(persistent_map, &k, &v));
+    TEST_ASSERT_EQUAL_INT(k * k, v);
+  }
+  int k = 1000;
+  TEST_ASSERT_FALSE(persistent_map_contains_key(persistent_map, &k));
+}
+
+void test_persistent_map_versions() {
+  for (int k = 0; k < 100; k++) {
+    advance(persistent_map_put(persistent_map, &k, &k));
+  }
+  PersistentMap *snapshot = persistent_map_snapshot(persistent_map);
+  TEST_ASSERT_EQUAL_PTR(persistent_map->root, snapshot->root);
+
+  int k = 99;
+  int v = -1;
+  PersistentMap *changed = persistent_map_put(snapshot, &k, &v);
+  k = 10;
+  PersistentMap *removed = persistent_map_remove(changed, &k);
+
+  // Older versions keep their entries.
+  k = 99;
+  persistent_map_get(snapshot, &k, &v);
+  TEST_ASSERT_EQUAL_INT(99, v);
+  persistent_map_get(changed, &k, &v);
+  TEST_ASSERT_EQUAL_INT(-1, v);
+  k = 10;
+  TEST_ASSERT(persistent_map_contains_key(changed, &k));
+  TEST_ASSERT_FALSE(persistent_map_contains_key(removed, &k));
+  TEST_ASSERT_EQUAL_INT(100, persistent_map_len(changed));
+  TEST_ASSERT_EQUAL_INT(99, persistent_map_len(removed));
+
+  // Only the path to the largest key was copied, the rest is shared.
+  TEST_ASSERT(snapshot->root != changed->root);
+  PersistentEntry *a = snapshot->root;
+  PersistentEntry *b = changed->root;
+  TEST_ASSERT_EQUAL_PTR(a->left, b->left);
+  TEST_ASSERT(a->right != b->right);
+
+  // Removing a missing key shares the whole tree.
+  k = 1000;
+  PersistentMap *same = persistent_map_remove(removed, &k);
+  TEST_ASSERT_EQUAL_PTR(removed->root, same->root);
+
+  persistent_map_free(snapshot);
+  persistent_map_free(changed);
+  persistent_map_free(same);
+  check_avl(removed->root);
+  persistent_map_free(removed);
+}
+
+void test_persistent_map_remove_random() {
+  // Every version is kept alive and checked against a plain array.
+  enum { VERSIONS = 200, KEYS = 64 };
+  PersistentMap *versions[VERSIONS];
+  bool present[VERSIONS][KEYS] = {{false}};
+  versions[0] = persistent_map_snapshot(persistent_map);
+  srand(5);
+  for (int i = 1; i < VERSIONS; i++) {
+    int from = rand() % i;
+    int k = rand() % KEYS;
+    for (int j = 0; j < KEYS; j++)
+      present[i][j] = present[from][j];
+    if (rand() % 3) {
+      versions[i] = persistent_map_put(versions[from], &k, &i);
+      present[i][k] = true;
+    } else {
+      versions[i] = persistent_map_remove(versions[from], &k);
+      present[i][k] = false;
+    }
+    TEST_ASSERT_NOT_NULL(versions[i]);
+  }
+  for (int i = 0; i < VERSIONS; i++) {
+    size_t len = 0;
+    for (int k = 0; k < KEYS; k++) {
+      TEST_ASSERT_EQUAL_INT(present[i][k],
+                            persistent_map_contains_key(versions[i], &k));
+      len += present[i][k];
+    }
+    TEST_ASSERT_EQUAL_INT(len, persistent_map_len(versions[i]));
+    check_avl(versions[i]->root);
+  }
+  for (int i = 0; i < VERSIONS; i++) {
+    persistent_map_free(versions[i]);
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_persistent_map_put_get);
+  RUN_TEST(test_persistent_map_versions);
+  RUN_TEST(test_persistent_map_remove_random);
+
+  return UNITY_END();
+}
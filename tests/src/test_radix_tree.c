@@ -0,0 +1,257 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+
+#include "kiyo-collections/radix_tree.h"
+
+RadixTree *radix_tree;
+
+void setUp(void) { radix_tree = radix_tree_new(sizeof(int)); }
+
+void tearDown(void) { radix_tree_free(radix_tree); }
+
+int put(char *key, int v) {
+  return radix_tree_put(radix_tree, key, strlen(key), &v);
+}
+
+int get(char *key) {
+  int v = -1;
+  radix_tree_get(radix_tree, key, strlen(key), &v);
+  return v;
+}
+
+int visited_count;
+unsigned char visited_previous[64];
+size_t visited_previous_len;
+
+void check_ascending(void *key, size_t key_len, void *value) {
+  // Every key comes after the previous one, a prefix before its extensions.
+  size_t len = key_len < visited_previous_len ? key_len : visited_previous_len;
+  int c = memcmp(visited_previous, key, len);
+  TEST_ASSERT(c < 0 || (c == 0 && visited_previous_len < key_len) ||
+              visited_count == 0);
+  memcpy(visited_previous, key, key_len);
+  visited_previous_len = key_len;
+  TEST_ASSERT_EQUAL_INT((int)key_len, *(int *)value);
+  visited_count++;
+}
+
+void test_radix_tree_put() {
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, put("apple", 1));
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, put("apple", 2));
+  put("app", 3);
+  put("application", 4);
+  put("", 5);
+  put("b", 6);
+  TEST_ASSERT_EQUAL_INT(5, radix_tree_len(radix_tree));
+  TEST_ASSERT_EQUAL_INT(2, get("apple"));
+  TEST_ASSERT_EQUAL_INT(3, get("app"));
+  TEST_ASSERT_EQUAL_INT(4, get("application"));
+  TEST_ASSERT_EQUAL_INT(5, get(""));
+  TEST_ASSERT_EQUAL_INT(6, get("b"));
+  TEST_ASSERT_EQUAL_INT(-1, get("ap"));
+  TEST_ASSERT_EQUAL_INT(-1, get("applications"));
+  TEST_ASSERT_FALSE(radix_tree_contains(radix_tree, "appl", 4));
+
+  int *value = radix_tree_get_ptr(radix_tree, "app", 3);
+  *value = 7;
+  TEST_ASSERT_EQUAL_INT(7, get("app"));
+
+  TEST_ASSERT_EQUAL_INT(EXIT_FAILURE, radix_tree_remove(radix_tree, "ap", 2));
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, radix_tree_remove(radix_tree, "app", 3));
+  TEST_ASSERT_EQUAL_INT(-1, get("app"));
+  TEST_ASSERT_EQUAL_INT(2, get("apple"));
+  TEST_ASSERT_EQUAL_INT(4, get("application"));
+  radix_tree_remove(radix_tree, "apple", 5);
+  radix_tree_remove(radix_tree, "", 0);
+  TEST_ASSERT_EQUAL_INT(4, get("application"));
+  TEST_ASSERT_EQUAL_INT(2, radix_tree_len(radix_tree));
+  radix_tree_clear(radix_tree);
+  TEST_ASSERT_EQUAL_INT(0, radix_tree_len(radix_tree));
+  TEST_ASSERT_EQUAL_INT(-1, get("b"));
+}
+
+void test_radix_tree_grow_shrink() {
+  // A single node grows through all kinds and shrinks back.
+  unsigned char key[2] = {'k', 0};
+  for (int i = 0; i < 256; i++) {
+    key[1] = (unsigned char)i;
+    radix_tree_put(radix_tree, key, 2, &i);
+  }
+  RadixNode *root = radix_tree->root;
+  TEST_ASSERT_EQUAL_INT(RADIX_NODE256, root->type);
+  TEST_ASSERT_EQUAL_INT(1, root->prefix_len);
+  for (int i = 0; i < 256; i++) {
+    key[1] = (unsigned char)i;
+    int v = -1;
+    radix_tree_get(radix_tree, key, 2, &v);
+    TEST_ASSERT_EQUAL_INT(i, v);
+  }
+  for (int i = 255; i >= 2; i--) {
+    key[1] = (unsigned char)i;
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, radix_tree_remove(radix_tree, key, 2));
+    root = radix_tree->root;
+    if (i == 37)
+      TEST_ASSERT_EQUAL_INT(RADIX_NODE48, root->type);
+    if (i == 12)
+      TEST_ASSERT_EQUAL_INT(RADIX_NODE16, root->type);
+    if (i == 3)
+      TEST_ASSERT_EQUAL_INT(RADIX_NODE4, root->type);
+  }
+  for (int i = 0; i < 2; i++) {
+    key[1] = (unsigned char)i;
+    int v = -1;
+    radix_tree_get(radix_tree, key, 2, &v);
+    TEST_ASSERT_EQUAL_INT(i, v);
+  }
+}
+
+void test_radix_tree_long_prefix() {
+  // The shared part is longer than the prefix stored inside a node.
+  char *keys[] = {
+      "https://example.com/collections/radix/tree",
+      "https://example.com/collections/radix/trie",
+      "https://example.com/collections/b/tree",
+      "https://example.com/col",
+      "https://example.org/",
+  };
+  for (int i = 0; i < 5; i++)
+    put(keys[i], i);
+  for (int i = 0; i < 5; i++)
+    TEST_ASSERT_EQUAL_INT(i, get(keys[i]));
+  TEST_ASSERT_EQUAL_INT(-1, get("https://example.com/collections/radix/"));
+  TEST_ASSERT_EQUAL_INT(-1, get("https://example.net/collections/b/tree"));
+
+  radix_tree_remove(radix_tree, keys[2], strlen(keys[2]));
+  radix_tree_remove(radix_tree, keys[4], strlen(keys[4]));
+  radix_tree_remove(radix_tree, keys[3], strlen(keys[3]));
+  // The remaining keys now hang below a single merged path.
+  TEST_ASSERT_EQUAL_INT(0, get(keys[0]));
+  TEST_ASSERT_EQUAL_INT(1, get(keys[1]));
+  RadixNode *root = radix_tree->root;
+  TEST_ASSERT_EQUAL_INT(strlen("https://example.com/collections/radix/tr"),
+                        root->prefix_len);
+  put("https://example.com/collections/radix/", 9);
+  TEST_ASSERT_EQUAL_INT(9, get("https://example.com/collections/radix/"));
+  TEST_ASSERT_EQUAL_INT(0, get(keys[0]));
+}
+
+void test_radix_tree_ordered() {
+  char key[16];
+  for (int i = 0; i < 400; i++) {
+    int len = snprintf(key, sizeof(key), "%d", (i * 7919) % 1000);
+    radix_tree_put(radix_tree, key, (size_t)len, &len);
+  }
+  visited_count = 0;
+  visited_previous_len = 0;
+  radix_tree_for_each(radix_tree, check_ascending);
+  TEST_ASSERT_EQUAL_INT(radix_tree_len(radix_tree), visited_count);
+
+  // Keys with the prefix "12" are 12, 120..129 and 1200..1299.
+  int expected = 0;
+  for (int i = 0; i < 400; i++) {
+    int len = snprintf(key, sizeof(key), "%d", (i * 7919) % 1000);
+    expected += len >= 2 && key[0] == '1' && key[1] == '2';
+  }
+  visited_count = 0;
+  visited_previous_len = 0;
+  radix_tree_prefix(radix_tree, "12", 2, check_ascending);
+  TEST_ASSERT_EQUAL_INT(expected, visited_count);
+  visited_count = 0;
+  radix_tree_prefix(radix_tree, "", 0, check_ascending);
+  TEST_ASSERT_EQUAL_INT(radix_tree_len(radix_tree), visited_count);
+  visited_count = 0;
+  radix_tree_prefix(radix_tree, "x", 1, check_ascending);
+  TEST_ASSERT_EQUAL_INT(0, visited_count);
+}
+
+void test_radix_tree_prefix_inside_path() {
+  put("abcdefghijklmnop", 16);
+  put("abcdefghijklmnopq", 17);
+  visited_count = 0;
+  visited_previous_len = 0;
+  radix_tree_prefix(radix_tree, "abcdefghij", 10, check_ascending);
+  TEST_ASSERT_EQUAL_INT(2, visited_count);
+  visited_count = 0;
+  radix_tree_prefix(radix_tree, "abcdefghiX", 10, check_ascending);
+  TEST_ASSERT_EQUAL_INT(0, visited_count);
+  visited_count = 0;
+  visited_previous_len = 0;
+  radix_tree_prefix(radix_tree, "abcdefghijklmnopq", 17, check_ascending);
+  TEST_ASSERT_EQUAL_INT(1, visited_count);
+}
+
+void test_radix_tree_prefix_past_long_path() {
+  // The shared path is longer than the stored prefix and the query prefix
+  // continues into the byte the node branches on.
+  put("aaaaaaaaaaaaaaaaaaaaX1", 22);
+  put("aaaaaaaaaaaaaaaaaaaaY2", 22);
+  visited_count = 0;
+  visited_previous_len = 0;
+  radix_tree_prefix(radix_tree, "aaaaaaaaaaaaaaaaaaaaX", 21, check_ascending);
+  TEST_ASSERT_EQUAL_INT(1, visited_count);
+  TEST_ASSERT_EQUAL_MEMORY("aaaaaaaaaaaaaaaaaaaaX1", visited_previous, 22);
+  visited_count = 0;
+  visited_previous_len = 0;
+  radix_tree_prefix(radix_tree, "aaaaaaaaaaaaaaaaaaaaZ", 21, check_ascending);
+  TEST_ASSERT_EQUAL_INT(0, visited_count);
+  visited_count = 0;
+  visited_previous_len = 0;
+  radix_tree_prefix(radix_tree, "aaaaaaaaaaaa", 12, check_ascending);
+  TEST_ASSERT_EQUAL_INT(2, visited_count);
+}
+
+void test_radix_tree_random() {
+  // Random keys over a small alphabet share many prefixes.
+  unsigned char keys[1000][12];
+  size_t lens[1000];
+  bool present[1000];
+  srand(5);
+  for (int i = 0; i < 1000; i++) {
+    lens[i] = (size_t)(rand() % 12);
+    for (size_t j = 0; j < lens[i]; j++)
+      keys[i][j] = (unsigned char)(rand() % 3 ? 'a' + rand() % 3 : rand());
+    present[i] = !radix_tree_contains(radix_tree, keys[i], lens[i]);
+    radix_tree_put(radix_tree, keys[i], lens[i], &i);
+  }
+  for (int i = 0; i < 1000; i += 2) {
+    if (present[i]) {
+      int status = radix_tree_remove(radix_tree, keys[i], lens[i]);
+      TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, status);
+      present[i] = false;
+    }
+  }
+  size_t len = 0;
+  for (int i = 0; i < 1000; i++) {
+    len += present[i];
+    if (!present[i])
+      continue;
+    // Later duplicates overwrite the value of the first one.
+    int v = -1;
+    radix_tree_get(radix_tree, keys[i], lens[i], &v);
+    TEST_ASSERT(v >= i);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(keys[v], keys[i], lens[i]));
+  }
+  TEST_ASSERT_EQUAL_INT(len, radix_tree_len(radix_tree));
+  for (int i = 0; i < 1000; i++) {
+    if (present[i])
+      radix_tree_remove(radix_tree, keys[i], lens[i]);
+  }
+  TEST_ASSERT_EQUAL_INT(0, radix_tree_len(radix_tree));
+  TEST_ASSERT_NULL(radix_tree->root);
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_radix_tree_put);
+  RUN_TEST(test_radix_tree_grow_shrink);
+  RUN_TEST(test_radix_tree_long_prefix);
+  RUN_TEST(test_radix_tree_ordered);
+  RUN_TEST(test_radix_tree_prefix_inside_path);
+  RUN_TEST(test_radix_tree_prefix_past_long_path);
+  RUN_TEST(test_radix_tree_random);
+
+  return UNITY_END();
+}
@@ -121,6 +121,22 @@ void test_vec_grow_shrink() {
   }
 }
 
+int compere(void *left, void *right) { return *(int *)right - *(int *)left; }
+
+void test_vec_sort() {
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, vec_sort(vec, compere));
+  for (int i = 0; i < 100; i++) {
+    int v = (i * 37) % 100;
+    vec_push(vec, &v);
+  }
+  TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, vec_sort(vec, compere));
+  int buf;
+  for (int i = 0; i < 100; i++) {
+    vec_get(vec, i, &buf);
+    TEST_ASSERT_EQUAL_INT(i, buf);
+  }
+}
+
 int main() {
   UNITY_BEGIN();
 
@@ -132,6 +148,7 @@ int main() {
   RUN_TEST(test_vec_get);
   RUN_TEST(test_vec_clear);
   RUN_TEST(test_vec_grow_shrink);
+  RUN_TEST(test_vec_sort);
 
   return UNITY_END();
 }